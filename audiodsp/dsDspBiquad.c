@@ -0,0 +1,170 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <math.h>
+#include "dsDspBiquad.h"
+#include "dsDspSimd.h"
+
+/* RBJ audio EQ cookbook, computed in double and normalised to a0 */
+void dsDspBiquadDesign(dsDspBiquad_t *biquad, dsDspBiquadType_t type, double freq, double gainDb, double q, uint32_t rate)
+{
+        double A = pow(10.0, gainDb / 40.0);
+        double w0 = 2.0 * M_PI * freq / rate;
+        double cw = cos(w0);
+        double alpha = sin(w0) / (2.0 * q);
+        double sqA = 2.0 * sqrt(A) * alpha;
+        double b0, b1, b2, a0, a1, a2;
+
+        switch (type) {
+        case dsDSP_BIQUAD_LOW_SHELF:
+                b0 = A * ((A + 1) - (A - 1) * cw + sqA);
+                b1 = 2 * A * ((A - 1) - (A + 1) * cw);
+                b2 = A * ((A + 1) - (A - 1) * cw - sqA);
+                a0 = (A + 1) + (A - 1) * cw + sqA;
+                a1 = -2 * ((A - 1) + (A + 1) * cw);
+                a2 = (A + 1) + (A - 1) * cw - sqA;
+                break;
+        case dsDSP_BIQUAD_HIGH_SHELF:
+                b0 = A * ((A + 1) + (A - 1) * cw + sqA);
+                b1 = -2 * A * ((A - 1) + (A + 1) * cw);
+                b2 = A * ((A + 1) + (A - 1) * cw - sqA);
+                a0 = (A + 1) - (A - 1) * cw + sqA;
+                a1 = 2 * ((A - 1) - (A + 1) * cw);
+                a2 = (A + 1) - (A - 1) * cw - sqA;
+                break;
+        case dsDSP_BIQUAD_LOWPASS:
+                b0 = (1 - cw) / 2;
+                b1 = 1 - cw;
+                b2 = (1 - cw) / 2;
+                a0 = 1 + alpha;
+                a1 = -2 * cw;
+                a2 = 1 - alpha;
+                break;
+        case dsDSP_BIQUAD_HIGHPASS:
+                b0 = (1 + cw) / 2;
+                b1 = -(1 + cw);
+                b2 = (1 + cw) / 2;
+                a0 = 1 + alpha;
+                a1 = -2 * cw;
+                a2 = 1 - alpha;
+                break;
+        default:
+                b0 = 1 + alpha * A;
+                b1 = -2 * cw;
+                b2 = 1 - alpha * A;
+                a0 = 1 + alpha / A;
+                a1 = -2 * cw;
+                a2 = 1 - alpha / A;
+                break;
+        }
+        biquad->m_b0 = (float)(b0 / a0);
+        biquad->m_b1 = (float)(b1 / a0);
+        biquad->m_b2 = (float)(b2 / a0);
+        biquad->m_a1 = (float)(a1 / a0);
+        biquad->m_a2 = (float)(a2 / a0);
+}
+
+void dsDspBiquadIdentity(dsDspBiquad_t *biquad)
+{
+        biquad->m_b0 = 1.0f;
+        biquad->m_b1 = biquad->m_b2 = biquad->m_a1 = biquad->m_a2 = 0.0f;
+}
+
+/*
+ * Transposed direct form II. The frame loop is outermost and runs the whole
+ * cascade per group of four channels, so the out-of-order core overlaps the
+ * sections of consecutive frames instead of stalling on one feedback loop.
+ */
+void dsDspBiquadRun(const dsDspBiquad_t *sections, uint32_t count, float *state, float *block, uint32_t frames, uint32_t stride)
+{
+        const uint32_t used = count < DS_DSP_BIQUAD_MAX ? count : DS_DSP_BIQUAD_MAX;
+        dsV4_t b0[DS_DSP_BIQUAD_MAX], b1[DS_DSP_BIQUAD_MAX], b2[DS_DSP_BIQUAD_MAX], na1[DS_DSP_BIQUAD_MAX], na2[DS_DSP_BIQUAD_MAX];
+
+        for (uint32_t n = 0; n < used; n++) {
+                const dsDspBiquad_t *bq = &sections[n];
+                b0[n] = dsV4Set(bq->m_b0);
+                b1[n] = dsV4Set(bq->m_b1);
+                b2[n] = dsV4Set(bq->m_b2);
+                na1[n] = dsV4Set(-bq->m_a1);
+                na2[n] = dsV4Set(-bq->m_a2);
+        }
+        for (uint32_t group = 0; group < stride; group += 4) {
+                dsV4_t s1[DS_DSP_BIQUAD_MAX], s2[DS_DSP_BIQUAD_MAX];
+                for (uint32_t n = 0; n < used; n++) {
+                        s1[n] = dsV4Load(state + (size_t) n * 2 * stride + group);
+                        s2[n] = dsV4Load(state + (size_t) n * 2 * stride + stride + group);
+                }
+                float *p = block + group;
+                for (uint32_t i = 0; i < frames; i++, p += stride) {
+                        dsV4_t x = dsV4Load(p);
+                        for (uint32_t n = 0; n < used; n++) {
+                                dsV4_t y = dsV4Mla(s1[n], b0[n], x);
+                                s1[n] = dsV4Mla(dsV4Mla(s2[n], b1[n], x), na1[n], y);
+                                s2[n] = dsV4Mla(dsV4Mul(b2[n], x), na2[n], y);
+                                x = y;
+                        }
+                        dsV4Store(p, x);
+                }
+                for (uint32_t n = 0; n < used; n++) {
+                        dsV4Store(state + (size_t) n * 2 * stride + group, s1[n]);
+                        dsV4Store(state + (size_t) n * 2 * stride + stride + group, s2[n]);
+                }
+        }
+}
+
+void dsDspBiquadLanesSet(dsDspBiquadLanes_t *section, uint32_t lane, const dsDspBiquad_t *biquad)
+{
+        section->m_b0[lane] = biquad->m_b0;
+        section->m_b1[lane] = biquad->m_b1;
+        section->m_b2[lane] = biquad->m_b2;
+        section->m_na1[lane] = -biquad->m_a1;
+        section->m_na2[lane] = -biquad->m_a2;
+}
+
+void dsDspBiquadRunLanes(const dsDspBiquadLanes_t *sections, uint32_t count, float *state, float *block, uint32_t frames)
+{
+        const uint32_t used = count < DS_DSP_BIQUAD_MAX ? count : DS_DSP_BIQUAD_MAX;
+        dsV4_t b0[DS_DSP_BIQUAD_MAX], b1[DS_DSP_BIQUAD_MAX], b2[DS_DSP_BIQUAD_MAX], na1[DS_DSP_BIQUAD_MAX], na2[DS_DSP_BIQUAD_MAX];
+        dsV4_t s1[DS_DSP_BIQUAD_MAX], s2[DS_DSP_BIQUAD_MAX];
+
+        for (uint32_t n = 0; n < used; n++) {
+                b0[n] = dsV4Load(sections[n].m_b0);
+                b1[n] = dsV4Load(sections[n].m_b1);
+                b2[n] = dsV4Load(sections[n].m_b2);
+                na1[n] = dsV4Load(sections[n].m_na1);
+                na2[n] = dsV4Load(sections[n].m_na2);
+                s1[n] = dsV4Load(state + n * 8);
+                s2[n] = dsV4Load(state + n * 8 + 4);
+        }
+        float *p = block;
+        for (uint32_t i = 0; i < frames; i++, p += 4) {
+                dsV4_t x = dsV4Load(p);
+                for (uint32_t n = 0; n < used; n++) {
+                        dsV4_t y = dsV4Mla(s1[n], b0[n], x);
+                        s1[n] = dsV4Mla(dsV4Mla(s2[n], b1[n], x), na1[n], y);
+                        s2[n] = dsV4Mla(dsV4Mul(b2[n], x), na2[n], y);
+                        x = y;
+                }
+                dsV4Store(p, x);
+        }
+        for (uint32_t n = 0; n < used; n++) {
+                dsV4Store(state + n * 8, s1[n]);
+                dsV4Store(state + n * 8 + 4, s2[n]);
+        }
+}
@@ -0,0 +1,76 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPBIQUAD_H
+#define __DSDSPBIQUAD_H
+
+#include <stdint.h>
+
+/*
+ * Biquad cascades over interleaved float blocks whose frames are padded to a
+ * multiple of four channels. The state holds 2 * stride floats per section.
+ */
+
+/* Longest cascade that is kept in registers; dsDspBiquadRun() runs at most this many */
+#define DS_DSP_BIQUAD_MAX 5
+
+typedef struct _dsDspBiquad_t {
+        float m_b0, m_b1, m_b2;
+        float m_a1, m_a2;       /* normalised, a0 == 1 */
+} dsDspBiquad_t;
+
+typedef enum _dsDspBiquadType_t {
+        dsDSP_BIQUAD_LOW_SHELF,
+        dsDSP_BIQUAD_PEAK,
+        dsDSP_BIQUAD_HIGH_SHELF,
+        dsDSP_BIQUAD_LOWPASS,
+        dsDSP_BIQUAD_HIGHPASS,
+} dsDspBiquadType_t;
+
+/**
+ * @brief Coefficients after the RBJ audio EQ cookbook. Gain only applies to shelves and peaks.
+ */
+void dsDspBiquadDesign(dsDspBiquad_t *biquad, dsDspBiquadType_t type, double freq, double gainDb, double q, uint32_t rate);
+
+/**
+ * @brief Run a cascade with the same coefficients on every channel.
+ */
+void dsDspBiquadRun(const dsDspBiquad_t *sections, uint32_t count, float *state, float *block, uint32_t frames, uint32_t stride);
+
+/*
+ * Cascades where each of the four lanes of a vector has its own
+ * coefficients, for running up to four different mono filters side by side
+ * over a block with four floats per frame. The state holds 8 floats per
+ * section.
+ */
+typedef struct _dsDspBiquadLanes_t {
+        float m_b0[4], m_b1[4], m_b2[4];
+        float m_na1[4], m_na2[4];       /* negated a1, a2 */
+} dsDspBiquadLanes_t;
+
+/**
+ * @brief Load one lane of a section. Unset lanes should be set to dsDspBiquadIdentity().
+ */
+void dsDspBiquadLanesSet(dsDspBiquadLanes_t *section, uint32_t lane, const dsDspBiquad_t *biquad);
+
+void dsDspBiquadIdentity(dsDspBiquad_t *biquad);
+
+void dsDspBiquadRunLanes(const dsDspBiquadLanes_t *sections, uint32_t count, float *state, float *block, uint32_t frames);
+
+#endif /* __DSDSPBIQUAD_H */
@@ -0,0 +1,178 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPCONTROL_H
+#define __DSDSPCONTROL_H
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <grp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dsSeqlock.h"
+
+/*
+ * Control block shared between the HAL and the pcm_dshal ALSA plugin.
+ *
+ * The HAL owns the block: it creates the shared memory object and is the
+ * only writer of m_params, serialising its own writers. Every plugin
+ * instance maps it and takes a seqlock snapshot of m_params at the start of
+ * a period when m_paramsLock has moved, so parameter changes never block
+ * the audio thread and land on period boundaries.
+ *
+ * In the other direction the plugins publish the loudness of what they
+ * play in m_loudness. A plugin only writes it while it holds
+ * m_loudnessWriter, so with several streams open the first one reports.
+ *
+ * m_inputs carries secondary streams from other processes to the plugin
+ * that mixes them in; the same first-stream rule applies.
+ */
+
+#define DS_DSP_SHM_NAME "/dshal_audio_dsp"
+#ifndef DS_DSP_SHM_GROUP
+#define DS_DSP_SHM_GROUP "audio"        /* clients that may map the block */
+#endif
+#define DS_DSP_CONTROL_MAGIC 0x44534450 /* "DSDP" */
+#define DS_DSP_CONTROL_VERSION 7
+
+#define DS_DSP_MAX_CHANNELS 8
+#define DS_DSP_MAX_DELAY_MS 500
+#define DS_DSP_EQ_MODES 4               /* off, open, rich, focused */
+#define DS_DSP_DIALOG_LEVELS 16         /* dsSetDialogEnhancement() range, 0 is off */
+#define DS_DSP_FADER_RANGE 32           /* dsSetFaderControl() range is -32 (main) to 32 (associated) */
+
+/* Secondary inputs mixed into the primary stream, see dsDspInput.h */
+#define DS_DSP_INPUT_SYSTEM 0           /* system sounds, TTS */
+#define DS_DSP_INPUT_ASSOCIATED 1       /* associated (audio description) audio */
+#define DS_DSP_INPUTS 2
+#define DS_DSP_INPUT_FRAMES 8192        /* per ring, power of two; 170 ms at 48 kHz */
+
+typedef struct _dsDspParams_t {
+        uint32_t m_delayMs;             /**< Lip-sync delay                      */
+        uint32_t m_delayOffsetMs;       /**< Added to m_delayMs                  */
+        uint32_t m_eqMode;              /**< Graphic EQ mode, 0 is off           */
+        uint32_t m_levellerMode;        /**< dsVolumeLeveller_t mode: off, on, auto */
+        uint32_t m_levellerLevel;       /**< 0-10                                */
+        uint32_t m_drcMode;             /**< 0 line, 1 RF                        */
+        uint32_t m_virtualizerMode;     /**< dsSurroundVirtualizer_t mode: off, on, auto */
+        uint32_t m_virtualizerBoost;    /**< 0-96                                */
+        uint32_t m_bassBoost;           /**< Bass enhancer 0-100, 0 is off       */
+        uint32_t m_dialogLevel;         /**< Dialog enhancement 0-16, 0 is off   */
+        uint32_t m_primaryCut;          /**< 100 minus the primary mixer level, 0 is unity */
+        uint32_t m_systemCut;           /**< 100 minus the system input level    */
+        uint32_t m_associatedMixing;    /**< Mix the associated audio input      */
+        int32_t m_fader;                /**< -32 main only, 0 both, 32 associated only */
+} dsDspParams_t;
+
+typedef struct _dsDspLoudness_t {
+        float m_momentary;              /**< LUFS, 400 ms window; -INFINITY if none */
+        float m_shortTerm;              /**< LUFS, 3 s window                    */
+        float m_integrated;             /**< LUFS, gated, since the stream started */
+        uint32_t m_channels;
+        uint64_t m_updatedNs;           /**< CLOCK_MONOTONIC of the last update, 0 if never */
+} dsDspLoudness_t;
+
+/*
+ * Single-producer single-consumer ring of interleaved S16 stereo frames.
+ * Positions are free-running frame counts; each side only writes its own.
+ */
+typedef struct _dsDspInputRing_t {
+        uint32_t m_rate;                /**< Producer's sample rate, 0 before the first write */
+        uint32_t m_consumer;            /**< pid of the mixing plugin, 0 if none */
+        uint32_t m_write __attribute__((aligned(64)));
+        uint32_t m_read __attribute__((aligned(64)));
+        int16_t m_samples[DS_DSP_INPUT_FRAMES * 2] __attribute__((aligned(64)));
+} dsDspInputRing_t;
+
+typedef struct _dsDspControl_t {
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint32_t m_size;                /**< sizeof(dsDspControl_t) of the creator */
+        dsSeqlock_t m_paramsLock;
+        dsDspParams_t m_params;
+        uint32_t m_loudnessWriter;      /**< pid of the publishing plugin, 0 if none */
+        dsSeqlock_t m_loudnessLock;
+        dsDspLoudness_t m_loudness;
+        dsDspInputRing_t m_inputs[DS_DSP_INPUTS];
+} dsDspControl_t;
+
+/**
+ * @brief Map the control block.
+ *
+ * @param [in] create  Create and initialise it if needed (HAL side).
+ * @return NULL if it does not exist or was created by an incompatible build.
+ */
+static inline dsDspControl_t* dsDspControlMap(bool create)
+{
+        int fd = shm_open(DS_DSP_SHM_NAME, create ? (O_RDWR | O_CREAT) : O_RDWR, 0660);
+        if (fd < 0) {
+                return NULL;
+        }
+        if (create) {
+                /* Audio clients run as other users in the audio group; don't let umask lock them out */
+                struct group *audio = getgrnam(DS_DSP_SHM_GROUP);
+                if (audio != NULL && fchown(fd, (uid_t) -1, audio->gr_gid) < 0) {
+                        audio = NULL;   /* stays in the HAL's group */
+                }
+                fchmod(fd, 0660);
+                if (ftruncate(fd, sizeof(dsDspControl_t)) < 0) {
+                        close(fd);
+                        return NULL;
+                }
+        }
+        else {
+                /* The HAL may be between shm_open() and ftruncate(); touching it now would fault */
+                struct stat st;
+                if (fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(dsDspControl_t)) {
+                        close(fd);
+                        return NULL;
+                }
+        }
+        void *addr = mmap(NULL, sizeof(dsDspControl_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+                return NULL;
+        }
+        dsDspControl_t *control = (dsDspControl_t*) addr;
+        if (create && (control->m_magic != DS_DSP_CONTROL_MAGIC ||
+                       control->m_version != DS_DSP_CONTROL_VERSION ||
+                       control->m_size != sizeof(dsDspControl_t))) {
+                memset(control, 0, sizeof(dsDspControl_t));
+                control->m_version = DS_DSP_CONTROL_VERSION;
+                control->m_size = sizeof(dsDspControl_t);
+                __atomic_store_n(&control->m_magic, DS_DSP_CONTROL_MAGIC, __ATOMIC_RELEASE);
+        }
+        if (__atomic_load_n(&control->m_magic, __ATOMIC_ACQUIRE) != DS_DSP_CONTROL_MAGIC ||
+            control->m_version != DS_DSP_CONTROL_VERSION || control->m_size != sizeof(dsDspControl_t)) {
+                munmap(addr, sizeof(dsDspControl_t));
+                return NULL;
+        }
+        return control;
+}
+
+static inline void dsDspControlUnmap(dsDspControl_t *control)
+{
+        if (control) {
+                munmap(control, sizeof(dsDspControl_t));
+        }
+}
+
+#endif /* __DSDSPCONTROL_H */
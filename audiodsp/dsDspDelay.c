@@ -0,0 +1,138 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "dsDspDelay.h"
+
+bool dsDspDelayInit(dsDspDelay_t *delay, uint32_t maxDelayFrames, uint32_t maxBlockFrames, uint32_t stride, uint32_t fadeFrames)
+{
+        uint32_t capacity = 1;
+        memset(delay, 0, sizeof(*delay));
+        while (capacity < maxDelayFrames + maxBlockFrames) {
+                capacity <<= 1;
+        }
+        if (posix_memalign((void**) &delay->m_ring, 64, (size_t) capacity * stride * sizeof(float)) != 0) {
+                delay->m_ring = NULL;
+                return false;
+        }
+        delay->m_capacity = capacity;
+        delay->m_stride = stride;
+        delay->m_maxDelay = maxDelayFrames;
+        delay->m_fadeLength = fadeFrames ? fadeFrames : 1;
+        dsDspDelayReset(delay);
+        return true;
+}
+
+void dsDspDelayFree(dsDspDelay_t *delay)
+{
+        free(delay->m_ring);
+        delay->m_ring = NULL;
+}
+
+void dsDspDelayReset(dsDspDelay_t *delay)
+{
+        delay->m_write = 0;
+        delay->m_fadeFrom = delay->m_delay;
+        delay->m_fadePos = delay->m_fadeLength;
+        delay->m_pending = delay->m_delay;
+        delay->m_primed = false;
+}
+
+void dsDspDelaySet(dsDspDelay_t *delay, uint32_t frames)
+{
+        delay->m_pending = frames < delay->m_maxDelay ? frames : delay->m_maxDelay;
+}
+
+bool dsDspDelayBypassed(const dsDspDelay_t *delay)
+{
+        return delay->m_delay == 0 && delay->m_pending == 0 && delay->m_fadePos >= delay->m_fadeLength;
+}
+
+/* Copy frames between the block and the ring, splitting where the ring wraps. */
+static void dsDspDelayCopyIn(dsDspDelay_t *delay, const float *block, uint32_t pos, uint32_t frames)
+{
+        uint32_t first = delay->m_capacity - pos;
+        first = frames < first ? frames : first;
+        memcpy(delay->m_ring + (size_t) pos * delay->m_stride, block, (size_t) first * delay->m_stride * sizeof(float));
+        memcpy(delay->m_ring, block + (size_t) first * delay->m_stride, (size_t)(frames - first) * delay->m_stride * sizeof(float));
+}
+
+static void dsDspDelayCopyOut(const dsDspDelay_t *delay, float *block, uint32_t pos, uint32_t frames)
+{
+        uint32_t first = delay->m_capacity - pos;
+        first = frames < first ? frames : first;
+        memcpy(block, delay->m_ring + (size_t) pos * delay->m_stride, (size_t) first * delay->m_stride * sizeof(float));
+        memcpy(block + (size_t) first * delay->m_stride, delay->m_ring, (size_t)(frames - first) * delay->m_stride * sizeof(float));
+}
+
+void dsDspDelayProcess(dsDspDelay_t *delay, float *block, uint32_t frames)
+{
+        const uint32_t mask = delay->m_capacity - 1;
+        const uint32_t stride = delay->m_stride;
+
+        if (delay->m_fadePos >= delay->m_fadeLength && delay->m_pending != delay->m_delay) {
+                delay->m_fadeFrom = delay->m_delay;
+                delay->m_delay = delay->m_pending;
+                delay->m_fadePos = 0;
+        }
+        if (dsDspDelayBypassed(delay)) {
+                delay->m_primed = false;
+                return;
+        }
+        if (!delay->m_primed) {
+                /* Coming out of bypass: the ring holds stale audio, start from silence */
+                memset(delay->m_ring, 0, (size_t) delay->m_capacity * stride * sizeof(float));
+                delay->m_primed = true;
+                delay->m_primePos = 0;
+        }
+
+        uint32_t start = delay->m_write;
+        dsDspDelayCopyIn(delay, block, start, frames);
+        delay->m_write = (start + frames) & mask;
+
+        /* Fade in what enters the ring first, or the delayed audio starts out of silence with a step */
+        const float step = 1.0f / delay->m_fadeLength;
+        for (uint32_t i = 0; i < frames && delay->m_primePos < delay->m_fadeLength; i++, delay->m_primePos++) {
+                float *frame = delay->m_ring + (size_t)((start + i) & mask) * stride;
+                float gain = delay->m_primePos * step;
+                for (uint32_t c = 0; c < stride; c++) {
+                        frame[c] *= gain;
+                }
+        }
+
+        if (delay->m_fadePos >= delay->m_fadeLength) {
+                dsDspDelayCopyOut(delay, block, (start - delay->m_delay) & mask, frames);
+                return;
+        }
+
+        for (uint32_t i = 0; i < frames; i++) {
+                float *out = block + (size_t) i * stride;
+                /* A zero delay side is the live input, which the prime fade-in must not touch */
+                const float *from = delay->m_fadeFrom ? delay->m_ring + (size_t)((start + i - delay->m_fadeFrom) & mask) * stride : out;
+                const float *to = delay->m_delay ? delay->m_ring + (size_t)((start + i - delay->m_delay) & mask) * stride : out;
+                float mix = delay->m_fadePos < delay->m_fadeLength ? (delay->m_fadePos + 1) * step : 1.0f;
+                for (uint32_t c = 0; c < stride; c++) {
+                        out[c] = from[c] + mix * (to[c] - from[c]);
+                }
+                if (delay->m_fadePos < delay->m_fadeLength) {
+                        delay->m_fadePos++;
+                }
+        }
+}
@@ -0,0 +1,64 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPDELAY_H
+#define __DSDSPDELAY_H
+
+#include <stdint.h>
+
+/*
+ * Delay line for lip-sync correction.
+ *
+ * Works in place on interleaved float blocks. The ring is allocated once for
+ * the largest delay plus one period; changing the delay crossfades between
+ * the old and new read positions so it never clicks. At zero delay with no
+ * fade running the block is not touched at all.
+ */
+
+typedef struct _dsDspDelay_t {
+        float *m_ring;
+        uint32_t m_capacity;    /* frames, power of two */
+        uint32_t m_stride;      /* floats per frame     */
+        uint32_t m_maxDelay;
+        uint32_t m_write;
+        uint32_t m_delay;       /* delay being faded to, or steady delay */
+        uint32_t m_fadeFrom;    /* delay being faded from */
+        uint32_t m_fadePos;     /* frames into the fade; m_fadeLength when none */
+        uint32_t m_fadeLength;
+        uint32_t m_pending;     /* requested while a fade was running */
+        bool m_primed;          /* ring holds the most recent input */
+        uint32_t m_primePos;    /* frames written since priming, for the fade-in */
+} dsDspDelay_t;
+
+bool dsDspDelayInit(dsDspDelay_t *delay, uint32_t maxDelayFrames, uint32_t maxBlockFrames, uint32_t stride, uint32_t fadeFrames);
+
+void dsDspDelayFree(dsDspDelay_t *delay);
+
+/**
+ * @brief Drop history, e.g. on stream prepare.
+ */
+void dsDspDelayReset(dsDspDelay_t *delay);
+
+void dsDspDelaySet(dsDspDelay_t *delay, uint32_t frames);
+
+bool dsDspDelayBypassed(const dsDspDelay_t *delay);
+
+void dsDspDelayProcess(dsDspDelay_t *delay, float *block, uint32_t frames);
+
+#endif /* __DSDSPDELAY_H */
@@ -0,0 +1,195 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dsDspSimd.h"
+#include "dsDspDialog.h"
+
+/* Presence EQ applied to the dialogue at the top level */
+#define DIALOG_LOW_HZ           120.0   /* low shelf: less boom masking the voice */
+#define DIALOG_LOW_DB           -2.0
+#define DIALOG_BODY_HZ          900.0
+#define DIALOG_BODY_DB          2.0
+#define DIALOG_PRESENCE_HZ      2500.0  /* consonants, intelligibility */
+#define DIALOG_PRESENCE_DB      5.0
+#define DIALOG_SIDE_CUT_DB      -4.5f   /* stereo side signal at the top level */
+#define DIALOG_BED_CUT_DB       -3.0f   /* non-centre channels at the top level */
+#define DIALOG_FRONT_LEAK       0.5f    /* share of the EQ given to dialogue mixed into the front pair */
+#define DIALOG_CENTRE           4       /* FC in ALSA channel order */
+
+/* Lanes: two equalised sources and their dry copies */
+enum { LANE_DIALOG, LANE_AUX, LANE_DIALOG_DRY, LANE_AUX_DRY };
+
+static void dsDspDialogTap(dsDspDialog_t *dialog, uint32_t lane, uint32_t a, float wa, uint32_t b, float wb)
+{
+        dialog->m_tap[lane][0] = a;
+        dialog->m_tap[lane][1] = b;
+        dialog->m_tapWeight[lane][0] = wa;
+        dialog->m_tapWeight[lane][1] = wb;
+}
+
+/* Add amount times the equalised source minus the dry one to a channel */
+static void dsDspDialogLift(dsDspDialog_t *dialog, uint32_t channel, uint32_t lane, float amount)
+{
+        dialog->m_add[lane][channel] = amount;
+        dialog->m_add[lane + 2][channel] = -amount;
+}
+
+bool dsDspDialogInit(dsDspDialog_t *dialog, uint32_t rate, uint32_t channels, uint32_t maxBlockFrames, uint32_t stride)
+{
+        dsDspBiquad_t sections[DS_DSP_DIALOG_SECTIONS], identity;
+        const float sideCut = 1.0f - powf(10.0f, DIALOG_SIDE_CUT_DB / 20.0f);
+        const float bedCut = 1.0f - powf(10.0f, DIALOG_BED_CUT_DB / 20.0f);
+        bool equalised[4] = { true, true, false, false };
+
+        memset(dialog, 0, sizeof(*dialog));
+        if (posix_memalign((void**) &dialog->m_scratch, 64, (size_t) maxBlockFrames * 4 * sizeof(float)) != 0) {
+                dialog->m_scratch = NULL;
+                return false;
+        }
+        dialog->m_channels = channels;
+        dialog->m_stride = stride;
+        dialog->m_rampFrames = DS_DSP_DIALOG_RAMP_MS * rate / 1000;
+        dialog->m_rampFrames = dialog->m_rampFrames ? dialog->m_rampFrames : 1;
+
+        /* Full-scale (level 16) mix vectors for the layout; the amount scales them */
+        if (channels == 1) {
+                dsDspDialogTap(dialog, LANE_DIALOG, 0, 1.0f, 0, 0.0f);
+                dsDspDialogTap(dialog, LANE_DIALOG_DRY, 0, 1.0f, 0, 0.0f);
+                dsDspDialogLift(dialog, 0, LANE_DIALOG, 1.0f);
+        } else if (channels <= DIALOG_CENTRE) {
+                /* Front pair mid carries the dialogue, its side the ambience */
+                dsDspDialogTap(dialog, LANE_DIALOG, 0, 0.5f, 1, 0.5f);
+                dsDspDialogTap(dialog, LANE_DIALOG_DRY, 0, 0.5f, 1, 0.5f);
+                dsDspDialogTap(dialog, LANE_AUX, 0, 0.5f, 1, -0.5f);
+                equalised[LANE_AUX] = false;
+                dsDspDialogLift(dialog, 0, LANE_DIALOG, 1.0f);
+                dsDspDialogLift(dialog, 1, LANE_DIALOG, 1.0f);
+                dialog->m_add[LANE_AUX][0] = -sideCut;
+                dialog->m_add[LANE_AUX][1] = sideCut;
+                for (uint32_t c = 2; c < channels; c++) {
+                        dialog->m_keep[c] = -bedCut;
+                }
+        } else {
+                /* Dedicated centre, plus whatever dialogue is panned into the front pair */
+                dsDspDialogTap(dialog, LANE_DIALOG, DIALOG_CENTRE, 1.0f, DIALOG_CENTRE, 0.0f);
+                dsDspDialogTap(dialog, LANE_DIALOG_DRY, DIALOG_CENTRE, 1.0f, DIALOG_CENTRE, 0.0f);
+                dsDspDialogTap(dialog, LANE_AUX, 0, 0.5f, 1, 0.5f);
+                dsDspDialogTap(dialog, LANE_AUX_DRY, 0, 0.5f, 1, 0.5f);
+                dsDspDialogLift(dialog, DIALOG_CENTRE, LANE_DIALOG, 1.0f);
+                dsDspDialogLift(dialog, 0, LANE_AUX, DIALOG_FRONT_LEAK);
+                dsDspDialogLift(dialog, 1, LANE_AUX, DIALOG_FRONT_LEAK);
+                for (uint32_t c = 0; c < channels; c++) {
+                        dialog->m_keep[c] = c == DIALOG_CENTRE ? 0.0f : -bedCut;
+                }
+        }
+
+        dsDspBiquadIdentity(&identity);
+        dsDspBiquadDesign(&sections[0], dsDSP_BIQUAD_LOW_SHELF, DIALOG_LOW_HZ, DIALOG_LOW_DB, 0.707, rate);
+        dsDspBiquadDesign(&sections[1], dsDSP_BIQUAD_PEAK, DIALOG_BODY_HZ, DIALOG_BODY_DB, 0.9, rate);
+        dsDspBiquadDesign(&sections[2], dsDSP_BIQUAD_PEAK, DIALOG_PRESENCE_HZ, DIALOG_PRESENCE_DB, 0.7, rate);
+        for (uint32_t n = 0; n < DS_DSP_DIALOG_SECTIONS; n++) {
+                for (uint32_t lane = 0; lane < 4; lane++) {
+                        dsDspBiquadLanesSet(&dialog->m_sections[n], lane, equalised[lane] ? &sections[n] : &identity);
+                }
+        }
+        dsDspDialogReset(dialog);
+        return true;
+}
+
+void dsDspDialogFree(dsDspDialog_t *dialog)
+{
+        free(dialog->m_scratch);
+        dialog->m_scratch = NULL;
+}
+
+void dsDspDialogReset(dsDspDialog_t *dialog)
+{
+        memset(dialog->m_state, 0, sizeof(dialog->m_state));
+}
+
+void dsDspDialogSet(dsDspDialog_t *dialog, uint32_t level)
+{
+        level = level < DS_DSP_DIALOG_LEVELS ? level : DS_DSP_DIALOG_LEVELS;
+        dialog->m_amountTarget = (float) level / DS_DSP_DIALOG_LEVELS;
+}
+
+bool dsDspDialogBypassed(const dsDspDialog_t *dialog)
+{
+        return dialog->m_amount == 0.0f && dialog->m_amountTarget == 0.0f;
+}
+
+void dsDspDialogProcess(dsDspDialog_t *dialog, float *block, uint32_t frames)
+{
+        const uint32_t stride = dialog->m_stride;
+        float *scratch = dialog->m_scratch;
+        dsV4_t keep[DS_DSP_MAX_CHANNELS / 4], add[4][DS_DSP_MAX_CHANNELS / 4];
+
+        if (dsDspDialogBypassed(dialog)) {
+                dialog->m_active = false;
+                return;
+        }
+        if (!dialog->m_active) {
+                /* Filter history is from before the bypass */
+                dsDspDialogReset(dialog);
+                dialog->m_active = true;
+        }
+
+        for (uint32_t i = 0; i < frames; i++) {
+                const float *frame = block + (size_t) i * stride;
+                float *lanes = scratch + (size_t) i * 4;
+                for (uint32_t lane = 0; lane < 4; lane++) {
+                        lanes[lane] = dialog->m_tapWeight[lane][0] * frame[dialog->m_tap[lane][0]] +
+                                      dialog->m_tapWeight[lane][1] * frame[dialog->m_tap[lane][1]];
+                }
+        }
+        dsDspBiquadRunLanes(dialog->m_sections, DS_DSP_DIALOG_SECTIONS, dialog->m_state, scratch, frames);
+
+        for (uint32_t g = 0; g < stride / 4; g++) {
+                keep[g] = dsV4Load(dialog->m_keep + g * 4);
+                for (uint32_t lane = 0; lane < 4; lane++) {
+                        add[lane][g] = dsV4Load(dialog->m_add[lane] + g * 4);
+                }
+        }
+        const float limit = (float) frames / dialog->m_rampFrames;
+        const float target = dialog->m_amountTarget;
+        const float amount = target > dialog->m_amount ? fminf(target, dialog->m_amount + limit) :
+                                                         fmaxf(target, dialog->m_amount - limit);
+        const float step = (amount - dialog->m_amount) / frames;
+        float a = dialog->m_amount;
+        for (uint32_t i = 0; i < frames; i++) {
+                const float *lanes = scratch + (size_t) i * 4;
+                const dsV4_t s0 = dsV4Set(lanes[0]), s1 = dsV4Set(lanes[1]);
+                const dsV4_t s2 = dsV4Set(lanes[2]), s3 = dsV4Set(lanes[3]);
+                float *frame = block + (size_t) i * stride;
+                a += step;
+                const dsV4_t va = dsV4Set(a);
+                for (uint32_t g = 0; g < stride / 4; g++) {
+                        const dsV4_t x = dsV4Load(frame + g * 4);
+                        dsV4_t mix = dsV4Mla(dsV4Mul(x, keep[g]), s0, add[0][g]);
+                        mix = dsV4Mla(mix, s1, add[1][g]);
+                        mix = dsV4Mla(mix, s2, add[2][g]);
+                        mix = dsV4Mla(mix, s3, add[3][g]);
+                        dsV4Store(frame + g * 4, dsV4Mla(x, mix, va));
+                }
+        }
+        dialog->m_amount = amount;
+}
@@ -0,0 +1,82 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPDIALOG_H
+#define __DSDSPDIALOG_H
+
+#include <stdint.h>
+#include "dsDspControl.h"
+#include "dsDspBiquad.h"
+
+/*
+ * Dialog enhancement.
+ *
+ * Dialogue sits in the centre: the mid signal of stereo, the FC channel of
+ * 5.1/7.1 (with some leaking into the front pair). That source is run
+ * through a speech-band presence EQ and the difference from the dry source
+ * is added back, while what is not centred (the side signal, or the other
+ * channels) is pulled down a little, so speech gains on the background
+ * without the overall level jumping. Adding the EQ difference rather than
+ * a band-passed copy keeps the response at full level exactly the EQ
+ * curve, with no phase dips at the band edges.
+ *
+ * Every layout reduces to up to four mono sources, two equalised and two
+ * dry, run in the lanes of one vector, and a per-frame mix
+ *
+ *      out = in + amount * (in * keep + sum of source[n] * add[n])
+ *
+ * with per-channel vectors keep and add[n] chosen for the layout at init.
+ * The amount ramps over DS_DSP_DIALOG_RAMP_MS when the level changes.
+ */
+
+#define DS_DSP_DIALOG_SECTIONS 3
+#define DS_DSP_DIALOG_RAMP_MS 20
+
+typedef struct _dsDspDialog_t {
+        uint32_t m_channels;
+        uint32_t m_stride;
+        uint32_t m_rampFrames;
+        uint32_t m_tap[4][2];           /* each source is a weighted sum of two channels */
+        float m_tapWeight[4][2];
+        dsDspBiquadLanes_t m_sections[DS_DSP_DIALOG_SECTIONS];
+        float m_state[DS_DSP_DIALOG_SECTIONS * 8];
+        float m_keep[DS_DSP_MAX_CHANNELS];
+        float m_add[4][DS_DSP_MAX_CHANNELS];
+        float *m_scratch;               /* 4 floats per frame */
+        float m_amount;
+        float m_amountTarget;
+        bool m_active;
+} dsDspDialog_t;
+
+bool dsDspDialogInit(dsDspDialog_t *dialog, uint32_t rate, uint32_t channels, uint32_t maxBlockFrames, uint32_t stride);
+
+void dsDspDialogFree(dsDspDialog_t *dialog);
+
+void dsDspDialogReset(dsDspDialog_t *dialog);
+
+/**
+ * @brief Set the level, 0 (off) to DS_DSP_DIALOG_LEVELS.
+ */
+void dsDspDialogSet(dsDspDialog_t *dialog, uint32_t level);
+
+bool dsDspDialogBypassed(const dsDspDialog_t *dialog);
+
+void dsDspDialogProcess(dsDspDialog_t *dialog, float *block, uint32_t frames);
+
+#endif /* __DSDSPDIALOG_H */
@@ -0,0 +1,167 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dsDspEnhancer.h"
+
+#define ENHANCER_SIDE_HP_HZ     150.0
+#define ENHANCER_PRESENCE_HZ    2500.0
+#define ENHANCER_PRESENCE_DB    3.0
+#define ENHANCER_SHADOW_HZ      2000.0  /* head shadow on the crosstalk path */
+#define ENHANCER_ITD_S          0.00025
+#define ENHANCER_CROSSTALK      0.35f   /* crosstalk cancellation per unit of width */
+#define ENHANCER_BASS_HZ        120.0
+#define ENHANCER_HARMONIC_LO_HZ 100.0
+#define ENHANCER_HARMONIC_HI_HZ 800.0
+#define ENHANCER_BASS_GAIN      2.0f    /* harmonic level at bass boost 100 */
+
+enum { LANE_SIDE, LANE_CROSS, LANE_UNUSED, LANE_BASS };
+
+bool dsDspEnhancerInit(dsDspEnhancer_t *enhancer, uint32_t rate, uint32_t channels, uint32_t maxBlockFrames, uint32_t stride)
+{
+        dsDspBiquad_t biquad, identity;
+
+        memset(enhancer, 0, sizeof(*enhancer));
+        if (posix_memalign((void**) &enhancer->m_scratch, 64, (size_t) maxBlockFrames * 4 * sizeof(float)) != 0) {
+                enhancer->m_scratch = NULL;
+                return false;
+        }
+        enhancer->m_channels = channels;
+        enhancer->m_stride = stride;
+        enhancer->m_itd = (uint32_t) lrint(rate * ENHANCER_ITD_S);
+        enhancer->m_itd = enhancer->m_itd < 1 ? 1 : (enhancer->m_itd < DS_DSP_ENHANCER_HISTORY ? enhancer->m_itd : DS_DSP_ENHANCER_HISTORY - 1);
+        enhancer->m_rampFrames = DS_DSP_ENHANCER_RAMP_MS * rate / 1000;
+        enhancer->m_rampFrames = enhancer->m_rampFrames ? enhancer->m_rampFrames : 1;
+
+        dsDspBiquadIdentity(&identity);
+        for (uint32_t lane = 0; lane < 4; lane++) {
+                for (uint32_t n = 0; n < 2; n++) {
+                        dsDspBiquadLanesSet(&enhancer->m_split[n], lane, &identity);
+                        dsDspBiquadLanesSet(&enhancer->m_harmonic[n], lane, &identity);
+                }
+        }
+        dsDspBiquadDesign(&biquad, dsDSP_BIQUAD_HIGHPASS, ENHANCER_SIDE_HP_HZ, 0.0, 0.707, rate);
+        dsDspBiquadLanesSet(&enhancer->m_split[0], LANE_SIDE, &biquad);
+        dsDspBiquadDesign(&biquad, dsDSP_BIQUAD_PEAK, ENHANCER_PRESENCE_HZ, ENHANCER_PRESENCE_DB, 0.7, rate);
+        dsDspBiquadLanesSet(&enhancer->m_split[1], LANE_SIDE, &biquad);
+        dsDspBiquadDesign(&biquad, dsDSP_BIQUAD_LOWPASS, ENHANCER_SHADOW_HZ, 0.0, 0.707, rate);
+        dsDspBiquadLanesSet(&enhancer->m_split[0], LANE_CROSS, &biquad);
+        /* Two Butterworth sections: a steep split so the harmonics, not the fundamentals, are boosted */
+        dsDspBiquadDesign(&biquad, dsDSP_BIQUAD_LOWPASS, ENHANCER_BASS_HZ, 0.0, 0.707, rate);
+        dsDspBiquadLanesSet(&enhancer->m_split[0], LANE_BASS, &biquad);
+        dsDspBiquadLanesSet(&enhancer->m_split[1], LANE_BASS, &biquad);
+        /* After rectification: drop DC and the fundamentals, keep the low harmonics */
+        dsDspBiquadDesign(&biquad, dsDSP_BIQUAD_HIGHPASS, ENHANCER_HARMONIC_LO_HZ, 0.0, 0.707, rate);
+        dsDspBiquadLanesSet(&enhancer->m_harmonic[0], LANE_BASS, &biquad);
+        dsDspBiquadDesign(&biquad, dsDSP_BIQUAD_LOWPASS, ENHANCER_HARMONIC_HI_HZ, 0.0, 0.707, rate);
+        dsDspBiquadLanesSet(&enhancer->m_harmonic[1], LANE_BASS, &biquad);
+        dsDspEnhancerReset(enhancer);
+        return true;
+}
+
+void dsDspEnhancerFree(dsDspEnhancer_t *enhancer)
+{
+        free(enhancer->m_scratch);
+        enhancer->m_scratch = NULL;
+}
+
+void dsDspEnhancerReset(dsDspEnhancer_t *enhancer)
+{
+        memset(enhancer->m_splitState, 0, sizeof(enhancer->m_splitState));
+        memset(enhancer->m_harmonicState, 0, sizeof(enhancer->m_harmonicState));
+        memset(enhancer->m_history, 0, sizeof(enhancer->m_history));
+        enhancer->m_historyPos = 0;
+}
+
+void dsDspEnhancerSet(dsDspEnhancer_t *enhancer, uint32_t mode, uint32_t boost, uint32_t bassBoost)
+{
+        boost = boost < 96 ? boost : 96;
+        bassBoost = bassBoost < 100 ? bassBoost : 100;
+        enhancer->m_widthTarget = (mode == 1 || mode == 2) && enhancer->m_channels == 2 ? boost / 96.0f : 0.0f;
+        enhancer->m_bassTarget = bassBoost * (ENHANCER_BASS_GAIN / 100.0f);
+}
+
+bool dsDspEnhancerBypassed(const dsDspEnhancer_t *enhancer)
+{
+        return enhancer->m_width == 0.0f && enhancer->m_widthTarget == 0.0f &&
+               enhancer->m_bass == 0.0f && enhancer->m_bassTarget == 0.0f;
+}
+
+/* Next value of a ramp after frames, moving at most a full scale of 1 per ramp length */
+static float dsDspEnhancerRamp(const dsDspEnhancer_t *enhancer, float current, float target, float scale, uint32_t frames)
+{
+        float limit = scale * frames / enhancer->m_rampFrames;
+        return target > current ? fminf(target, current + limit) : fmaxf(target, current - limit);
+}
+
+void dsDspEnhancerProcess(dsDspEnhancer_t *enhancer, float *block, uint32_t frames)
+{
+        const uint32_t stride = enhancer->m_stride;
+        const uint32_t right = enhancer->m_channels > 1 ? 1 : 0;
+        const uint32_t mask = DS_DSP_ENHANCER_HISTORY - 1;
+        float *scratch = enhancer->m_scratch;
+
+        if (dsDspEnhancerBypassed(enhancer)) {
+                enhancer->m_active = false;
+                return;
+        }
+        if (!enhancer->m_active) {
+                /* Filter history is from before the bypass */
+                dsDspEnhancerReset(enhancer);
+                enhancer->m_active = true;
+        }
+
+        for (uint32_t i = 0; i < frames; i++) {
+                const float *frame = block + (size_t) i * stride;
+                float *lanes = scratch + (size_t) i * 4;
+                lanes[LANE_SIDE] = 0.5f * (frame[0] - frame[right]);
+                lanes[LANE_CROSS] = enhancer->m_history[(enhancer->m_historyPos - enhancer->m_itd) & mask];
+                lanes[LANE_UNUSED] = 0.0f;
+                lanes[LANE_BASS] = 0.5f * (frame[0] + frame[right]);
+                enhancer->m_history[enhancer->m_historyPos++ & mask] = lanes[LANE_SIDE];
+        }
+        dsDspBiquadRunLanes(enhancer->m_split, 2, enhancer->m_splitState, scratch, frames);
+        for (uint32_t i = 0; i < frames; i++) {
+                scratch[(size_t) i * 4 + LANE_BASS] = fabsf(scratch[(size_t) i * 4 + LANE_BASS]);
+        }
+        dsDspBiquadRunLanes(enhancer->m_harmonic, 2, enhancer->m_harmonicState, scratch, frames);
+
+        const float width = dsDspEnhancerRamp(enhancer, enhancer->m_width, enhancer->m_widthTarget, 1.0f, frames);
+        const float bass = dsDspEnhancerRamp(enhancer, enhancer->m_bass, enhancer->m_bassTarget, ENHANCER_BASS_GAIN, frames);
+        const float widthStep = (width - enhancer->m_width) / frames;
+        const float bassStep = (bass - enhancer->m_bass) / frames;
+        float w = enhancer->m_width, b = enhancer->m_bass;
+        for (uint32_t i = 0; i < frames; i++) {
+                const float *lanes = scratch + (size_t) i * 4;
+                float *frame = block + (size_t) i * stride;
+                w += widthStep;
+                b += bassStep;
+                /* L - c D(R), R - c D(L) restricted to the side signal is S + c D(S) */
+                const float side = w * (lanes[LANE_SIDE] + ENHANCER_CROSSTALK * lanes[LANE_CROSS]);
+                const float harmonics = b * lanes[LANE_BASS];
+                frame[0] += side + harmonics;
+                if (right) {
+                        frame[1] += harmonics - side;
+                }
+        }
+        enhancer->m_width = width;
+        enhancer->m_bass = bass;
+}
@@ -0,0 +1,89 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPENHANCER_H
+#define __DSDSPENHANCER_H
+
+#include <stdint.h>
+#include "dsDspBiquad.h"
+
+/*
+ * Surround virtualizer and bass enhancer.
+ *
+ * The virtualizer widens stereo: the side signal is high-passed (bass stays
+ * centred), given a presence lift and added back, together with a delayed,
+ * low-passed copy that cancels some of the acoustic crosstalk between the
+ * speakers (an interaural delay plus head shadow, the cheapest useful
+ * HRTF). Cancelling on the side signal only leaves the centre (dialogue)
+ * uncoloured. It only applies to stereo streams; multichannel output has
+ * real surrounds.
+ *
+ * The bass enhancer takes the mono sum below ~120 Hz, rectifies it to
+ * generate harmonics that small speakers can reproduce, band-limits them
+ * and adds them to the front pair, so the missing fundamental is implied.
+ *
+ * The side, crosstalk and bass paths are different mono filters, so they
+ * run side by side in the lanes of one vector. Filters are
+ * designed for the stream rate at init; parameter changes ramp the mix
+ * amounts over DS_DSP_ENHANCER_RAMP_MS, so they can be applied at any
+ * period boundary without clicks.
+ */
+
+#define DS_DSP_ENHANCER_RAMP_MS 20
+#define DS_DSP_ENHANCER_HISTORY 64      /* frames, power of two; holds the interaural delay */
+
+typedef struct _dsDspEnhancer_t {
+        uint32_t m_channels;
+        uint32_t m_stride;
+        uint32_t m_itd;                 /* interaural delay, frames */
+        uint32_t m_rampFrames;
+        dsDspBiquadLanes_t m_split[2];  /* side, crosstalk, unused, bass band */
+        dsDspBiquadLanes_t m_harmonic[2];
+        float m_splitState[2 * 8];
+        float m_harmonicState[2 * 8];
+        float m_history[DS_DSP_ENHANCER_HISTORY];      /* side signal */
+        uint32_t m_historyPos;
+        float *m_scratch;               /* 4 floats per frame */
+        float m_width;                  /* current and requested mix amounts */
+        float m_widthTarget;
+        float m_bass;
+        float m_bassTarget;
+        bool m_active;
+} dsDspEnhancer_t;
+
+bool dsDspEnhancerInit(dsDspEnhancer_t *enhancer, uint32_t rate, uint32_t channels, uint32_t maxBlockFrames, uint32_t stride);
+
+void dsDspEnhancerFree(dsDspEnhancer_t *enhancer);
+
+void dsDspEnhancerReset(dsDspEnhancer_t *enhancer);
+
+/**
+ * @brief Set the amounts.
+ *
+ * @param [in] mode       dsSurroundVirtualizer_t mode: 0 off, 1 on, 2 auto
+ * @param [in] boost      Virtualizer strength 0-96
+ * @param [in] bassBoost  Bass enhancer strength 0-100, 0 is off
+ */
+void dsDspEnhancerSet(dsDspEnhancer_t *enhancer, uint32_t mode, uint32_t boost, uint32_t bassBoost);
+
+bool dsDspEnhancerBypassed(const dsDspEnhancer_t *enhancer);
+
+void dsDspEnhancerProcess(dsDspEnhancer_t *enhancer, float *block, uint32_t frames);
+
+#endif /* __DSDSPENHANCER_H */
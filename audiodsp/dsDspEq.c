@@ -0,0 +1,166 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dsDspEq.h"
+#include "dsDspSimd.h"
+
+typedef struct {
+        dsDspBiquadType_t m_type;
+        float m_freq;
+        float m_gainDb;
+        float m_q;
+} dsDspEqBand_t;
+
+static const dsDspEqBand_t _presets[DS_DSP_EQ_MODES][DS_DSP_EQ_BANDS] = {
+        /* Off */
+        {
+                { dsDSP_BIQUAD_LOW_SHELF,    100.0f,  0.0f, 0.707f },
+                { dsDSP_BIQUAD_PEAK,         400.0f,  0.0f, 1.0f },
+                { dsDSP_BIQUAD_PEAK,        2500.0f,  0.0f, 1.0f },
+                { dsDSP_BIQUAD_PEAK,        3000.0f,  0.0f, 1.0f },
+                { dsDSP_BIQUAD_HIGH_SHELF,  8000.0f,  0.0f, 0.707f },
+        },
+        /* Open: a little more air and bottom end */
+        {
+                { dsDSP_BIQUAD_LOW_SHELF,    100.0f,  3.0f, 0.707f },
+                { dsDSP_BIQUAD_PEAK,         400.0f,  0.0f, 1.0f },
+                { dsDSP_BIQUAD_PEAK,        2500.0f,  0.0f, 1.0f },
+                { dsDSP_BIQUAD_PEAK,        3000.0f,  0.0f, 1.0f },
+                { dsDSP_BIQUAD_HIGH_SHELF,  8000.0f,  2.0f, 0.707f },
+        },
+        /* Rich: fuller bass, less box, more presence */
+        {
+                { dsDSP_BIQUAD_LOW_SHELF,    100.0f,  5.0f, 0.707f },
+                { dsDSP_BIQUAD_PEAK,         400.0f, -2.0f, 1.0f },
+                { dsDSP_BIQUAD_PEAK,        2500.0f,  0.0f, 1.0f },
+                { dsDSP_BIQUAD_PEAK,        3000.0f,  2.0f, 1.0f },
+                { dsDSP_BIQUAD_HIGH_SHELF, 10000.0f,  3.0f, 0.707f },
+        },
+        /* Focused: voice band forward, lows and highs pulled back */
+        {
+                { dsDSP_BIQUAD_LOW_SHELF,    100.0f, -2.0f, 0.707f },
+                { dsDSP_BIQUAD_PEAK,         400.0f,  0.0f, 1.0f },
+                { dsDSP_BIQUAD_PEAK,        2500.0f,  4.0f, 0.8f },
+                { dsDSP_BIQUAD_PEAK,        3000.0f,  0.0f, 1.0f },
+                { dsDSP_BIQUAD_HIGH_SHELF,  8000.0f, -2.0f, 0.707f },
+        },
+};
+
+bool dsDspEqInit(dsDspEq_t *eq, uint32_t rate, uint32_t maxBlockFrames, uint32_t stride, uint32_t fadeFrames)
+{
+        const size_t stateSize = (size_t) DS_DSP_EQ_BANDS * 2 * stride * sizeof(float);
+
+        memset(eq, 0, sizeof(*eq));
+        if (posix_memalign((void**) &eq->m_state, 64, stateSize) != 0 ||
+            posix_memalign((void**) &eq->m_fadeState, 64, stateSize) != 0 ||
+            posix_memalign((void**) &eq->m_scratch, 64, (size_t) maxBlockFrames * stride * sizeof(float)) != 0) {
+                dsDspEqFree(eq);
+                return false;
+        }
+        eq->m_stride = stride;
+        eq->m_fadeLength = fadeFrames ? fadeFrames : 1;
+        for (uint32_t mode = 0; mode < DS_DSP_EQ_MODES; mode++) {
+                dsDspEqChain_t *chain = &eq->m_chain[mode];
+                for (uint32_t band = 0; band < DS_DSP_EQ_BANDS; band++) {
+                        const dsDspEqBand_t *preset = &_presets[mode][band];
+                        /* Flat bands cost cycles for nothing, and bands near Nyquist can't be realised */
+                        if (preset->m_gainDb == 0.0f || preset->m_freq >= rate * 0.45f) {
+                                continue;
+                        }
+                        dsDspBiquadDesign(&chain->m_band[chain->m_bands++], preset->m_type, preset->m_freq,
+                                          preset->m_gainDb, preset->m_q, rate);
+                }
+        }
+        dsDspEqReset(eq);
+        return true;
+}
+
+void dsDspEqFree(dsDspEq_t *eq)
+{
+        free(eq->m_state);
+        free(eq->m_fadeState);
+        free(eq->m_scratch);
+        eq->m_state = eq->m_fadeState = eq->m_scratch = NULL;
+}
+
+void dsDspEqReset(dsDspEq_t *eq)
+{
+        memset(eq->m_state, 0, (size_t) DS_DSP_EQ_BANDS * 2 * eq->m_stride * sizeof(float));
+        eq->m_mode = eq->m_pending;
+        eq->m_fadeFrom = eq->m_mode;
+        eq->m_fadePos = eq->m_fadeLength;
+}
+
+void dsDspEqSetMode(dsDspEq_t *eq, uint32_t mode)
+{
+        eq->m_pending = mode < DS_DSP_EQ_MODES ? mode : 0;
+}
+
+bool dsDspEqBypassed(const dsDspEq_t *eq)
+{
+        return eq->m_chain[eq->m_mode].m_bands == 0 && eq->m_chain[eq->m_pending].m_bands == 0 &&
+               eq->m_fadePos >= eq->m_fadeLength;
+}
+
+void dsDspEqProcess(dsDspEq_t *eq, float *block, uint32_t frames)
+{
+        const uint32_t stride = eq->m_stride;
+        const size_t stateSize = (size_t) DS_DSP_EQ_BANDS * 2 * stride * sizeof(float);
+
+        if (eq->m_fadePos >= eq->m_fadeLength && eq->m_pending != eq->m_mode) {
+                /*
+                 * The outgoing chain keeps its history. State left by other
+                 * coefficients is no valid history for the incoming chain, so
+                 * it starts from silence and the crossfade covers its warm-up.
+                 */
+                memcpy(eq->m_fadeState, eq->m_state, stateSize);
+                memset(eq->m_state, 0, stateSize);
+                eq->m_fadeFrom = eq->m_mode;
+                eq->m_mode = eq->m_pending;
+                eq->m_fadePos = 0;
+        }
+        if (dsDspEqBypassed(eq)) {
+                return;
+        }
+        if (eq->m_fadePos >= eq->m_fadeLength) {
+                dsDspBiquadRun(eq->m_chain[eq->m_mode].m_band, eq->m_chain[eq->m_mode].m_bands, eq->m_state, block, frames, stride);
+                return;
+        }
+
+        memcpy(eq->m_scratch, block, (size_t) frames * stride * sizeof(float));
+        dsDspBiquadRun(eq->m_chain[eq->m_fadeFrom].m_band, eq->m_chain[eq->m_fadeFrom].m_bands, eq->m_fadeState, eq->m_scratch, frames, stride);
+        dsDspBiquadRun(eq->m_chain[eq->m_mode].m_band, eq->m_chain[eq->m_mode].m_bands, eq->m_state, block, frames, stride);
+
+        const float step = 1.0f / eq->m_fadeLength;
+        for (uint32_t i = 0; i < frames; i++) {
+                float *out = block + (size_t) i * stride;
+                const float *from = eq->m_scratch + (size_t) i * stride;
+                const dsV4_t mix = dsV4Set(eq->m_fadePos < eq->m_fadeLength ? (eq->m_fadePos + 1) * step : 1.0f);
+                for (uint32_t c = 0; c < stride; c += 4) {
+                        dsV4_t f = dsV4Load(from + c);
+                        dsV4Store(out + c, dsV4Mla(f, mix, dsV4Sub(dsV4Load(out + c), f)));
+                }
+                if (eq->m_fadePos < eq->m_fadeLength) {
+                        eq->m_fadePos++;
+                }
+        }
+}
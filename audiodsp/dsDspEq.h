@@ -0,0 +1,75 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPEQ_H
+#define __DSDSPEQ_H
+
+#include <stdint.h>
+#include "dsDspControl.h"
+#include "dsDspBiquad.h"
+
+/*
+ * Graphic equalizer selected by dsSetGraphicEqualizerMode().
+ *
+ * Each mode is a cascade of up to DS_DSP_EQ_BANDS biquads (low shelf, three
+ * peaks, high shelf). Coefficients for every mode are computed once for the
+ * stream rate in dsDspEqInit(), so a mode change on the period path is a
+ * table switch followed by a short crossfade from the old chain. Bands at
+ * 0 dB are dropped from the cascade and mode 0 (off) leaves the block alone.
+ */
+
+#define DS_DSP_EQ_BANDS DS_DSP_BIQUAD_MAX
+
+typedef struct _dsDspEqChain_t {
+        uint32_t m_bands;
+        dsDspBiquad_t m_band[DS_DSP_EQ_BANDS];
+} dsDspEqChain_t;
+
+typedef struct _dsDspEq_t {
+        uint32_t m_stride;
+        uint32_t m_mode;
+        uint32_t m_pending;     /* requested while a fade was running */
+        uint32_t m_fadeFrom;
+        uint32_t m_fadePos;     /* frames into the fade; m_fadeLength when none */
+        uint32_t m_fadeLength;
+        dsDspEqChain_t m_chain[DS_DSP_EQ_MODES];
+        float *m_state;         /* 2 * stride floats per band, current chain */
+        float *m_fadeState;     /* same for the chain being faded out */
+        float *m_scratch;       /* one block, output of the chain being faded out */
+} dsDspEq_t;
+
+bool dsDspEqInit(dsDspEq_t *eq, uint32_t rate, uint32_t maxBlockFrames, uint32_t stride, uint32_t fadeFrames);
+
+void dsDspEqFree(dsDspEq_t *eq);
+
+/**
+ * @brief Clear the filter history, e.g. on stream prepare.
+ */
+void dsDspEqReset(dsDspEq_t *eq);
+
+/**
+ * @brief Select a mode (0 off, 1 open, 2 rich, 3 focused). Out of range selects off.
+ */
+void dsDspEqSetMode(dsDspEq_t *eq, uint32_t mode);
+
+bool dsDspEqBypassed(const dsDspEq_t *eq);
+
+void dsDspEqProcess(dsDspEq_t *eq, float *block, uint32_t frames);
+
+#endif /* __DSDSPEQ_H */
@@ -0,0 +1,83 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPINPUT_H
+#define __DSDSPINPUT_H
+
+#include <stdint.h>
+#include "dsDspControl.h"
+
+/*
+ * Producer side of the secondary inputs (system sounds, TTS, associated
+ * audio) that the pcm_dshal plugin mixes into the stream it processes.
+ *
+ * A client maps the control block with dsDspControlMap(false) and writes
+ * interleaved S16 stereo at the rate of the main stream; frames at another
+ * rate are dropped by the mixer. Writes never block: they take what fits
+ * and return the count, so the producer paces itself on the returned
+ * value or on dsDspInputQueued(). Only one producer per input.
+ */
+
+/**
+ * @brief Frames written but not yet mixed.
+ */
+static inline uint32_t dsDspInputQueued(const dsDspControl_t *control, uint32_t input)
+{
+        const dsDspInputRing_t *ring = &control->m_inputs[input];
+        return __atomic_load_n(&ring->m_write, __ATOMIC_RELAXED) - __atomic_load_n(&ring->m_read, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Whether a plugin is currently mixing the input.
+ */
+static inline bool dsDspInputConsumed(const dsDspControl_t *control, uint32_t input)
+{
+        return __atomic_load_n(&control->m_inputs[input].m_consumer, __ATOMIC_ACQUIRE) != 0;
+}
+
+/**
+ * @brief Queue stereo frames on an input.
+ *
+ * @return Frames taken, 0 when the ring is full or the input is invalid.
+ */
+static inline uint32_t dsDspInputWrite(dsDspControl_t *control, uint32_t input, uint32_t rate,
+                                       const int16_t *frames, uint32_t count)
+{
+        if (input >= DS_DSP_INPUTS || rate == 0) {
+                return 0;
+        }
+        dsDspInputRing_t *ring = &control->m_inputs[input];
+        const uint32_t write = ring->m_write;
+        const uint32_t space = DS_DSP_INPUT_FRAMES - (write - __atomic_load_n(&ring->m_read, __ATOMIC_ACQUIRE));
+        count = count < space ? count : space;
+        if (__atomic_load_n(&ring->m_rate, __ATOMIC_RELAXED) != rate) {
+                __atomic_store_n(&ring->m_rate, rate, __ATOMIC_RELEASE);
+        }
+        for (uint32_t done = 0; done < count; ) {
+                const uint32_t pos = (write + done) & (DS_DSP_INPUT_FRAMES - 1);
+                uint32_t chunk = DS_DSP_INPUT_FRAMES - pos;
+                chunk = chunk < count - done ? chunk : count - done;
+                memcpy(&ring->m_samples[pos * 2], frames + (size_t) done * 2, (size_t) chunk * 2 * sizeof(int16_t));
+                done += chunk;
+        }
+        __atomic_store_n(&ring->m_write, write + count, __ATOMIC_RELEASE);
+        return count;
+}
+
+#endif /* __DSDSPINPUT_H */
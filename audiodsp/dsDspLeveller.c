@@ -0,0 +1,218 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dsDspLeveller.h"
+#include "dsDspSimd.h"
+
+#define LEVELLER_TARGET_DB      -24.0f  /* long-term RMS the leveller steers to */
+#define LEVELLER_MAX_BOOST_DB   12.0f
+#define LEVELLER_MAX_CUT_DB     12.0f
+#define LEVELLER_INTEGRATION_S  1.0f
+#define LEVELLER_RISE_DB_S      6.0f    /* slow up so pauses in speech are not pumped */
+#define LEVELLER_FALL_DB_S      20.0f
+#define LEVELLER_GATE_MS        1e-6f   /* -60 dBFS, quieter sub-blocks don't move the estimate */
+#define LEVELLER_AUTO_LEVEL     7
+#define LEVELLER_CEILING_DB     -1.0f
+#define LEVELLER_ATTACK         0.5f    /* per sub-block, >99% within the lookahead */
+#define LEVELLER_SNAP_DB        0.01f
+
+typedef struct {
+        float m_thresholdDb;
+        float m_ratio;
+        float m_releaseS;
+} dsDspLevellerDrc_t;
+
+/* Indexed by DRC mode; line mode only applies while the leveller is on */
+static const dsDspLevellerDrc_t _drcPresets[] = {
+        { -12.0f, 2.0f, 0.25f },        /* line */
+        { -20.0f, 4.0f, 0.15f },        /* RF */
+};
+
+bool dsDspLevellerInit(dsDspLeveller_t *leveller, uint32_t rate, uint32_t channels, uint32_t maxBlockFrames,
+                       uint32_t stride, uint32_t fadeFrames)
+{
+        uint32_t subBlocks = (maxBlockFrames + DS_DSP_LEVELLER_SUBBLOCK - 1) / DS_DSP_LEVELLER_SUBBLOCK;
+
+        memset(leveller, 0, sizeof(*leveller));
+        leveller->m_gains = (float*) malloc(subBlocks * sizeof(float));
+        if (leveller->m_gains == NULL ||
+            !dsDspDelayInit(&leveller->m_lookahead, DS_DSP_LEVELLER_LOOKAHEAD, maxBlockFrames, stride, fadeFrames)) {
+                free(leveller->m_gains);
+                leveller->m_gains = NULL;
+                return false;
+        }
+        leveller->m_rate = rate;
+        leveller->m_channels = channels;
+        leveller->m_stride = stride;
+        dsDspLevellerSet(leveller, 0, 0, 0);
+        dsDspLevellerReset(leveller);
+        return true;
+}
+
+void dsDspLevellerFree(dsDspLeveller_t *leveller)
+{
+        dsDspDelayFree(&leveller->m_lookahead);
+        free(leveller->m_gains);
+        leveller->m_gains = NULL;
+}
+
+void dsDspLevellerReset(dsDspLeveller_t *leveller)
+{
+        /* Start out assuming content at the target, so a new stream is not corrected until measured */
+        leveller->m_loudnessMs = powf(10.0f, LEVELLER_TARGET_DB / 10.0f);
+        leveller->m_levelDb = 0.0f;
+        leveller->m_reductionDb = 0.0f;
+        memset(leveller->m_required, 0, sizeof(leveller->m_required));
+        leveller->m_requiredPos = 0;
+        leveller->m_gain = 1.0f;
+        dsDspDelayReset(&leveller->m_lookahead);
+}
+
+void dsDspLevellerSet(dsDspLeveller_t *leveller, uint32_t mode, uint32_t level, uint32_t drcMode)
+{
+        const uint32_t subBlock = DS_DSP_LEVELLER_SUBBLOCK;
+
+        if (mode == 2) {
+                level = LEVELLER_AUTO_LEVEL;
+        }
+        leveller->m_amount = (mode == 1 || mode == 2) && level <= 10 ? level / 10.0f : 0.0f;
+        drcMode = drcMode < sizeof(_drcPresets) / sizeof(_drcPresets[0]) ? drcMode : 0;
+        const dsDspLevellerDrc_t *drc = &_drcPresets[drcMode];
+        leveller->m_thresholdDb = drc->m_thresholdDb;
+        leveller->m_slope = (drcMode == 1 || leveller->m_amount > 0.0f) ? 1.0f - 1.0f / drc->m_ratio : 0.0f;
+        leveller->m_releaseCoef = expf(-(float) subBlock / (drc->m_releaseS * leveller->m_rate));
+        leveller->m_enabled = leveller->m_amount > 0.0f || leveller->m_slope > 0.0f;
+        dsDspDelaySet(&leveller->m_lookahead, leveller->m_enabled ? DS_DSP_LEVELLER_LOOKAHEAD : 0);
+}
+
+bool dsDspLevellerBypassed(const dsDspLeveller_t *leveller)
+{
+        return !leveller->m_enabled && leveller->m_levelDb == 0.0f && leveller->m_reductionDb == 0.0f &&
+               dsDspDelayBypassed(&leveller->m_lookahead);
+}
+
+/* Peak and mean square over the real channels of a run of frames */
+static void dsDspLevellerMeasure(const dsDspLeveller_t *leveller, const float *block, uint32_t frames, float *peak, float *ms)
+{
+        const uint32_t stride = leveller->m_stride;
+        dsV4_t peakV = dsV4Set(0.0f), sumV = dsV4Set(0.0f);
+        float lanes[4];
+
+        for (uint32_t i = 0; i < frames; i++) {
+                for (uint32_t c = 0; c < stride; c += 4) {
+                        dsV4_t x = dsV4Load(block + (size_t) i * stride + c);
+                        peakV = dsV4Max(peakV, dsV4Abs(x));
+                        sumV = dsV4Mla(sumV, x, x);
+                }
+        }
+        dsV4Store(lanes, peakV);
+        *peak = fmaxf(fmaxf(lanes[0], lanes[1]), fmaxf(lanes[2], lanes[3]));
+        dsV4Store(lanes, sumV);
+        *ms = (lanes[0] + lanes[1] + lanes[2] + lanes[3]) / ((float) frames * leveller->m_channels);
+}
+
+/* Gain for the sub-block that leaves the lookahead now, from the one that enters it */
+static float dsDspLevellerGain(dsDspLeveller_t *leveller, float peak, float ms, uint32_t frames)
+{
+        const float seconds = (float) frames / leveller->m_rate;
+        float targetDb = 0.0f;
+        float required = 0.0f;
+
+        if (leveller->m_amount > 0.0f) {
+                if (ms > LEVELLER_GATE_MS) {
+                        float coef = 1.0f - expf(-seconds / LEVELLER_INTEGRATION_S);
+                        leveller->m_loudnessMs += coef * (ms - leveller->m_loudnessMs);
+                }
+                targetDb = leveller->m_amount * (LEVELLER_TARGET_DB - 10.0f * log10f(leveller->m_loudnessMs));
+                targetDb = fminf(fmaxf(targetDb, -LEVELLER_MAX_CUT_DB), LEVELLER_MAX_BOOST_DB);
+        }
+        if (targetDb > leveller->m_levelDb) {
+                leveller->m_levelDb = fminf(targetDb, leveller->m_levelDb + LEVELLER_RISE_DB_S * seconds);
+        }
+        else {
+                leveller->m_levelDb = fmaxf(targetDb, leveller->m_levelDb - LEVELLER_FALL_DB_S * seconds);
+        }
+
+        if (leveller->m_enabled && peak > 0.0f) {
+                float peakDb = 20.0f * log10f(peak) + leveller->m_levelDb;
+                float over = peakDb - leveller->m_thresholdDb;
+                required = over > 0.0f ? over * leveller->m_slope : 0.0f;
+                required = fmaxf(required, peakDb - LEVELLER_CEILING_DB);
+        }
+        leveller->m_required[leveller->m_requiredPos] = required;
+        leveller->m_requiredPos = (leveller->m_requiredPos + 1) % (DS_DSP_LEVELLER_HOLD + 1);
+
+        /* Anything still inside the lookahead must be covered by the time it comes out */
+        float held = 0.0f;
+        for (uint32_t i = 0; i <= DS_DSP_LEVELLER_HOLD; i++) {
+                held = fmaxf(held, leveller->m_required[i]);
+        }
+        if (held > leveller->m_reductionDb) {
+                leveller->m_reductionDb += LEVELLER_ATTACK * (held - leveller->m_reductionDb);
+        }
+        else {
+                leveller->m_reductionDb = held + leveller->m_releaseCoef * (leveller->m_reductionDb - held);
+        }
+
+        if (!leveller->m_enabled) {
+                if (fabsf(leveller->m_levelDb) < LEVELLER_SNAP_DB) {
+                        leveller->m_levelDb = 0.0f;
+                }
+                if (leveller->m_reductionDb < LEVELLER_SNAP_DB) {
+                        leveller->m_reductionDb = 0.0f;
+                }
+        }
+        return powf(10.0f, (leveller->m_levelDb - leveller->m_reductionDb) / 20.0f);
+}
+
+void dsDspLevellerProcess(dsDspLeveller_t *leveller, float *block, uint32_t frames)
+{
+        const uint32_t stride = leveller->m_stride;
+        const uint32_t subBlock = DS_DSP_LEVELLER_SUBBLOCK;
+
+        if (dsDspLevellerBypassed(leveller)) {
+                return;
+        }
+        for (uint32_t start = 0, n = 0; start < frames; start += subBlock, n++) {
+                uint32_t count = frames - start < subBlock ? frames - start : subBlock;
+                float peak, ms;
+                dsDspLevellerMeasure(leveller, block + (size_t) start * stride, count, &peak, &ms);
+                leveller->m_gains[n] = dsDspLevellerGain(leveller, peak, ms, count);
+        }
+
+        dsDspDelayProcess(&leveller->m_lookahead, block, frames);
+
+        for (uint32_t start = 0, n = 0; start < frames; start += subBlock, n++) {
+                uint32_t count = frames - start < subBlock ? frames - start : subBlock;
+                float gain = leveller->m_gain;
+                const float step = (leveller->m_gains[n] - gain) / count;
+                float *p = block + (size_t) start * stride;
+                for (uint32_t i = 0; i < count; i++, p += stride) {
+                        gain += step;
+                        const dsV4_t g = dsV4Set(gain);
+                        for (uint32_t c = 0; c < stride; c += 4) {
+                                dsV4Store(p + c, dsV4Mul(dsV4Load(p + c), g));
+                        }
+                }
+                leveller->m_gain = leveller->m_gains[n];
+        }
+}
@@ -0,0 +1,82 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPLEVELLER_H
+#define __DSDSPLEVELLER_H
+
+#include <stdint.h>
+#include "dsDspDelay.h"
+
+/*
+ * Volume leveller and dynamic range control.
+ *
+ * Detection runs on the incoming block in sub-blocks of
+ * DS_DSP_LEVELLER_SUBBLOCK frames: the mean square feeds a slow, gated
+ * loudness estimate that the leveller steers towards a target level, and
+ * the peak feeds a compressor and a -1 dBFS ceiling. The audio itself goes
+ * through a DS_DSP_LEVELLER_LOOKAHEAD frame delay so gain reductions are in
+ * place before the peaks that caused them arrive. The resulting gain is
+ * interpolated across each sub-block.
+ *
+ * The leveller follows dsVolumeLeveller_t (mode 0 off, 1 on at the given
+ * level 0-10, 2 auto) and the compressor the DRC mode (0 line, 1 RF). Line
+ * mode keeps the full dynamic range and only engages with the leveller, to
+ * catch what its boost would push into the ceiling.
+ */
+
+#define DS_DSP_LEVELLER_SUBBLOCK 32
+#define DS_DSP_LEVELLER_HOLD 8
+#define DS_DSP_LEVELLER_LOOKAHEAD (DS_DSP_LEVELLER_SUBBLOCK * DS_DSP_LEVELLER_HOLD)
+
+typedef struct _dsDspLeveller_t {
+        uint32_t m_rate;
+        uint32_t m_channels;
+        uint32_t m_stride;
+        float m_amount;                 /* leveller strength 0..1, 0 is off */
+        float m_thresholdDb;            /* compressor curve for the DRC mode */
+        float m_slope;                  /* 1 - 1/ratio, 0 when not compressing */
+        float m_releaseCoef;
+        bool m_enabled;
+        float m_loudnessMs;             /* gated mean square estimate */
+        float m_levelDb;                /* leveller gain */
+        float m_reductionDb;            /* compressor and ceiling gain reduction */
+        float m_required[DS_DSP_LEVELLER_HOLD + 1];
+        uint32_t m_requiredPos;
+        float m_gain;                   /* linear gain at the end of the last sub-block */
+        float *m_gains;                 /* per sub-block of the current block */
+        dsDspDelay_t m_lookahead;
+} dsDspLeveller_t;
+
+bool dsDspLevellerInit(dsDspLeveller_t *leveller, uint32_t rate, uint32_t channels, uint32_t maxBlockFrames,
+                       uint32_t stride, uint32_t fadeFrames);
+
+void dsDspLevellerFree(dsDspLeveller_t *leveller);
+
+void dsDspLevellerReset(dsDspLeveller_t *leveller);
+
+/**
+ * @brief Select the presets. Out of range values turn the respective part off.
+ */
+void dsDspLevellerSet(dsDspLeveller_t *leveller, uint32_t mode, uint32_t level, uint32_t drcMode);
+
+bool dsDspLevellerBypassed(const dsDspLeveller_t *leveller);
+
+void dsDspLevellerProcess(dsDspLeveller_t *leveller, float *block, uint32_t frames);
+
+#endif /* __DSDSPLEVELLER_H */
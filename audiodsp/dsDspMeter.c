@@ -0,0 +1,199 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dsDspMeter.h"
+#include "dsDspSimd.h"
+
+#define METER_GATE_LUFS         -70.0f
+#define METER_RELATIVE_GATE_LU  -10.0f
+#define METER_MOMENTARY_STEPS   4
+
+/*
+ * BS.1770 pre-filter as analog prototypes, so it can be designed for any
+ * rate; at 48 kHz this reproduces the coefficients printed in the standard.
+ */
+static void dsDspMeterDesign(dsDspMeter_t *meter)
+{
+        const double rate = meter->m_rate;
+        double K, Q, a0;
+
+        /* High shelf, +4 dB above ~1.7 kHz: head diffraction */
+        const double Vh = pow(10.0, 3.999843853973347 / 20.0);
+        const double Vb = pow(Vh, 0.4996667741545416);
+        Q = 0.7071752369554196;
+        K = tan(M_PI * 1681.974450955533 / rate);
+        a0 = 1.0 + K / Q + K * K;
+        meter->m_kWeighting[0].m_b0 = (float)((Vh + Vb * K / Q + K * K) / a0);
+        meter->m_kWeighting[0].m_b1 = (float)(2.0 * (K * K - Vh) / a0);
+        meter->m_kWeighting[0].m_b2 = (float)((Vh - Vb * K / Q + K * K) / a0);
+        meter->m_kWeighting[0].m_a1 = (float)(2.0 * (K * K - 1.0) / a0);
+        meter->m_kWeighting[0].m_a2 = (float)((1.0 - K / Q + K * K) / a0);
+
+        /* RLB high-pass at ~38 Hz */
+        Q = 0.5003270373238773;
+        K = tan(M_PI * 38.13547087602444 / rate);
+        a0 = 1.0 + K / Q + K * K;
+        meter->m_kWeighting[1].m_b0 = 1.0f;
+        meter->m_kWeighting[1].m_b1 = -2.0f;
+        meter->m_kWeighting[1].m_b2 = 1.0f;
+        meter->m_kWeighting[1].m_a1 = (float)(2.0 * (K * K - 1.0) / a0);
+        meter->m_kWeighting[1].m_a2 = (float)((1.0 - K / Q + K * K) / a0);
+}
+
+static float dsDspMeterLufs(double energy)
+{
+        return energy > 0.0 ? (float)(-0.691 + 10.0 * log10(energy)) : -INFINITY;
+}
+
+bool dsDspMeterInit(dsDspMeter_t *meter, uint32_t rate, uint32_t channels, uint32_t stride)
+{
+        memset(meter, 0, sizeof(*meter));
+        if (rate < 10 || channels == 0 || channels > DS_DSP_MAX_CHANNELS || stride > DS_DSP_MAX_CHANNELS ||
+            posix_memalign((void**) &meter->m_state, 64, 2 * 2 * stride * sizeof(float)) != 0) {
+                meter->m_state = NULL;
+                return false;
+        }
+        meter->m_rate = rate;
+        meter->m_channels = channels;
+        meter->m_stride = stride;
+        meter->m_stepFrames = rate / 10;
+        /* ALSA order FL FR RL RR FC LFE SL SR: surrounds +1.5 dB, LFE not counted */
+        for (uint32_t c = 0; c < channels; c++) {
+                meter->m_weights[c] = 1.0f;
+        }
+        if (channels >= 6) {
+                meter->m_weights[2] = meter->m_weights[3] = 1.41f;
+                meter->m_weights[5] = 0.0f;
+        }
+        if (channels == 8) {
+                meter->m_weights[6] = meter->m_weights[7] = 1.41f;
+        }
+        dsDspMeterDesign(meter);
+        dsDspMeterReset(meter);
+        return true;
+}
+
+void dsDspMeterFree(dsDspMeter_t *meter)
+{
+        free(meter->m_state);
+        meter->m_state = NULL;
+}
+
+void dsDspMeterReset(dsDspMeter_t *meter)
+{
+        memset(meter->m_state, 0, 2 * 2 * meter->m_stride * sizeof(float));
+        meter->m_stepPos = 0;
+        meter->m_stepEnergy = 0.0;
+        meter->m_stepCount = 0;
+        memset(meter->m_histogram, 0, sizeof(meter->m_histogram));
+        memset(meter->m_histogramEnergy, 0, sizeof(meter->m_histogramEnergy));
+        meter->m_momentary = meter->m_shortTerm = meter->m_integrated = -INFINITY;
+}
+
+static float dsDspMeterIntegrated(const dsDspMeter_t *meter)
+{
+        double energy = 0.0;
+        uint64_t blocks = 0;
+        uint32_t bin;
+
+        for (bin = 0; bin < DS_DSP_METER_BINS; bin++) {
+                energy += meter->m_histogramEnergy[bin];
+                blocks += meter->m_histogram[bin];
+        }
+        if (blocks == 0) {
+                return -INFINITY;
+        }
+        float relativeGate = dsDspMeterLufs(energy / blocks) + METER_RELATIVE_GATE_LU;
+        int first = (int) ceilf((relativeGate - METER_GATE_LUFS) * 10.0f - 0.5f);
+        energy = 0.0;
+        blocks = 0;
+        for (bin = first > 0 ? first : 0; bin < DS_DSP_METER_BINS; bin++) {
+                energy += meter->m_histogramEnergy[bin];
+                blocks += meter->m_histogram[bin];
+        }
+        return blocks ? dsDspMeterLufs(energy / blocks) : -INFINITY;
+}
+
+static void dsDspMeterStep(dsDspMeter_t *meter)
+{
+        double energy;
+        uint32_t i;
+
+        meter->m_steps[meter->m_stepCount % DS_DSP_METER_STEPS] = meter->m_stepEnergy / meter->m_stepFrames;
+        meter->m_stepCount++;
+        meter->m_stepEnergy = 0.0;
+        meter->m_stepPos = 0;
+
+        if (meter->m_stepCount >= METER_MOMENTARY_STEPS) {
+                energy = 0.0;
+                for (i = 1; i <= METER_MOMENTARY_STEPS; i++) {
+                        energy += meter->m_steps[(meter->m_stepCount - i) % DS_DSP_METER_STEPS];
+                }
+                energy /= METER_MOMENTARY_STEPS;
+                meter->m_momentary = dsDspMeterLufs(energy);
+                if (meter->m_momentary > METER_GATE_LUFS) {
+                        int bin = (int)((meter->m_momentary - METER_GATE_LUFS) * 10.0f);
+                        bin = bin < DS_DSP_METER_BINS ? bin : DS_DSP_METER_BINS - 1;
+                        meter->m_histogram[bin]++;
+                        meter->m_histogramEnergy[bin] += energy;
+                        meter->m_integrated = dsDspMeterIntegrated(meter);
+                }
+        }
+        if (meter->m_stepCount >= DS_DSP_METER_STEPS) {
+                energy = 0.0;
+                for (i = 0; i < DS_DSP_METER_STEPS; i++) {
+                        energy += meter->m_steps[i];
+                }
+                meter->m_shortTerm = dsDspMeterLufs(energy / DS_DSP_METER_STEPS);
+        }
+}
+
+void dsDspMeterProcess(dsDspMeter_t *meter, float *block, uint32_t frames)
+{
+        const uint32_t stride = meter->m_stride;
+
+        dsDspBiquadRun(meter->m_kWeighting, 2, meter->m_state, block, frames, stride);
+
+        for (uint32_t start = 0; start < frames; ) {
+                uint32_t count = meter->m_stepFrames - meter->m_stepPos;
+                count = frames - start < count ? frames - start : count;
+                float lanes[4];
+                double sum = 0.0;
+                for (uint32_t group = 0; group < stride; group += 4) {
+                        const dsV4_t weights = dsV4Load(meter->m_weights + group);
+                        const float *p = block + (size_t) start * stride + group;
+                        dsV4_t acc = dsV4Set(0.0f);
+                        for (uint32_t i = 0; i < count; i++, p += stride) {
+                                dsV4_t x = dsV4Load(p);
+                                acc = dsV4Mla(acc, x, x);
+                        }
+                        dsV4Store(lanes, dsV4Mul(acc, weights));
+                        sum += (double) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+                }
+                meter->m_stepEnergy += sum;
+                meter->m_stepPos += count;
+                start += count;
+                if (meter->m_stepPos == meter->m_stepFrames) {
+                        dsDspMeterStep(meter);
+                }
+        }
+}
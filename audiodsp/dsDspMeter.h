@@ -0,0 +1,75 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPMETER_H
+#define __DSDSPMETER_H
+
+#include <stdint.h>
+#include "dsDspControl.h"
+#include "dsDspBiquad.h"
+
+/*
+ * EBU R128 / ITU-R BS.1770 loudness meter.
+ *
+ * Audio is K-weighted (shelf plus RLB high-pass, designed for the stream
+ * rate) and the channel-weighted energy is summed into 100 ms steps. Each
+ * step updates the momentary (400 ms) and short-term (3 s) loudness from a
+ * ring of step energies and adds the latest 400 ms block (75% overlap) to
+ * a 0.1 LU histogram, from which the gated integrated loudness is derived
+ * without keeping the blocks. All values are in LUFS, -INFINITY until
+ * there is enough audio.
+ */
+
+#define DS_DSP_METER_STEPS 30           /* 3 s of 100 ms steps */
+#define DS_DSP_METER_BINS 800           /* -70 .. +10 LUFS in 0.1 LU */
+
+typedef struct _dsDspMeter_t {
+        uint32_t m_rate;
+        uint32_t m_channels;
+        uint32_t m_stride;
+        uint32_t m_stepFrames;
+        uint32_t m_stepPos;
+        float m_weights[DS_DSP_MAX_CHANNELS];
+        dsDspBiquad_t m_kWeighting[2];
+        float *m_state;
+        double m_stepEnergy;
+        double m_steps[DS_DSP_METER_STEPS];
+        uint64_t m_stepCount;
+        uint32_t m_histogram[DS_DSP_METER_BINS];
+        double m_histogramEnergy[DS_DSP_METER_BINS];
+        float m_momentary;
+        float m_shortTerm;
+        float m_integrated;
+} dsDspMeter_t;
+
+bool dsDspMeterInit(dsDspMeter_t *meter, uint32_t rate, uint32_t channels, uint32_t stride);
+
+void dsDspMeterFree(dsDspMeter_t *meter);
+
+/**
+ * @brief Start a new measurement, e.g. for a new stream.
+ */
+void dsDspMeterReset(dsDspMeter_t *meter);
+
+/**
+ * @brief Measure a block. The block is K-weighted in place.
+ */
+void dsDspMeterProcess(dsDspMeter_t *meter, float *block, uint32_t frames);
+
+#endif /* __DSDSPMETER_H */
@@ -0,0 +1,199 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include "dsDspMeterTap.h"
+
+static uint64_t dsDspMeterTapNowNs()
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Take over m_loudnessWriter if it is free or its owner died without letting go. */
+static bool dsDspMeterTapOwn(dsDspControl_t *control)
+{
+        uint32_t self = (uint32_t) getpid();
+        uint32_t owner = __atomic_load_n(&control->m_loudnessWriter, __ATOMIC_ACQUIRE);
+
+        if (owner == self) {
+                return true;
+        }
+        if (owner != 0 && (kill((pid_t) owner, 0) == 0 || errno != ESRCH)) {
+                return false;
+        }
+        if (!__atomic_compare_exchange_n(&control->m_loudnessWriter, &owner, self, false,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return false;
+        }
+        /* A writer that died mid-update leaves the sequence odd */
+        uint32_t seq = __atomic_load_n(&control->m_loudnessLock.m_seq, __ATOMIC_RELAXED);
+        if (seq & 1) {
+                __atomic_store_n(&control->m_loudnessLock.m_seq, seq + 1, __ATOMIC_RELEASE);
+        }
+        return true;
+}
+
+static void dsDspMeterTapPublish(dsDspMeterTap_t *tap)
+{
+        dsDspControl_t *control = __atomic_load_n(&tap->m_control, __ATOMIC_ACQUIRE);
+        if (control == NULL || !dsDspMeterTapOwn(control)) {
+                return;
+        }
+        dsSeqlockWriteBegin(&control->m_loudnessLock);
+        control->m_loudness.m_momentary = tap->m_meter.m_momentary;
+        control->m_loudness.m_shortTerm = tap->m_meter.m_shortTerm;
+        control->m_loudness.m_integrated = tap->m_meter.m_integrated;
+        control->m_loudness.m_channels = tap->m_meter.m_channels;
+        control->m_loudness.m_updatedNs = dsDspMeterTapNowNs();
+        dsSeqlockWriteEnd(&control->m_loudnessLock);
+}
+
+static void* dsDspMeterTapThread(void *arg)
+{
+        dsDspMeterTap_t *tap = (dsDspMeterTap_t*) arg;
+        const uint32_t mask = tap->m_capacity - 1;
+        const uint32_t stride = tap->m_stride;
+        struct sched_param param = { 0 };
+
+        /* Only run when nothing else wants the CPU; falling behind just drops blocks */
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+        while (__atomic_load_n(&tap->m_running, __ATOMIC_ACQUIRE)) {
+                if (__atomic_exchange_n(&tap->m_resetRequested, 0, __ATOMIC_ACQ_REL)) {
+                        dsDspMeterReset(&tap->m_meter);
+                        dsDspMeterTapPublish(tap);
+                }
+                uint32_t head = __atomic_load_n(&tap->m_head, __ATOMIC_ACQUIRE);
+                uint32_t tail = tap->m_tail;
+                if (head == tail) {
+                        struct timespec ts = { 0, DS_DSP_METER_POLL_MS * 1000000L };
+                        nanosleep(&ts, NULL);
+                        continue;
+                }
+                uint64_t steps = tap->m_meter.m_stepCount;
+                while (head != tail) {
+                        uint32_t frames = head - tail;
+                        uint32_t pos = tail & mask;
+                        frames = frames < tap->m_scratchFrames ? frames : tap->m_scratchFrames;
+                        frames = frames < tap->m_capacity - pos ? frames : tap->m_capacity - pos;
+                        /* The meter filters in place; the ring belongs to the writer once released */
+                        memcpy(tap->m_scratch, tap->m_ring + (size_t) pos * stride, (size_t) frames * stride * sizeof(float));
+                        tail += frames;
+                        __atomic_store_n(&tap->m_tail, tail, __ATOMIC_RELEASE);
+                        dsDspMeterProcess(&tap->m_meter, tap->m_scratch, frames);
+                }
+                if (tap->m_meter.m_stepCount != steps) {
+                        dsDspMeterTapPublish(tap);
+                }
+        }
+        return NULL;
+}
+
+bool dsDspMeterTapStart(dsDspMeterTap_t *tap, uint32_t rate, uint32_t channels, uint32_t stride, uint32_t maxBlockFrames)
+{
+        uint32_t capacity = 1;
+
+        memset(tap, 0, sizeof(*tap));
+        /* Half a second of slack on top of a block */
+        while (capacity < rate / 2 + maxBlockFrames) {
+                capacity <<= 1;
+        }
+        tap->m_capacity = capacity;
+        tap->m_stride = stride;
+        tap->m_scratchFrames = maxBlockFrames;
+        if (!dsDspMeterInit(&tap->m_meter, rate, channels, stride)) {
+                return false;
+        }
+        if (posix_memalign((void**) &tap->m_ring, 64, (size_t) capacity * stride * sizeof(float)) != 0 ||
+            posix_memalign((void**) &tap->m_scratch, 64, (size_t) maxBlockFrames * stride * sizeof(float)) != 0) {
+                free(tap->m_ring);
+                dsDspMeterFree(&tap->m_meter);
+                return false;
+        }
+        tap->m_running = true;
+        if (pthread_create(&tap->m_thread, NULL, dsDspMeterTapThread, tap) != 0) {
+                tap->m_running = false;
+                free(tap->m_ring);
+                free(tap->m_scratch);
+                dsDspMeterFree(&tap->m_meter);
+                return false;
+        }
+        return true;
+}
+
+void dsDspMeterTapStop(dsDspMeterTap_t *tap)
+{
+        if (!tap->m_running) {
+                return;
+        }
+        __atomic_store_n(&tap->m_running, false, __ATOMIC_RELEASE);
+        pthread_join(tap->m_thread, NULL);
+        dsDspControl_t *control = tap->m_control;
+        if (control) {
+                uint32_t self = (uint32_t) getpid();
+                __atomic_compare_exchange_n(&control->m_loudnessWriter, &self, 0, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+        }
+        if (tap->m_dropped) {
+                printf("dshal: loudness meter dropped %u blocks\n", tap->m_dropped);
+        }
+        free(tap->m_ring);
+        free(tap->m_scratch);
+        tap->m_ring = tap->m_scratch = NULL;
+        dsDspMeterFree(&tap->m_meter);
+}
+
+void dsDspMeterTapAttach(dsDspMeterTap_t *tap, dsDspControl_t *control)
+{
+        __atomic_store_n(&tap->m_control, control, __ATOMIC_RELEASE);
+}
+
+void dsDspMeterTapReset(dsDspMeterTap_t *tap)
+{
+        __atomic_store_n(&tap->m_resetRequested, 1, __ATOMIC_RELEASE);
+}
+
+void dsDspMeterTapWrite(dsDspMeterTap_t *tap, const float *block, uint32_t frames)
+{
+        const uint32_t mask = tap->m_capacity - 1;
+        const uint32_t stride = tap->m_stride;
+        uint32_t head = tap->m_head;
+
+        if (!tap->m_running) {
+                return;
+        }
+        if (tap->m_capacity - (head - __atomic_load_n(&tap->m_tail, __ATOMIC_ACQUIRE)) < frames) {
+                tap->m_dropped++;
+                return;
+        }
+        uint32_t pos = head & mask;
+        uint32_t first = tap->m_capacity - pos;
+        first = frames < first ? frames : first;
+        memcpy(tap->m_ring + (size_t) pos * stride, block, (size_t) first * stride * sizeof(float));
+        memcpy(tap->m_ring, block + (size_t) first * stride, (size_t)(frames - first) * stride * sizeof(float));
+        __atomic_store_n(&tap->m_head, head + frames, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,76 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPMETERTAP_H
+#define __DSDSPMETERTAP_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "dsDspControl.h"
+#include "dsDspMeter.h"
+
+/*
+ * Feeds the output of the pipeline to a loudness meter on a SCHED_IDLE
+ * thread.
+ *
+ * The audio thread only copies each processed block into a single-producer
+ * ring (no locks, no syscalls); if the meter falls behind the block is
+ * dropped and counted. The meter thread drains the ring every
+ * DS_DSP_METER_POLL_MS and publishes the readings in the control block
+ * after every 100 ms step.
+ */
+
+#define DS_DSP_METER_POLL_MS 50
+
+typedef struct _dsDspMeterTap_t {
+        dsDspMeter_t m_meter;
+        float *m_ring;
+        uint32_t m_capacity;            /* frames, power of two */
+        uint32_t m_stride;
+        uint32_t m_head;                /* written by the audio thread */
+        uint32_t m_tail;                /* written by the meter thread */
+        uint32_t m_dropped;
+        uint32_t m_resetRequested;
+        dsDspControl_t *m_control;
+        float *m_scratch;
+        uint32_t m_scratchFrames;
+        bool m_running;
+        pthread_t m_thread;
+} dsDspMeterTap_t;
+
+bool dsDspMeterTapStart(dsDspMeterTap_t *tap, uint32_t rate, uint32_t channels, uint32_t stride, uint32_t maxBlockFrames);
+
+void dsDspMeterTapStop(dsDspMeterTap_t *tap);
+
+/**
+ * @brief Publish readings into this control block (NULL to stop). Any thread.
+ */
+void dsDspMeterTapAttach(dsDspMeterTap_t *tap, dsDspControl_t *control);
+
+/**
+ * @brief Start a new measurement. Safe from the audio thread.
+ */
+void dsDspMeterTapReset(dsDspMeterTap_t *tap);
+
+/**
+ * @brief Queue a processed block for metering. Audio thread only.
+ */
+void dsDspMeterTapWrite(dsDspMeterTap_t *tap, const float *block, uint32_t frames);
+
+#endif /* __DSDSPMETERTAP_H */
@@ -0,0 +1,217 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include "dsDspSimd.h"
+#include "dsDspInput.h"
+#include "dsDspMixer.h"
+
+/* Take over an input ring if it is free or its consumer died without letting go. */
+static bool dsDspMixerClaim(dsDspInputRing_t *ring)
+{
+        uint32_t self = (uint32_t) getpid();
+        uint32_t owner = __atomic_load_n(&ring->m_consumer, __ATOMIC_ACQUIRE);
+
+        if (owner != 0 && owner != self && (kill((pid_t) owner, 0) == 0 || errno != ESRCH)) {
+                return false;
+        }
+        if (owner != self && !__atomic_compare_exchange_n(&ring->m_consumer, &owner, self, false,
+                                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return false;
+        }
+        /* Whatever was queued while nobody mixed is stale */
+        __atomic_store_n(&ring->m_read, __atomic_load_n(&ring->m_write, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+        return true;
+}
+
+static void dsDspMixerRelease(dsDspMixer_t *mixer)
+{
+        for (uint32_t n = 0; n < DS_DSP_INPUTS; n++) {
+                if (mixer->m_owner[n]) {
+                        uint32_t self = (uint32_t) getpid();
+                        __atomic_compare_exchange_n(&mixer->m_control->m_inputs[n].m_consumer, &self, 0, false,
+                                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+                        mixer->m_owner[n] = false;
+                }
+        }
+}
+
+bool dsDspMixerInit(dsDspMixer_t *mixer, uint32_t rate, uint32_t channels, uint32_t maxBlockFrames, uint32_t stride)
+{
+        memset(mixer, 0, sizeof(*mixer));
+        mixer->m_rate = rate;
+        mixer->m_channels = channels;
+        mixer->m_stride = stride;
+        mixer->m_primaryGain = mixer->m_primaryTarget = 1.0f;
+        if (posix_memalign((void**) &mixer->m_scratch, 64, (size_t) maxBlockFrames * 4 * sizeof(float)) != 0) {
+                mixer->m_scratch = NULL;
+                return false;
+        }
+        memset(mixer->m_scratch, 0, (size_t) maxBlockFrames * 4 * sizeof(float));
+        return true;
+}
+
+void dsDspMixerFree(dsDspMixer_t *mixer)
+{
+        if (mixer->m_control) {
+                dsDspMixerRelease(mixer);
+        }
+        free(mixer->m_scratch);
+        mixer->m_scratch = NULL;
+}
+
+void dsDspMixerReset(dsDspMixer_t *mixer)
+{
+        for (uint32_t n = 0; n < DS_DSP_INPUTS; n++) {
+                if (mixer->m_owner[n]) {
+                        dsDspInputRing_t *ring = &mixer->m_control->m_inputs[n];
+                        __atomic_store_n(&ring->m_read, __atomic_load_n(&ring->m_write, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+                }
+        }
+        mixer->m_primaryGain = mixer->m_primaryTarget;
+        memcpy(mixer->m_inputGain, mixer->m_inputTarget, sizeof(mixer->m_inputGain));
+}
+
+void dsDspMixerAttach(dsDspMixer_t *mixer, dsDspControl_t *control)
+{
+        if (mixer->m_control) {
+                dsDspMixerRelease(mixer);
+        }
+        mixer->m_control = control;
+        mixer->m_claimCountdown = 0;
+        dsDspMixerUpdate(mixer);
+}
+
+void dsDspMixerSet(dsDspMixer_t *mixer, uint32_t primaryCut, uint32_t systemCut, bool associated, int32_t fader)
+{
+        const float primary = (100 - (primaryCut < 100 ? primaryCut : 100)) / 100.0f;
+        const float system = (100 - (systemCut < 100 ? systemCut : 100)) / 100.0f;
+        float main = 1.0f, description = 0.0f;
+
+        if (associated) {
+                fader = fader < -DS_DSP_FADER_RANGE ? -DS_DSP_FADER_RANGE : (fader > DS_DSP_FADER_RANGE ? DS_DSP_FADER_RANGE : fader);
+                main = fader > 0 ? (float)(DS_DSP_FADER_RANGE - fader) / DS_DSP_FADER_RANGE : 1.0f;
+                description = fader < 0 ? (float)(DS_DSP_FADER_RANGE + fader) / DS_DSP_FADER_RANGE : 1.0f;
+        }
+        /* Associated audio belongs to the programme and follows its level */
+        mixer->m_primaryTarget = primary * main;
+        mixer->m_inputTarget[DS_DSP_INPUT_SYSTEM] = system;
+        mixer->m_inputTarget[DS_DSP_INPUT_ASSOCIATED] = primary * description;
+}
+
+void dsDspMixerUpdate(dsDspMixer_t *mixer)
+{
+        if (mixer->m_control == NULL || mixer->m_claimCountdown-- > 0) {
+                return;
+        }
+        mixer->m_claimCountdown = DS_DSP_MIXER_CLAIM_PERIODS;
+        for (uint32_t n = 0; n < DS_DSP_INPUTS; n++) {
+                if (!mixer->m_owner[n]) {
+                        mixer->m_owner[n] = dsDspMixerClaim(&mixer->m_control->m_inputs[n]);
+                }
+        }
+}
+
+bool dsDspMixerBypassed(const dsDspMixer_t *mixer)
+{
+        if (mixer->m_primaryGain != 1.0f || mixer->m_primaryTarget != 1.0f) {
+                return false;
+        }
+        for (uint32_t n = 0; n < DS_DSP_INPUTS; n++) {
+                if (mixer->m_owner[n] && dsDspInputQueued(mixer->m_control, n) != 0) {
+                        return false;
+                }
+        }
+        return true;
+}
+
+/* Convert up to frames queued frames of an input into the scratch block; returns how many. */
+static uint32_t dsDspMixerTake(dsDspMixer_t *mixer, dsDspInputRing_t *ring, uint32_t frames)
+{
+        const uint32_t write = __atomic_load_n(&ring->m_write, __ATOMIC_ACQUIRE);
+        const uint32_t read = ring->m_read;
+        const uint32_t queued = write - read;
+        float *scratch = mixer->m_scratch;
+
+        if (queued > DS_DSP_INPUT_FRAMES || __atomic_load_n(&ring->m_rate, __ATOMIC_ACQUIRE) != mixer->m_rate) {
+                mixer->m_dropped += queued;
+                __atomic_store_n(&ring->m_read, write, __ATOMIC_RELEASE);
+                return 0;
+        }
+        const uint32_t count = queued < frames ? queued : frames;
+        for (uint32_t i = 0; i < count; i++) {
+                const int16_t *sample = &ring->m_samples[((read + i) & (DS_DSP_INPUT_FRAMES - 1)) * 2];
+                const float left = sample[0] * (1.0f / 32768.0f), right = sample[1] * (1.0f / 32768.0f);
+                if (mixer->m_channels == 1) {
+                        scratch[i * 4] = 0.5f * (left + right);
+                } else {
+                        scratch[i * 4] = left;
+                        scratch[i * 4 + 1] = right;
+                }
+        }
+        __atomic_store_n(&ring->m_read, read + count, __ATOMIC_RELEASE);
+        return count;
+}
+
+void dsDspMixerProcess(dsDspMixer_t *mixer, float *block, uint32_t frames)
+{
+        const uint32_t stride = mixer->m_stride;
+        bool mixed = false;
+
+        if (mixer->m_primaryGain != 1.0f || mixer->m_primaryTarget != 1.0f) {
+                const float step = (mixer->m_primaryTarget - mixer->m_primaryGain) / frames;
+                float gain = mixer->m_primaryGain;
+                for (uint32_t i = 0; i < frames; i++, gain += step) {
+                        const dsV4_t g = dsV4Set(gain);
+                        for (uint32_t c = 0; c < stride; c += 4) {
+                                float *p = block + (size_t) i * stride + c;
+                                dsV4Store(p, dsV4Mul(dsV4Load(p), g));
+                        }
+                }
+                mixer->m_primaryGain = mixer->m_primaryTarget;
+        }
+        for (uint32_t n = 0; n < DS_DSP_INPUTS; n++) {
+                if (!mixer->m_owner[n]) {
+                        continue;
+                }
+                /* Drained even when muted, so nothing stale plays once it is turned up */
+                const uint32_t count = dsDspMixerTake(mixer, &mixer->m_control->m_inputs[n], frames);
+                const float step = (mixer->m_inputTarget[n] - mixer->m_inputGain[n]) / frames;
+                float gain = mixer->m_inputGain[n];
+                if (count > 0 && (gain != 0.0f || step != 0.0f)) {
+                        const float *scratch = mixer->m_scratch;
+                        for (uint32_t i = 0; i < count; i++, gain += step) {
+                                float *p = block + (size_t) i * stride;
+                                dsV4Store(p, dsV4Mla(dsV4Load(p), dsV4Load(scratch + i * 4), dsV4Set(gain)));
+                        }
+                        mixed = true;
+                }
+                mixer->m_inputGain[n] = mixer->m_inputTarget[n];
+        }
+        if (mixed) {
+                const dsV4_t lo = dsV4Set(-1.0f), hi = dsV4Set(1.0f);
+                for (size_t i = 0; i < (size_t) frames * stride; i += 4) {
+                        dsV4Store(block + i, dsV4Min(dsV4Max(dsV4Load(block + i), lo), hi));
+                }
+        }
+}
@@ -0,0 +1,87 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPMIXER_H
+#define __DSDSPMIXER_H
+
+#include <stdint.h>
+#include "dsDspControl.h"
+
+/*
+ * Secondary input mixer, the first stage of the pipeline.
+ *
+ * Scales the primary stream by its mixer level and adds whatever the
+ * system and associated audio inputs (dsDspInput.h) have queued, each at
+ * its own gain, into the front left/right channels; a mono stream gets the
+ * average. Gains follow dsSetAudioMixerLevels() and, while associated
+ * audio mixing is on, the dsSetFaderControl() balance, and are ramped
+ * linearly across each block. After mixing the block is clamped to full
+ * scale. Inputs that fall short of a block are mixed for what they have;
+ * the stage never waits for them.
+ *
+ * The plugin that attaches first owns the rings (one consumer each);
+ * others retry every DS_DSP_MIXER_CLAIM_PERIODS periods.
+ */
+
+#define DS_DSP_MIXER_CLAIM_PERIODS 100
+
+typedef struct _dsDspMixer_t {
+        uint32_t m_rate;
+        uint32_t m_channels;
+        uint32_t m_stride;
+        float *m_scratch;               /* one input block as 4-lane frames */
+        dsDspControl_t *m_control;
+        bool m_owner[DS_DSP_INPUTS];
+        uint32_t m_claimCountdown;
+        float m_primaryGain;
+        float m_primaryTarget;
+        float m_inputGain[DS_DSP_INPUTS];
+        float m_inputTarget[DS_DSP_INPUTS];
+        uint32_t m_dropped;             /* input frames discarded for a rate mismatch */
+} dsDspMixer_t;
+
+bool dsDspMixerInit(dsDspMixer_t *mixer, uint32_t rate, uint32_t channels, uint32_t maxBlockFrames, uint32_t stride);
+
+void dsDspMixerFree(dsDspMixer_t *mixer);
+
+/**
+ * @brief Drop what the inputs have queued, e.g. on stream prepare.
+ */
+void dsDspMixerReset(dsDspMixer_t *mixer);
+
+/**
+ * @brief Mix the inputs of this control block (NULL to release them).
+ */
+void dsDspMixerAttach(dsDspMixer_t *mixer, dsDspControl_t *control);
+
+/**
+ * @brief Set the gains from the mixer parameters of dsDspParams_t.
+ */
+void dsDspMixerSet(dsDspMixer_t *mixer, uint32_t primaryCut, uint32_t systemCut, bool associated, int32_t fader);
+
+/**
+ * @brief Retry claiming inputs owned by another stream. Once per period.
+ */
+void dsDspMixerUpdate(dsDspMixer_t *mixer);
+
+bool dsDspMixerBypassed(const dsDspMixer_t *mixer);
+
+void dsDspMixerProcess(dsDspMixer_t *mixer, float *block, uint32_t frames);
+
+#endif /* __DSDSPMIXER_H */
@@ -0,0 +1,215 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dsDspPipeline.h"
+
+static void dsDspPipelineApply(dsDspPipeline_t *pipeline)
+{
+        const dsDspParams_t *params = &pipeline->m_params;
+        dsDspMixerSet(&pipeline->m_mixer, params->m_primaryCut, params->m_systemCut, params->m_associatedMixing != 0,
+                      params->m_fader);
+        dsDspEqSetMode(&pipeline->m_eq, params->m_eqMode);
+        dsDspDialogSet(&pipeline->m_dialog, params->m_dialogLevel);
+        dsDspEnhancerSet(&pipeline->m_enhancer, params->m_virtualizerMode, params->m_virtualizerBoost, params->m_bassBoost);
+        dsDspLevellerSet(&pipeline->m_leveller, params->m_levellerMode, params->m_levellerLevel, params->m_drcMode);
+        uint32_t delayMs = params->m_delayMs + params->m_delayOffsetMs;
+        delayMs = delayMs < DS_DSP_MAX_DELAY_MS ? delayMs : DS_DSP_MAX_DELAY_MS;
+        dsDspDelaySet(&pipeline->m_delay, (uint32_t)((uint64_t) delayMs * pipeline->m_rate / 1000));
+}
+
+bool dsDspPipelineInit(dsDspPipeline_t *pipeline, uint32_t rate, uint32_t channels, uint32_t maxFrames)
+{
+        memset(pipeline, 0, sizeof(*pipeline));
+        if (rate == 0 || channels == 0 || channels > DS_DSP_MAX_CHANNELS || maxFrames == 0) {
+                return false;
+        }
+        pipeline->m_rate = rate;
+        pipeline->m_channels = channels;
+        pipeline->m_stride = (channels + 3) & ~3u;
+        pipeline->m_maxFrames = maxFrames;
+        if (posix_memalign((void**) &pipeline->m_block, 64, (size_t) maxFrames * pipeline->m_stride * sizeof(float)) != 0) {
+                pipeline->m_block = NULL;
+                return false;
+        }
+        /* Padding lanes stay zero; the stages process them but they are never exported */
+        memset(pipeline->m_block, 0, (size_t) maxFrames * pipeline->m_stride * sizeof(float));
+        if (!dsDspMixerInit(&pipeline->m_mixer, rate, channels, maxFrames, pipeline->m_stride)) {
+                dsDspPipelineFree(pipeline);
+                return false;
+        }
+        if (!dsDspEqInit(&pipeline->m_eq, rate, maxFrames, pipeline->m_stride, DS_DSP_EQ_FADE_MS * rate / 1000)) {
+                dsDspPipelineFree(pipeline);
+                return false;
+        }
+        if (!dsDspDialogInit(&pipeline->m_dialog, rate, channels, maxFrames, pipeline->m_stride)) {
+                dsDspPipelineFree(pipeline);
+                return false;
+        }
+        if (!dsDspEnhancerInit(&pipeline->m_enhancer, rate, channels, maxFrames, pipeline->m_stride)) {
+                dsDspPipelineFree(pipeline);
+                return false;
+        }
+        if (!dsDspLevellerInit(&pipeline->m_leveller, rate, channels, maxFrames, pipeline->m_stride,
+                               DS_DSP_LEVELLER_FADE_MS * rate / 1000)) {
+                dsDspPipelineFree(pipeline);
+                return false;
+        }
+        if (!dsDspDelayInit(&pipeline->m_delay, (uint32_t)((uint64_t) DS_DSP_MAX_DELAY_MS * rate / 1000), maxFrames,
+                            pipeline->m_stride, DS_DSP_DELAY_FADE_MS * rate / 1000)) {
+                dsDspPipelineFree(pipeline);
+                return false;
+        }
+        dsDspPipelineApply(pipeline);
+        return true;
+}
+
+void dsDspPipelineFree(dsDspPipeline_t *pipeline)
+{
+        dsDspMixerFree(&pipeline->m_mixer);
+        dsDspEqFree(&pipeline->m_eq);
+        dsDspDialogFree(&pipeline->m_dialog);
+        dsDspEnhancerFree(&pipeline->m_enhancer);
+        dsDspLevellerFree(&pipeline->m_leveller);
+        dsDspDelayFree(&pipeline->m_delay);
+        free(pipeline->m_block);
+        pipeline->m_block = NULL;
+}
+
+void dsDspPipelineReset(dsDspPipeline_t *pipeline)
+{
+        dsDspMixerReset(&pipeline->m_mixer);
+        dsDspEqReset(&pipeline->m_eq);
+        dsDspDialogReset(&pipeline->m_dialog);
+        dsDspEnhancerReset(&pipeline->m_enhancer);
+        dsDspLevellerReset(&pipeline->m_leveller);
+        dsDspDelayReset(&pipeline->m_delay);
+}
+
+void dsDspPipelineAttach(dsDspPipeline_t *pipeline, dsDspControl_t *control)
+{
+        pipeline->m_control = control;
+        dsDspMixerAttach(&pipeline->m_mixer, control);
+        /* Odd never matches a settled sequence, so the next update takes a snapshot */
+        pipeline->m_controlSeq = 1;
+}
+
+void dsDspPipelineSetParams(dsDspPipeline_t *pipeline, const dsDspParams_t *params)
+{
+        pipeline->m_params = *params;
+        dsDspPipelineApply(pipeline);
+}
+
+void dsDspPipelineUpdate(dsDspPipeline_t *pipeline)
+{
+        dsDspControl_t *control = pipeline->m_control;
+        dsDspParams_t params;
+        uint32_t seq;
+
+        dsDspMixerUpdate(&pipeline->m_mixer);
+        if (control == NULL) {
+                return;
+        }
+        /*
+         * One attempt per period: the block is shared with other processes and a
+         * writer may stall or die mid-update, so never spin here. On a miss the
+         * previous parameters stay in effect and the next period tries again.
+         */
+        seq = __atomic_load_n(&control->m_paramsLock.m_seq, __ATOMIC_ACQUIRE);
+        if (seq == pipeline->m_controlSeq || (seq & 1)) {
+                return;
+        }
+        params = control->m_params;
+        if (dsSeqlockReadRetry(&control->m_paramsLock, seq)) {
+                return;
+        }
+        pipeline->m_params = params;
+        pipeline->m_controlSeq = seq;
+        dsDspPipelineApply(pipeline);
+}
+
+bool dsDspPipelineBypassed(const dsDspPipeline_t *pipeline)
+{
+        return dsDspMixerBypassed(&pipeline->m_mixer) && dsDspEqBypassed(&pipeline->m_eq) && dsDspDialogBypassed(&pipeline->m_dialog) &&
+               dsDspEnhancerBypassed(&pipeline->m_enhancer) &&
+               dsDspLevellerBypassed(&pipeline->m_leveller) &&
+               dsDspDelayBypassed(&pipeline->m_delay);
+}
+
+void dsDspPipelineImportS16(dsDspPipeline_t *pipeline, const int16_t *const *planes, uint32_t step, uint32_t frames)
+{
+        const uint32_t stride = pipeline->m_stride;
+        for (uint32_t c = 0; c < pipeline->m_channels; c++) {
+                const int16_t *src = planes[c];
+                float *dst = pipeline->m_block + c;
+                for (uint32_t i = 0; i < frames; i++) {
+                        dst[(size_t) i * stride] = src[(size_t) i * step] * (1.0f / 32768.0f);
+                }
+        }
+}
+
+void dsDspPipelineImportFloat(dsDspPipeline_t *pipeline, const float *const *planes, uint32_t step, uint32_t frames)
+{
+        const uint32_t stride = pipeline->m_stride;
+        for (uint32_t c = 0; c < pipeline->m_channels; c++) {
+                const float *src = planes[c];
+                float *dst = pipeline->m_block + c;
+                for (uint32_t i = 0; i < frames; i++) {
+                        dst[(size_t) i * stride] = src[(size_t) i * step];
+                }
+        }
+}
+
+void dsDspPipelineExportS16(const dsDspPipeline_t *pipeline, int16_t *const *planes, uint32_t step, uint32_t frames)
+{
+        const uint32_t stride = pipeline->m_stride;
+        for (uint32_t c = 0; c < pipeline->m_channels; c++) {
+                const float *src = pipeline->m_block + c;
+                int16_t *dst = planes[c];
+                for (uint32_t i = 0; i < frames; i++) {
+                        float value = src[(size_t) i * stride] * 32768.0f;
+                        value = value > 32767.0f ? 32767.0f : (value < -32768.0f ? -32768.0f : value);
+                        dst[(size_t) i * step] = (int16_t) lrintf(value);
+                }
+        }
+}
+
+void dsDspPipelineExportFloat(const dsDspPipeline_t *pipeline, float *const *planes, uint32_t step, uint32_t frames)
+{
+        const uint32_t stride = pipeline->m_stride;
+        for (uint32_t c = 0; c < pipeline->m_channels; c++) {
+                const float *src = pipeline->m_block + c;
+                float *dst = planes[c];
+                for (uint32_t i = 0; i < frames; i++) {
+                        dst[(size_t) i * step] = src[(size_t) i * stride];
+                }
+        }
+}
+
+void dsDspPipelineProcess(dsDspPipeline_t *pipeline, uint32_t frames)
+{
+        dsDspMixerProcess(&pipeline->m_mixer, pipeline->m_block, frames);
+        dsDspEqProcess(&pipeline->m_eq, pipeline->m_block, frames);
+        dsDspDialogProcess(&pipeline->m_dialog, pipeline->m_block, frames);
+        dsDspEnhancerProcess(&pipeline->m_enhancer, pipeline->m_block, frames);
+        dsDspLevellerProcess(&pipeline->m_leveller, pipeline->m_block, frames);
+        dsDspDelayProcess(&pipeline->m_delay, pipeline->m_block, frames);
+}
@@ -0,0 +1,106 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPPIPELINE_H
+#define __DSDSPPIPELINE_H
+
+#include <stdint.h>
+#include "dsDspControl.h"
+#include "dsDspDelay.h"
+#include "dsDspEq.h"
+#include "dsDspDialog.h"
+#include "dsDspEnhancer.h"
+#include "dsDspLeveller.h"
+#include "dsDspMixer.h"
+
+/*
+ * Output processing chain run by the pcm_dshal plugin for each period.
+ *
+ * Samples are converted to interleaved float with the frame padded to a
+ * multiple of four channels (m_stride) so SIMD kernels can work across
+ * channels, run through the stages, and converted back. All memory is
+ * allocated in dsDspPipelineInit(); the period path only reads the
+ * parameter snapshot and processes.
+ */
+
+#define DS_DSP_DELAY_FADE_MS 10
+#define DS_DSP_EQ_FADE_MS 20
+#define DS_DSP_LEVELLER_FADE_MS 10
+
+typedef struct _dsDspPipeline_t {
+        uint32_t m_rate;
+        uint32_t m_channels;
+        uint32_t m_stride;
+        uint32_t m_maxFrames;
+        float *m_block;
+        dsDspControl_t *m_control;      /* NULL when the HAL has not published one */
+        uint32_t m_controlSeq;
+        dsDspParams_t m_params;
+        dsDspMixer_t m_mixer;
+        dsDspEq_t m_eq;
+        dsDspDialog_t m_dialog;
+        dsDspEnhancer_t m_enhancer;
+        dsDspLeveller_t m_leveller;
+        dsDspDelay_t m_delay;
+} dsDspPipeline_t;
+
+bool dsDspPipelineInit(dsDspPipeline_t *pipeline, uint32_t rate, uint32_t channels, uint32_t maxFrames);
+
+void dsDspPipelineFree(dsDspPipeline_t *pipeline);
+
+void dsDspPipelineReset(dsDspPipeline_t *pipeline);
+
+/**
+ * @brief Follow parameters published in a control block (NULL to stop).
+ */
+void dsDspPipelineAttach(dsDspPipeline_t *pipeline, dsDspControl_t *control);
+
+/**
+ * @brief Apply parameters directly, for tools that run without the HAL.
+ */
+void dsDspPipelineSetParams(dsDspPipeline_t *pipeline, const dsDspParams_t *params);
+
+/**
+ * @brief Pick up new parameters from the control block, if any. Call once per period.
+ */
+void dsDspPipelineUpdate(dsDspPipeline_t *pipeline);
+
+/**
+ * @brief True when processing would leave the samples unchanged.
+ */
+bool dsDspPipelineBypassed(const dsDspPipeline_t *pipeline);
+
+/**
+ * @brief Load frames (at most m_maxFrames) into the work block.
+ *
+ * @param [in] planes  Per-channel sample pointers.
+ * @param [in] step    Distance between consecutive samples of a channel, in samples.
+ */
+void dsDspPipelineImportS16(dsDspPipeline_t *pipeline, const int16_t *const *planes, uint32_t step, uint32_t frames);
+void dsDspPipelineImportFloat(dsDspPipeline_t *pipeline, const float *const *planes, uint32_t step, uint32_t frames);
+
+void dsDspPipelineExportS16(const dsDspPipeline_t *pipeline, int16_t *const *planes, uint32_t step, uint32_t frames);
+void dsDspPipelineExportFloat(const dsDspPipeline_t *pipeline, float *const *planes, uint32_t step, uint32_t frames);
+
+/**
+ * @brief Run all stages over the work block.
+ */
+void dsDspPipelineProcess(dsDspPipeline_t *pipeline, uint32_t frames);
+
+#endif /* __DSDSPPIPELINE_H */
@@ -0,0 +1,76 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSDSPSIMD_H
+#define __DSDSPSIMD_H
+
+/*
+ * Four-lane float vectors for the DSP kernels: NEON on ARM, SSE on x86 and
+ * plain structs elsewhere. Frames in the pipeline are padded to a multiple
+ * of four channels, so one vector is four channels of one frame.
+ */
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DS_DSP_SIMD "NEON"
+typedef float32x4_t dsV4_t;
+static inline dsV4_t dsV4Load(const float *p) { return vld1q_f32(p); }
+static inline void dsV4Store(float *p, dsV4_t v) { vst1q_f32(p, v); }
+static inline dsV4_t dsV4Set(float x) { return vdupq_n_f32(x); }
+static inline dsV4_t dsV4Add(dsV4_t a, dsV4_t b) { return vaddq_f32(a, b); }
+static inline dsV4_t dsV4Sub(dsV4_t a, dsV4_t b) { return vsubq_f32(a, b); }
+static inline dsV4_t dsV4Mul(dsV4_t a, dsV4_t b) { return vmulq_f32(a, b); }
+/* a + b * c */
+static inline dsV4_t dsV4Mla(dsV4_t a, dsV4_t b, dsV4_t c) { return vmlaq_f32(a, b, c); }
+static inline dsV4_t dsV4Max(dsV4_t a, dsV4_t b) { return vmaxq_f32(a, b); }
+static inline dsV4_t dsV4Min(dsV4_t a, dsV4_t b) { return vminq_f32(a, b); }
+static inline dsV4_t dsV4Abs(dsV4_t a) { return vabsq_f32(a); }
+#elif defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#define DS_DSP_SIMD "SSE"
+typedef __m128 dsV4_t;
+static inline dsV4_t dsV4Load(const float *p) { return _mm_loadu_ps(p); }
+static inline void dsV4Store(float *p, dsV4_t v) { _mm_storeu_ps(p, v); }
+static inline dsV4_t dsV4Set(float x) { return _mm_set1_ps(x); }
+static inline dsV4_t dsV4Add(dsV4_t a, dsV4_t b) { return _mm_add_ps(a, b); }
+static inline dsV4_t dsV4Sub(dsV4_t a, dsV4_t b) { return _mm_sub_ps(a, b); }
+static inline dsV4_t dsV4Mul(dsV4_t a, dsV4_t b) { return _mm_mul_ps(a, b); }
+static inline dsV4_t dsV4Mla(dsV4_t a, dsV4_t b, dsV4_t c) { return _mm_add_ps(a, _mm_mul_ps(b, c)); }
+static inline dsV4_t dsV4Max(dsV4_t a, dsV4_t b) { return _mm_max_ps(a, b); }
+static inline dsV4_t dsV4Min(dsV4_t a, dsV4_t b) { return _mm_min_ps(a, b); }
+static inline dsV4_t dsV4Abs(dsV4_t a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+#else
+#define DS_DSP_SIMD "scalar"
+typedef struct { float v[4]; } dsV4_t;
+static inline dsV4_t dsV4Load(const float *p) { dsV4_t r = {{ p[0], p[1], p[2], p[3] }}; return r; }
+static inline void dsV4Store(float *p, dsV4_t v) { p[0] = v.v[0]; p[1] = v.v[1]; p[2] = v.v[2]; p[3] = v.v[3]; }
+static inline dsV4_t dsV4Set(float x) { dsV4_t r = {{ x, x, x, x }}; return r; }
+#define DS_V4_OP(name, expr) \
+static inline dsV4_t name(dsV4_t a, dsV4_t b) { dsV4_t r; for (int i = 0; i < 4; i++) { float x = a.v[i], y = b.v[i]; r.v[i] = (expr); } return r; }
+DS_V4_OP(dsV4Add, x + y)
+DS_V4_OP(dsV4Sub, x - y)
+DS_V4_OP(dsV4Mul, x * y)
+DS_V4_OP(dsV4Max, x > y ? x : y)
+DS_V4_OP(dsV4Min, x < y ? x : y)
+#undef DS_V4_OP
+static inline dsV4_t dsV4Mla(dsV4_t a, dsV4_t b, dsV4_t c) { return dsV4Add(a, dsV4Mul(b, c)); }
+static inline dsV4_t dsV4Abs(dsV4_t a) { dsV4_t r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] < 0 ? -a.v[i] : a.v[i]; return r; }
+#endif
+
+#endif /* __DSDSPSIMD_H */
@@ -0,0 +1,264 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * pcm_dshal: ALSA external filter plugin that runs the HAL's output DSP
+ * (audiodsp/dsDspPipeline.c) in front of the HDMI PCM. Parameters come from
+ * the control block the HAL publishes (dsDspControl.h); without it the
+ * plugin passes audio straight through. See audiodsp/asound.conf.example.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <alsa/asoundlib.h>
+#include <alsa/pcm_external.h>
+#include "dsDspPipeline.h"
+#include "dsDspMeterTap.h"
+
+/* Periods between attempts to map the control block while the HAL is not up */
+#define DSHAL_CONTROL_RETRY_PERIODS 256
+#define DSHAL_MIN_BLOCK_FRAMES 1024
+
+typedef struct _dsPcmDshal_t {
+        snd_pcm_extplug_t m_ext;
+        dsDspPipeline_t m_pipeline;
+        bool m_ready;
+        bool m_meterEnabled;            /* "meter" config field, default on */
+        bool m_metering;
+        dsDspMeterTap_t m_meter;
+        dsDspControl_t *m_control;
+        uint32_t m_controlRetry;
+} dsPcmDshal_t;
+
+static void dshal_attach_control(dsPcmDshal_t *dshal)
+{
+        if (dshal->m_control == NULL) {
+                dshal->m_control = dsDspControlMap(false);
+        }
+        if (dshal->m_ready) {
+                dsDspPipelineAttach(&dshal->m_pipeline, dshal->m_control);
+        }
+        if (dshal->m_metering) {
+                dsDspMeterTapAttach(&dshal->m_meter, dshal->m_control);
+        }
+        dshal->m_controlRetry = 0;
+}
+
+static snd_pcm_sframes_t dshal_transfer(snd_pcm_extplug_t *ext,
+                                        const snd_pcm_channel_area_t *dst_areas, snd_pcm_uframes_t dst_offset,
+                                        const snd_pcm_channel_area_t *src_areas, snd_pcm_uframes_t src_offset,
+                                        snd_pcm_uframes_t size)
+{
+        dsPcmDshal_t *dshal = (dsPcmDshal_t*) ext->private_data;
+        dsDspPipeline_t *pipeline = &dshal->m_pipeline;
+
+        if (!dshal->m_ready) {
+                snd_pcm_areas_copy(dst_areas, dst_offset, src_areas, src_offset, ext->channels, size, ext->format);
+                return size;
+        }
+        if (dshal->m_control == NULL && ++dshal->m_controlRetry >= DSHAL_CONTROL_RETRY_PERIODS) {
+                dshal_attach_control(dshal);
+        }
+        dsDspPipelineUpdate(pipeline);
+
+        /* extplug calls again for the remainder */
+        if (size > pipeline->m_maxFrames) {
+                size = pipeline->m_maxFrames;
+        }
+        const bool bypassed = dsDspPipelineBypassed(pipeline);
+        if (bypassed && !dshal->m_metering) {
+                snd_pcm_areas_copy(dst_areas, dst_offset, src_areas, src_offset, ext->channels, size, ext->format);
+                return size;
+        }
+
+        const unsigned int bits = (ext->format == SND_PCM_FORMAT_S16_LE) ? 16 : 32;
+        const void *src[DS_DSP_MAX_CHANNELS];
+        void *dst[DS_DSP_MAX_CHANNELS];
+        unsigned int srcStep = src_areas[0].step / bits;
+        unsigned int dstStep = dst_areas[0].step / bits;
+        for (unsigned int c = 0; c < ext->channels; c++) {
+                src[c] = (const char*) src_areas[c].addr + (src_areas[c].first + src_offset * src_areas[c].step) / 8;
+                dst[c] = (char*) dst_areas[c].addr + (dst_areas[c].first + dst_offset * dst_areas[c].step) / 8;
+        }
+
+        /* When bypassed the block is only loaded for the meter; the output is a plain copy */
+        if (ext->format == SND_PCM_FORMAT_S16_LE) {
+                dsDspPipelineImportS16(pipeline, (const int16_t *const *) src, srcStep, size);
+        }
+        else {
+                dsDspPipelineImportFloat(pipeline, (const float *const *) src, srcStep, size);
+        }
+        if (!bypassed) {
+                dsDspPipelineProcess(pipeline, size);
+        }
+        if (dshal->m_metering) {
+                dsDspMeterTapWrite(&dshal->m_meter, pipeline->m_block, size);
+        }
+        if (bypassed) {
+                snd_pcm_areas_copy(dst_areas, dst_offset, src_areas, src_offset, ext->channels, size, ext->format);
+        }
+        else if (ext->format == SND_PCM_FORMAT_S16_LE) {
+                dsDspPipelineExportS16(pipeline, (int16_t *const *) dst, dstStep, size);
+        }
+        else {
+                dsDspPipelineExportFloat(pipeline, (float *const *) dst, dstStep, size);
+        }
+        return size;
+}
+
+static int dshal_hw_free(snd_pcm_extplug_t *ext)
+{
+        dsPcmDshal_t *dshal = (dsPcmDshal_t*) ext->private_data;
+        if (dshal->m_metering) {
+                dsDspMeterTapStop(&dshal->m_meter);
+                dshal->m_metering = false;
+        }
+        if (dshal->m_ready) {
+                dsDspPipelineFree(&dshal->m_pipeline);
+                dshal->m_ready = false;
+        }
+        return 0;
+}
+
+static int dshal_hw_params(snd_pcm_extplug_t *ext, snd_pcm_hw_params_t *params)
+{
+        dsPcmDshal_t *dshal = (dsPcmDshal_t*) ext->private_data;
+        snd_pcm_uframes_t period = 0;
+
+        dshal_hw_free(ext);
+        snd_pcm_hw_params_get_period_size(params, &period, NULL);
+        if (period < DSHAL_MIN_BLOCK_FRAMES) {
+                period = DSHAL_MIN_BLOCK_FRAMES;
+        }
+        if (!dsDspPipelineInit(&dshal->m_pipeline, ext->rate, ext->channels, period)) {
+                SNDERR("dshal: cannot set up processing for %u Hz, %u channels", ext->rate, ext->channels);
+                return -ENOMEM;
+        }
+        dshal->m_ready = true;
+        if (dshal->m_meterEnabled) {
+                dshal->m_metering = dsDspMeterTapStart(&dshal->m_meter, ext->rate, ext->channels,
+                                                       dshal->m_pipeline.m_stride, period);
+                if (!dshal->m_metering) {
+                        SNDERR("dshal: cannot start the loudness meter, continuing without");
+                }
+        }
+        dshal_attach_control(dshal);
+        return 0;
+}
+
+static int dshal_init(snd_pcm_extplug_t *ext)
+{
+        dsPcmDshal_t *dshal = (dsPcmDshal_t*) ext->private_data;
+        if (dshal->m_ready) {
+                dsDspPipelineReset(&dshal->m_pipeline);
+        }
+        if (dshal->m_metering) {
+                dsDspMeterTapReset(&dshal->m_meter);
+        }
+        return 0;
+}
+
+static int dshal_close(snd_pcm_extplug_t *ext)
+{
+        dsPcmDshal_t *dshal = (dsPcmDshal_t*) ext->private_data;
+        dshal_hw_free(ext);
+        dsDspControlUnmap(dshal->m_control);
+        free(dshal);
+        return 0;
+}
+
+static const snd_pcm_extplug_callback_t dshal_callback = {
+        .transfer = dshal_transfer,
+        .close = dshal_close,
+        .hw_params = dshal_hw_params,
+        .hw_free = dshal_hw_free,
+        .init = dshal_init,
+};
+
+extern "C" {
+
+SND_PCM_PLUGIN_DEFINE_FUNC(dshal)
+{
+        snd_config_iterator_t i, next;
+        snd_config_t *slave = NULL;
+        dsPcmDshal_t *dshal;
+        int meter = 1;
+        int err;
+
+        snd_config_for_each(i, next, conf) {
+                snd_config_t *n = snd_config_iterator_entry(i);
+                const char *id;
+                if (snd_config_get_id(n, &id) < 0) {
+                        continue;
+                }
+                if (strcmp(id, "comment") == 0 || strcmp(id, "type") == 0 || strcmp(id, "hint") == 0) {
+                        continue;
+                }
+                if (strcmp(id, "slave") == 0) {
+                        slave = n;
+                        continue;
+                }
+                if (strcmp(id, "meter") == 0) {
+                        meter = snd_config_get_bool(n);
+                        if (meter < 0) {
+                                SNDERR("Invalid value for %s", id);
+                                return -EINVAL;
+                        }
+                        continue;
+                }
+                SNDERR("Unknown field %s", id);
+                return -EINVAL;
+        }
+        if (slave == NULL) {
+                SNDERR("No slave defined for dshal");
+                return -EINVAL;
+        }
+
+        dshal = (dsPcmDshal_t*) calloc(1, sizeof(dsPcmDshal_t));
+        if (dshal == NULL) {
+                return -ENOMEM;
+        }
+        dshal->m_ext.version = SND_PCM_EXTPLUG_VERSION;
+        dshal->m_ext.name = "RDK DS HAL output processing";
+        dshal->m_ext.callback = &dshal_callback;
+        dshal->m_ext.private_data = dshal;
+        dshal->m_meterEnabled = meter != 0;
+
+        err = snd_pcm_extplug_create(&dshal->m_ext, name, root, slave, stream, mode);
+        if (err < 0) {
+                free(dshal);
+                return err;
+        }
+
+        static const unsigned int formats[] = { SND_PCM_FORMAT_S16_LE, SND_PCM_FORMAT_FLOAT_LE };
+        snd_pcm_extplug_set_param_list(&dshal->m_ext, SND_PCM_EXTPLUG_HW_FORMAT, 2, formats);
+        snd_pcm_extplug_set_slave_param_list(&dshal->m_ext, SND_PCM_EXTPLUG_HW_FORMAT, 2, formats);
+        snd_pcm_extplug_set_param_link(&dshal->m_ext, SND_PCM_EXTPLUG_HW_FORMAT, 1);
+        snd_pcm_extplug_set_param_minmax(&dshal->m_ext, SND_PCM_EXTPLUG_HW_CHANNELS, 1, DS_DSP_MAX_CHANNELS);
+        snd_pcm_extplug_set_param_link(&dshal->m_ext, SND_PCM_EXTPLUG_HW_CHANNELS, 1);
+
+        *pcmp = dshal->m_ext.pcm;
+        return 0;
+}
+
+SND_PCM_PLUGIN_SYMBOL(dshal);
+
+}
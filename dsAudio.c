@@ -21,19 +21,21 @@
 #include "dsAudio.h"
 #include <stdint.h>
 #include <math.h>
+#include <string.h>
 #include "dsError.h"
 #include "dsUtl.h"
 #include "dshalUtils.h"
-#include <alsa/asoundlib.h>
+#include "dsAudioMixer.h"
+#include "dsAudioRamp.h"
+#include "dsAudioGainTable.h"
+#include "dsAudioCmdQueue.h"
+#include "dsAudioDucking.h"
+#include "dsAudioDsp.h"
+#include "dsAudioIec61937.h"
+#include "dsAudioSinkCaps.h"
+#include "dsAudioEvents.h"
+#include "dsAudioState.h"
 
-#define ALSA_CARD_NAME "hw:0"
-#if (SND_LIB_MAJOR >= 1) && (SND_LIB_MINOR >= 2)
-#define ALSA_ELEMENT_NAME "HDMI"
-#else
-#define ALSA_ELEMENT_NAME "PCM"
-#endif
-
-#define MAX_LINEAR_DB_SCALE 24
 
 typedef struct _AOPHandle_t {
         dsAudioPortType_t m_vType;
@@ -44,13 +46,9 @@ typedef struct _AOPHandle_t {
 
 static AOPHandle_t _handles[dsAUDIOPORT_TYPE_MAX][2] = {
 };
-float dBmin;
-float dBmax;
-static dsAudioEncoding_t _encoding = dsAUDIO_ENC_PCM;
-static bool  _isms11Enabled = false;
-static dsAudioStereoMode_t _stereoModeHDMI = dsAUDIO_STEREO_STEREO;
 
 static void dsGetdBRange();
+static dsError_t dsAudioApplyCommand(const dsAudioCmd_t *cmd);
 
 bool dsIsValidHandle(intptr_t uHandle)
 {
@@ -65,52 +63,9 @@ bool dsIsValidHandle(intptr_t uHandle)
     return retValue;
 }
 
-static int8_t initAlsa(const char *selemname, const char *s_card, snd_mixer_elem_t **element)
+static dsAudioPortType_t dsGetPortType(intptr_t handle)
 {
-        int ret = 0;
-        snd_mixer_t *smixer = NULL;
-        snd_mixer_selem_id_t *sid;
-
-        if ((ret = snd_mixer_open(&smixer, 0)) < 0) {
-                printf("Cannot open sound mixer %s", snd_strerror(ret));
-                snd_mixer_close(smixer);
-                return ret;
-        }
-        if ((ret = snd_mixer_attach(smixer, s_card)) < 0) {
-                printf("sound mixer attach Failed %s", snd_strerror(ret));
-                snd_mixer_close(smixer);
-                return ret;
-        }
-        if ((ret = snd_mixer_selem_register(smixer, NULL, NULL)) < 0) {
-                printf("Cannot register sound mixer element %s", snd_strerror(ret));
-                snd_mixer_close(smixer);
-                return ret;
-        }
-        ret = snd_mixer_load(smixer);
-        if (ret < 0) {
-                printf("Sound mixer load %s error: %s", s_card, snd_strerror(ret));
-                snd_mixer_close(smixer);
-                return ret;
-        }
-
-        ret = snd_mixer_selem_id_malloc(&sid);
-        if (ret < 0) {
-                printf("Sound mixer: id allocation failed. %s: error: %s", s_card, snd_strerror(ret));
-                snd_mixer_close(smixer);
-                return ret;
-        }
-
-        snd_mixer_selem_id_set_index(sid, 0);
-        snd_mixer_selem_id_set_name(sid, selemname);
-
-        *element = snd_mixer_find_selem(smixer, sid);
-        if (NULL == *element) {
-                printf("Unable to find simple control '%s',%i\n", snd_mixer_selem_id_get_name(sid), snd_mixer_selem_id_get_index(sid));
-                snd_mixer_close(smixer);
-                ret = -1;
-        }
-
-        return ret;
+        return ((AOPHandle_t *) handle)->m_vType;
 }
 //###################################################################################################
 dsError_t dsAudioPortInit()
@@ -128,6 +83,27 @@ dsError_t dsAudioPortInit()
         _handles[dsAUDIOPORT_TYPE_SPDIF][0].m_index = 0;
         _handles[dsAUDIOPORT_TYPE_SPDIF][0].m_IsEnabled = true;
 
+#ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
+        if (dsAudioMixerOpen() != dsERR_NONE) {
+                /* Not fatal: the session is reopened on first use */
+                printf("failed to initialize alsa!\n");
+        }
+        if (dsAudioRampInit() != dsERR_NONE) {
+                ret = dsERR_GENERAL;
+        }
+#endif
+        if (dsAudioDspOpen() != dsERR_NONE) {
+                /* Not fatal: output processing stays in passthrough until it can be created */
+                printf("failed to create audio DSP control block!\n");
+        }
+        dsAudioSinkCapsInit();
+        if (dsAudioEventsInit() != dsERR_NONE) {
+                /* Not fatal: dsAudioOutIsConnected still answers, callbacks stay silent */
+                printf("failed to start audio event dispatcher!\n");
+        }
+        if (dsAudioCmdQueueInit(dsAudioApplyCommand) != dsERR_NONE) {
+                ret = dsERR_GENERAL;
+        }
         dsGetdBRange();
         return ret;
 }
@@ -135,18 +111,20 @@ dsError_t dsAudioPortInit()
 static void dsGetdBRange()
 {
 #ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
-        long min_dB_value, max_dB_value;
-        const char *s_card = ALSA_CARD_NAME;
-        const char *element_name = ALSA_ELEMENT_NAME;
-        snd_mixer_elem_t *mixer_elem = NULL;
-        initAlsa(element_name,s_card,&mixer_elem);
-        if(mixer_elem == NULL) {
-                printf("failed to initialize alsa!\n");
-                return;
-        }
-        if(!snd_mixer_selem_get_playback_dB_range(mixer_elem, &min_dB_value, &max_dB_value)) {
-                dBmax = (float) max_dB_value/100;
-                dBmin = (float) min_dB_value/100;
+        const dsAudioPortType_t ports[] = { dsAUDIOPORT_TYPE_HDMI, dsAUDIOPORT_TYPE_SPDIF };
+        for (size_t n = 0; n < sizeof(ports) / sizeof(ports[0]); n++) {
+                dsAudioMixerState_t mixer;
+                dsAudioPortState_t state;
+                if (!dsAudioMixerGetState(ports[n], &mixer) || !mixer.m_hasDb) {
+                        if (ports[n] == dsAUDIOPORT_TYPE_HDMI) {
+                                printf("failed to initialize alsa!\n");
+                        }
+                        continue;
+                }
+                dsAudioStateBegin(ports[n], &state);
+                state.m_dBMax = (float) mixer.m_dBMax/100;
+                state.m_dBMin = (float) mixer.m_dBMin/100;
+                dsAudioStateCommit(ports[n], &state);
         }
 #endif
 }
@@ -167,9 +145,13 @@ dsError_t  dsGetAudioPort(dsAudioPortType_t type, int index, intptr_t *handle)
 
 dsError_t dsGetAudioEncoding(intptr_t handle, dsAudioEncoding_t *encoding)
 {
-        dsError_t ret = dsERR_NONE;
-        *encoding = _encoding;
-        return ret;
+        dsAudioPortState_t state;
+        if( ! dsIsValidHandle(handle) || encoding == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioStateGet(dsGetPortType(handle), &state);
+        *encoding = state.m_encoding;
+        return dsERR_NONE;
 }
 
 dsError_t dsGetAudioCompression(intptr_t handle, dsAudioCompression_t *compression)
@@ -186,9 +168,13 @@ dsError_t dsGetAudioCompression(intptr_t handle, dsAudioCompression_t *compressi
 
 dsError_t dsGetStereoMode(intptr_t handle, dsAudioStereoMode_t *stereoMode)
 {
-	dsError_t ret = dsERR_NONE;
-        *stereoMode = _stereoModeHDMI;
-	return ret;
+        dsAudioPortState_t state;
+        if( ! dsIsValidHandle(handle) || stereoMode == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioStateGet(dsGetPortType(handle), &state);
+        *stereoMode = state.m_stereoMode;
+        return dsERR_NONE;
 }
 
 dsError_t dsGetPersistedStereoMode (intptr_t handle, dsAudioStereoMode_t *stereoMode)
@@ -204,62 +190,27 @@ dsError_t dsGetStereoAuto (intptr_t handle, int *autoMode)
 dsError_t dsIsAudioMute (intptr_t handle, bool *muted)
 {
 #ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
-        printf("Inside %s :%d\n",__FUNCTION__,__LINE__);
-        dsError_t ret = dsERR_NONE;
+        dsAudioMixerState_t state;
         if( ! dsIsValidHandle(handle) || NULL == muted ){
-                ret = dsERR_INVALID_PARAM;
+                return dsERR_INVALID_PARAM;
         }
-	const char *s_card = ALSA_CARD_NAME;
-	const char *element_name = ALSA_ELEMENT_NAME;
-        snd_mixer_elem_t *mixer_elem = NULL;
-	initAlsa(element_name,s_card,&mixer_elem);
-        if(mixer_elem == NULL) {
-                printf("failed to initialize alsa!\n");
+        if (!dsAudioMixerGetState(dsGetPortType(handle), &state) || !state.m_hasSwitch) {
                 return dsERR_GENERAL;
         }
-	int mute_status;
-	if (snd_mixer_selem_has_playback_switch(mixer_elem)) {
-		snd_mixer_selem_get_playback_switch(mixer_elem,  SND_MIXER_SCHN_FRONT_LEFT, &mute_status);
-		if (!mute_status) {
-			*muted = true;
-		} else {
-			*muted = false;
-		}
-	}
-	else {
-		ret = dsERR_GENERAL;
-	}
-	return ret;
+        *muted = state.m_muted;
+        return dsERR_NONE;
 #else
         return dsERR_NONE;
 #endif
 }
 
-dsError_t dsSetAudioMute(intptr_t handle, bool mute)
+static dsError_t dsApplyAudioMute(intptr_t handle, bool mute)
 {
 #ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
-        printf("Inside %s :%d\n",__FUNCTION__,__LINE__);
-        dsError_t ret = dsERR_NONE;
         if( ! dsIsValidHandle(handle)){
-                ret = dsERR_INVALID_PARAM;
-        }
-        const char *s_card = ALSA_CARD_NAME;
-        const char *element_name = ALSA_ELEMENT_NAME;
-        snd_mixer_elem_t *mixer_elem = NULL;
-        initAlsa(element_name,s_card,&mixer_elem);
-        if(mixer_elem == NULL) {
-                printf("failed to initialize alsa!\n");
-                return dsERR_GENERAL;
-        }
-        if (snd_mixer_selem_has_playback_switch(mixer_elem)) {
-                snd_mixer_selem_set_playback_switch_all(mixer_elem, !mute);
-                if (mute) {
-                        printf("Audio Mute success\n");
-                } else {
-                        printf("Audio Unmute success.\n");
-                }
+                return dsERR_INVALID_PARAM;
         }
-        return ret;
+        return dsAudioRampMute(dsGetPortType(handle), mute);
 #else
         return dsERR_NONE;
 #endif
@@ -267,7 +218,6 @@ dsError_t dsSetAudioMute(intptr_t handle, bool mute)
 
 dsError_t  dsIsAudioPortEnabled(intptr_t handle, bool *enabled)
 {
-    printf("Inside %s :%d\n",__FUNCTION__,__LINE__);
     dsError_t ret = dsERR_NONE;
     bool audioEnabled = true;
     ret = dsIsAudioMute(handle, &audioEnabled);
@@ -279,89 +229,38 @@ dsError_t  dsIsAudioPortEnabled(intptr_t handle, bool *enabled)
 
 dsError_t  dsEnableAudioPort(intptr_t handle, bool enabled)
 {
-    printf("Inside %s :%d\n",__FUNCTION__,__LINE__);
     return dsSetAudioMute ( handle, !enabled );
 }
 
 dsError_t dsGetAudioGain(intptr_t handle, float *gain)
 {
 #ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
-        dsError_t ret = dsERR_NONE;
-
+        dsAudioMixerState_t state;
         if( ! dsIsValidHandle(handle) || gain == NULL) {
-                ret = dsERR_INVALID_PARAM;
-        }
-
-        if ( dsERR_NONE == ret ) {
-                long value_got;
-                const char *s_card = ALSA_CARD_NAME;
-                const char *element_name = ALSA_ELEMENT_NAME;
-                long vol_min = 0, vol_max = 0;
-                double normalized= 0, min_norm = 0;
-                snd_mixer_elem_t *mixer_elem;
-                initAlsa(element_name,s_card,&mixer_elem);
-                if(mixer_elem == NULL) {
-                        printf("failed to initialize alsa!\n");
-                        return dsERR_GENERAL;
-                }
-
-                snd_mixer_selem_get_playback_dB_range(mixer_elem, &vol_min, &vol_max);
-                if(!snd_mixer_selem_get_playback_dB(mixer_elem, SND_MIXER_SCHN_FRONT_LEFT, &value_got))
-                {
-                    printf("dsGetAudioGain: Gain  in dB %.2f\n", value_got/100.0);
-                    if ((vol_max - vol_min) <= MAX_LINEAR_DB_SCALE * 100)
-                    {
-                      *gain = (value_got - vol_min) / (double)(vol_max - vol_min);
-                    }
-                    else
-                    {
-                        normalized = pow(10, (value_got - vol_max) / 6000.0);
-
-                        if (vol_min != SND_CTL_TLV_DB_GAIN_MUTE)
-                        {
-                          min_norm = pow(10, (vol_min - vol_max) / 6000.0);
-                          normalized = (normalized - min_norm) / (1 - min_norm);
-                        }
-                        *gain = (float)(((int)(100.0f * normalized + 0.5f))/1.0f);
-                        printf("dsGetAudioGain: Rounded Gain  in linear scale %.2f\n", *gain);
-                    }
-                }
-
+                return dsERR_INVALID_PARAM;
         }
-        return ret;
+        if (!dsAudioMixerGetState(dsGetPortType(handle), &state) || !state.m_hasDb) {
+                return dsERR_GENERAL;
+        }
+        *gain = state.m_gain;
+        return dsERR_NONE;
 #else
         return dsERR_NONE;
 #endif
-
 }
 
 dsError_t dsGetAudioDB(intptr_t handle, float *db)
 {
-    #ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
-        dsError_t ret = dsERR_NONE;
-
+#ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
+        dsAudioMixerState_t state;
         if( ! dsIsValidHandle(handle) || db == NULL) {
-                ret = dsERR_INVALID_PARAM;
+                return dsERR_INVALID_PARAM;
         }
-
-        if ( dsERR_NONE == ret ) {
-                long db_value;
-                const char *s_card = ALSA_CARD_NAME;
-                const char *element_name = ALSA_ELEMENT_NAME;
-
-                snd_mixer_elem_t *mixer_elem = NULL;
-                initAlsa(element_name,s_card,&mixer_elem);
-                if(mixer_elem == NULL) {
-                        printf("failed to initialize alsa!\n");
-                        return dsERR_GENERAL;
-                }
-
-                if(!snd_mixer_selem_get_playback_dB(mixer_elem, SND_MIXER_SCHN_FRONT_LEFT, &db_value)) {
-                        *db = (float) db_value/100;
-                }
-
+        if (!dsAudioMixerGetState(dsGetPortType(handle), &state) || !state.m_hasDb) {
+                return dsERR_GENERAL;
         }
-        return ret;
+        *db = (float) state.m_dB/100;
+        return dsERR_NONE;
 #else
         return dsERR_NONE;
 #endif
@@ -369,31 +268,16 @@ dsError_t dsGetAudioDB(intptr_t handle, float *db)
 
 dsError_t dsGetAudioLevel(intptr_t handle, float *level)
 {
- #ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
-        dsError_t ret = dsERR_NONE;
-
-        if( ! dsIsValidHandle(handle) ) {
-                ret = dsERR_INVALID_PARAM;
+#ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
+        dsAudioMixerState_t state;
+        if( ! dsIsValidHandle(handle) || level == NULL) {
+                return dsERR_INVALID_PARAM;
         }
-
-        if ( dsERR_NONE == ret ) {
-                long vol_value, min, max;
-                const char *s_card = "default";
-                const char *element_name = ALSA_ELEMENT_NAME;
-
-                snd_mixer_elem_t *mixer_elem = NULL;
-                initAlsa(element_name,s_card,&mixer_elem);
-                if(mixer_elem == NULL) {
-                        printf("failed to initialize alsa!\n");
-                        return dsERR_GENERAL;
-                }
-                if(!snd_mixer_selem_get_playback_volume(mixer_elem, SND_MIXER_SCHN_FRONT_LEFT, &vol_value)) {
-	                snd_mixer_selem_get_playback_volume_range(mixer_elem, &min, &max);
-                        *level = (float)((vol_value - min)*100/(max - min));
-                }
-
+        if (!dsAudioMixerGetState(dsGetPortType(handle), &state) || !state.m_hasVolume) {
+                return dsERR_GENERAL;
         }
-        return ret;
+        *level = state.m_level;
+        return dsERR_NONE;
 #else
         return dsERR_NONE;
 #endif
@@ -401,20 +285,82 @@ dsError_t dsGetAudioLevel(intptr_t handle, float *level)
 
 dsError_t dsGetAudioMaxDB(intptr_t handle, float *maxDb)
 {
-        *maxDb = dBmax;
+        dsAudioPortState_t state;
+        if( ! dsIsValidHandle(handle) || maxDb == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioStateGet(dsGetPortType(handle), &state);
+        *maxDb = state.m_dBMax;
         return dsERR_NONE;
 }
 
 dsError_t dsGetAudioMinDB(intptr_t handle, float *minDb)
 {
-        *minDb = dBmin;
+        dsAudioPortState_t state;
+        if( ! dsIsValidHandle(handle) || minDb == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioStateGet(dsGetPortType(handle), &state);
+        *minDb = state.m_dBMin;
+        return dsERR_NONE;
+}
+
+dsError_t dsGetAudioPortState(intptr_t handle, dsAudioPortState_t *state)
+{
+        if( ! dsIsValidHandle(handle) || state == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioStateGet(dsGetPortType(handle), state);
         return dsERR_NONE;
 }
 
+/*
+ * Level at which the programme measured by the output plugin's loudness
+ * meter plays at DS_AUDIO_TARGET_LUFS. The meter sits before the mixer, so
+ * the required attenuation is simply target minus integrated loudness.
+ */
 dsError_t dsGetAudioOptimalLevel(intptr_t handle, float *optimalLevel)
 {
-	dsError_t ret = dsERR_NONE;
-	return ret;
+#ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
+        dsDspLoudness_t loudness;
+        dsAudioMixerState_t state;
+        long dB, volume;
+
+        if( ! dsIsValidHandle(handle) || optimalLevel == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        if (dsAudioDspGetLoudness(&loudness) != dsERR_NONE || !isfinite(loudness.m_integrated)) {
+                return dsERR_GENERAL;
+        }
+        if (!dsAudioMixerGetState(dsGetPortType(handle), &state) || !state.m_hasDb || !state.m_hasVolume ||
+            state.m_volMax <= state.m_volMin) {
+                return dsERR_OPERATION_NOT_SUPPORTED;
+        }
+        dB = lrintf((DS_AUDIO_TARGET_LUFS - loudness.m_integrated) * 100.0f);
+        dB = dB < state.m_dBMin ? state.m_dBMin : (dB > state.m_dBMax ? state.m_dBMax : dB);
+
+        snd_mixer_elem_t *mixer_elem = dsAudioMixerAcquire(dsGetPortType(handle));
+        if(mixer_elem == NULL) {
+                return dsERR_GENERAL;
+        }
+        int err = snd_mixer_selem_ask_playback_dB_vol(mixer_elem, dB, -1, &volume);
+        dsAudioMixerRelease(dsGetPortType(handle), err);
+        if (err) {
+                return dsERR_GENERAL;
+        }
+        *optimalLevel = (float)((volume - state.m_volMin)*100/(state.m_volMax - state.m_volMin));
+        return dsERR_NONE;
+#else
+        return dsERR_OPERATION_NOT_SUPPORTED;
+#endif
+}
+
+dsError_t dsGetAudioLoudness(intptr_t handle, dsDspLoudness_t *loudness)
+{
+        if( ! dsIsValidHandle(handle) || loudness == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        return dsAudioDspGetLoudness(loudness);
 }
 
 dsError_t  dsIsAudioLoopThru(intptr_t handle, bool *loopThru)
@@ -423,30 +369,88 @@ dsError_t  dsIsAudioLoopThru(intptr_t handle, bool *loopThru)
 	return ret;
 }
 
-dsError_t dsSetAudioEncoding(intptr_t handle, dsAudioEncoding_t encoding)
+/* ALSA side of an encoding change; dsAudioPublishState() has already recorded it */
+static dsError_t dsApplyAudioEncoding(intptr_t handle)
 {
-    dsError_t ret = dsERR_NONE;
-    _encoding = encoding;
-    return ret;
+    dsAudioEncoding_t streaming;
+    dsAudioPortState_t state;
+    dsAudioStateGet(dsGetPortType(handle), &state);
+    /* A passthrough stream of another format ends; its writer reopens */
+    if (dsAudioIec61937IsOpen(&streaming) && streaming != state.m_encoding) {
+        dsAudioIec61937Close();
+    }
+    return dsERR_NONE;
 }
 
-dsError_t dsSetAudioCompression(intptr_t handle, dsAudioCompression_t compression)
+/* Whether the sink lists the compressed format at the rate */
+static bool dsAudioSinkAccepts(dsAudioEncoding_t encoding, uint32_t sampleRate)
 {
-    dsError_t ret = dsERR_NONE;
-    return ret;
+        dsAudioSinkCaps_t caps;
+        uint8_t fs;
+        switch (sampleRate) {
+        case 32000: fs = DS_AUDIO_SAD_RATE_32K; break;
+        case 44100: fs = DS_AUDIO_SAD_RATE_44K; break;
+        case 48000: fs = DS_AUDIO_SAD_RATE_48K; break;
+        default:    return false;
+        }
+        dsAudioSinkCapsGet(&caps);
+        return dsAudioSinkCapsSupports(&caps, encoding == dsAUDIO_ENC_EAC3 ? DS_AUDIO_SAD_EAC3 : DS_AUDIO_SAD_AC3, 2, fs);
 }
 
-dsError_t dsIsAudioMSDecode(intptr_t handle, bool *ms11Enabled)
+dsError_t dsAudioPassthroughOpen(intptr_t handle, uint32_t sampleRate, bool *passthrough)
+{
+        dsAudioPortState_t state;
+        dsError_t ret;
+        if( ! dsIsValidHandle(handle) || passthrough == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        if (dsGetPortType(handle) != dsAUDIOPORT_TYPE_HDMI) {
+                return dsERR_OPERATION_NOT_SUPPORTED;
+        }
+        dsAudioStateGet(dsAUDIOPORT_TYPE_HDMI, &state);
+        const dsAudioEncoding_t encoding = state.m_encoding;
+        *passthrough = false;
+        if ((encoding != dsAUDIO_ENC_AC3 && encoding != dsAUDIO_ENC_EAC3) || !dsAudioSinkAccepts(encoding, sampleRate)) {
+                /* Decode to PCM */
+                return dsERR_NONE;
+        }
+        ret = dsAudioIec61937Open(encoding, sampleRate);
+        *passthrough = (ret == dsERR_NONE);
+        return ret;
+}
+
+dsError_t dsAudioPassthroughWrite(intptr_t handle, const uint8_t *frame, size_t size)
+{
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        return dsAudioIec61937Write(frame, size);
+}
+
+dsError_t dsAudioPassthroughClose(intptr_t handle)
+{
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioIec61937Close();
+        return dsERR_NONE;
+}
+
+dsError_t dsSetAudioCompression(intptr_t handle, dsAudioCompression_t compression)
 {
     dsError_t ret = dsERR_NONE;
-    *ms11Enabled = _isms11Enabled;
     return ret;
 }
 
-dsError_t dsSetStereoMode(intptr_t handle, dsAudioStereoMode_t mode) {
-
-	dsError_t ret = dsERR_NONE;
-	return ret;
+dsError_t dsIsAudioMSDecode(intptr_t handle, bool *ms11Enabled)
+{
+    dsAudioPortState_t state;
+    if( ! dsIsValidHandle(handle) || ms11Enabled == NULL) {
+        return dsERR_INVALID_PARAM;
+    }
+    dsAudioStateGet(dsGetPortType(handle), &state);
+    *ms11Enabled = state.m_ms11Enabled;
+    return dsERR_NONE;
 }
 
 dsError_t dsSetStereoAuto (intptr_t handle, int autoMode)
@@ -454,137 +458,314 @@ dsError_t dsSetStereoAuto (intptr_t handle, int autoMode)
         return dsERR_NONE;
 }
 
-dsError_t dsSetAudioGain(intptr_t handle, float gain)
+static dsError_t dsApplyAudioGain(intptr_t handle, float gain)
 {
 #ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
-        dsError_t ret = dsERR_NONE;
+        dsAudioMixerState_t state;
+        dsAudioRampConfig_t config;
 
         if( ! dsIsValidHandle(handle) ) {
-                ret = dsERR_INVALID_PARAM;
+                return dsERR_INVALID_PARAM;
+        }
+        if (!dsAudioMixerGetState(dsGetPortType(handle), &state) || !state.m_hasDb) {
+                printf("failed to initialize alsa!\n");
+                return dsERR_GENERAL;
+        }
+        if (state.m_muted)
+        {
+            printf("dsSetAudioGain: Mute is enabled. \n");
+            return dsERR_GENERAL;
         }
 
-        if ( dsERR_NONE == ret ) {
-                const char *s_card = ALSA_CARD_NAME;
-                const char *element_name = ALSA_ELEMENT_NAME;
-                bool enabled = false;
-                ret = dsERR_GENERAL;
-                snd_mixer_elem_t *mixer_elem;
-                initAlsa(element_name,s_card,&mixer_elem);
-                if(mixer_elem == NULL) {
-                        printf("failed to initialize alsa!\n");
-                        return dsERR_GENERAL;
-                }
-
-
-                dsIsAudioMute(handle, &enabled);
-                if (true == enabled)
-                {
-                    printf("dsSetAudioGain: Mute is enabled. \n");
-                    return ret;
-                }
+        const dsAudioGainTable_t *table = dsAudioGainTableGet(state.m_dBMin, state.m_dBMax);
+        if (table == NULL) {
+                return dsERR_GENERAL;
+        }
+        long target = dsAudioGainTableToDb(table, gain);
+        dsAudioRampGetConfig(&config);
+        return dsAudioRampToDb(dsGetPortType(handle), target, config.m_gainMs);
+#else
+        return dsERR_NONE;
+#endif
+}
 
-                long vol_min, vol_max;
-                double min_norm;
-                gain = gain / 100.0f;
+static dsError_t dsApplyAudioDB(intptr_t handle, float db)
+{
+#ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
+        dsAudioPortState_t state;
+        if( ! dsIsValidHandle(handle) ) {
+                return dsERR_INVALID_PARAM;
+        }
 
-                snd_mixer_selem_get_playback_dB_range(mixer_elem, &vol_min, &vol_max);
-                if (vol_max - vol_min <= MAX_LINEAR_DB_SCALE * 100)
-                {
-                  long floatval = lrint(gain * (vol_max - vol_min)) + vol_min;
-                  snd_mixer_selem_set_playback_dB_all(mixer_elem, floatval, 0);
-                  ret = dsERR_NONE;
-                }
-                else
-                {
-                    if (vol_min != SND_CTL_TLV_DB_GAIN_MUTE)
-                    {
-                        min_norm = pow(10, (vol_min - vol_max) / 6000.0);
-                        gain = gain * (1 - min_norm) + min_norm;
-                    }
-                    long floatval = lrint(6000.0 * log10(gain)) + vol_max;
-                    snd_mixer_selem_set_playback_dB_all(mixer_elem, floatval, 0);
-                    printf("dsSetAudioGain: Setting gain in dB: %.2f \n", floatval/100.0);
-                    ret = dsERR_NONE;
-                }
+        dsAudioStateGet(dsGetPortType(handle), &state);
+        if(db < state.m_dBMin) {
+                db = state.m_dBMin;
+        }
+        if(db > state.m_dBMax) {
+                db = state.m_dBMax;
         }
 
-        return ret;
+        /* A step on the ramp worker, so it lands in order with any fade in progress */
+        return dsAudioRampToDb(dsGetPortType(handle), lrintf(db * 100), 0);
 #else
         return dsERR_NONE;
 #endif
 }
 
-dsError_t dsSetAudioDB(intptr_t handle, float db)
+dsError_t dsAudioGainToDbBatch(intptr_t handle, const float *gains, float *dBs, size_t count)
 {
 #ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
-        dsError_t ret = dsERR_NONE;
+        dsAudioMixerState_t state;
+        long values[64];
 
-        if( ! dsIsValidHandle(handle) ) {
-                ret = dsERR_INVALID_PARAM;
+        if( ! dsIsValidHandle(handle) || (count && (gains == NULL || dBs == NULL))) {
+                return dsERR_INVALID_PARAM;
         }
+        if (!dsAudioMixerGetState(dsGetPortType(handle), &state) || !state.m_hasDb) {
+                return dsERR_GENERAL;
+        }
+        const dsAudioGainTable_t *table = dsAudioGainTableGet(state.m_dBMin, state.m_dBMax);
+        if (table == NULL) {
+                return dsERR_GENERAL;
+        }
+        for (size_t done = 0; done < count; ) {
+                size_t chunk = count - done < 64 ? count - done : 64;
+                dsAudioGainTableToDbBatch(table, gains + done, values, chunk);
+                for (size_t i = 0; i < chunk; i++) {
+                        dBs[done + i] = values[i] / 100.0f;
+                }
+                done += chunk;
+        }
+        return dsERR_NONE;
+#else
+        return dsERR_OPERATION_NOT_SUPPORTED;
+#endif
+}
 
-        if ( dsERR_NONE == ret ) {
-                const char *s_card = ALSA_CARD_NAME;
-                const char *element_name = ALSA_ELEMENT_NAME;
+dsError_t dsAudioDbToGainBatch(intptr_t handle, const float *dBs, float *gains, size_t count)
+{
+#ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
+        dsAudioMixerState_t state;
+        long values[64];
 
-                snd_mixer_elem_t *mixer_elem = NULL;
-                initAlsa(element_name,s_card,&mixer_elem);
-                if(mixer_elem == NULL) {
-                        printf("failed to initialize alsa!\n");
-                        return dsERR_GENERAL;
+        if( ! dsIsValidHandle(handle) || (count && (gains == NULL || dBs == NULL))) {
+                return dsERR_INVALID_PARAM;
+        }
+        if (!dsAudioMixerGetState(dsGetPortType(handle), &state) || !state.m_hasDb) {
+                return dsERR_GENERAL;
+        }
+        const dsAudioGainTable_t *table = dsAudioGainTableGet(state.m_dBMin, state.m_dBMax);
+        if (table == NULL) {
+                return dsERR_GENERAL;
+        }
+        for (size_t done = 0; done < count; ) {
+                size_t chunk = count - done < 64 ? count - done : 64;
+                for (size_t i = 0; i < chunk; i++) {
+                        values[i] = lrintf(dBs[done + i] * 100);
                 }
+                dsAudioGainTableToGainBatch(table, values, gains + done, chunk);
+                done += chunk;
+        }
+        return dsERR_NONE;
+#else
+        return dsERR_OPERATION_NOT_SUPPORTED;
+#endif
+}
 
-                if(db < dBmin) {
-                        db = dBmin;
-                }
-                if(db > dBmax) {
-                        db = dBmax;
-                }
+static dsError_t dsApplyAudioLevel(intptr_t handle, float level)
+{
+ #ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
+        dsError_t ret = dsERR_NONE;
 
-                if(!snd_mixer_selem_set_playback_dB_all(mixer_elem, (long) db * 100, 0)) {
-                        ret = dsERR_NONE;
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+
+        long vol_value, min, max, dB = 0;
+        /* While ducked the level is only recorded as the user level, as dsSetAudioGain() does */
+        const bool direct = dsAudioRampCancel(dsGetPortType(handle));
+        snd_mixer_elem_t *mixer_elem = dsAudioMixerAcquire(dsGetPortType(handle));
+        if(mixer_elem == NULL) {
+                printf("failed to initialize alsa!\n");
+                return dsERR_GENERAL;
+        }
+        int err = snd_mixer_selem_get_playback_volume_range(mixer_elem, &min, &max);
+        if (!err) {
+                vol_value = (long)(((level / 100.0) * (max - min)) + min);
+                if (direct) {
+                        err = snd_mixer_selem_set_playback_volume_all(mixer_elem, vol_value);
                 }
                 else {
-                        ret = dsERR_GENERAL;
+                        err = snd_mixer_selem_ask_playback_vol_dB(mixer_elem, vol_value, &dB);
                 }
         }
+        dsAudioMixerRelease(dsGetPortType(handle), err);
+        if(err) {
+            printf("Failed to set Audio level\n");
+            ret = dsERR_GENERAL;
+        }
+        else if (!direct) {
+            ret = dsAudioRampToDb(dsGetPortType(handle), dB, 0);
+        }
         return ret;
 #else
         return dsERR_NONE;
 #endif
 }
 
+static dsError_t dsAudioApplyCommand(const dsAudioCmd_t *cmd)
+{
+        switch (cmd->m_type) {
+        case dsAUDIOCMD_GAIN:
+                return dsApplyAudioGain(cmd->m_handle, cmd->m_value.m_float);
+        case dsAUDIOCMD_DB:
+                return dsApplyAudioDB(cmd->m_handle, cmd->m_value.m_float);
+        case dsAUDIOCMD_LEVEL:
+                return dsApplyAudioLevel(cmd->m_handle, cmd->m_value.m_float);
+        case dsAUDIOCMD_MUTE:
+                return dsApplyAudioMute(cmd->m_handle, cmd->m_value.m_bool);
+        case dsAUDIOCMD_ENCODING:
+                return dsApplyAudioEncoding(cmd->m_handle);
+        case dsAUDIOCMD_STEREO_MODE:
+                /* Nothing to do in ALSA; queued so its callback stays in order */
+                return dsERR_NONE;
+        default:
+                return dsERR_INVALID_PARAM;
+        }
+}
+
+/*
+ * Encoding and stereo mode are plain settings: record them in the caller so
+ * the getters and dsAudioPassthroughOpen() see them as soon as the setter
+ * returns. Only what follows in ALSA is left to the worker.
+ * @return true for commands that carry such a setting.
+ */
+static bool dsAudioPublishState(const dsAudioCmd_t *cmd)
+{
+        dsAudioPortState_t state;
+        const dsAudioPortType_t port = dsGetPortType(cmd->m_handle);
+
+        switch (cmd->m_type) {
+        case dsAUDIOCMD_ENCODING:
+                dsAudioStateBegin(port, &state);
+                state.m_encoding = cmd->m_value.m_encoding;
+                dsAudioStateCommit(port, &state);
+                return true;
+        case dsAUDIOCMD_STEREO_MODE:
+                dsAudioStateBegin(port, &state);
+                state.m_stereoMode = cmd->m_value.m_stereoMode;
+                dsAudioStateCommit(port, &state);
+                return true;
+        default:
+                return false;
+        }
+}
+
+/*
+ * Queue a setter; before dsAudioPortInit() there is no worker, so apply in
+ * place. A setting already published is never rejected for a full queue:
+ * its ALSA side is then done in place too.
+ */
+static dsError_t dsAudioSubmit(const dsAudioCmd_t *cmd)
+{
+        const bool published = dsAudioPublishState(cmd);
+        dsError_t ret = dsAudioCmdQueuePost(cmd);
+        if (ret == dsERR_INVALID_STATE || (published && ret == dsERR_RESOURCE_NOT_AVAILABLE)) {
+                ret = dsAudioApplyCommand(cmd);
+                if (cmd->m_callback) {
+                        cmd->m_callback(cmd->m_handle, cmd->m_type, ret, cmd->m_userData);
+                }
+        }
+        else if (ret == dsERR_RESOURCE_NOT_AVAILABLE) {
+                printf("Audio command queue full, rejecting command %d\n", cmd->m_type);
+        }
+        return ret;
+}
+
+static dsError_t dsAudioSubmitFloat(intptr_t handle, dsAudioCmdType_t type, float value)
+{
+        dsAudioCmd_t cmd;
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.m_type = type;
+        cmd.m_handle = handle;
+        cmd.m_value.m_float = value;
+        return dsAudioSubmit(&cmd);
+}
+
+dsError_t dsSetAudioGain(intptr_t handle, float gain)
+{
+        return dsAudioSubmitFloat(handle, dsAUDIOCMD_GAIN, gain);
+}
+
+dsError_t dsSetAudioDB(intptr_t handle, float db)
+{
+        return dsAudioSubmitFloat(handle, dsAUDIOCMD_DB, db);
+}
+
 dsError_t dsSetAudioLevel(intptr_t handle, float level)
 {
- #ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
-        dsError_t ret = dsERR_NONE;
+        return dsAudioSubmitFloat(handle, dsAUDIOCMD_LEVEL, level);
+}
 
+dsError_t dsSetAudioMute(intptr_t handle, bool mute)
+{
+        dsAudioCmd_t cmd;
         if( ! dsIsValidHandle(handle)) {
-                ret = dsERR_INVALID_PARAM;
+                return dsERR_INVALID_PARAM;
         }
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.m_type = dsAUDIOCMD_MUTE;
+        cmd.m_handle = handle;
+        cmd.m_value.m_bool = mute;
+        return dsAudioSubmit(&cmd);
+}
 
-        if ( dsERR_NONE == ret ) {
-                long vol_value, min, max;
-                const char *s_card = ALSA_CARD_NAME;
-                const char *element_name = ALSA_ELEMENT_NAME;
+dsError_t dsSetAudioEncoding(intptr_t handle, dsAudioEncoding_t encoding)
+{
+        dsAudioCmd_t cmd;
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.m_type = dsAUDIOCMD_ENCODING;
+        cmd.m_handle = handle;
+        cmd.m_value.m_encoding = encoding;
+        return dsAudioSubmit(&cmd);
+}
 
-                snd_mixer_elem_t *mixer_elem = NULL;
-                initAlsa(element_name,s_card,&mixer_elem);
-                if(mixer_elem == NULL) {
-                        printf("failed to initialize alsa!\n");
-                        return dsERR_GENERAL;
-                }
-                snd_mixer_selem_get_playback_volume_range(mixer_elem, &min, &max);
-                vol_value = (long)(((level / 100.0) * (max - min)) + min);
-                if(snd_mixer_selem_set_playback_volume_all(mixer_elem, vol_value)) {
-                    printf("Failed to set Audio level\n");
-                }
+dsError_t dsSetStereoMode(intptr_t handle, dsAudioStereoMode_t mode)
+{
+        dsAudioCmd_t cmd;
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.m_type = dsAUDIOCMD_STEREO_MODE;
+        cmd.m_handle = handle;
+        cmd.m_value.m_stereoMode = mode;
+        return dsAudioSubmit(&cmd);
+}
 
+dsError_t dsAudioPostCommand(const dsAudioCmd_t *cmd)
+{
+        if (cmd == NULL || ! dsIsValidHandle(cmd->m_handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        return dsAudioSubmit(cmd);
+}
+
+dsError_t dsAudioFlushCommands()
+{
+        dsError_t ret = dsAudioCmdQueueFlush();
+#ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
+        if (ret == dsERR_NONE) {
+                dsAudioRampFlush();
         }
-        return ret;
-#else
-        return dsERR_NONE;
 #endif
+        return ret;
 }
 
 dsError_t dsEnableLoopThru(intptr_t handle, bool loopThru)
@@ -596,32 +777,53 @@ dsError_t dsEnableLoopThru(intptr_t handle, bool loopThru)
 dsError_t dsAudioPortTerm()
 {
 	dsError_t ret = dsERR_NONE;
+	dsAudioCmdQueueTerm();
+	dsAudioEventsTerm();
+	dsAudioIec61937Close();
+	dsAudioSinkCapsTerm();
+	dsAudioDspClose();
+#ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
+	dsAudioRampTerm();
+	dsAudioDuckingReset();
+	dsAudioMixerClose();
+	dsAudioGainTableReleaseAll();
+#endif
 	return ret;
 }
 
 bool dsCheckSurroundSupport()
 {
-     bool status = false;
-     int num_channels = 0;
-    for (int i=1; i<=8; i++) {
-      if (vc_tv_hdmi_audio_supported(EDID_AudioFormat_eAC3, i, EDID_AudioSampleRate_e44KHz, EDID_AudioSampleSize_16bit ) == 0)
-        num_channels = i;
-    }
-
-    if (num_channels)
-        status = true;
-
-    return status;
+        dsAudioSinkCaps_t caps;
+        dsAudioSinkCapsGet(&caps);
+        return caps.m_maxChannels[DS_AUDIO_SAD_AC3] > 0;
 }
 dsError_t  dsGetAudioFormat(intptr_t handle, dsAudioFormat_t *audioFormat)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        if( ! dsIsValidHandle(handle) || audioFormat == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        *audioFormat = dsAudioEventsGetFormat();
+        return dsERR_NONE;
 }
 dsError_t  dsGetDialogEnhancement(intptr_t handle, int *level)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || level == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspGet(&params);
+        *level = (int) params.m_dialogLevel;
+        return dsERR_NONE;
+}
+dsError_t  dsSetDialogEnhancement(intptr_t handle, int level)
+{
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || level < 0 || level > DS_DSP_DIALOG_LEVELS) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_dialogLevel = (uint32_t) level;
+        return dsAudioDspCommit(&params);
 }
 dsError_t  dsGetDolbyVolumeMode(intptr_t handle, bool *mode)
 {
@@ -645,23 +847,47 @@ dsError_t  dsSetIntelligentEqualizerMode(intptr_t handle, int mode)
 }
 dsError_t  dsGetVolumeLeveller(intptr_t handle, dsVolumeLeveller_t* volLeveller)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || volLeveller == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspGet(&params);
+        volLeveller->mode = (int) params.m_levellerMode;
+        volLeveller->level = (int) params.m_levellerLevel;
+        return dsERR_NONE;
 }
 dsError_t  dsSetVolumeLeveller(intptr_t handle, dsVolumeLeveller_t volLeveller)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        /* mode 0 off, 1 on, 2 auto; level 0-10 */
+        if( ! dsIsValidHandle(handle) || volLeveller.mode < 0 || volLeveller.mode > 2 ||
+            volLeveller.level < 0 || volLeveller.level > 10) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_levellerMode = (uint32_t) volLeveller.mode;
+        params.m_levellerLevel = (uint32_t) volLeveller.level;
+        return dsAudioDspCommit(&params);
 }
 dsError_t  dsGetBassEnhancer(intptr_t handle, int *boost)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || boost == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspGet(&params);
+        *boost = (int) params.m_bassBoost;
+        return dsERR_NONE;
 }
 dsError_t  dsSetBassEnhancer(intptr_t handle, int boost)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || boost < 0 || boost > 100) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_bassBoost = (uint32_t) boost;
+        return dsAudioDspCommit(&params);
 }
 dsError_t  dsIsSurroundDecoderEnabled(intptr_t handle, bool *enabled)
 {
@@ -675,23 +901,48 @@ dsError_t  dsEnableSurroundDecoder(intptr_t handle, bool enabled)
 }
 dsError_t  dsGetDRCMode(intptr_t handle, int *mode)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || mode == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspGet(&params);
+        *mode = (int) params.m_drcMode;
+        return dsERR_NONE;
 }
 dsError_t  dsSetDRCMode(intptr_t handle, int mode)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        /* 0 line, 1 RF */
+        if( ! dsIsValidHandle(handle) || mode < 0 || mode > 1) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_drcMode = (uint32_t) mode;
+        return dsAudioDspCommit(&params);
 }
 dsError_t  dsGetSurroundVirtualizer(intptr_t handle, dsSurroundVirtualizer_t *virtualizer)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || virtualizer == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspGet(&params);
+        virtualizer->mode = (int) params.m_virtualizerMode;
+        virtualizer->boost = (int) params.m_virtualizerBoost;
+        return dsERR_NONE;
 }
 dsError_t  dsSetSurroundVirtualizer(intptr_t handle, dsSurroundVirtualizer_t virtualizer)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        /* mode 0 off, 1 on, 2 auto; boost 0-96 */
+        if( ! dsIsValidHandle(handle) || virtualizer.mode < 0 || virtualizer.mode > 2 ||
+            virtualizer.boost < 0 || virtualizer.boost > 96) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_virtualizerMode = (uint32_t) virtualizer.mode;
+        params.m_virtualizerBoost = (uint32_t) virtualizer.boost;
+        return dsAudioDspCommit(&params);
 }
 dsError_t  dsGetMISteering(intptr_t handle, bool *enabled)
 {
@@ -705,13 +956,23 @@ dsError_t  dsSetMISteering(intptr_t handle, bool enabled)
 }
 dsError_t  dsGetGraphicEqualizerMode(intptr_t handle, int *mode)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || mode == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspGet(&params);
+        *mode = (int) params.m_eqMode;
+        return dsERR_NONE;
 }
 dsError_t  dsSetGraphicEqualizerMode(intptr_t handle, int mode)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || mode < 0 || mode >= DS_DSP_EQ_MODES) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_eqMode = (uint32_t) mode;
+        return dsAudioDspCommit(&params);
 }
 dsError_t  dsGetMS12AudioProfileList(intptr_t handle, dsMS12AudioProfileList_t* profiles)
 {
@@ -740,23 +1001,43 @@ dsError_t dsAudioEnableARC(intptr_t handle, dsAudioARCStatus_t arcStatus)
 }
 dsError_t dsGetAudioDelay(intptr_t handle, uint32_t *audioDelayMs)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || audioDelayMs == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspGet(&params);
+        *audioDelayMs = params.m_delayMs;
+        return dsERR_NONE;
 }
 dsError_t dsSetAudioDelay(intptr_t handle, const uint32_t audioDelayMs)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || audioDelayMs > DS_DSP_MAX_DELAY_MS) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_delayMs = audioDelayMs;
+        return dsAudioDspCommit(&params);
 }
 dsError_t dsGetAudioDelayOffset(intptr_t handle, uint32_t *audioDelayOffsetMs)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || audioDelayOffsetMs == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspGet(&params);
+        *audioDelayOffsetMs = params.m_delayOffsetMs;
+        return dsERR_NONE;
 }
 dsError_t dsSetAudioDelayOffset(intptr_t handle, const uint32_t audioDelayOffsetMs)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || audioDelayOffsetMs > DS_DSP_MAX_DELAY_MS) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_delayOffsetMs = audioDelayOffsetMs;
+        return dsAudioDspCommit(&params);
 }
 dsError_t dsSetAudioAtmosOutputMode(intptr_t handle, bool enable)
 {
@@ -765,8 +1046,17 @@ dsError_t dsSetAudioAtmosOutputMode(intptr_t handle, bool enable)
 }
 dsError_t dsGetSinkDeviceAtmosCapability(intptr_t handle, dsATMOSCapability_t *capability)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsAudioSinkCaps_t caps;
+        if( ! dsIsValidHandle(handle) || capability == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        if (dsGetPortType(handle) != dsAUDIOPORT_TYPE_HDMI) {
+                *capability = dsAUDIO_ATMOS_NOTSUPPORTED;
+                return dsERR_NONE;
+        }
+        dsAudioSinkCapsGet(&caps);
+        *capability = caps.m_atmos;
+        return dsERR_NONE;
 }
 dsError_t  dsEnableMS12Config(intptr_t handle, dsMS12FEATURE_t feature,const bool enable)
 {
@@ -790,8 +1080,14 @@ dsError_t  dsSetMS12AudioProfile(intptr_t handle, const char* profile)
 }
 dsError_t  dsSetAudioDucking(intptr_t handle, dsAudioDuckingAction_t action, dsAudioDuckingType_t type, const unsigned char level)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+#ifdef ALSA_AUDIO_MASTER_CONTROL_ENABLE
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        return dsAudioDuckingUpdate(dsGetPortType(handle), action, type, level);
+#else
+        return dsERR_NONE;
+#endif
 }
 dsError_t  dsIsAudioMS12Decode(intptr_t handle, bool *hasMS12Decode)
 {
@@ -800,28 +1096,35 @@ dsError_t  dsIsAudioMS12Decode(intptr_t handle, bool *hasMS12Decode)
 }
 dsError_t dsAudioOutIsConnected(intptr_t handle, bool* isConnected)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        if( ! dsIsValidHandle(handle) || isConnected == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        return dsAudioEventsIsConnected(dsGetPortType(handle), isConnected);
 }
 dsError_t dsAudioOutRegisterConnectCB(dsAudioOutPortConnectCB_t CBFunc)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsAudioEventsSetConnectCB(CBFunc);
+        return dsERR_NONE;
 }
 dsError_t dsAudioFormatUpdateRegisterCB(dsAudioFormatUpdateCB_t cbFun)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsAudioEventsSetFormatCB(cbFun);
+        return dsERR_NONE;
 }
 dsError_t dsAudioAtmosCapsChangeRegisterCB (dsAtmosCapsChangeCB_t cbFun)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsAudioEventsSetAtmosCapsCB(cbFun);
+        return dsERR_NONE;
 }
 dsError_t dsGetAudioCapabilities(intptr_t handle, int *capabilities)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsAudioSinkCaps_t caps;
+        if( ! dsIsValidHandle(handle) || capabilities == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioSinkCapsGet(&caps);
+        *capabilities = caps.m_capabilities;
+        return dsERR_NONE;
 }
 dsError_t dsGetMS12Capabilities(intptr_t handle, int *capabilities)
 {
@@ -830,43 +1133,85 @@ dsError_t dsGetMS12Capabilities(intptr_t handle, int *capabilities)
 }
 dsError_t dsResetDialogEnhancement(intptr_t handle)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_dialogLevel = 0;
+        return dsAudioDspCommit(&params);
 }
 dsError_t dsResetBassEnhancer(intptr_t handle)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_bassBoost = 0;
+        return dsAudioDspCommit(&params);
 }
 dsError_t dsResetSurroundVirtualizer(intptr_t handle)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_virtualizerMode = 0;
+        params.m_virtualizerBoost = 0;
+        return dsAudioDspCommit(&params);
 }
 dsError_t dsResetVolumeLeveller(intptr_t handle)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_levellerMode = 0;
+        params.m_levellerLevel = 0;
+        return dsAudioDspCommit(&params);
 }
 dsError_t dsSetAssociatedAudioMixing(intptr_t handle, bool mixing)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_associatedMixing = mixing ? 1 : 0;
+        return dsAudioDspCommit(&params);
 }
 dsError_t  dsGetAssociatedAudioMixing(intptr_t handle, bool *mixing)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || mixing == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspGet(&params);
+        *mixing = params.m_associatedMixing != 0;
+        return dsERR_NONE;
 }
 dsError_t  dsSetFaderControl(intptr_t handle, int mixerbalance)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || mixerbalance < -DS_DSP_FADER_RANGE || mixerbalance > DS_DSP_FADER_RANGE) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        params.m_fader = mixerbalance;
+        return dsAudioDspCommit(&params);
 }
 dsError_t  dsGetFaderControl(intptr_t handle, int* mixerbalance)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || mixerbalance == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspGet(&params);
+        *mixerbalance = params.m_fader;
+        return dsERR_NONE;
 }
 dsError_t  dsSetPrimaryLanguage(intptr_t handle, const char* pLang)
 {
@@ -895,6 +1240,18 @@ dsError_t dsGetHDMIARCPortId(int *portId)
 }
 dsError_t dsSetAudioMixerLevels (intptr_t handle, dsAudioInput_t aInput, int volume)
 {
-        dsError_t ret = dsERR_NONE;
-        return ret;
+        dsDspParams_t params;
+        if( ! dsIsValidHandle(handle) || volume < 0 || volume > 100) {
+                return dsERR_INVALID_PARAM;
+        }
+        if (aInput != dsAUDIO_INPUT_PRIMARY && aInput != dsAUDIO_INPUT_SYSTEM) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsAudioDspBegin(&params);
+        if (aInput == dsAUDIO_INPUT_PRIMARY) {
+                params.m_primaryCut = (uint32_t)(100 - volume);
+        } else {
+                params.m_systemCut = (uint32_t)(100 - volume);
+        }
+        return dsAudioDspCommit(&params);
 }
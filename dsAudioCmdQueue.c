@@ -0,0 +1,277 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include "dsAudioCmdQueue.h"
+
+/* Power of two; a held volume key produces a few commands per repeat at most */
+#define CMD_QUEUE_CAPACITY 64
+#define CMD_QUEUE_BATCH 16
+
+typedef struct _dsAudioCmdCell_t {
+        uint32_t m_seq;
+        dsAudioCmd_t m_cmd;
+} dsAudioCmdCell_t;
+
+/*
+ * Bounded MPSC ring (D. Vyukov's bounded queue): each cell's sequence number
+ * says whether it is free for the producer that claimed the position or
+ * holds a command for the consumer. Producers only contend on _enqueuePos.
+ */
+static dsAudioCmdCell_t _cells[CMD_QUEUE_CAPACITY];
+static uint32_t _enqueuePos __attribute__((aligned(64)));
+static uint32_t _dequeuePos __attribute__((aligned(64)));
+
+static dsAudioCmdApplyFn_t _apply = NULL;
+static pthread_t _worker;
+static bool _running = false;
+static bool _stop = false;
+static int _sleeping = 0;
+static int _posting = 0;                /* producers between the _running check and the enqueue */
+static int _wakeFd = -1;
+
+/* Flush bookkeeping: the worker publishes how far it has applied */
+static pthread_mutex_t _doneLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _doneCond = PTHREAD_COND_INITIALIZER;
+static uint32_t _completedPos = 0;
+static int _flushWaiters = 0;
+
+static bool dsAudioCmdEnqueue(const dsAudioCmd_t *cmd)
+{
+        uint32_t pos = __atomic_load_n(&_enqueuePos, __ATOMIC_RELAXED);
+        dsAudioCmdCell_t *cell;
+
+        for (;;) {
+                cell = &_cells[pos & (CMD_QUEUE_CAPACITY - 1)];
+                uint32_t seq = __atomic_load_n(&cell->m_seq, __ATOMIC_ACQUIRE);
+                int32_t diff = (int32_t)(seq - pos);
+                if (diff == 0) {
+                        if (__atomic_compare_exchange_n(&_enqueuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                                break;
+                        }
+                }
+                else if (diff < 0) {
+                        return false;
+                }
+                else {
+                        pos = __atomic_load_n(&_enqueuePos, __ATOMIC_RELAXED);
+                }
+        }
+        cell->m_cmd = *cmd;
+        __atomic_store_n(&cell->m_seq, pos + 1, __ATOMIC_RELEASE);
+        return true;
+}
+
+/* Single consumer: only the worker thread calls this. */
+static bool dsAudioCmdDequeue(dsAudioCmd_t *cmd)
+{
+        uint32_t pos = _dequeuePos;
+        dsAudioCmdCell_t *cell = &_cells[pos & (CMD_QUEUE_CAPACITY - 1)];
+        uint32_t seq = __atomic_load_n(&cell->m_seq, __ATOMIC_ACQUIRE);
+
+        if ((int32_t)(seq - (pos + 1)) < 0) {
+                return false;
+        }
+        *cmd = cell->m_cmd;
+        __atomic_store_n(&cell->m_seq, pos + CMD_QUEUE_CAPACITY, __ATOMIC_RELEASE);
+        _dequeuePos = pos + 1;
+        return true;
+}
+
+static bool dsAudioCmdQueueEmpty()
+{
+        uint32_t pos = _dequeuePos;
+        uint32_t seq = __atomic_load_n(&_cells[pos & (CMD_QUEUE_CAPACITY - 1)].m_seq, __ATOMIC_ACQUIRE);
+        return (int32_t)(seq - (pos + 1)) < 0;
+}
+
+static void dsAudioCmdWake()
+{
+        uint64_t one = 1;
+        if (write(_wakeFd, &one, sizeof(one)) < 0) {
+                printf("Failed to wake audio command worker\n");
+        }
+}
+
+static bool dsAudioCmdSameProperty(const dsAudioCmd_t *a, const dsAudioCmd_t *b)
+{
+        return a->m_type == b->m_type && a->m_handle == b->m_handle;
+}
+
+/* Apply a batch in order, applying only the last of each run on the same property. */
+static void dsAudioCmdApplyBatch(const dsAudioCmd_t *batch, int count)
+{
+        int runStart = 0;
+        for (int i = 0; i < count; i++) {
+                if (i + 1 < count && dsAudioCmdSameProperty(&batch[i], &batch[i + 1])) {
+                        continue;
+                }
+                dsError_t result = _apply(&batch[i]);
+                for (int j = runStart; j <= i; j++) {
+                        if (batch[j].m_callback) {
+                                batch[j].m_callback(batch[j].m_handle, batch[j].m_type, result, batch[j].m_userData);
+                        }
+                }
+                runStart = i + 1;
+        }
+}
+
+static void* dsAudioCmdWorker(void *arg)
+{
+        dsAudioCmd_t batch[CMD_QUEUE_BATCH];
+        struct pollfd pfd;
+
+        pfd.fd = _wakeFd;
+        pfd.events = POLLIN;
+
+        for (;;) {
+                int count = 0;
+                while (count < CMD_QUEUE_BATCH && dsAudioCmdDequeue(&batch[count])) {
+                        count++;
+                }
+                if (count > 0) {
+                        dsAudioCmdApplyBatch(batch, count);
+                        pthread_mutex_lock(&_doneLock);
+                        _completedPos = _dequeuePos;
+                        if (_flushWaiters) {
+                                pthread_cond_broadcast(&_doneCond);
+                        }
+                        pthread_mutex_unlock(&_doneLock);
+                        continue;
+                }
+                if (__atomic_load_n(&_stop, __ATOMIC_ACQUIRE)) {
+                        break;
+                }
+
+                /* Producers only write the eventfd when they see us asleep */
+                __atomic_store_n(&_sleeping, 1, __ATOMIC_SEQ_CST);
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+                if (!dsAudioCmdQueueEmpty() || __atomic_load_n(&_stop, __ATOMIC_ACQUIRE)) {
+                        __atomic_store_n(&_sleeping, 0, __ATOMIC_SEQ_CST);
+                        continue;
+                }
+                if (poll(&pfd, 1, -1) > 0) {
+                        uint64_t value;
+                        if (read(_wakeFd, &value, sizeof(value)) < 0) {
+                                printf("Failed to drain audio command wake fd\n");
+                        }
+                }
+                __atomic_store_n(&_sleeping, 0, __ATOMIC_SEQ_CST);
+        }
+        return NULL;
+}
+
+dsError_t dsAudioCmdQueueInit(dsAudioCmdApplyFn_t apply)
+{
+        if (apply == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        if (_running) {
+                return dsERR_NONE;
+        }
+        for (uint32_t i = 0; i < CMD_QUEUE_CAPACITY; i++) {
+                _cells[i].m_seq = i;
+        }
+        _enqueuePos = _dequeuePos = _completedPos = 0;
+        _apply = apply;
+        _stop = false;
+        _sleeping = 0;
+        _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_wakeFd < 0 || pthread_create(&_worker, NULL, dsAudioCmdWorker, NULL) != 0) {
+                printf("Failed to start audio command worker\n");
+                if (_wakeFd >= 0) {
+                        close(_wakeFd);
+                        _wakeFd = -1;
+                }
+                return dsERR_GENERAL;
+        }
+        __atomic_store_n(&_running, true, __ATOMIC_RELEASE);
+        return dsERR_NONE;
+}
+
+dsError_t dsAudioCmdQueueTerm()
+{
+        if (!__atomic_load_n(&_running, __ATOMIC_ACQUIRE)) {
+                return dsERR_NONE;
+        }
+        __atomic_store_n(&_running, false, __ATOMIC_SEQ_CST);
+        /* Late posts are rejected; let the ones already past the check land so the worker drains them */
+        while (__atomic_load_n(&_posting, __ATOMIC_SEQ_CST)) {
+                sched_yield();
+        }
+        __atomic_store_n(&_stop, true, __ATOMIC_SEQ_CST);
+        dsAudioCmdWake();
+        pthread_join(_worker, NULL);
+        close(_wakeFd);
+        _wakeFd = -1;
+
+        /* Release flushers still waiting on the worker */
+        pthread_mutex_lock(&_doneLock);
+        _completedPos = _dequeuePos;
+        pthread_cond_broadcast(&_doneCond);
+        pthread_mutex_unlock(&_doneLock);
+        return dsERR_NONE;
+}
+
+dsError_t dsAudioCmdQueuePost(const dsAudioCmd_t *cmd)
+{
+        if (cmd == NULL || cmd->m_type >= dsAUDIOCMD_MAX) {
+                return dsERR_INVALID_PARAM;
+        }
+        dsError_t ret = dsERR_NONE;
+        __atomic_add_fetch(&_posting, 1, __ATOMIC_SEQ_CST);
+        if (!__atomic_load_n(&_running, __ATOMIC_SEQ_CST)) {
+                ret = dsERR_INVALID_STATE;
+        }
+        else if (!dsAudioCmdEnqueue(cmd)) {
+                ret = dsERR_RESOURCE_NOT_AVAILABLE;
+        }
+        else if (__atomic_exchange_n(&_sleeping, 0, __ATOMIC_SEQ_CST)) {
+                dsAudioCmdWake();
+        }
+        __atomic_sub_fetch(&_posting, 1, __ATOMIC_SEQ_CST);
+        return ret;
+}
+
+dsError_t dsAudioCmdQueueFlush()
+{
+        if (!__atomic_load_n(&_running, __ATOMIC_ACQUIRE)) {
+                return dsERR_NONE;
+        }
+        if (pthread_equal(pthread_self(), _worker)) {
+                /* From a completion callback: waiting on ourselves would never return */
+                return dsERR_INVALID_STATE;
+        }
+        uint32_t target = __atomic_load_n(&_enqueuePos, __ATOMIC_ACQUIRE);
+
+        pthread_mutex_lock(&_doneLock);
+        _flushWaiters++;
+        while ((int32_t)(_completedPos - target) < 0 && __atomic_load_n(&_running, __ATOMIC_ACQUIRE)) {
+                pthread_cond_wait(&_doneCond, &_doneLock);
+        }
+        _flushWaiters--;
+        pthread_mutex_unlock(&_doneLock);
+        return dsERR_NONE;
+}
@@ -0,0 +1,108 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSAUDIOCMDQUEUE_H
+#define __DSAUDIOCMDQUEUE_H
+
+#include <stdint.h>
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Audio setter command queue.
+ *
+ * The dsAudio setters validate their arguments and post a command to a
+ * bounded lock-free queue; a single worker thread applies the commands in
+ * order, so callers (typically the IPC dispatcher) never wait on ALSA. When a
+ * run of consecutive commands sets the same property of the same port only
+ * the last one is applied. Setters return dsERR_RESOURCE_NOT_AVAILABLE when
+ * the queue is full; dsAudioFlushCommands() waits for everything posted so
+ * far to reach the mixer for callers that need the old synchronous behaviour.
+ * Encoding and stereo mode are recorded before the setter returns, so their
+ * getters read back the new value at once; only the ALSA side is queued.
+ */
+
+typedef enum _dsAudioCmdType_t {
+        dsAUDIOCMD_GAIN = 0,
+        dsAUDIOCMD_DB,
+        dsAUDIOCMD_LEVEL,
+        dsAUDIOCMD_MUTE,
+        dsAUDIOCMD_ENCODING,
+        dsAUDIOCMD_STEREO_MODE,
+        dsAUDIOCMD_MAX
+} dsAudioCmdType_t;
+
+/**
+ * @brief Called on the worker thread once a command has been applied.
+ *
+ * Commands merged into a later one report that command's result. Must not
+ * block or call dsAudioFlushCommands().
+ */
+typedef void (*dsAudioCmdCompleteCB_t)(intptr_t handle, dsAudioCmdType_t type, dsError_t result, void *userData);
+
+typedef struct _dsAudioCmd_t {
+        dsAudioCmdType_t m_type;
+        intptr_t m_handle;
+        union {
+                float m_float;                  /**< gain, dB, level  */
+                bool m_bool;                    /**< mute             */
+                dsAudioEncoding_t m_encoding;
+                dsAudioStereoMode_t m_stereoMode;
+        } m_value;
+        dsAudioCmdCompleteCB_t m_callback;      /**< Optional         */
+        void *m_userData;
+} dsAudioCmd_t;
+
+typedef dsError_t (*dsAudioCmdApplyFn_t)(const dsAudioCmd_t *cmd);
+
+dsError_t dsAudioCmdQueueInit(dsAudioCmdApplyFn_t apply);
+
+/**
+ * @brief Apply whatever is still queued and stop the worker.
+ *
+ * A post racing with Term is either applied before the worker exits or
+ * rejected with dsERR_INVALID_STATE; pending flushes return.
+ */
+dsError_t dsAudioCmdQueueTerm();
+
+/**
+ * @return dsERR_RESOURCE_NOT_AVAILABLE if the queue is full,
+ *         dsERR_INVALID_STATE if the worker is not running.
+ */
+dsError_t dsAudioCmdQueuePost(const dsAudioCmd_t *cmd);
+
+/**
+ * @brief Wait until every command posted before the call has been applied.
+ */
+dsError_t dsAudioCmdQueueFlush();
+
+/**
+ * @brief Post a setter command with an optional completion callback.
+ *
+ * @param [in] cmd  Command; the handle is validated before queueing.
+ */
+dsError_t dsAudioPostCommand(const dsAudioCmd_t *cmd);
+
+/**
+ * @brief Block until all posted setter commands, and the volume fades they
+ * started, have reached the mixer.
+ */
+dsError_t dsAudioFlushCommands();
+
+#endif /* __DSAUDIOCMDQUEUE_H */
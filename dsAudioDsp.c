@@ -0,0 +1,127 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include "dsAudioDsp.h"
+
+#define DS_AUDIO_DSP_READ_ATTEMPTS 100
+
+static dsDspControl_t *_control = NULL;
+static dsDspParams_t _params;
+static pthread_mutex_t _dspLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Called with _dspLock held. */
+static void dsAudioDspPublish()
+{
+        dsSeqlockWriteBegin(&_control->m_paramsLock);
+        _control->m_params = _params;
+        dsSeqlockWriteEnd(&_control->m_paramsLock);
+}
+
+/* Called with _dspLock held. */
+static bool dsAudioDspMapLocked()
+{
+        if (_control == NULL) {
+                _control = dsDspControlMap(true);
+                if (_control == NULL) {
+                        printf("Cannot create audio DSP control block %s\n", DS_DSP_SHM_NAME);
+                        return false;
+                }
+                dsAudioDspPublish();
+        }
+        return true;
+}
+
+dsError_t dsAudioDspOpen()
+{
+        dsError_t ret;
+        pthread_mutex_lock(&_dspLock);
+        ret = dsAudioDspMapLocked() ? dsERR_NONE : dsERR_GENERAL;
+        pthread_mutex_unlock(&_dspLock);
+        return ret;
+}
+
+void dsAudioDspClose()
+{
+        /* The block outlives us so running streams keep their settings */
+        pthread_mutex_lock(&_dspLock);
+        dsDspControlUnmap(_control);
+        _control = NULL;
+        pthread_mutex_unlock(&_dspLock);
+}
+
+void dsAudioDspGet(dsDspParams_t *params)
+{
+        pthread_mutex_lock(&_dspLock);
+        *params = _params;
+        pthread_mutex_unlock(&_dspLock);
+}
+
+void dsAudioDspBegin(dsDspParams_t *params)
+{
+        pthread_mutex_lock(&_dspLock);
+        *params = _params;
+}
+
+dsError_t dsAudioDspCommit(const dsDspParams_t *params)
+{
+        dsError_t ret = dsERR_NONE;
+        _params = *params;
+        if (dsAudioDspMapLocked()) {
+                dsAudioDspPublish();
+        }
+        else {
+                ret = dsERR_GENERAL;
+        }
+        pthread_mutex_unlock(&_dspLock);
+        return ret;
+}
+
+dsError_t dsAudioDspGetLoudness(dsDspLoudness_t *loudness)
+{
+        dsDspControl_t *control;
+        uint32_t seq;
+
+        pthread_mutex_lock(&_dspLock);
+        if (!dsAudioDspMapLocked()) {
+                pthread_mutex_unlock(&_dspLock);
+                return dsERR_GENERAL;
+        }
+        control = _control;
+        /*
+         * The writer is a SCHED_IDLE thread in another process that may be
+         * preempted or die mid-update, so don't spin on it indefinitely.
+         */
+        for (int attempt = 0; attempt < DS_AUDIO_DSP_READ_ATTEMPTS; attempt++) {
+                seq = __atomic_load_n(&control->m_loudnessLock.m_seq, __ATOMIC_ACQUIRE);
+                if (seq & 1) {
+                        sched_yield();
+                        continue;
+                }
+                *loudness = control->m_loudness;
+                if (!dsSeqlockReadRetry(&control->m_loudnessLock, seq)) {
+                        pthread_mutex_unlock(&_dspLock);
+                        return loudness->m_updatedNs ? dsERR_NONE : dsERR_GENERAL;
+                }
+        }
+        pthread_mutex_unlock(&_dspLock);
+        return dsERR_GENERAL;
+}
@@ -0,0 +1,87 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSAUDIODSP_H
+#define __DSAUDIODSP_H
+
+#include "dsError.h"
+#include "dsDspControl.h"
+
+/*
+ * HAL side of the pcm_dshal output processing plugin.
+ *
+ * The HAL keeps the authoritative copy of the DSP parameters and publishes
+ * it through the shared control block. Updates are bracketed the same way
+ * as mixer access:
+ *
+ *      dsDspParams_t params;
+ *      dsAudioDspBegin(&params);
+ *      params.m_delayMs = 40;
+ *      ret = dsAudioDspCommit(&params);
+ */
+
+dsError_t dsAudioDspOpen();
+
+void dsAudioDspClose();
+
+/**
+ * @brief Current parameters.
+ */
+void dsAudioDspGet(dsDspParams_t *params);
+
+/**
+ * @brief Lock the parameters for update and return a copy to modify.
+ */
+void dsAudioDspBegin(dsDspParams_t *params);
+
+/**
+ * @brief Store and publish the modified copy, then unlock.
+ *
+ * @return dsERR_GENERAL if the control block could not be created; the
+ *         values are kept and published once it can.
+ */
+dsError_t dsAudioDspCommit(const dsDspParams_t *params);
+
+/**
+ * @brief Latest reading of the output plugin's loudness meter.
+ *
+ * @return dsERR_GENERAL if no plugin has reported since the block was created.
+ */
+dsError_t dsAudioDspGetLoudness(dsDspLoudness_t *loudness);
+
+/* Reference programme loudness used by dsGetAudioOptimalLevel() (ATSC A/85) */
+#define DS_AUDIO_TARGET_LUFS -24.0f
+
+/**
+ * @brief Loudness of what the HDMI output is playing, for telemetry.
+ *
+ * Momentary, short-term and integrated loudness as measured by the pcm_dshal
+ * plugin, before the mixer volume. Values are -INFINITY until measured;
+ * m_updatedNs (CLOCK_MONOTONIC) tells how current they are.
+ */
+dsError_t dsGetAudioLoudness(intptr_t handle, dsDspLoudness_t *loudness);
+
+/**
+ * @brief Set the dialog enhancement level, 0 (off) to 16.
+ *
+ * Declared here as well for dsAudio.h versions that predate it.
+ */
+dsError_t dsSetDialogEnhancement(intptr_t handle, int level);
+
+#endif /* __DSAUDIODSP_H */
@@ -0,0 +1,133 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include "dsUtl.h"
+#include "dsAudioMixer.h"
+#include "dsAudioRamp.h"
+#include "dsAudioGainTable.h"
+#include "dsAudioDucking.h"
+
+#define DUCKING_MAX_ACTIVE 8
+#define DUCKING_RAMP_MS 100
+/* RELATIVE 0%: far enough below any control's range to end up at its minimum */
+#define DUCKING_SILENCE_DB (-100000)
+
+typedef struct _dsAudioDucker_t {
+        dsAudioDuckingType_t m_type;
+        unsigned char m_level;
+} dsAudioDucker_t;
+
+static dsAudioDucker_t _duckers[dsAUDIOPORT_TYPE_MAX][DUCKING_MAX_ACTIVE];
+static int _duckerCount[dsAUDIOPORT_TYPE_MAX];
+static pthread_mutex_t _duckingLock = PTHREAD_MUTEX_INITIALIZER;
+
+static long dsAudioDuckingRelativeDb(unsigned char level)
+{
+        return level == 0 ? DUCKING_SILENCE_DB : lrint(2000.0 * log10(level / 100.0));
+}
+
+/* Combine the active requests and hand the result to the ramp engine. Called with _duckingLock held. */
+static dsError_t dsAudioDuckingApply(dsAudioPortType_t port)
+{
+        dsAudioMixerState_t state;
+        long ceiling = LONG_MAX;
+        long offset = 0;
+
+        if (_duckerCount[port] == 0) {
+                return dsAudioRampDuck(port, false, LONG_MAX, 0, DUCKING_RAMP_MS);
+        }
+        if (!dsAudioMixerGetState(port, &state) || !state.m_hasDb) {
+                return dsERR_GENERAL;
+        }
+        const dsAudioGainTable_t *table = dsAudioGainTableGet(state.m_dBMin, state.m_dBMax);
+        for (int i = 0; i < _duckerCount[port]; i++) {
+                const dsAudioDucker_t *ducker = &_duckers[port][i];
+                if (ducker->m_type == dsAUDIO_DUCKINGTYPE_ABSOLUTE) {
+                        long limit = table ? dsAudioGainTableToDb(table, ducker->m_level) : state.m_dBMin;
+                        ceiling = limit < ceiling ? limit : ceiling;
+                }
+                else {
+                        long attenuation = dsAudioDuckingRelativeDb(ducker->m_level);
+                        offset = attenuation < offset ? attenuation : offset;
+                }
+        }
+        return dsAudioRampDuck(port, true, ceiling, offset, DUCKING_RAMP_MS);
+}
+
+dsError_t dsAudioDuckingUpdate(dsAudioPortType_t port, dsAudioDuckingAction_t action, dsAudioDuckingType_t type, unsigned char level)
+{
+        dsError_t ret;
+
+        if (!dsAudioType_isValid(port) || level > 100 ||
+            (type != dsAUDIO_DUCKINGTYPE_ABSOLUTE && type != dsAUDIO_DUCKINGTYPE_RELATIVE)) {
+                return dsERR_INVALID_PARAM;
+        }
+
+        pthread_mutex_lock(&_duckingLock);
+        dsAudioDucker_t *duckers = _duckers[port];
+        int *count = &_duckerCount[port];
+        if (action == dsAUDIO_DUCKINGACTION_START) {
+                if (*count == DUCKING_MAX_ACTIVE) {
+                        pthread_mutex_unlock(&_duckingLock);
+                        printf("Too many active duckers on audio port %d\n", port);
+                        return dsERR_RESOURCE_NOT_AVAILABLE;
+                }
+                duckers[*count].m_type = type;
+                duckers[*count].m_level = level;
+                (*count)++;
+        }
+        else if (action == dsAUDIO_DUCKINGACTION_STOP) {
+                if (*count == 0) {
+                        pthread_mutex_unlock(&_duckingLock);
+                        return dsERR_NONE;
+                }
+                /* Pair with the newest identical START; failing that, the newest of any */
+                int match = *count - 1;
+                for (int i = *count - 1; i >= 0; i--) {
+                        if (duckers[i].m_type == type && duckers[i].m_level == level) {
+                                match = i;
+                                break;
+                        }
+                }
+                for (int i = match; i < *count - 1; i++) {
+                        duckers[i] = duckers[i + 1];
+                }
+                (*count)--;
+        }
+        else {
+                pthread_mutex_unlock(&_duckingLock);
+                return dsERR_INVALID_PARAM;
+        }
+        ret = dsAudioDuckingApply(port);
+        pthread_mutex_unlock(&_duckingLock);
+        return ret;
+}
+
+void dsAudioDuckingReset()
+{
+        pthread_mutex_lock(&_duckingLock);
+        for (int i = 0; i < dsAUDIOPORT_TYPE_MAX; i++) {
+                _duckerCount[i] = 0;
+        }
+        pthread_mutex_unlock(&_duckingLock);
+}
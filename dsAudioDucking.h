@@ -0,0 +1,47 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSAUDIODUCKING_H
+#define __DSAUDIODUCKING_H
+
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Ducking for dsSetAudioDucking().
+ *
+ * Every START is counted until a matching STOP, so voice guidance and TTS
+ * can duck the same port independently; the deepest attenuation among the
+ * active requests wins. The level is faded down and back up by the ramp
+ * engine, and the level in effect before the first START is restored once
+ * the last one stops.
+ *
+ * ABSOLUTE caps the output at the given volume (same 0..100 scale as
+ * dsSetAudioGain()); RELATIVE scales the current output amplitude to the
+ * given percentage.
+ */
+
+dsError_t dsAudioDuckingUpdate(dsAudioPortType_t port, dsAudioDuckingAction_t action, dsAudioDuckingType_t type, unsigned char level);
+
+/**
+ * @brief Forget all duckers without touching the mixer.
+ */
+void dsAudioDuckingReset();
+
+#endif /* __DSAUDIODUCKING_H */
@@ -0,0 +1,362 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <alsa/asoundlib.h>
+#include "dshalUtils.h"
+#include "dsAudioSinkCaps.h"
+#include "dsAudioStreamFormat.h"
+#include "dsAudioEvents.h"
+
+#define EVENTS_CARD "hw:0"
+#define EVENTS_JACK_NAME "HDMI Jack"
+#define EVENTS_ELD_NAME "ELD"
+#define EVENTS_MAX_FDS 8
+/* Quiet time after a hotplug or ELD event before the sink is read */
+#define EVENTS_SETTLE_MS 100
+/* Interval and attempts to wait for an opened PCM to be configured */
+#define EVENTS_PROBE_MS 20
+#define EVENTS_PROBE_TRIES 25
+
+static pthread_t _dispatcher;
+static bool _running = false;
+static bool _stop = false;
+static int _wakeFd = -1;
+static snd_ctl_t *_ctl = NULL;
+static bool _following = false;         /* hotplug callback registered, holding a tvservice reference */
+
+/* Set by the event sources, consumed by the dispatcher */
+static bool _sinkChanged = false;
+static int _posted = dsAUDIO_FORMAT_NONE;       /* the HAL's own stream, which knows its codec */
+
+/* Format going to the sink, written by the dispatcher and read by dsGetAudioFormat() */
+static int _format = dsAUDIO_FORMAT_NONE;
+
+static dsAudioOutPortConnectCB_t _connectCB = NULL;
+static dsAudioFormatUpdateCB_t _formatCB = NULL;
+static dsAtmosCapsChangeCB_t _atmosCB = NULL;
+
+/* Last delivered values, dispatcher thread only except _connected */
+static bool _connected = false;
+static dsATMOSCapability_t _atmos = dsAUDIO_ATMOS_NOTSUPPORTED;
+static int _deliveredFormat = dsAUDIO_FORMAT_NONE;
+static dsAudioFormat_t _detected = dsAUDIO_FORMAT_NONE;
+
+/* Control events the dispatcher acts on */
+#define EVENTS_CTL_SINK 0x1
+#define EVENTS_CTL_FORMAT 0x2
+
+static void dsAudioEventsWake()
+{
+        uint64_t one = 1;
+        if (_wakeFd >= 0 && write(_wakeFd, &one, sizeof(one)) < 0) {
+                printf("Failed to wake audio event dispatcher\n");
+        }
+}
+
+static void dsAudioEventsHotplug(void *callback_data, uint32_t reason, uint32_t param1, uint32_t param2)
+{
+        if (reason & (VC_HDMI_UNPLUGGED | VC_HDMI_ATTACHED)) {
+                __atomic_store_n(&_sinkChanged, true, __ATOMIC_RELEASE);
+                dsAudioEventsWake();
+        }
+}
+
+/* @return 1 or 0 for the jack state, -1 if the card has no jack control */
+static int dsAudioEventsReadJack()
+{
+        snd_ctl_elem_value_t *value;
+        if (_ctl == NULL) {
+                return -1;
+        }
+        snd_ctl_elem_value_alloca(&value);
+        snd_ctl_elem_value_set_interface(value, SND_CTL_ELEM_IFACE_CARD);
+        snd_ctl_elem_value_set_name(value, EVENTS_JACK_NAME);
+        if (snd_ctl_elem_read(_ctl, value) < 0) {
+                return -1;
+        }
+        return snd_ctl_elem_value_get_boolean(value, 0) ? 1 : 0;
+}
+
+static bool dsAudioEventsSinkConnected()
+{
+        TV_DISPLAY_STATE_T tvstate;
+        int jack = dsAudioEventsReadJack();
+        if (jack >= 0) {
+                return jack == 1;
+        }
+        memset(&tvstate, 0, sizeof(tvstate));
+        return vc_tv_get_display_state(&tvstate) == 0 && !(tvstate.state & VC_HDMI_UNPLUGGED) &&
+               (tvstate.state & (VC_HDMI_ATTACHED | VC_HDMI_HDMI | VC_HDMI_DVI));
+}
+
+/* Drain the control events; @return the EVENTS_CTL_ kinds among them */
+static int dsAudioEventsReadCtl()
+{
+        snd_ctl_event_t *event;
+        int kinds = 0;
+
+        snd_ctl_event_alloca(&event);
+        while (snd_ctl_read(_ctl, event) > 0) {
+                if (snd_ctl_event_get_type(event) != SND_CTL_EVENT_ELEM) {
+                        continue;
+                }
+                const char *name = snd_ctl_event_elem_get_name(event);
+                if (strcmp(name, EVENTS_JACK_NAME) == 0 || strcmp(name, EVENTS_ELD_NAME) == 0) {
+                        kinds |= EVENTS_CTL_SINK;
+                }
+                else if (dsAudioStreamFormatIsControl(name)) {
+                        kinds |= EVENTS_CTL_FORMAT;
+                }
+        }
+        return kinds;
+}
+
+static void dsAudioEventsDeliverSink()
+{
+        dsAudioSinkCaps_t caps;
+        const bool connected = dsAudioEventsSinkConnected();
+
+        dsAudioSinkCapsInvalidate();
+        dsAudioSinkCapsGet(&caps);
+        const dsATMOSCapability_t atmos = connected ? caps.m_atmos : dsAUDIO_ATMOS_NOTSUPPORTED;
+
+        if (connected != _connected) {
+                __atomic_store_n(&_connected, connected, __ATOMIC_RELEASE);
+                dsAudioOutPortConnectCB_t cb = __atomic_load_n(&_connectCB, __ATOMIC_ACQUIRE);
+                if (cb) {
+                        cb(dsAUDIOPORT_TYPE_HDMI, 0, connected);
+                }
+        }
+        if (atmos != _atmos) {
+                _atmos = atmos;
+                dsAtmosCapsChangeCB_t cb = __atomic_load_n(&_atmosCB, __ATOMIC_ACQUIRE);
+                if (cb) {
+                        cb(atmos, connected);
+                }
+        }
+}
+
+static int dsAudioEventsCurrentFormat()
+{
+        const int posted = __atomic_load_n(&_posted, __ATOMIC_ACQUIRE);
+        return posted != dsAUDIO_FORMAT_NONE ? posted : (int) _detected;
+}
+
+static void dsAudioEventsDeliverFormat()
+{
+        const int format = dsAudioEventsCurrentFormat();
+        __atomic_store_n(&_format, format, __ATOMIC_RELEASE);
+        if (format != _deliveredFormat) {
+                _deliveredFormat = format;
+                dsAudioFormatUpdateCB_t cb = __atomic_load_n(&_formatCB, __ATOMIC_ACQUIRE);
+                if (cb) {
+                        cb((dsAudioFormat_t) format);
+                }
+        }
+}
+
+static uint64_t dsAudioEventsNowMs()
+{
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/* Milliseconds until the earlier of two deadlines (0 = none), -1 for none */
+static int dsAudioEventsTimeout(uint64_t now, uint64_t a, uint64_t b)
+{
+        uint64_t next = a && (!b || a < b) ? a : b;
+        if (next == 0) {
+                return -1;
+        }
+        return next > now ? (int)(next - now) : 0;
+}
+
+static void* dsAudioEventsDispatcher(void *arg)
+{
+        struct pollfd pfds[EVENTS_MAX_FDS];
+        int nfds = 1, ctlFds = 0;
+        uint64_t settleAt = 0, probeAt = 0;
+        int probes = 0;
+
+        pfds[0].fd = _wakeFd;
+        pfds[0].events = POLLIN;
+        if (dsAudioStreamFormatFd() >= 0) {
+                pfds[nfds].fd = dsAudioStreamFormatFd();
+                pfds[nfds].events = POLLIN;
+                nfds++;
+        }
+        if (_ctl != NULL) {
+                ctlFds = snd_ctl_poll_descriptors(_ctl, pfds + nfds, EVENTS_MAX_FDS - nfds);
+                ctlFds = ctlFds > 0 ? ctlFds : 0;
+        }
+
+        for (;;) {
+                const int ready = poll(pfds, nfds + ctlFds, dsAudioEventsTimeout(dsAudioEventsNowMs(), settleAt, probeAt));
+                if (__atomic_load_n(&_stop, __ATOMIC_ACQUIRE)) {
+                        break;
+                }
+                if (ready < 0) {
+                        continue;
+                }
+                if (pfds[0].revents & POLLIN) {
+                        uint64_t value;
+                        if (read(_wakeFd, &value, sizeof(value)) < 0) {
+                                printf("Failed to drain audio event wake fd\n");
+                        }
+                }
+                const uint64_t now = dsAudioEventsNowMs();
+                bool probe = nfds > 1 && (pfds[1].revents & POLLIN) && dsAudioStreamFormatReadEvents();
+                if (ctlFds > 0) {
+                        unsigned short revents = 0;
+                        snd_ctl_poll_descriptors_revents(_ctl, pfds + nfds, ctlFds, &revents);
+                        const int kinds = (revents & POLLIN) ? dsAudioEventsReadCtl() : 0;
+                        if (kinds & EVENTS_CTL_SINK) {
+                                settleAt = now + EVENTS_SETTLE_MS;
+                        }
+                        probe = probe || (kinds & EVENTS_CTL_FORMAT);
+                }
+                if (__atomic_exchange_n(&_sinkChanged, false, __ATOMIC_ACQ_REL)) {
+                        settleAt = now + EVENTS_SETTLE_MS;
+                }
+                if (probe) {
+                        probeAt = now;
+                        probes = EVENTS_PROBE_TRIES;
+                }
+                if (settleAt && now >= settleAt) {
+                        /* Settled: nothing new for EVENTS_SETTLE_MS */
+                        settleAt = 0;
+                        dsAudioEventsDeliverSink();
+                }
+                if (probeAt && now >= probeAt) {
+                        /* A player opens the PCM before choosing its parameters */
+                        const bool configured = dsAudioStreamFormatProbe(_ctl, &_detected);
+                        probeAt = !configured && --probes > 0 ? now + EVENTS_PROBE_MS : 0;
+                }
+                dsAudioEventsDeliverFormat();
+        }
+        return NULL;
+}
+
+dsError_t dsAudioEventsInit()
+{
+        dsAudioSinkCaps_t caps;
+
+        if (_running) {
+                return dsERR_NONE;
+        }
+        if (snd_ctl_open(&_ctl, EVENTS_CARD, SND_CTL_NONBLOCK) < 0) {
+                _ctl = NULL;
+        } else if (snd_ctl_subscribe_events(_ctl, 1) < 0) {
+                snd_ctl_close(_ctl);
+                _ctl = NULL;
+        }
+        if (vchi_tv_init() == 0) {
+                vc_tv_register_callback(&dsAudioEventsHotplug, NULL);
+                _following = true;
+        }
+        dsAudioStreamFormatInit();
+        /* Only changes from here on are reported */
+        _connected = dsAudioEventsSinkConnected();
+        dsAudioSinkCapsGet(&caps);
+        _atmos = _connected ? caps.m_atmos : dsAUDIO_ATMOS_NOTSUPPORTED;
+        dsAudioStreamFormatProbe(_ctl, &_detected);
+        _deliveredFormat = dsAudioEventsCurrentFormat();
+        __atomic_store_n(&_format, _deliveredFormat, __ATOMIC_RELEASE);
+        _sinkChanged = false;
+        _stop = false;
+
+        _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_wakeFd < 0 || pthread_create(&_dispatcher, NULL, dsAudioEventsDispatcher, NULL) != 0) {
+                printf("Failed to start audio event dispatcher\n");
+                dsAudioEventsTerm();
+                return dsERR_GENERAL;
+        }
+        __atomic_store_n(&_running, true, __ATOMIC_RELEASE);
+        return dsERR_NONE;
+}
+
+void dsAudioEventsTerm()
+{
+        if (_following) {
+                vc_tv_unregister_callback_full(&dsAudioEventsHotplug, NULL);
+                vchi_tv_uninit();
+                _following = false;
+        }
+        if (__atomic_load_n(&_running, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&_running, false, __ATOMIC_RELEASE);
+                __atomic_store_n(&_stop, true, __ATOMIC_RELEASE);
+                dsAudioEventsWake();
+                pthread_join(_dispatcher, NULL);
+        }
+        if (_wakeFd >= 0) {
+                close(_wakeFd);
+                _wakeFd = -1;
+        }
+        dsAudioStreamFormatTerm();
+        if (_ctl != NULL) {
+                snd_ctl_close(_ctl);
+                _ctl = NULL;
+        }
+}
+
+void dsAudioEventsSetConnectCB(dsAudioOutPortConnectCB_t cb)
+{
+        __atomic_store_n(&_connectCB, cb, __ATOMIC_RELEASE);
+}
+
+void dsAudioEventsSetFormatCB(dsAudioFormatUpdateCB_t cb)
+{
+        __atomic_store_n(&_formatCB, cb, __ATOMIC_RELEASE);
+}
+
+void dsAudioEventsSetAtmosCapsCB(dsAtmosCapsChangeCB_t cb)
+{
+        __atomic_store_n(&_atmosCB, cb, __ATOMIC_RELEASE);
+}
+
+dsError_t dsAudioEventsIsConnected(dsAudioPortType_t port, bool *connected)
+{
+        if (port != dsAUDIOPORT_TYPE_HDMI) {
+                return dsERR_OPERATION_NOT_SUPPORTED;
+        }
+        /* Before dsAudioPortInit() there is no dispatcher keeping the state */
+        *connected = __atomic_load_n(&_running, __ATOMIC_ACQUIRE) ? __atomic_load_n(&_connected, __ATOMIC_ACQUIRE)
+                                                                   : dsAudioEventsSinkConnected();
+        return dsERR_NONE;
+}
+
+void dsAudioEventsFormatChanged(dsAudioFormat_t format)
+{
+        if (__atomic_exchange_n(&_posted, (int) format, __ATOMIC_ACQ_REL) != (int) format) {
+                dsAudioEventsWake();
+        }
+}
+
+dsAudioFormat_t dsAudioEventsGetFormat()
+{
+        return (dsAudioFormat_t) __atomic_load_n(&_format, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,65 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSAUDIOEVENTS_H
+#define __DSAUDIOEVENTS_H
+
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Audio output event dispatcher.
+ *
+ * A HAL thread waits on the HDMI card's ALSA control events (jack, ELD and
+ * channel status changes), tvservice hotplug notifications, opens and closes
+ * of the HDMI PCM and format changes posted by the HAL, and calls the
+ * registered dsAudio callbacks from that thread. Each
+ * callback fires only when the value it reports differs from the one last
+ * delivered; hotplug bursts are coalesced until the link has settled.
+ */
+
+dsError_t dsAudioEventsInit();
+
+void dsAudioEventsTerm();
+
+void dsAudioEventsSetConnectCB(dsAudioOutPortConnectCB_t cb);
+void dsAudioEventsSetFormatCB(dsAudioFormatUpdateCB_t cb);
+void dsAudioEventsSetAtmosCapsCB(dsAtmosCapsChangeCB_t cb);
+
+/**
+ * @brief Whether a sink is connected to the port, as last seen by the dispatcher.
+ *
+ * @return dsERR_OPERATION_NOT_SUPPORTED for ports without connection detection.
+ */
+dsError_t dsAudioEventsIsConnected(dsAudioPortType_t port, bool *connected);
+
+/**
+ * @brief Report the format now going to the sink. Does not block; may be called with locks held.
+ */
+void dsAudioEventsFormatChanged(dsAudioFormat_t format);
+
+/**
+ * @brief The format going to the sink, as last seen by the dispatcher. Lock-free.
+ *
+ * A format posted by the HAL's own stream takes precedence over the one
+ * detected on the PCM (dsAudioStreamFormat.h).
+ */
+dsAudioFormat_t dsAudioEventsGetFormat();
+
+#endif /* __DSAUDIOEVENTS_H */
@@ -0,0 +1,220 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include <alsa/asoundlib.h>
+#include "dsAudioGainTable.h"
+
+#define MAX_LINEAR_DB_SCALE 24
+/*
+ * Knots are on every 0.1% of absolute gain, so whole-percent gains convert
+ * exactly; gains below m_gainLo never reach the table.
+ */
+#define GAIN_TABLE_STEPS 1000
+#define GAIN_KNOTS_PER_PERCENT (GAIN_TABLE_STEPS / 100.0f)
+#define DB_TABLE_STEPS 1024
+/* With a mute bottom, gains that report as 0% map straight to mute */
+#define MUTE_GAIN_THRESHOLD 0.5f
+
+struct _dsAudioGainTable_t {
+        long m_dBMin;
+        long m_dBMax;
+        bool m_linear;
+        float m_gainLo;                 /* below this the level is m_dBMin        */
+        long m_dBLo;                    /* below this the gain is 0               */
+        float m_dBScale;                /* knots per 1/100 dB                     */
+        float m_toDb[GAIN_TABLE_STEPS + 1];
+        float m_toGain[DB_TABLE_STEPS + 1];
+        struct _dsAudioGainTable_t *m_next;
+};
+
+static dsAudioGainTable_t *_current = NULL;
+static dsAudioGainTable_t *_tables = NULL;
+static pthread_mutex_t _tableLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The closed forms the tables are sampled from; only used while building. */
+static double dsAudioGainTableMinNorm(long dBMin, long dBMax)
+{
+        return dBMin != SND_CTL_TLV_DB_GAIN_MUTE ? pow(10, (dBMin - dBMax) / 6000.0) : 0.0;
+}
+
+static double dsAudioGainCurveToDb(long dBMin, long dBMax, double gain)
+{
+        double min_norm = dsAudioGainTableMinNorm(dBMin, dBMax);
+        double normalized = (gain / 100.0) * (1 - min_norm) + min_norm;
+        return 6000.0 * log10(normalized) + dBMax;
+}
+
+static double dsAudioGainCurveToGain(long dBMin, long dBMax, double dB)
+{
+        double min_norm = dsAudioGainTableMinNorm(dBMin, dBMax);
+        double normalized = pow(10, (dB - dBMax) / 6000.0);
+        return 100.0 * (normalized - min_norm) / (1 - min_norm);
+}
+
+static dsAudioGainTable_t* dsAudioGainTableBuild(long dBMin, long dBMax)
+{
+        dsAudioGainTable_t *table = (dsAudioGainTable_t*) calloc(1, sizeof(dsAudioGainTable_t));
+        if (table == NULL) {
+                return NULL;
+        }
+        table->m_dBMin = dBMin;
+        table->m_dBMax = dBMax;
+        table->m_linear = (dBMax - dBMin) <= MAX_LINEAR_DB_SCALE * 100;
+        if (table->m_linear) {
+                /* Affine both ways, nothing to sample */
+                return table;
+        }
+
+        table->m_gainLo = (dBMin == SND_CTL_TLV_DB_GAIN_MUTE) ? MUTE_GAIN_THRESHOLD : 0.0f;
+        double dBLo = dsAudioGainCurveToDb(dBMin, dBMax, table->m_gainLo);
+        for (int i = 0; i <= GAIN_TABLE_STEPS; i++) {
+                double gain = i * 100.0 / GAIN_TABLE_STEPS;
+                /* Knots under m_gainLo are only read for gains that get clamped; keep them finite */
+                table->m_toDb[i] = (float) (gain < table->m_gainLo ? dBLo : dsAudioGainCurveToDb(dBMin, dBMax, gain));
+        }
+
+        table->m_dBLo = lrint(dBLo);
+        table->m_dBScale = DB_TABLE_STEPS / (float)(dBMax - table->m_dBLo);
+        for (int i = 0; i <= DB_TABLE_STEPS; i++) {
+                double dB = table->m_dBLo + i * (double)(dBMax - table->m_dBLo) / DB_TABLE_STEPS;
+                table->m_toGain[i] = (float) dsAudioGainCurveToGain(dBMin, dBMax, dB);
+        }
+        return table;
+}
+
+const dsAudioGainTable_t* dsAudioGainTableGet(long dBMin, long dBMax)
+{
+        dsAudioGainTable_t *table = __atomic_load_n(&_current, __ATOMIC_ACQUIRE);
+        if (table && table->m_dBMin == dBMin && table->m_dBMax == dBMax) {
+                return table;
+        }
+        if (dBMax <= dBMin) {
+                return NULL;
+        }
+
+        pthread_mutex_lock(&_tableLock);
+        for (table = _tables; table; table = table->m_next) {
+                if (table->m_dBMin == dBMin && table->m_dBMax == dBMax) {
+                        break;
+                }
+        }
+        if (table == NULL && (table = dsAudioGainTableBuild(dBMin, dBMax)) != NULL) {
+                /* Superseded tables stay on the list; readers may still hold them */
+                table->m_next = _tables;
+                _tables = table;
+        }
+        if (table) {
+                __atomic_store_n(&_current, table, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&_tableLock);
+        return table;
+}
+
+void dsAudioGainTableReleaseAll()
+{
+        pthread_mutex_lock(&_tableLock);
+        __atomic_store_n(&_current, (dsAudioGainTable_t*) NULL, __ATOMIC_RELEASE);
+        while (_tables) {
+                dsAudioGainTable_t *next = _tables->m_next;
+                free(_tables);
+                _tables = next;
+        }
+        pthread_mutex_unlock(&_tableLock);
+}
+
+static inline float dsAudioGainTableLookup(const float *knots, int steps, float position)
+{
+        position = position < 0 ? 0 : (position > steps ? steps : position);
+        int index = (int) position;
+        index = index < steps ? index : steps - 1;
+        float frac = position - index;
+        return knots[index] + frac * (knots[index + 1] - knots[index]);
+}
+
+long dsAudioGainTableToDb(const dsAudioGainTable_t *table, float gain)
+{
+        gain = gain < 0 ? 0 : (gain > 100 ? 100 : gain);
+        if (table->m_linear) {
+                return lrint(gain / 100.0f * (table->m_dBMax - table->m_dBMin)) + table->m_dBMin;
+        }
+        if (gain < table->m_gainLo) {
+                return table->m_dBMin;
+        }
+        return lrintf(dsAudioGainTableLookup(table->m_toDb, GAIN_TABLE_STEPS, gain * GAIN_KNOTS_PER_PERCENT));
+}
+
+/* Both branches report whole percents, as dsGetAudioGain() always has on the curve. */
+static inline float dsAudioGainTableLinearGain(long dB, long dBMin, float scale)
+{
+        float gain = (dB - dBMin) * scale;
+        gain = gain < 0 ? 0 : (gain > 100 ? 100 : gain);
+        return (float)(int)(gain + 0.5f);
+}
+
+float dsAudioGainTableToGain(const dsAudioGainTable_t *table, long dB)
+{
+        if (table->m_linear) {
+                return dsAudioGainTableLinearGain(dB, table->m_dBMin, 100.0f / (table->m_dBMax - table->m_dBMin));
+        }
+        if (dB <= table->m_dBLo) {
+                return 0.0f;
+        }
+        float gain = dsAudioGainTableLookup(table->m_toGain, DB_TABLE_STEPS, (dB - table->m_dBLo) * table->m_dBScale);
+        return (float)(int)(gain + 0.5f);
+}
+
+/*
+ * The batch loops below have no calls or early exits in the body so the
+ * compiler can vectorise the clamping and interpolation arithmetic.
+ */
+void dsAudioGainTableToDbBatch(const dsAudioGainTable_t *table, const float *gains, long *dB, size_t count)
+{
+        if (table->m_linear) {
+                const float span = (float)(table->m_dBMax - table->m_dBMin) / 100.0f;
+                for (size_t i = 0; i < count; i++) {
+                        float gain = gains[i] < 0 ? 0 : (gains[i] > 100 ? 100 : gains[i]);
+                        dB[i] = lrintf(gain * span) + table->m_dBMin;
+                }
+                return;
+        }
+        for (size_t i = 0; i < count; i++) {
+                float gain = gains[i] > 100 ? 100 : gains[i];
+                float value = dsAudioGainTableLookup(table->m_toDb, GAIN_TABLE_STEPS, gain * GAIN_KNOTS_PER_PERCENT);
+                dB[i] = gain < table->m_gainLo ? table->m_dBMin : lrintf(value);
+        }
+}
+
+void dsAudioGainTableToGainBatch(const dsAudioGainTable_t *table, const long *dB, float *gains, size_t count)
+{
+        if (table->m_linear) {
+                const float scale = 100.0f / (table->m_dBMax - table->m_dBMin);
+                for (size_t i = 0; i < count; i++) {
+                        gains[i] = dsAudioGainTableLinearGain(dB[i], table->m_dBMin, scale);
+                }
+                return;
+        }
+        for (size_t i = 0; i < count; i++) {
+                float gain = dsAudioGainTableLookup(table->m_toGain, DB_TABLE_STEPS, (dB[i] - table->m_dBLo) * table->m_dBScale);
+                gains[i] = dB[i] <= table->m_dBLo ? 0.0f : (float)(int)(gain + 0.5f);
+        }
+}
@@ -0,0 +1,82 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSAUDIOGAINTABLE_H
+#define __DSAUDIOGAINTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Gain <-> mixer dB conversion.
+ *
+ * dsGetAudioGain()/dsSetAudioGain() map the 0..100 gain onto the control's
+ * dB range linearly when the range spans 24 dB or less, and otherwise with
+ * the 60 dB/decade curve alsamixer uses. Both directions are sampled once
+ * per dB range into tables and answered by linear interpolation, so no
+ * pow()/log10() runs per call. Tables are immutable once published and are
+ * shared between threads without locking.
+ *
+ * Gains are in percent, dB values in 1/100 dB as the mixer uses them.
+ * dB -> gain reports whole percents on both scales, so a whole-percent gain
+ * reads back unchanged whenever the range spans more than 1 dB.
+ */
+
+typedef struct _dsAudioGainTable_t dsAudioGainTable_t;
+
+/**
+ * @brief Tables for a mixer dB range, built on first use.
+ *
+ * @return NULL if the range is empty or allocation fails.
+ */
+const dsAudioGainTable_t* dsAudioGainTableGet(long dBMin, long dBMax);
+
+/**
+ * @brief Free all tables. Only call once nothing can be converting any more.
+ */
+void dsAudioGainTableReleaseAll();
+
+long dsAudioGainTableToDb(const dsAudioGainTable_t *table, float gain);
+
+float dsAudioGainTableToGain(const dsAudioGainTable_t *table, long dB);
+
+void dsAudioGainTableToDbBatch(const dsAudioGainTable_t *table, const float *gains, long *dB, size_t count);
+
+void dsAudioGainTableToGainBatch(const dsAudioGainTable_t *table, const long *dB, float *gains, size_t count);
+
+/**
+ * @brief Convert a list of gains to the dB levels dsSetAudioGain() would set on a port.
+ *
+ * Meant for drawing volume curves; nothing is written to the mixer.
+ *
+ * @param [in]  handle  Handle of the audio port.
+ * @param [in]  gains   Gains in the range 0..100.
+ * @param [out] dBs     dB value for each gain.
+ * @param [in]  count   Number of entries.
+ */
+dsError_t dsAudioGainToDbBatch(intptr_t handle, const float *gains, float *dBs, size_t count);
+
+/**
+ * @brief Convert a list of dB levels to the gains dsGetAudioGain() would report on a port.
+ */
+dsError_t dsAudioDbToGainBatch(intptr_t handle, const float *dBs, float *gains, size_t count);
+
+#endif /* __DSAUDIOGAINTABLE_H */
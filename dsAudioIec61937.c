@@ -0,0 +1,458 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <alsa/asoundlib.h>
+#include "dsAudioIec61937.h"
+#include "dsAudioEvents.h"
+
+#define IEC61937_FALLBACK_PCM "hw:0,0"
+#define IEC61937_STATUS_NAME "IEC958 Playback Default"
+#define IEC61937_PERIODS 4              /* ring size, in bursts */
+#define IEC61937_WAIT_MS 1000
+
+/* Burst preamble, IEC 61937-1 */
+#define IEC61937_PA 0xF872
+#define IEC61937_PB 0x4E1F
+#define IEC61937_PREAMBLE_BYTES 8
+/* Data types, IEC 61937-3 */
+#define IEC61937_TYPE_AC3 0x01
+#define IEC61937_TYPE_EAC3 0x15
+/* PCM frames per burst at the link rate: 1536 samples, E-AC-3 at four times the rate */
+#define IEC61937_AC3_BURST_FRAMES 1536
+#define IEC61937_EAC3_BURST_FRAMES 6144
+#define IEC61937_EAC3_BLOCKS 6          /* audio blocks per E-AC-3 burst */
+#define IEC61937_FRAME_BYTES 4          /* S16_LE stereo */
+
+typedef struct _dsAudioIec61937_t {
+        snd_pcm_t *m_pcm;
+        snd_ctl_t *m_ctl;               /* card of the PCM, NULL if it has none (file PCMs) */
+        snd_ctl_elem_value_t *m_status; /* channel status control, holding the value to restore */
+        snd_aes_iec958_t m_savedStatus;
+        dsAudioEncoding_t m_encoding;
+        uint32_t m_rate;
+        snd_pcm_uframes_t m_burstFrames;
+        snd_pcm_uframes_t m_bufferFrames;
+        /* Burst being filled: ring position and payload so far */
+        bool m_inBurst;
+        uint8_t *m_ring;
+        snd_pcm_uframes_t m_burstOffset;
+        uint32_t m_payloadBytes;
+        uint32_t m_blocks;
+        uint16_t m_dataType;
+} dsAudioIec61937_t;
+
+typedef struct _dsAudioIec61937Frame_t {
+        dsAudioEncoding_t m_encoding;
+        uint32_t m_rate;
+        uint32_t m_bytes;               /* first syncframe */
+        uint32_t m_blocks;              /* audio blocks, E-AC-3 */
+        uint32_t m_bsmod;               /* AC-3 bitstream mode, goes into the data type */
+} dsAudioIec61937Frame_t;
+
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+static dsAudioIec61937_t _stream;
+
+static const uint32_t kAc3Rates[3] = { 48000, 44100, 32000 };
+static const uint16_t kAc3Kbps[19] = { 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 576, 640 };
+static const uint32_t kEac3Blocks[4] = { 1, 2, 3, 6 };
+
+/* Parse the sync info and bitstream info common to AC-3 (bsid <= 8) and E-AC-3 (bsid 11-16) */
+static bool dsAudioIec61937Parse(const uint8_t *data, size_t size, dsAudioIec61937Frame_t *frame)
+{
+        if (size < 6 || data[0] != 0x0B || data[1] != 0x77) {
+                return false;
+        }
+        const uint32_t bsid = data[5] >> 3;
+        const uint32_t fscod = data[4] >> 6;
+        if (bsid <= 8) {
+                const uint32_t frmsizecod = data[4] & 0x3F;
+                if (fscod == 3 || frmsizecod >= 2 * 19) {
+                        return false;
+                }
+                const uint32_t kbps = kAc3Kbps[frmsizecod >> 1];
+                /* Words per syncframe: 1536 samples at the bit rate; 44.1 kHz alternates by one word */
+                const uint32_t words = fscod == 0 ? 2 * kbps : (fscod == 2 ? 3 * kbps : kbps * 320 / 147 + (frmsizecod & 1));
+                frame->m_encoding = dsAUDIO_ENC_AC3;
+                frame->m_rate = kAc3Rates[fscod];
+                frame->m_bytes = 2 * words;
+                frame->m_blocks = IEC61937_EAC3_BLOCKS;
+                frame->m_bsmod = data[5] & 0x07;
+                return true;
+        }
+        if (bsid >= 11 && bsid <= 16) {
+                frame->m_encoding = dsAUDIO_ENC_EAC3;
+                frame->m_bytes = 2 * ((((uint32_t) data[2] & 0x07) << 8 | data[3]) + 1);
+                if (fscod == 3) {
+                        /* Reduced rates (fscod2), always six blocks */
+                        static const uint32_t kHalfRates[3] = { 24000, 22050, 16000 };
+                        const uint32_t fscod2 = (data[4] >> 4) & 0x03;
+                        if (fscod2 == 3) {
+                                return false;
+                        }
+                        frame->m_rate = kHalfRates[fscod2];
+                        frame->m_blocks = IEC61937_EAC3_BLOCKS;
+                } else {
+                        frame->m_rate = kAc3Rates[fscod];
+                        frame->m_blocks = kEac3Blocks[(data[4] >> 4) & 0x03];
+                }
+                frame->m_bsmod = 0;
+                return true;
+        }
+        return false;
+}
+
+static unsigned char dsAudioIec61937RateCode(uint32_t linkRate)
+{
+        switch (linkRate) {
+        case 32000:  return IEC958_AES3_CON_FS_32000;
+        case 44100:  return IEC958_AES3_CON_FS_44100;
+        case 48000:  return IEC958_AES3_CON_FS_48000;
+        case 176400: return IEC958_AES3_CON_FS_176400;
+        case 192000: return IEC958_AES3_CON_FS_192000;
+        default:     return IEC958_AES3_CON_FS_NOTID;
+        }
+}
+
+/*
+ * Mark the stream non-audio in the card's channel status, as the "hdmi"
+ * and "iec958" ALSA devices do with their AES0-3 arguments. Not fatal: PCMs
+ * without a card have nothing to set.
+ */
+static void dsAudioIec61937SetStatus(uint32_t linkRate)
+{
+        snd_pcm_info_t *info;
+        snd_aes_iec958_t status;
+        char name[16];
+        int card, err;
+
+        snd_pcm_info_alloca(&info);
+        if (snd_pcm_info(_stream.m_pcm, info) < 0 || (card = snd_pcm_info_get_card(info)) < 0) {
+                return;
+        }
+        snprintf(name, sizeof(name), "hw:%d", card);
+        if ((err = snd_ctl_open(&_stream.m_ctl, name, 0)) < 0) {
+                printf("IEC 61937: cannot open %s: %s\n", name, snd_strerror(err));
+                _stream.m_ctl = NULL;
+                return;
+        }
+        if (snd_ctl_elem_value_malloc(&_stream.m_status) < 0) {
+                _stream.m_status = NULL;
+                return;
+        }
+        /* Per-device PCM interface on the firmware driver, mixer interface on vc4-hdmi */
+        snd_ctl_elem_value_set_interface(_stream.m_status, SND_CTL_ELEM_IFACE_PCM);
+        snd_ctl_elem_value_set_device(_stream.m_status, snd_pcm_info_get_device(info));
+        snd_ctl_elem_value_set_name(_stream.m_status, IEC61937_STATUS_NAME);
+        if (snd_ctl_elem_read(_stream.m_ctl, _stream.m_status) < 0) {
+                snd_ctl_elem_value_set_interface(_stream.m_status, SND_CTL_ELEM_IFACE_MIXER);
+                snd_ctl_elem_value_set_device(_stream.m_status, 0);
+                if ((err = snd_ctl_elem_read(_stream.m_ctl, _stream.m_status)) < 0) {
+                        printf("IEC 61937: no channel status control on %s: %s\n", name, snd_strerror(err));
+                        snd_ctl_elem_value_free(_stream.m_status);
+                        _stream.m_status = NULL;
+                        return;
+                }
+        }
+        snd_ctl_elem_value_get_iec958(_stream.m_status, &_stream.m_savedStatus);
+        memset(&status, 0, sizeof(status));
+        status.status[0] = IEC958_AES0_NONAUDIO | IEC958_AES0_CON_NOT_COPYRIGHT;
+        status.status[1] = IEC958_AES1_CON_ORIGINAL | IEC958_AES1_CON_PCM_CODER;
+        status.status[3] = dsAudioIec61937RateCode(linkRate);
+        snd_ctl_elem_value_set_iec958(_stream.m_status, &status);
+        if ((err = snd_ctl_elem_write(_stream.m_ctl, _stream.m_status)) < 0) {
+                printf("IEC 61937: setting channel status failed: %s\n", snd_strerror(err));
+        }
+}
+
+static void dsAudioIec61937RestoreStatus()
+{
+        if (_stream.m_status != NULL) {
+                snd_ctl_elem_value_set_iec958(_stream.m_status, &_stream.m_savedStatus);
+                snd_ctl_elem_write(_stream.m_ctl, _stream.m_status);
+                snd_ctl_elem_value_free(_stream.m_status);
+                _stream.m_status = NULL;
+        }
+        if (_stream.m_ctl != NULL) {
+                snd_ctl_close(_stream.m_ctl);
+                _stream.m_ctl = NULL;
+        }
+}
+
+static void dsAudioIec61937CloseLocked()
+{
+        if (_stream.m_pcm == NULL) {
+                return;
+        }
+        snd_pcm_drop(_stream.m_pcm);
+        dsAudioIec61937RestoreStatus();
+        snd_pcm_close(_stream.m_pcm);
+        memset(&_stream, 0, sizeof(_stream));
+        dsAudioEventsFormatChanged(dsAUDIO_FORMAT_NONE);
+}
+
+static int dsAudioIec61937Configure(uint32_t linkRate)
+{
+        snd_pcm_hw_params_t *hw;
+        snd_pcm_sw_params_t *sw;
+        snd_pcm_uframes_t period = _stream.m_burstFrames;
+        snd_pcm_uframes_t buffer = _stream.m_burstFrames * IEC61937_PERIODS;
+        int err;
+
+        snd_pcm_hw_params_alloca(&hw);
+        snd_pcm_sw_params_alloca(&sw);
+        if ((err = snd_pcm_hw_params_any(_stream.m_pcm, hw)) < 0 ||
+            (err = snd_pcm_hw_params_set_access(_stream.m_pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0 ||
+            (err = snd_pcm_hw_params_set_format(_stream.m_pcm, hw, SND_PCM_FORMAT_S16_LE)) < 0 ||
+            (err = snd_pcm_hw_params_set_channels(_stream.m_pcm, hw, 2)) < 0 ||
+            /* A resampled burst is noise to the sink */
+            (err = snd_pcm_hw_params_set_rate_resample(_stream.m_pcm, hw, 0)) < 0 ||
+            (err = snd_pcm_hw_params_set_rate(_stream.m_pcm, hw, linkRate, 0)) < 0 ||
+            (err = snd_pcm_hw_params_set_period_size_near(_stream.m_pcm, hw, &period, NULL)) < 0 ||
+            (err = snd_pcm_hw_params_set_buffer_size_near(_stream.m_pcm, hw, &buffer)) < 0 ||
+            (err = snd_pcm_hw_params(_stream.m_pcm, hw)) < 0) {
+                return err;
+        }
+        if (buffer < 2 * _stream.m_burstFrames) {
+                return -EINVAL;
+        }
+        _stream.m_bufferFrames = buffer;
+        /* Start once two bursts are queued; wake up when one fits */
+        if ((err = snd_pcm_sw_params_current(_stream.m_pcm, sw)) < 0 ||
+            (err = snd_pcm_sw_params_set_start_threshold(_stream.m_pcm, sw, 2 * _stream.m_burstFrames)) < 0 ||
+            (err = snd_pcm_sw_params_set_avail_min(_stream.m_pcm, sw, _stream.m_burstFrames)) < 0 ||
+            (err = snd_pcm_sw_params(_stream.m_pcm, sw)) < 0) {
+                return err;
+        }
+        return snd_pcm_prepare(_stream.m_pcm);
+}
+
+dsError_t dsAudioIec61937Open(dsAudioEncoding_t encoding, uint32_t sampleRate)
+{
+        uint32_t linkRate;
+        int err;
+
+        if ((encoding != dsAUDIO_ENC_AC3 && encoding != dsAUDIO_ENC_EAC3) ||
+            (sampleRate != 32000 && sampleRate != 44100 && sampleRate != 48000)) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_lock);
+        if (_stream.m_pcm != NULL) {
+                pthread_mutex_unlock(&_lock);
+                return dsERR_INVALID_STATE;
+        }
+        if ((err = snd_pcm_open(&_stream.m_pcm, DS_AUDIO_IEC61937_PCM, SND_PCM_STREAM_PLAYBACK, 0)) < 0 &&
+            (err = snd_pcm_open(&_stream.m_pcm, IEC61937_FALLBACK_PCM, SND_PCM_STREAM_PLAYBACK, 0)) < 0) {
+                printf("IEC 61937: cannot open %s: %s\n", IEC61937_FALLBACK_PCM, snd_strerror(err));
+                _stream.m_pcm = NULL;
+                pthread_mutex_unlock(&_lock);
+                return dsERR_GENERAL;
+        }
+        _stream.m_encoding = encoding;
+        _stream.m_rate = sampleRate;
+        if (encoding == dsAUDIO_ENC_EAC3) {
+                _stream.m_burstFrames = IEC61937_EAC3_BURST_FRAMES;
+                linkRate = 4 * sampleRate;
+        } else {
+                _stream.m_burstFrames = IEC61937_AC3_BURST_FRAMES;
+                linkRate = sampleRate;
+        }
+        if ((err = dsAudioIec61937Configure(linkRate)) < 0) {
+                printf("IEC 61937: cannot set up %u Hz mmap stream: %s\n", linkRate, snd_strerror(err));
+                dsAudioIec61937CloseLocked();
+                pthread_mutex_unlock(&_lock);
+                return dsERR_GENERAL;
+        }
+        dsAudioIec61937SetStatus(linkRate);
+        pthread_mutex_unlock(&_lock);
+        dsAudioEventsFormatChanged(encoding == dsAUDIO_ENC_EAC3 ? dsAUDIO_FORMAT_DOLBY_EAC3 : dsAUDIO_FORMAT_DOLBY_AC3);
+        return dsERR_NONE;
+}
+
+/* Wait until a whole burst fits in the ring, recovering from underruns */
+static int dsAudioIec61937WaitSpace()
+{
+        for (;;) {
+                snd_pcm_sframes_t avail = snd_pcm_avail_update(_stream.m_pcm);
+                if (avail < 0) {
+                        if (snd_pcm_recover(_stream.m_pcm, (int) avail, 1) < 0) {
+                                return (int) avail;
+                        }
+                        continue;
+                }
+                if ((snd_pcm_uframes_t) avail >= _stream.m_burstFrames) {
+                        return 0;
+                }
+                int err = snd_pcm_wait(_stream.m_pcm, IEC61937_WAIT_MS);
+                if (err < 0 && snd_pcm_recover(_stream.m_pcm, err, 1) < 0) {
+                        return err;
+                }
+                if (err == 0) {
+                        return -EIO;
+                }
+        }
+}
+
+/*
+ * Start a burst at the application pointer. For interleaved access the areas
+ * returned by snd_pcm_mmap_begin() map the whole ring, and the next
+ * m_burstFrames frames are free, so the burst is filled in place, across
+ * the wrap if need be, and only committed once complete.
+ */
+static int dsAudioIec61937BeginBurst()
+{
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset, frames = _stream.m_burstFrames;
+        int err;
+
+        if ((err = dsAudioIec61937WaitSpace()) < 0 ||
+            (err = snd_pcm_mmap_begin(_stream.m_pcm, &areas, &offset, &frames)) < 0) {
+                return err;
+        }
+        _stream.m_ring = (uint8_t *) areas[0].addr + areas[0].first / 8;
+        _stream.m_burstOffset = offset;
+        _stream.m_inBurst = true;
+        return 0;
+}
+
+/* Store 16-bit words little-endian at a byte offset into the burst, wrapping at the ring end */
+static void dsAudioIec61937PutWords(uint32_t at, const uint8_t *bigEndian, const uint16_t *words, uint32_t count)
+{
+        const uint32_t ringBytes = (uint32_t) _stream.m_bufferFrames * IEC61937_FRAME_BYTES;
+        uint32_t pos = ((uint32_t) _stream.m_burstOffset * IEC61937_FRAME_BYTES + at) % ringBytes;
+
+        while (count > 0) {
+                uint32_t run = (ringBytes - pos) / 2;
+                run = run < count ? run : count;
+                uint8_t *dst = _stream.m_ring + pos;
+                if (bigEndian != NULL) {
+                        /* Coded data is a big-endian word stream */
+                        for (uint32_t i = 0; i < run; i++) {
+                                dst[2 * i] = bigEndian[2 * i + 1];
+                                dst[2 * i + 1] = bigEndian[2 * i];
+                        }
+                        bigEndian += 2 * run;
+                } else if (words != NULL) {
+                        for (uint32_t i = 0; i < run; i++) {
+                                dst[2 * i] = (uint8_t) words[i];
+                                dst[2 * i + 1] = (uint8_t) (words[i] >> 8);
+                        }
+                        words += run;
+                } else {
+                        memset(dst, 0, 2 * run);
+                }
+                count -= run;
+                pos = (pos + 2 * run) % ringBytes;
+        }
+}
+
+static int dsAudioIec61937EndBurst()
+{
+        const uint32_t burstBytes = (uint32_t) _stream.m_burstFrames * IEC61937_FRAME_BYTES;
+        const uint32_t used = IEC61937_PREAMBLE_BYTES + _stream.m_payloadBytes;
+        /* Length code: bits for AC-3, bytes for E-AC-3 */
+        const uint16_t length = (uint16_t) (_stream.m_encoding == dsAUDIO_ENC_AC3 ? _stream.m_payloadBytes * 8 : _stream.m_payloadBytes);
+        const uint16_t preamble[4] = { IEC61937_PA, IEC61937_PB, _stream.m_dataType, length };
+        snd_pcm_uframes_t left = _stream.m_burstFrames;
+        int err = 0;
+
+        dsAudioIec61937PutWords(0, NULL, preamble, 4);
+        dsAudioIec61937PutWords(used, NULL, NULL, (burstBytes - used) / 2);
+        _stream.m_inBurst = false;
+        _stream.m_payloadBytes = 0;
+        _stream.m_blocks = 0;
+        while (left > 0) {
+                const snd_pcm_channel_area_t *areas;
+                snd_pcm_uframes_t offset, frames = left;
+                snd_pcm_sframes_t committed;
+                if ((err = snd_pcm_mmap_begin(_stream.m_pcm, &areas, &offset, &frames)) < 0) {
+                        break;
+                }
+                if ((committed = snd_pcm_mmap_commit(_stream.m_pcm, offset, frames)) < 0 ||
+                    (snd_pcm_uframes_t) committed != frames) {
+                        err = committed < 0 ? (int) committed : -EPIPE;
+                        break;
+                }
+                left -= frames;
+        }
+        if (err < 0) {
+                /* The burst is lost; the next one starts from the recovered pointer */
+                err = snd_pcm_recover(_stream.m_pcm, err, 1);
+        }
+        return err;
+}
+
+dsError_t dsAudioIec61937Write(const uint8_t *frame, size_t size)
+{
+        dsAudioIec61937Frame_t info;
+        int err;
+
+        if (frame == NULL || (size & 1) != 0 || !dsAudioIec61937Parse(frame, size, &info) || info.m_bytes > size) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_lock);
+        if (_stream.m_pcm == NULL) {
+                pthread_mutex_unlock(&_lock);
+                return dsERR_INVALID_STATE;
+        }
+        /* One syncframe per AC-3 burst; E-AC-3 access units may carry dependent frames */
+        if (info.m_encoding != _stream.m_encoding || info.m_rate != _stream.m_rate ||
+            (info.m_encoding == dsAUDIO_ENC_AC3 && info.m_bytes != size) ||
+            IEC61937_PREAMBLE_BYTES + _stream.m_payloadBytes + size > _stream.m_burstFrames * IEC61937_FRAME_BYTES) {
+                pthread_mutex_unlock(&_lock);
+                return dsERR_INVALID_PARAM;
+        }
+        if (!_stream.m_inBurst && (err = dsAudioIec61937BeginBurst()) < 0) {
+                printf("IEC 61937: output failed: %s\n", snd_strerror(err));
+                pthread_mutex_unlock(&_lock);
+                return dsERR_GENERAL;
+        }
+        _stream.m_dataType = info.m_encoding == dsAUDIO_ENC_AC3 ? (uint16_t) (IEC61937_TYPE_AC3 | info.m_bsmod << 8) : IEC61937_TYPE_EAC3;
+        dsAudioIec61937PutWords(IEC61937_PREAMBLE_BYTES + _stream.m_payloadBytes, frame, NULL, (uint32_t) size / 2);
+        _stream.m_payloadBytes += (uint32_t) size;
+        _stream.m_blocks += info.m_blocks;
+        if (_stream.m_blocks >= IEC61937_EAC3_BLOCKS && (err = dsAudioIec61937EndBurst()) < 0) {
+                printf("IEC 61937: output failed: %s\n", snd_strerror(err));
+                pthread_mutex_unlock(&_lock);
+                return dsERR_GENERAL;
+        }
+        pthread_mutex_unlock(&_lock);
+        return dsERR_NONE;
+}
+
+void dsAudioIec61937Close()
+{
+        pthread_mutex_lock(&_lock);
+        dsAudioIec61937CloseLocked();
+        pthread_mutex_unlock(&_lock);
+}
+
+bool dsAudioIec61937IsOpen(dsAudioEncoding_t *encoding)
+{
+        pthread_mutex_lock(&_lock);
+        const bool open = _stream.m_pcm != NULL;
+        if (open && encoding != NULL) {
+                *encoding = _stream.m_encoding;
+        }
+        pthread_mutex_unlock(&_lock);
+        return open;
+}
@@ -0,0 +1,95 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSAUDIOIEC61937_H
+#define __DSAUDIOIEC61937_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Compressed-audio passthrough to the HDMI sink (IEC 61937).
+ *
+ * When dsSetAudioEncoding() selects AC-3 or E-AC-3 and the sink's EDID
+ * lists the format, the caller's frames are sent undecoded: each AC-3
+ * syncframe, or each six audio blocks of E-AC-3, becomes one IEC 61937
+ * burst (Pa/Pb sync words, data type, length, payload, zero stuffing)
+ * carried in a 16-bit stereo PCM stream at the frame rate (AC-3) or four
+ * times it (E-AC-3). The channel status is switched to non-audio for the
+ * stream and restored when it closes.
+ *
+ * Frames are byte-swapped straight from the caller's buffer into the
+ * mmap'd ring of the PCM; there is no intermediate copy, decode or
+ * re-encode. The PCM is DS_AUDIO_IEC61937_PCM if it is defined in the ALSA
+ * configuration (a file-backed PCM there makes the bursts inspectable
+ * without a sink, see audiodsp/asound.conf.example), the HDMI device
+ * otherwise.
+ *
+ * One stream at a time, HDMI only. Write and close may be called from
+ * different threads.
+ */
+
+#define DS_AUDIO_IEC61937_PCM "dshal_iec958"
+
+/**
+ * @brief Open the passthrough stream of a port for the current encoding.
+ *
+ * @param [in]  handle       Audio port handle (HDMI)
+ * @param [in]  sampleRate   Rate of the coded audio: 32000, 44100 or 48000
+ * @param [out] passthrough  true if frames are to be written with
+ *                           dsAudioPassthroughWrite(); false if the stream
+ *                           has to be decoded and played as PCM, because the
+ *                           encoding is PCM or the sink does not take it
+ * @return dsERR_INVALID_STATE if a stream is already open,
+ *         dsERR_OPERATION_NOT_SUPPORTED for ports other than HDMI,
+ *         dsERR_GENERAL if the PCM could not be set up.
+ */
+dsError_t dsAudioPassthroughOpen(intptr_t handle, uint32_t sampleRate, bool *passthrough);
+
+/**
+ * @brief Send one AC-3 syncframe or one E-AC-3 access unit.
+ *
+ * An E-AC-3 access unit is an independent frame followed by its dependent
+ * frames, as demuxers deliver them. Blocks until the ring has room for the
+ * burst.
+ *
+ * @return dsERR_INVALID_PARAM if the data is not a frame of the open
+ *         encoding and rate, dsERR_INVALID_STATE if no stream is open (or
+ *         the encoding has changed since it was opened).
+ */
+dsError_t dsAudioPassthroughWrite(intptr_t handle, const uint8_t *frame, size_t size);
+
+/**
+ * @brief Stop the stream, dropping what is queued, and restore the channel status.
+ */
+dsError_t dsAudioPassthroughClose(intptr_t handle);
+
+/* Used by dsAudio.c, which owns handles and sink capabilities */
+
+dsError_t dsAudioIec61937Open(dsAudioEncoding_t encoding, uint32_t sampleRate);
+
+dsError_t dsAudioIec61937Write(const uint8_t *frame, size_t size);
+
+void dsAudioIec61937Close();
+
+bool dsAudioIec61937IsOpen(dsAudioEncoding_t *encoding);
+
+#endif /* __DSAUDIOIEC61937_H */
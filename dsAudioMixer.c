@@ -0,0 +1,466 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include "dsUtl.h"
+#include "dsSeqlock.h"
+#include "dsAudioMixer.h"
+#include "dsAudioGainTable.h"
+
+/* Per-port card and simple element, overridable at build time */
+#ifndef ALSA_HDMI_CARD_NAME
+#define ALSA_HDMI_CARD_NAME "hw:0"
+#endif
+#ifndef ALSA_HDMI_ELEMENT_NAME
+#if (SND_LIB_MAJOR >= 1) && (SND_LIB_MINOR >= 2)
+#define ALSA_HDMI_ELEMENT_NAME "HDMI"
+#else
+#define ALSA_HDMI_ELEMENT_NAME "PCM"
+#endif
+#endif
+#ifndef ALSA_SPDIF_CARD_NAME
+#define ALSA_SPDIF_CARD_NAME "hw:0"
+#endif
+#ifndef ALSA_SPDIF_ELEMENT_NAME
+#define ALSA_SPDIF_ELEMENT_NAME "IEC958"
+#endif
+
+#define MIXER_MAX_POLL_FDS 8
+/* A card that will not open is retried with exponential backoff */
+#define MIXER_REOPEN_INTERVAL_MS 1000
+#define MIXER_REOPEN_MAX_INTERVAL_MS 60000
+
+/* Open failures are logged once per failing streak; retries stay quiet */
+#define MIXER_OPEN_LOG(backend, ...) do { if (!(backend)->m_failing) printf(__VA_ARGS__); } while (0)
+
+/*
+ * One backend per port: its own mixer handle on its own card, element and
+ * lock, so a write or a reopen on one port never waits for or touches
+ * another. The Pi has no S/PDIF output; unless ALSA_SPDIF_ELEMENT_NAME names
+ * a real control the SPDIF port simply has no element.
+ */
+typedef struct __attribute__((aligned(64))) _dsAudioMixerBackend_t {
+        const char *m_card;             /**< NULL for ports without a mixer */
+        const char *m_element;
+        pthread_mutex_t m_lock;
+        snd_mixer_t *m_mixer;
+        snd_mixer_elem_t *m_elem;
+        bool m_stale;
+        uint32_t m_generation;
+        bool m_failing;                 /**< last open failed, already logged */
+        uint32_t m_retryMs;
+        uint64_t m_retryAtMs;
+        /* Lock-free snapshot of the element for the getters */
+        dsSeqlock_t m_cacheLock;
+        dsAudioMixerState_t m_cache;
+} dsAudioMixerBackend_t;
+
+static dsAudioMixerBackend_t _backends[dsAUDIOPORT_TYPE_MAX];
+
+static pthread_t _eventThread;
+static pthread_mutex_t _threadLock = PTHREAD_MUTEX_INITIALIZER;
+static bool _eventThreadRunning = false;
+static bool _eventThreadStop = false;
+static int _wakeFd = -1;
+
+static uint64_t dsAudioMixerNowMs()
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool dsAudioMixerDeviceGone(int err)
+{
+        return err == -ENODEV || err == -ENXIO || err == -EBADFD || err == -EIO;
+}
+
+static void dsAudioMixerWake()
+{
+        uint64_t one = 1;
+        if (_wakeFd >= 0 && write(_wakeFd, &one, sizeof(one)) < 0) {
+                printf("Failed to wake mixer event thread\n");
+        }
+}
+
+static void dsAudioMixerSetupOnce()
+{
+        for (int i = 0; i < dsAUDIOPORT_TYPE_MAX; i++) {
+                pthread_mutex_init(&_backends[i].m_lock, NULL);
+        }
+        _backends[dsAUDIOPORT_TYPE_HDMI].m_card = ALSA_HDMI_CARD_NAME;
+        _backends[dsAUDIOPORT_TYPE_HDMI].m_element = ALSA_HDMI_ELEMENT_NAME;
+        _backends[dsAUDIOPORT_TYPE_SPDIF].m_card = ALSA_SPDIF_CARD_NAME;
+        _backends[dsAUDIOPORT_TYPE_SPDIF].m_element = ALSA_SPDIF_ELEMENT_NAME;
+}
+
+static void dsAudioMixerSetup()
+{
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
+        pthread_once(&once, dsAudioMixerSetupOnce);
+}
+
+/*
+ * Copy the element's values into the port cache. The simple mixer keeps the
+ * values in user space, so this is memory reads only. Called with the
+ * backend lock held.
+ */
+static void dsAudioMixerRefresh(dsAudioMixerBackend_t *backend)
+{
+        snd_mixer_elem_t *elem = backend->m_elem;
+        dsAudioMixerState_t state;
+        int unmuted = 1;
+
+        memset(&state, 0, sizeof(state));
+        if (elem != NULL && !backend->m_stale) {
+                state.m_hasSwitch = snd_mixer_selem_has_playback_switch(elem);
+                if (state.m_hasSwitch) {
+                        snd_mixer_selem_get_playback_switch(elem, SND_MIXER_SCHN_FRONT_LEFT, &unmuted);
+                }
+                state.m_muted = !unmuted;
+                if (snd_mixer_selem_get_playback_dB_range(elem, &state.m_dBMin, &state.m_dBMax) == 0 &&
+                    snd_mixer_selem_get_playback_dB(elem, SND_MIXER_SCHN_FRONT_LEFT, &state.m_dB) == 0) {
+                        const dsAudioGainTable_t *table = dsAudioGainTableGet(state.m_dBMin, state.m_dBMax);
+                        state.m_hasDb = (table != NULL);
+                        state.m_gain = table ? dsAudioGainTableToGain(table, state.m_dB) : 0.0f;
+                }
+                if (snd_mixer_selem_get_playback_volume_range(elem, &state.m_volMin, &state.m_volMax) == 0 &&
+                    snd_mixer_selem_get_playback_volume(elem, SND_MIXER_SCHN_FRONT_LEFT, &state.m_volume) == 0 &&
+                    state.m_volMax > state.m_volMin) {
+                        state.m_hasVolume = true;
+                        state.m_level = (float)((state.m_volume - state.m_volMin)*100/(state.m_volMax - state.m_volMin));
+                }
+                state.m_valid = true;
+        }
+        dsSeqlockWriteBegin(&backend->m_cacheLock);
+        backend->m_cache = state;
+        dsSeqlockWriteEnd(&backend->m_cacheLock);
+}
+
+/* Runs inside snd_mixer_handle_events(), i.e. with the backend lock held. */
+static int dsAudioMixerElemCallback(snd_mixer_elem_t *elem, unsigned int mask)
+{
+        dsAudioMixerBackend_t *backend = (dsAudioMixerBackend_t *) snd_mixer_elem_get_callback_private(elem);
+        if (mask == SND_CTL_EVENT_MASK_REMOVE) {
+                backend->m_stale = true;
+        }
+        dsAudioMixerRefresh(backend);
+        return 0;
+}
+
+/* Called with the backend lock held. */
+static void dsAudioMixerCloseLocked(dsAudioMixerBackend_t *backend)
+{
+        if (backend->m_mixer) {
+                snd_mixer_close(backend->m_mixer);
+        }
+        backend->m_mixer = NULL;
+        backend->m_elem = NULL;
+        backend->m_stale = false;
+        dsAudioMixerRefresh(backend);
+}
+
+/* Called with the backend lock held. Schedules the next reopen attempt. */
+static dsError_t dsAudioMixerOpenFailed(dsAudioMixerBackend_t *backend)
+{
+        if (!backend->m_failing) {
+                printf("Sound mixer %s unavailable, retrying in the background\n", backend->m_card);
+        }
+        backend->m_failing = true;
+        backend->m_retryMs = backend->m_retryMs == 0 ? MIXER_REOPEN_INTERVAL_MS :
+                             (backend->m_retryMs * 2 < MIXER_REOPEN_MAX_INTERVAL_MS ? backend->m_retryMs * 2 : MIXER_REOPEN_MAX_INTERVAL_MS);
+        backend->m_retryAtMs = dsAudioMixerNowMs() + backend->m_retryMs;
+        return dsERR_GENERAL;
+}
+
+/* Called with the backend lock held. */
+static dsError_t dsAudioMixerOpenLocked(dsAudioMixerBackend_t *backend)
+{
+        int ret = 0;
+        snd_mixer_selem_id_t *sid = NULL;
+
+        dsAudioMixerCloseLocked(backend);
+        backend->m_generation++;
+        if ((ret = snd_mixer_open(&backend->m_mixer, 0)) < 0) {
+                MIXER_OPEN_LOG(backend, "Cannot open sound mixer %s\n", snd_strerror(ret));
+                backend->m_mixer = NULL;
+                return dsAudioMixerOpenFailed(backend);
+        }
+        if ((ret = snd_mixer_attach(backend->m_mixer, backend->m_card)) < 0) {
+                MIXER_OPEN_LOG(backend, "sound mixer attach %s Failed %s\n", backend->m_card, snd_strerror(ret));
+                dsAudioMixerCloseLocked(backend);
+                return dsAudioMixerOpenFailed(backend);
+        }
+        if ((ret = snd_mixer_selem_register(backend->m_mixer, NULL, NULL)) < 0) {
+                MIXER_OPEN_LOG(backend, "Cannot register sound mixer element %s\n", snd_strerror(ret));
+                dsAudioMixerCloseLocked(backend);
+                return dsAudioMixerOpenFailed(backend);
+        }
+        if ((ret = snd_mixer_load(backend->m_mixer)) < 0) {
+                MIXER_OPEN_LOG(backend, "Sound mixer load %s error: %s\n", backend->m_card, snd_strerror(ret));
+                dsAudioMixerCloseLocked(backend);
+                return dsAudioMixerOpenFailed(backend);
+        }
+        if ((ret = snd_mixer_selem_id_malloc(&sid)) < 0) {
+                MIXER_OPEN_LOG(backend, "Sound mixer: id allocation failed. %s: error: %s\n", backend->m_card, snd_strerror(ret));
+                dsAudioMixerCloseLocked(backend);
+                return dsAudioMixerOpenFailed(backend);
+        }
+        snd_mixer_selem_id_set_index(sid, 0);
+        snd_mixer_selem_id_set_name(sid, backend->m_element);
+        backend->m_elem = snd_mixer_find_selem(backend->m_mixer, sid);
+        if (backend->m_elem == NULL) {
+                printf("Unable to find simple control '%s',%i on %s\n", snd_mixer_selem_id_get_name(sid),
+                       snd_mixer_selem_id_get_index(sid), backend->m_card);
+        }
+        else {
+                snd_mixer_elem_set_callback(backend->m_elem, dsAudioMixerElemCallback);
+                snd_mixer_elem_set_callback_private(backend->m_elem, backend);
+        }
+        snd_mixer_selem_id_free(sid);
+        if (backend->m_failing) {
+                printf("Sound mixer %s available again\n", backend->m_card);
+        }
+        backend->m_failing = false;
+        backend->m_retryMs = 0;
+        dsAudioMixerRefresh(backend);
+        return dsERR_NONE;
+}
+
+/*
+ * Sleeps in poll() on the control descriptors of every backend and applies
+ * change events to the port caches; also reopens a backend when its card
+ * goes away and comes back. Each backend is only locked while its own
+ * descriptors are collected or its events handled.
+ */
+static void* dsAudioMixerEventThread(void *arg)
+{
+        struct pollfd pfds[MIXER_MAX_POLL_FDS];
+        struct {
+                int m_first;
+                int m_count;
+                uint32_t m_generation;
+        } ranges[dsAUDIOPORT_TYPE_MAX];
+
+        while (!__atomic_load_n(&_eventThreadStop, __ATOMIC_ACQUIRE)) {
+                int nfds = 1;
+                int timeout = -1;
+                uint64_t now = dsAudioMixerNowMs();
+
+                pfds[0].fd = _wakeFd;
+                pfds[0].events = POLLIN;
+                pfds[0].revents = 0;
+                for (int i = 0; i < dsAUDIOPORT_TYPE_MAX; i++) {
+                        dsAudioMixerBackend_t *backend = &_backends[i];
+                        ranges[i].m_count = 0;
+                        if (backend->m_card == NULL) {
+                                continue;
+                        }
+                        pthread_mutex_lock(&backend->m_lock);
+                        if ((backend->m_mixer == NULL || backend->m_stale) &&
+                            (!backend->m_failing || now >= backend->m_retryAtMs)) {
+                                dsAudioMixerOpenLocked(backend);
+                        }
+                        if (backend->m_mixer) {
+                                int count = snd_mixer_poll_descriptors_count(backend->m_mixer);
+                                if (count > MIXER_MAX_POLL_FDS - nfds) {
+                                        count = MIXER_MAX_POLL_FDS - nfds;
+                                }
+                                if (count > 0) {
+                                        count = snd_mixer_poll_descriptors(backend->m_mixer, &pfds[nfds], count);
+                                }
+                                ranges[i].m_first = nfds;
+                                ranges[i].m_count = count > 0 ? count : 0;
+                                nfds += ranges[i].m_count;
+                        }
+                        else {
+                                int wait = backend->m_retryAtMs > now ? (int)(backend->m_retryAtMs - now) : 0;
+                                timeout = (timeout < 0 || wait < timeout) ? wait : timeout;
+                        }
+                        ranges[i].m_generation = backend->m_generation;
+                        pthread_mutex_unlock(&backend->m_lock);
+                }
+
+                int ready = poll(pfds, nfds, timeout);
+                if (ready <= 0) {
+                        continue;
+                }
+                if (pfds[0].revents & POLLIN) {
+                        uint64_t value;
+                        if (read(_wakeFd, &value, sizeof(value)) < 0) {
+                                printf("Failed to drain mixer wake fd\n");
+                        }
+                }
+                for (int i = 0; i < dsAUDIOPORT_TYPE_MAX; i++) {
+                        dsAudioMixerBackend_t *backend = &_backends[i];
+                        if (ranges[i].m_count == 0) {
+                                continue;
+                        }
+                        pthread_mutex_lock(&backend->m_lock);
+                        if (ranges[i].m_generation != backend->m_generation || backend->m_stale) {
+                                pthread_mutex_unlock(&backend->m_lock);
+                                continue;
+                        }
+                        unsigned short revents = 0;
+                        snd_mixer_poll_descriptors_revents(backend->m_mixer, &pfds[ranges[i].m_first], ranges[i].m_count, &revents);
+                        if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                                printf("Sound card %s went away, reopening mixer\n", backend->m_card);
+                                backend->m_stale = true;
+                                dsAudioMixerRefresh(backend);
+                        }
+                        else if (revents & POLLIN) {
+                                int err = snd_mixer_handle_events(backend->m_mixer);
+                                if (err < 0 && dsAudioMixerDeviceGone(err)) {
+                                        printf("Sound card %s went away (%s), reopening mixer\n", backend->m_card, snd_strerror(err));
+                                        backend->m_stale = true;
+                                        dsAudioMixerRefresh(backend);
+                                }
+                        }
+                        pthread_mutex_unlock(&backend->m_lock);
+                }
+        }
+        return NULL;
+}
+
+dsError_t dsAudioMixerOpen()
+{
+        dsError_t ret = dsERR_NONE;
+
+        dsAudioMixerSetup();
+        for (int i = 0; i < dsAUDIOPORT_TYPE_MAX; i++) {
+                dsAudioMixerBackend_t *backend = &_backends[i];
+                if (backend->m_card == NULL) {
+                        continue;
+                }
+                pthread_mutex_lock(&backend->m_lock);
+                if (dsAudioMixerOpenLocked(backend) != dsERR_NONE) {
+                        ret = dsERR_GENERAL;
+                }
+                pthread_mutex_unlock(&backend->m_lock);
+        }
+        pthread_mutex_lock(&_threadLock);
+        if (!_eventThreadRunning) {
+                _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                __atomic_store_n(&_eventThreadStop, false, __ATOMIC_RELEASE);
+                if (_wakeFd >= 0 && pthread_create(&_eventThread, NULL, dsAudioMixerEventThread, NULL) == 0) {
+                        _eventThreadRunning = true;
+                }
+                else {
+                        printf("Failed to start mixer event thread\n");
+                }
+        }
+        pthread_mutex_unlock(&_threadLock);
+        return ret;
+}
+
+void dsAudioMixerClose()
+{
+        dsAudioMixerSetup();
+        pthread_mutex_lock(&_threadLock);
+        if (_eventThreadRunning) {
+                __atomic_store_n(&_eventThreadStop, true, __ATOMIC_RELEASE);
+                dsAudioMixerWake();
+                pthread_join(_eventThread, NULL);
+                _eventThreadRunning = false;
+        }
+        if (_wakeFd >= 0) {
+                close(_wakeFd);
+                _wakeFd = -1;
+        }
+        pthread_mutex_unlock(&_threadLock);
+
+        for (int i = 0; i < dsAUDIOPORT_TYPE_MAX; i++) {
+                pthread_mutex_lock(&_backends[i].m_lock);
+                dsAudioMixerCloseLocked(&_backends[i]);
+                pthread_mutex_unlock(&_backends[i].m_lock);
+        }
+}
+
+snd_mixer_elem_t* dsAudioMixerAcquire(dsAudioPortType_t type)
+{
+        dsAudioMixerBackend_t *backend;
+
+        if (!dsAudioType_isValid(type)) {
+                return NULL;
+        }
+        dsAudioMixerSetup();
+        backend = &_backends[type];
+        if (backend->m_card == NULL) {
+                return NULL;
+        }
+        pthread_mutex_lock(&backend->m_lock);
+        if (backend->m_mixer == NULL || backend->m_stale) {
+                dsError_t ret = dsAudioMixerOpenLocked(backend);
+                /* The event thread is polling the old descriptors */
+                dsAudioMixerWake();
+                if (ret != dsERR_NONE) {
+                        pthread_mutex_unlock(&backend->m_lock);
+                        return NULL;
+                }
+        }
+        if (backend->m_elem == NULL) {
+                pthread_mutex_unlock(&backend->m_lock);
+                return NULL;
+        }
+        /* Don't wait for the event thread to catch up with outside changes */
+        int err = snd_mixer_handle_events(backend->m_mixer);
+        if (err < 0 && dsAudioMixerDeviceGone(err)) {
+                backend->m_stale = true;
+                dsAudioMixerRefresh(backend);
+                dsAudioMixerWake();
+                pthread_mutex_unlock(&backend->m_lock);
+                return NULL;
+        }
+        return backend->m_elem;
+}
+
+void dsAudioMixerRelease(dsAudioPortType_t type, int alsaResult)
+{
+        dsAudioMixerBackend_t *backend = &_backends[type];
+        if (alsaResult < 0 && dsAudioMixerDeviceGone(alsaResult)) {
+                backend->m_stale = true;
+                dsAudioMixerWake();
+        }
+        /* Our own writes are applied to the simple element immediately; publish them now rather than on the echo event. */
+        dsAudioMixerRefresh(backend);
+        pthread_mutex_unlock(&backend->m_lock);
+}
+
+bool dsAudioMixerGetState(dsAudioPortType_t type, dsAudioMixerState_t *state)
+{
+        const dsAudioMixerBackend_t *backend;
+        uint32_t seq;
+
+        if (!dsAudioType_isValid(type)) {
+                return false;
+        }
+        backend = &_backends[type];
+        do {
+                seq = dsSeqlockReadBegin(&backend->m_cacheLock);
+                *state = backend->m_cache;
+        } while (dsSeqlockReadRetry(&backend->m_cacheLock, seq));
+        return state->m_valid;
+}
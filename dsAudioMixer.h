@@ -0,0 +1,89 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSAUDIOMIXER_H
+#define __DSAUDIOMIXER_H
+
+#include <alsa/asoundlib.h>
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Persistent ALSA mixer sessions, one per audio port.
+ *
+ * Each port has its own backend: card, simple element, mixer handle and
+ * lock, opened by dsAudioPortInit() (cards and elements are set with the
+ * ALSA_HDMI_* and ALSA_SPDIF_* build defines). dsAudioMixerAcquire() takes
+ * the port's lock and returns its element, dsAudioMixerRelease() drops it,
+ * so calls on different ports run concurrently. If a card goes away its
+ * session is reopened on the next acquire, and in the background with an
+ * exponential backoff while the card stays missing (logged once).
+ *
+ * A background thread waits on the poll descriptors of all sessions and
+ * keeps a per-port snapshot of the element up to date, so getters can answer
+ * from dsAudioMixerGetState() without locking or touching the card. Changes
+ * made outside the HAL (e.g. amixer) reach the snapshot once that thread, or
+ * the next dsAudioMixerAcquire() on the port, has handled their event.
+ */
+
+typedef struct _dsAudioMixerState_t {
+        bool m_valid;           /**< Element present and values below are current. */
+        bool m_hasSwitch;
+        bool m_muted;
+        bool m_hasDb;
+        bool m_hasVolume;
+        long m_dB;              /**< Current level in 1/100 dB.                 */
+        long m_dBMin;
+        long m_dBMax;
+        long m_volume;          /**< Raw mixer volume.                          */
+        long m_volMin;
+        long m_volMax;
+        float m_gain;           /**< m_dB mapped as dsGetAudioGain() reports it. */
+        float m_level;          /**< m_volume mapped to 0..100.                 */
+} dsAudioMixerState_t;
+
+dsError_t dsAudioMixerOpen();
+
+void dsAudioMixerClose();
+
+/**
+ * @brief Lock the port's session and return its mixer element.
+ *
+ * Pending mixer events are applied first so values changed outside the HAL
+ * (e.g. amixer) are seen. On NULL the lock is not held.
+ */
+snd_mixer_elem_t* dsAudioMixerAcquire(dsAudioPortType_t type);
+
+/**
+ * @brief Unlock the port's session.
+ *
+ * @param [in] type        Port passed to dsAudioMixerAcquire().
+ * @param [in] alsaResult  Result of the last ALSA call made on the element;
+ *                         device-gone errors schedule a reopen.
+ */
+void dsAudioMixerRelease(dsAudioPortType_t type, int alsaResult);
+
+/**
+ * @brief Lock-free read of the cached state of a port.
+ *
+ * @return false if the port has no element or the card is unavailable.
+ */
+bool dsAudioMixerGetState(dsAudioPortType_t type, dsAudioMixerState_t *state);
+
+#endif
@@ -0,0 +1,525 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include "dsUtl.h"
+#include "dsAudioMixer.h"
+#include "dsAudioRamp.h"
+
+/* Fades never go below this, even when the control bottoms out at mute (1/100 dB) */
+#define RAMP_FLOOR_DB (-6000)
+
+typedef enum _dsAudioRampPhase_t {
+        RAMP_IDLE = 0,
+        RAMP_LEVEL,             /* fading m_from -> m_to                        */
+        RAMP_MUTING,            /* fading to the floor, then switch off         */
+        RAMP_UNMUTE_PENDING,    /* switch on at the floor, then fade up         */
+} dsAudioRampPhase_t;
+
+typedef struct _dsAudioRamp_t {
+        dsAudioRampPhase_t m_phase;
+        long m_from;
+        long m_to;
+        long m_current;
+        long m_floor;
+        long m_dBMin;
+        bool m_userValid;       /* m_user is known; otherwise the mixer level is it    */
+        long m_user;            /* level last asked for, before any ducking            */
+        bool m_ducked;
+        long m_duckCeiling;     /* ducked level never exceeds this                     */
+        long m_duckOffset;      /* ... nor m_user plus this (<= 0)                     */
+        uint64_t m_startUs;
+        uint32_t m_durationMs;
+} dsAudioRamp_t;
+
+typedef struct _dsAudioRampAction_t {
+        bool m_writeDb;
+        long m_dB;
+        int m_switch;           /* -1 leave, 0 off, 1 on */
+        bool m_restoreAfter;
+        long m_restore;
+} dsAudioRampAction_t;
+
+static dsAudioRamp_t _ramps[dsAUDIOPORT_TYPE_MAX];
+static dsAudioRampConfig_t _config = { 60, 30, 5, dsAUDIORAMP_CURVE_SCURVE };
+static pthread_mutex_t _rampLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _rampIdle = PTHREAD_COND_INITIALIZER;
+static bool _rampApplying = false;
+
+static pthread_t _rampThread;
+static bool _rampRunning = false;
+static bool _rampStop = false;
+static int _wakeFd = -1;
+static int _timerFd = -1;
+
+static uint64_t dsAudioRampNowUs()
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void dsAudioRampWake()
+{
+        uint64_t one = 1;
+        if (_wakeFd >= 0 && write(_wakeFd, &one, sizeof(one)) < 0) {
+                printf("Failed to wake audio ramp thread\n");
+        }
+}
+
+static long dsAudioRampInterpolate(const dsAudioRamp_t *ramp, double t)
+{
+        switch (_config.m_curve) {
+        case dsAUDIORAMP_CURVE_SCURVE:
+                t = t * t * (3.0 - 2.0 * t);
+                break;
+        case dsAUDIORAMP_CURVE_LINEAR_AMPLITUDE: {
+                double from = pow(10, ramp->m_from / 2000.0);
+                double to = pow(10, ramp->m_to / 2000.0);
+                double amplitude = from + (to - from) * t;
+                return amplitude > 0 ? lrint(2000.0 * log10(amplitude)) : ramp->m_floor;
+        }
+        default:
+                break;
+        }
+        return lrint(ramp->m_from + (ramp->m_to - ramp->m_from) * t);
+}
+
+/* Start a fade on ramp from its current position. Called with _rampLock held. */
+static void dsAudioRampStart(dsAudioRamp_t *ramp, dsAudioRampPhase_t phase, long from, long to, uint32_t durationMs)
+{
+        ramp->m_phase = phase;
+        ramp->m_from = from;
+        ramp->m_to = to;
+        ramp->m_current = from;
+        ramp->m_startUs = dsAudioRampNowUs();
+        ramp->m_durationMs = durationMs;
+}
+
+/* Level the port should sit at: the user level with ducking applied. Called with _rampLock held. */
+static long dsAudioRampEffective(const dsAudioRamp_t *ramp)
+{
+        long level = ramp->m_user;
+        if (ramp->m_ducked) {
+                level += ramp->m_duckOffset;
+                level = level < ramp->m_duckCeiling ? level : ramp->m_duckCeiling;
+        }
+        return level > ramp->m_dBMin ? level : ramp->m_dBMin;
+}
+
+/* Pin the user level before the mixer level starts to differ from it. Called with _rampLock held. */
+static void dsAudioRampLatchUser(dsAudioRamp_t *ramp, const dsAudioMixerState_t *state)
+{
+        ramp->m_dBMin = state->m_dBMin;
+        if (!ramp->m_userValid) {
+                ramp->m_user = state->m_dB;
+                ramp->m_userValid = true;
+        }
+}
+
+/* Where the port's level is right now, as far as the engine knows. Called with _rampLock held. */
+static long dsAudioRampPosition(const dsAudioRamp_t *ramp, const dsAudioMixerState_t *state)
+{
+        return ramp->m_phase == RAMP_LEVEL || ramp->m_phase == RAMP_MUTING ? ramp->m_current : state->m_dB;
+}
+
+/*
+ * Advance one port by a tick and work out the mixer writes needed. Called
+ * with _rampLock held; the writes are done after it is dropped.
+ */
+static bool dsAudioRampStep(dsAudioRamp_t *ramp, uint64_t nowUs, dsAudioRampAction_t *action)
+{
+        memset(action, 0, sizeof(*action));
+        action->m_switch = -1;
+
+        if (ramp->m_phase == RAMP_IDLE) {
+                return false;
+        }
+        if (ramp->m_phase == RAMP_UNMUTE_PENDING) {
+                action->m_writeDb = true;
+                action->m_dB = ramp->m_floor;
+                action->m_switch = 1;
+                dsAudioRampStart(ramp, RAMP_LEVEL, ramp->m_floor, dsAudioRampEffective(ramp), _config.m_muteMs);
+                return true;
+        }
+
+        double t = 1.0;
+        uint64_t durationUs = (uint64_t)ramp->m_durationMs * 1000;
+        if (durationUs > 0 && nowUs - ramp->m_startUs < durationUs) {
+                t = (double)(nowUs - ramp->m_startUs) / durationUs;
+        }
+        long next = (t >= 1.0) ? ramp->m_to : dsAudioRampInterpolate(ramp, t);
+        if (next != ramp->m_current) {
+                action->m_writeDb = true;
+                action->m_dB = next;
+                ramp->m_current = next;
+        }
+        if (t >= 1.0) {
+                if (ramp->m_phase == RAMP_MUTING) {
+                        action->m_switch = 0;
+                        action->m_restoreAfter = true;
+                        action->m_restore = dsAudioRampEffective(ramp);
+                }
+                ramp->m_phase = RAMP_IDLE;
+                if (!ramp->m_ducked) {
+                        /* Mixer and user level agree again; follow outside changes from here */
+                        ramp->m_userValid = false;
+                }
+        }
+        return action->m_writeDb || action->m_switch >= 0;
+}
+
+static void dsAudioRampApply(dsAudioPortType_t type, const dsAudioRampAction_t *action)
+{
+        int err = 0;
+        snd_mixer_elem_t *mixer_elem = dsAudioMixerAcquire(type);
+        if (mixer_elem == NULL) {
+                return;
+        }
+        if (action->m_writeDb) {
+                err = snd_mixer_selem_set_playback_dB_all(mixer_elem, action->m_dB, 0);
+        }
+        if (!err && action->m_switch >= 0 && snd_mixer_selem_has_playback_switch(mixer_elem)) {
+                err = snd_mixer_selem_set_playback_switch_all(mixer_elem, action->m_switch);
+        }
+        if (!err && action->m_restoreAfter) {
+                err = snd_mixer_selem_set_playback_dB_all(mixer_elem, action->m_restore, 0);
+        }
+        if (err < 0) {
+                printf("Audio ramp: mixer write failed %s\n", snd_strerror(err));
+        }
+        dsAudioMixerRelease(type, err);
+}
+
+static void dsAudioRampArmTimer(bool active, uint32_t tickMs)
+{
+        struct itimerspec spec;
+        memset(&spec, 0, sizeof(spec));
+        if (active) {
+                spec.it_value.tv_sec = tickMs / 1000;
+                spec.it_value.tv_nsec = (tickMs % 1000) * 1000000L;
+                spec.it_interval = spec.it_value;
+        }
+        timerfd_settime(_timerFd, 0, &spec, NULL);
+}
+
+static void* dsAudioRampThread(void *arg)
+{
+        struct pollfd pfds[2];
+        bool armed = false;
+
+        pfds[0].fd = _wakeFd;
+        pfds[0].events = POLLIN;
+        pfds[1].fd = _timerFd;
+        pfds[1].events = POLLIN;
+
+        while (true) {
+                dsAudioRampAction_t actions[dsAUDIOPORT_TYPE_MAX];
+                bool pending[dsAUDIOPORT_TYPE_MAX];
+                bool active = false;
+                uint32_t tickMs;
+
+                if (poll(pfds, 2, -1) < 0) {
+                        continue;
+                }
+                uint64_t value;
+                if ((pfds[0].revents & POLLIN) && read(_wakeFd, &value, sizeof(value)) < 0) {
+                        printf("Failed to drain audio ramp wake fd\n");
+                }
+                if ((pfds[1].revents & POLLIN) && read(_timerFd, &value, sizeof(value)) < 0) {
+                        printf("Failed to drain audio ramp timer\n");
+                }
+
+                pthread_mutex_lock(&_rampLock);
+                if (_rampStop) {
+                        pthread_mutex_unlock(&_rampLock);
+                        break;
+                }
+                uint64_t nowUs = dsAudioRampNowUs();
+                for (int i = 0; i < dsAUDIOPORT_TYPE_MAX; i++) {
+                        pending[i] = dsAudioRampStep(&_ramps[i], nowUs, &actions[i]);
+                        active |= (_ramps[i].m_phase != RAMP_IDLE);
+                }
+                tickMs = _config.m_tickMs ? _config.m_tickMs : 1;
+                _rampApplying = true;
+                pthread_mutex_unlock(&_rampLock);
+
+                for (int i = 0; i < dsAUDIOPORT_TYPE_MAX; i++) {
+                        if (pending[i]) {
+                                dsAudioRampApply((dsAudioPortType_t)i, &actions[i]);
+                        }
+                }
+
+                pthread_mutex_lock(&_rampLock);
+                _rampApplying = false;
+                if (!active) {
+                        pthread_cond_broadcast(&_rampIdle);
+                }
+                pthread_mutex_unlock(&_rampLock);
+                if (active != armed) {
+                        dsAudioRampArmTimer(active, tickMs);
+                        armed = active;
+                }
+        }
+        dsAudioRampArmTimer(false, 0);
+        return NULL;
+}
+
+dsError_t dsAudioRampInit()
+{
+        dsError_t ret = dsERR_NONE;
+        pthread_mutex_lock(&_rampLock);
+        if (!_rampRunning) {
+                memset(_ramps, 0, sizeof(_ramps));
+                _rampStop = false;
+                _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                _timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+                if (_wakeFd < 0 || _timerFd < 0 ||
+                    pthread_create(&_rampThread, NULL, dsAudioRampThread, NULL) != 0) {
+                        printf("Failed to start audio ramp thread\n");
+                        if (_wakeFd >= 0) close(_wakeFd);
+                        if (_timerFd >= 0) close(_timerFd);
+                        _wakeFd = _timerFd = -1;
+                        ret = dsERR_GENERAL;
+                }
+                else {
+                        _rampRunning = true;
+                }
+        }
+        pthread_mutex_unlock(&_rampLock);
+        return ret;
+}
+
+dsError_t dsAudioRampTerm()
+{
+        pthread_mutex_lock(&_rampLock);
+        if (!_rampRunning) {
+                pthread_mutex_unlock(&_rampLock);
+                return dsERR_NONE;
+        }
+        _rampStop = true;
+        _rampRunning = false;
+        dsAudioRampWake();
+        pthread_mutex_unlock(&_rampLock);
+
+        pthread_join(_rampThread, NULL);
+        pthread_mutex_lock(&_rampLock);
+        pthread_cond_broadcast(&_rampIdle);
+        pthread_mutex_unlock(&_rampLock);
+        close(_wakeFd);
+        close(_timerFd);
+        _wakeFd = _timerFd = -1;
+        return dsERR_NONE;
+}
+
+dsError_t dsAudioRampSetConfig(const dsAudioRampConfig_t *config)
+{
+        if (config == NULL || config->m_curve >= dsAUDIORAMP_CURVE_MAX || config->m_tickMs == 0) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_rampLock);
+        _config = *config;
+        pthread_mutex_unlock(&_rampLock);
+        return dsERR_NONE;
+}
+
+dsError_t dsAudioRampGetConfig(dsAudioRampConfig_t *config)
+{
+        if (config == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_rampLock);
+        *config = _config;
+        pthread_mutex_unlock(&_rampLock);
+        return dsERR_NONE;
+}
+
+dsError_t dsAudioRampToDb(dsAudioPortType_t type, long dB, uint32_t durationMs)
+{
+        dsAudioMixerState_t state;
+        if (!dsAudioType_isValid(type)) {
+                return dsERR_INVALID_PARAM;
+        }
+        if (!dsAudioMixerGetState(type, &state) || !state.m_hasDb) {
+                return dsERR_GENERAL;
+        }
+        if (dB < state.m_dBMin) dB = state.m_dBMin;
+        if (dB > state.m_dBMax) dB = state.m_dBMax;
+
+        pthread_mutex_lock(&_rampLock);
+        if (!_rampRunning) {
+                pthread_mutex_unlock(&_rampLock);
+                return dsERR_INVALID_STATE;
+        }
+        dsAudioRamp_t *ramp = &_ramps[type];
+        ramp->m_dBMin = state.m_dBMin;
+        ramp->m_user = dB;
+        ramp->m_userValid = true;
+        /* While a mute transition runs the new level is picked up when it completes */
+        if (ramp->m_phase != RAMP_MUTING && ramp->m_phase != RAMP_UNMUTE_PENDING) {
+                dsAudioRampStart(ramp, RAMP_LEVEL, dsAudioRampPosition(ramp, &state), dsAudioRampEffective(ramp), durationMs);
+        }
+        dsAudioRampWake();
+        pthread_mutex_unlock(&_rampLock);
+        return dsERR_NONE;
+}
+
+/* Immediate mute for elements with a playback switch but no dB range */
+static dsError_t dsAudioRampSwitch(dsAudioPortType_t type, bool mute)
+{
+        snd_mixer_elem_t *mixer_elem = dsAudioMixerAcquire(type);
+        if (mixer_elem == NULL) {
+                return dsERR_GENERAL;
+        }
+        int err = snd_mixer_selem_set_playback_switch_all(mixer_elem, !mute);
+        dsAudioMixerRelease(type, err);
+        if (err < 0) {
+                printf("Audio ramp: mixer switch failed %s\n", snd_strerror(err));
+                return dsERR_GENERAL;
+        }
+        return dsERR_NONE;
+}
+
+dsError_t dsAudioRampMute(dsAudioPortType_t type, bool mute)
+{
+        dsAudioMixerState_t state;
+        if (!dsAudioType_isValid(type)) {
+                return dsERR_INVALID_PARAM;
+        }
+        if (!dsAudioMixerGetState(type, &state)) {
+                return dsERR_GENERAL;
+        }
+        if (!state.m_hasSwitch) {
+                return dsERR_NONE;
+        }
+        if (!state.m_hasDb) {
+                /* Nothing to fade; flip the switch like an unramped mute */
+                return dsAudioRampSwitch(type, mute);
+        }
+
+        pthread_mutex_lock(&_rampLock);
+        if (!_rampRunning) {
+                pthread_mutex_unlock(&_rampLock);
+                return dsERR_INVALID_STATE;
+        }
+        dsAudioRamp_t *ramp = &_ramps[type];
+        ramp->m_floor = state.m_dBMin > RAMP_FLOOR_DB ? state.m_dBMin : RAMP_FLOOR_DB;
+        if (mute) {
+                if (ramp->m_phase == RAMP_UNMUTE_PENDING) {
+                        /* The switch was never turned back on */
+                        ramp->m_phase = RAMP_IDLE;
+                }
+                else if (ramp->m_phase != RAMP_MUTING && !state.m_muted) {
+                        dsAudioRampLatchUser(ramp, &state);
+                        long from = dsAudioRampPosition(ramp, &state);
+                        dsAudioRampStart(ramp, RAMP_MUTING, from, from < ramp->m_floor ? from : ramp->m_floor, _config.m_muteMs);
+                }
+        }
+        else {
+                if (ramp->m_phase == RAMP_MUTING) {
+                        /* Still audible: turn around from where the fade got to */
+                        dsAudioRampStart(ramp, RAMP_LEVEL, ramp->m_current, dsAudioRampEffective(ramp), _config.m_muteMs);
+                }
+                else if (state.m_muted && ramp->m_phase != RAMP_UNMUTE_PENDING) {
+                        dsAudioRampLatchUser(ramp, &state);
+                        ramp->m_phase = RAMP_UNMUTE_PENDING;
+                }
+        }
+        dsAudioRampWake();
+        pthread_mutex_unlock(&_rampLock);
+        return dsERR_NONE;
+}
+
+dsError_t dsAudioRampDuck(dsAudioPortType_t type, bool ducked, long ceiling, long offset, uint32_t durationMs)
+{
+        dsAudioMixerState_t state;
+        if (!dsAudioType_isValid(type) || offset > 0) {
+                return dsERR_INVALID_PARAM;
+        }
+        if (!dsAudioMixerGetState(type, &state) || !state.m_hasDb) {
+                return dsERR_GENERAL;
+        }
+
+        pthread_mutex_lock(&_rampLock);
+        if (!_rampRunning) {
+                pthread_mutex_unlock(&_rampLock);
+                return dsERR_INVALID_STATE;
+        }
+        dsAudioRamp_t *ramp = &_ramps[type];
+        dsAudioRampLatchUser(ramp, &state);
+        ramp->m_ducked = ducked;
+        ramp->m_duckCeiling = ceiling;
+        ramp->m_duckOffset = offset;
+        /* Muted or mid mute transition: the new level applies when the port is audible again */
+        if (ramp->m_phase != RAMP_MUTING && ramp->m_phase != RAMP_UNMUTE_PENDING && !state.m_muted) {
+                dsAudioRampStart(ramp, RAMP_LEVEL, dsAudioRampPosition(ramp, &state), dsAudioRampEffective(ramp), durationMs);
+        }
+        dsAudioRampWake();
+        pthread_mutex_unlock(&_rampLock);
+        return dsERR_NONE;
+}
+
+bool dsAudioRampCancel(dsAudioPortType_t type)
+{
+        if (!dsAudioType_isValid(type)) {
+                return true;
+        }
+        pthread_mutex_lock(&_rampLock);
+        const bool ducked = _ramps[type].m_ducked;
+        if (!ducked) {
+                /* Mute transitions are left to finish so the switch ends up where it was asked to */
+                if (_ramps[type].m_phase == RAMP_LEVEL) {
+                        _ramps[type].m_phase = RAMP_IDLE;
+                }
+                /* The direct write becomes the user level */
+                _ramps[type].m_userValid = false;
+        }
+        pthread_mutex_unlock(&_rampLock);
+        return !ducked;
+}
+
+static bool dsAudioRampBusy()
+{
+        if (_rampApplying) {
+                return true;
+        }
+        for (int i = 0; i < dsAUDIOPORT_TYPE_MAX; i++) {
+                if (_ramps[i].m_phase != RAMP_IDLE) {
+                        return true;
+                }
+        }
+        return false;
+}
+
+void dsAudioRampFlush()
+{
+        pthread_mutex_lock(&_rampLock);
+        while (_rampRunning && dsAudioRampBusy()) {
+                pthread_cond_wait(&_rampIdle, &_rampLock);
+        }
+        pthread_mutex_unlock(&_rampLock);
+}
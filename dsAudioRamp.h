@@ -0,0 +1,112 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSAUDIORAMP_H
+#define __DSAUDIORAMP_H
+
+#include <stdint.h>
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Volume ramp engine.
+ *
+ * Level and mute changes are handed to a worker thread that steps the mixer
+ * dB control towards the target on a timerfd tick, so the output fades
+ * instead of jumping. Requests return immediately. A new request for a port
+ * retargets the running ramp from wherever it currently is, so a burst of
+ * volume key presses becomes one continuous fade and the mixer is only
+ * written when the quantised level actually changes.
+ */
+
+typedef enum _dsAudioRampCurve_t {
+        dsAUDIORAMP_CURVE_LINEAR_DB = 0,  /**< Constant dB per tick.                   */
+        dsAUDIORAMP_CURVE_SCURVE,         /**< Smoothstep in dB, soft at both ends.     */
+        dsAUDIORAMP_CURVE_LINEAR_AMPLITUDE,/**< Constant amplitude per tick.            */
+        dsAUDIORAMP_CURVE_MAX
+} dsAudioRampCurve_t;
+
+typedef struct _dsAudioRampConfig_t {
+        uint32_t m_gainMs;              /**< Duration of a level change, 0 for a step. */
+        uint32_t m_muteMs;              /**< Duration of a mute/unmute fade.           */
+        uint32_t m_tickMs;              /**< Mixer update interval while ramping.      */
+        dsAudioRampCurve_t m_curve;
+} dsAudioRampConfig_t;
+
+dsError_t dsAudioRampInit();
+
+dsError_t dsAudioRampTerm();
+
+dsError_t dsAudioRampSetConfig(const dsAudioRampConfig_t *config);
+
+dsError_t dsAudioRampGetConfig(dsAudioRampConfig_t *config);
+
+/**
+ * @brief Fade a port to a mixer level.
+ *
+ * @param [in] type        Port whose element is ramped.
+ * @param [in] dB          Target in 1/100 dB.
+ * @param [in] durationMs  Fade length; 0 applies the level on the next tick.
+ *
+ * This becomes the port's user level. If the port is ducked the fade goes
+ * to the ducked equivalent, and if it is fading out to mute the level is
+ * applied once the mute completes.
+ */
+dsError_t dsAudioRampToDb(dsAudioPortType_t type, long dB, uint32_t durationMs);
+
+/**
+ * @brief Fade out and switch the port off, or switch it back on and fade in.
+ *
+ * The mixer level is put back to its pre-fade value once muted, so the
+ * level getters are unaffected by the fade. Elements with a playback switch
+ * but no dB range cannot fade and are switched immediately.
+ */
+dsError_t dsAudioRampMute(dsAudioPortType_t type, bool mute);
+
+/**
+ * @brief Hold a port below its user level, or release it.
+ *
+ * The level last asked for with dsAudioRampToDb() (or the mixer level when
+ * none was) is remembered and ramped back to exactly when ducking ends.
+ * While ducked the output is min(user + offset, ceiling); level changes
+ * made meanwhile update the remembered level.
+ *
+ * @param [in] ducked      false to release; ceiling and offset are then ignored.
+ * @param [in] ceiling     Highest level while ducked, 1/100 dB.
+ * @param [in] offset      Attenuation from the user level, 1/100 dB, <= 0.
+ * @param [in] durationMs  Length of the fade in or out.
+ */
+dsError_t dsAudioRampDuck(dsAudioPortType_t type, bool ducked, long ceiling, long offset, uint32_t durationMs);
+
+/**
+ * @brief Stop a level fade on a port, e.g. before a direct mixer write.
+ *
+ * A mute or unmute in progress still completes.
+ * @return false, without cancelling anything, if the port is ducked: a new
+ *         level must then go through dsAudioRampToDb() so that it becomes the
+ *         user level and the duck keeps applying.
+ */
+bool dsAudioRampCancel(dsAudioPortType_t type);
+
+/**
+ * @brief Wait until every fade has finished and been written to the mixer.
+ */
+void dsAudioRampFlush();
+
+#endif /* __DSAUDIORAMP_H */
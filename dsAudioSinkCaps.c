@@ -0,0 +1,265 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <alsa/asoundlib.h>
+#include "dshalUtils.h"
+#include "dsSeqlock.h"
+#include "dsAudioSinkCaps.h"
+
+#define SINK_CAPS_CARD "hw:0"
+#define SINK_CAPS_ELD_NAME "ELD"
+#define SINK_CAPS_ELD_MAX 256
+#define SINK_CAPS_EDID_BLOCK 128
+#define SINK_CAPS_EDID_MAX_EXTENSIONS 3
+
+/* ELD baseline block, CEA-861-D based layout (ELD version 2) */
+#define ELD_HEADER_BYTES 4
+#define ELD_MNL(eld) ((eld)[4] & 0x1F)
+#define ELD_SAD_COUNT(eld) ((eld)[5] >> 4)
+#define ELD_SPEAKERS(eld) ((eld)[7])
+#define ELD_NAME_OFFSET 20
+
+/* CTA-861 data block tags */
+#define CTA_TAG_AUDIO 1
+#define CTA_TAG_SPEAKERS 4
+
+static pthread_mutex_t _refreshLock = PTHREAD_MUTEX_INITIALIZER;
+static dsSeqlock_t _capsLock;
+static dsAudioSinkCaps_t _caps;
+static bool _stale = true;
+static bool _following = false;         /* hotplug callback registered, holding a tvservice reference */
+
+static void dsAudioSinkCapsHotplug(void *callback_data, uint32_t reason, uint32_t param1, uint32_t param2)
+{
+        if (reason & (VC_HDMI_UNPLUGGED | VC_HDMI_ATTACHED)) {
+                __atomic_store_n(&_stale, true, __ATOMIC_RELEASE);
+        }
+}
+
+static void dsAudioSinkCapsAddSad(dsAudioSinkCaps_t *caps, const uint8_t *sad)
+{
+        dsAudioSad_t *entry;
+        if (caps->m_sadCount >= DS_AUDIO_SINK_MAX_SADS) {
+                return;
+        }
+        entry = &caps->m_sads[caps->m_sadCount++];
+        entry->m_format = (sad[0] >> 3) & 0x0F;
+        entry->m_channels = (sad[0] & 0x07) + 1;
+        entry->m_rates = sad[1] & 0x7F;
+        entry->m_detail = sad[2];
+}
+
+/* Fill the per-format summary and the HAL-level answers from the descriptors */
+static void dsAudioSinkCapsSummarise(dsAudioSinkCaps_t *caps)
+{
+        for (uint8_t i = 0; i < caps->m_sadCount; i++) {
+                const dsAudioSad_t *sad = &caps->m_sads[i];
+                const uint8_t f = sad->m_format;
+                caps->m_maxChannels[f] = sad->m_channels > caps->m_maxChannels[f] ? sad->m_channels : caps->m_maxChannels[f];
+                caps->m_rates[f] |= sad->m_rates;
+                if (f >= DS_AUDIO_SAD_AC3 && f <= DS_AUDIO_SAD_DTS) {
+                        /* Maximum bit rate */
+                        caps->m_detail[f] = sad->m_detail > caps->m_detail[f] ? sad->m_detail : caps->m_detail[f];
+                } else {
+                        caps->m_detail[f] |= sad->m_detail;
+                }
+        }
+        caps->m_present = caps->m_sadCount > 0;
+        caps->m_atmos = dsAUDIO_ATMOS_NOTSUPPORTED;
+        if (caps->m_maxChannels[DS_AUDIO_SAD_EAC3] && (caps->m_detail[DS_AUDIO_SAD_EAC3] & DS_AUDIO_SAD_JOC)) {
+                caps->m_atmos = dsAUDIO_ATMOS_DDPLUSSTREAM;
+        }
+        if (caps->m_maxChannels[DS_AUDIO_SAD_MAT] && (caps->m_detail[DS_AUDIO_SAD_MAT] & DS_AUDIO_SAD_JOC)) {
+                caps->m_atmos = dsAUDIO_ATMOS_ATMOSMETADATA;
+        }
+        caps->m_capabilities = dsAUDIOSUPPORT_NONE;
+        if (caps->m_maxChannels[DS_AUDIO_SAD_AC3]) {
+                caps->m_capabilities |= dsAUDIOSUPPORT_DD;
+        }
+        if (caps->m_maxChannels[DS_AUDIO_SAD_EAC3]) {
+                caps->m_capabilities |= dsAUDIOSUPPORT_DDPLUS;
+        }
+        if (caps->m_atmos != dsAUDIO_ATMOS_NOTSUPPORTED) {
+                caps->m_capabilities |= dsAUDIOSUPPORT_ATMOS;
+        }
+}
+
+/*
+ * Read the ELD control of the HDMI PCM.
+ * @return bytes read, 0 for an empty ELD (no sink or no audio), -1 if the card has no ELD control.
+ */
+static int dsAudioSinkCapsReadEld(uint8_t *eld)
+{
+        snd_ctl_t *ctl;
+        snd_ctl_elem_id_t *id;
+        snd_ctl_elem_info_t *info;
+        snd_ctl_elem_value_t *value;
+        int count = -1;
+
+        if (snd_ctl_open(&ctl, SINK_CAPS_CARD, 0) < 0) {
+                return -1;
+        }
+        snd_ctl_elem_id_alloca(&id);
+        snd_ctl_elem_info_alloca(&info);
+        snd_ctl_elem_value_alloca(&value);
+        snd_ctl_elem_id_set_interface(id, SND_CTL_ELEM_IFACE_PCM);
+        snd_ctl_elem_id_set_device(id, 0);
+        snd_ctl_elem_id_set_name(id, SINK_CAPS_ELD_NAME);
+        snd_ctl_elem_info_set_id(info, id);
+        snd_ctl_elem_value_set_id(value, id);
+        if (snd_ctl_elem_info(ctl, info) == 0 && snd_ctl_elem_info_get_type(info) == SND_CTL_ELEM_TYPE_BYTES &&
+            snd_ctl_elem_read(ctl, value) == 0) {
+                count = (int) snd_ctl_elem_info_get_count(info);
+                count = count < SINK_CAPS_ELD_MAX ? count : SINK_CAPS_ELD_MAX;
+                memcpy(eld, snd_ctl_elem_value_get_bytes(value), count);
+        }
+        snd_ctl_close(ctl);
+        return count;
+}
+
+static void dsAudioSinkCapsParseEld(dsAudioSinkCaps_t *caps, const uint8_t *eld, int size)
+{
+        if (size < ELD_NAME_OFFSET || (eld[0] >> 3) == 0) {
+                return;
+        }
+        const int sads = ELD_NAME_OFFSET + ELD_MNL(eld);
+        caps->m_speakers = ELD_SPEAKERS(eld);
+        for (int i = 0; i < ELD_SAD_COUNT(eld) && sads + 3 * i + 3 <= size; i++) {
+                dsAudioSinkCapsAddSad(caps, eld + sads + 3 * i);
+        }
+}
+
+/* Audio and speaker allocation data blocks of the CTA extensions */
+static void dsAudioSinkCapsReadEdid(dsAudioSinkCaps_t *caps)
+{
+        uint8_t block[SINK_CAPS_EDID_BLOCK];
+        int extensions;
+
+        if (vchi_tv_init() != 0) {
+                return;
+        }
+        if (vc_tv_hdmi_ddc_read(0, sizeof(block), block) != (int) sizeof(block)) {
+                vchi_tv_uninit();
+                return;
+        }
+        extensions = block[0x7E] < SINK_CAPS_EDID_MAX_EXTENSIONS ? block[0x7E] : SINK_CAPS_EDID_MAX_EXTENSIONS;
+        for (int n = 1; n <= extensions; n++) {
+                if (vc_tv_hdmi_ddc_read(n * sizeof(block), sizeof(block), block) != (int) sizeof(block) ||
+                    block[0] != 0x02 || block[1] < 3) {
+                        continue;
+                }
+                const int end = block[2] >= 4 && block[2] <= sizeof(block) ? block[2] : 4;
+                for (int pos = 4; pos < end; ) {
+                        const int tag = block[pos] >> 5, length = block[pos] & 0x1F;
+                        if (pos + 1 + length > end) {
+                                break;
+                        }
+                        if (tag == CTA_TAG_AUDIO) {
+                                for (int i = 0; i + 3 <= length; i += 3) {
+                                        dsAudioSinkCapsAddSad(caps, block + pos + 1 + i);
+                                }
+                        } else if (tag == CTA_TAG_SPEAKERS && length >= 1) {
+                                caps->m_speakers = block[pos + 1];
+                        }
+                        pos += 1 + length;
+                }
+        }
+        vchi_tv_uninit();
+}
+
+static void dsAudioSinkCapsRefresh()
+{
+        dsAudioSinkCaps_t caps;
+        uint8_t eld[SINK_CAPS_ELD_MAX];
+        int size;
+
+        memset(&caps, 0, sizeof(caps));
+        if ((size = dsAudioSinkCapsReadEld(eld)) >= 0) {
+                dsAudioSinkCapsParseEld(&caps, eld, size);
+        } else {
+                /* The firmware audio driver has no ELD; the EDID holds the same descriptors */
+                dsAudioSinkCapsReadEdid(&caps);
+        }
+        dsAudioSinkCapsSummarise(&caps);
+        dsSeqlockWriteBegin(&_capsLock);
+        _caps = caps;
+        dsSeqlockWriteEnd(&_capsLock);
+}
+
+void dsAudioSinkCapsInit()
+{
+        pthread_mutex_lock(&_refreshLock);
+        if (!_following && vchi_tv_init() == 0) {
+                vc_tv_register_callback(&dsAudioSinkCapsHotplug, NULL);
+                _following = true;
+        }
+        __atomic_store_n(&_stale, true, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&_refreshLock);
+}
+
+void dsAudioSinkCapsTerm()
+{
+        pthread_mutex_lock(&_refreshLock);
+        if (_following) {
+                vc_tv_unregister_callback_full(&dsAudioSinkCapsHotplug, NULL);
+                vchi_tv_uninit();
+                _following = false;
+        }
+        pthread_mutex_unlock(&_refreshLock);
+}
+
+void dsAudioSinkCapsInvalidate()
+{
+        __atomic_store_n(&_stale, true, __ATOMIC_RELEASE);
+}
+
+void dsAudioSinkCapsGet(dsAudioSinkCaps_t *caps)
+{
+        uint32_t seq;
+
+        if (__atomic_load_n(&_stale, __ATOMIC_ACQUIRE)) {
+                pthread_mutex_lock(&_refreshLock);
+                /* Cleared before reading, so a hotplug during the read marks it stale again */
+                if (__atomic_exchange_n(&_stale, false, __ATOMIC_ACQ_REL)) {
+                        dsAudioSinkCapsRefresh();
+                }
+                pthread_mutex_unlock(&_refreshLock);
+        }
+        do {
+                seq = dsSeqlockReadBegin(&_capsLock);
+                *caps = _caps;
+        } while (dsSeqlockReadRetry(&_capsLock, seq));
+}
+
+bool dsAudioSinkCapsSupports(const dsAudioSinkCaps_t *caps, uint8_t format, uint8_t channels, uint8_t rateBit)
+{
+        if (format >= DS_AUDIO_SAD_FORMATS || caps->m_maxChannels[format] < channels) {
+                return false;
+        }
+        for (uint8_t i = 0; i < caps->m_sadCount; i++) {
+                const dsAudioSad_t *sad = &caps->m_sads[i];
+                if (sad->m_format == format && sad->m_channels >= channels && (rateBit == 0 || (sad->m_rates & rateBit))) {
+                        return true;
+                }
+        }
+        return false;
+}
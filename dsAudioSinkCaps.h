@@ -0,0 +1,111 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSAUDIOSINKCAPS_H
+#define __DSAUDIOSINKCAPS_H
+
+#include <stdint.h>
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Audio capabilities of the HDMI sink, as a table of its Short Audio
+ * Descriptors (CEA-861).
+ *
+ * The table is built once per hotplug, from the card's ELD control when
+ * the driver has one and from the CTA extension of the EDID otherwise, and
+ * published under a seqlock; queries copy it without locking or touching
+ * the hardware. A tvservice hotplug notification marks it stale and the
+ * next query rebuilds it.
+ */
+
+/* SAD audio format codes */
+#define DS_AUDIO_SAD_LPCM       1
+#define DS_AUDIO_SAD_AC3        2
+#define DS_AUDIO_SAD_DTS        7
+#define DS_AUDIO_SAD_EAC3       10
+#define DS_AUDIO_SAD_DTSHD      11
+#define DS_AUDIO_SAD_MAT        12      /* Dolby TrueHD / MAT */
+#define DS_AUDIO_SAD_FORMATS    16
+
+/* SAD sample rate bits */
+#define DS_AUDIO_SAD_RATE_32K   0x01
+#define DS_AUDIO_SAD_RATE_44K   0x02
+#define DS_AUDIO_SAD_RATE_48K   0x04
+#define DS_AUDIO_SAD_RATE_88K   0x08
+#define DS_AUDIO_SAD_RATE_96K   0x10
+#define DS_AUDIO_SAD_RATE_176K  0x20
+#define DS_AUDIO_SAD_RATE_192K  0x40
+
+/* Third SAD byte for LPCM: sample sizes */
+#define DS_AUDIO_SAD_LPCM_16BIT 0x01
+#define DS_AUDIO_SAD_LPCM_20BIT 0x02
+#define DS_AUDIO_SAD_LPCM_24BIT 0x04
+/* Third SAD byte for E-AC-3 and MAT: object audio (Atmos) */
+#define DS_AUDIO_SAD_JOC        0x01
+
+#define DS_AUDIO_SINK_MAX_SADS  32
+
+typedef struct _dsAudioSad_t {
+        uint8_t m_format;               /**< DS_AUDIO_SAD_* format code     */
+        uint8_t m_channels;             /**< Maximum channels               */
+        uint8_t m_rates;                /**< DS_AUDIO_SAD_RATE_* bits        */
+        uint8_t m_detail;               /**< Third byte: LPCM sizes, max bit rate / 8 kbps, or format flags */
+} dsAudioSad_t;
+
+typedef struct _dsAudioSinkCaps_t {
+        bool m_present;                 /**< A sink with audio is connected */
+        uint8_t m_speakers;             /**< Speaker allocation, CEA-861 byte 1 */
+        uint8_t m_sadCount;
+        dsAudioSad_t m_sads[DS_AUDIO_SINK_MAX_SADS];
+        /* Per format code, merged over its descriptors */
+        uint8_t m_maxChannels[DS_AUDIO_SAD_FORMATS];    /**< 0 if the format is not listed */
+        uint8_t m_rates[DS_AUDIO_SAD_FORMATS];
+        uint8_t m_detail[DS_AUDIO_SAD_FORMATS];
+        dsATMOSCapability_t m_atmos;
+        int m_capabilities;             /**< dsAudioCapabilities_t bits the sink can take */
+} dsAudioSinkCaps_t;
+
+/**
+ * @brief Start following hotplugs. Called by dsAudioPortInit().
+ */
+void dsAudioSinkCapsInit();
+
+void dsAudioSinkCapsTerm();
+
+/**
+ * @brief Mark the table stale, for event sources other than tvservice (ALSA ELD changes).
+ */
+void dsAudioSinkCapsInvalidate();
+
+/**
+ * @brief Copy the capability table, rebuilding it first after a hotplug.
+ *
+ * m_present is false if no sink is connected or its EDID could not be read.
+ */
+void dsAudioSinkCapsGet(dsAudioSinkCaps_t *caps);
+
+/**
+ * @brief Whether the sink lists a format with at least the given channels at a rate.
+ *
+ * @param [in] rateBit  One DS_AUDIO_SAD_RATE_* bit, or 0 for any rate
+ */
+bool dsAudioSinkCapsSupports(const dsAudioSinkCaps_t *caps, uint8_t format, uint8_t channels, uint8_t rateBit);
+
+#endif /* __DSAUDIOSINKCAPS_H */
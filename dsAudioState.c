@@ -0,0 +1,76 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <string.h>
+#include <pthread.h>
+#include "dsSeqlock.h"
+#include "dsAudioState.h"
+
+/* A line per port so readers of one port don't share it with writes to another */
+typedef struct _dsAudioStateSlot_t {
+        dsSeqlock_t m_lock;
+        dsAudioPortState_t m_state;
+} __attribute__((aligned(64))) dsAudioStateSlot_t;
+
+static dsAudioStateSlot_t _slots[dsAUDIOPORT_TYPE_MAX];
+static pthread_mutex_t _writeLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void dsAudioStateSetupOnce()
+{
+        for (int port = 0; port < dsAUDIOPORT_TYPE_MAX; port++) {
+                memset(&_slots[port].m_state, 0, sizeof(dsAudioPortState_t));
+                _slots[port].m_state.m_encoding = dsAUDIO_ENC_PCM;
+                _slots[port].m_state.m_stereoMode = dsAUDIO_STEREO_STEREO;
+        }
+}
+
+static void dsAudioStateSetup()
+{
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
+        pthread_once(&once, dsAudioStateSetupOnce);
+}
+
+void dsAudioStateGet(dsAudioPortType_t port, dsAudioPortState_t *state)
+{
+        const dsAudioStateSlot_t *slot = &_slots[port];
+        uint32_t seq;
+
+        dsAudioStateSetup();
+        do {
+                seq = dsSeqlockReadBegin(&slot->m_lock);
+                *state = slot->m_state;
+        } while (dsSeqlockReadRetry(&slot->m_lock, seq));
+}
+
+void dsAudioStateBegin(dsAudioPortType_t port, dsAudioPortState_t *state)
+{
+        dsAudioStateSetup();
+        pthread_mutex_lock(&_writeLock);
+        *state = _slots[port].m_state;
+}
+
+void dsAudioStateCommit(dsAudioPortType_t port, const dsAudioPortState_t *state)
+{
+        dsAudioStateSlot_t *slot = &_slots[port];
+
+        dsSeqlockWriteBegin(&slot->m_lock);
+        slot->m_state = *state;
+        dsSeqlockWriteEnd(&slot->m_lock);
+        pthread_mutex_unlock(&_writeLock);
+}
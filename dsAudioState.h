@@ -0,0 +1,70 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSAUDIOSTATE_H
+#define __DSAUDIOSTATE_H
+
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Per-port audio settings that the HAL answers from memory.
+ *
+ * Each port's settings are one block published under a seqlock: reads are
+ * lock-free and always see the fields of a single update together, and
+ * updates are serialised and bracketed like the DSP parameters:
+ *
+ *      dsAudioPortState_t state;
+ *      dsAudioStateBegin(port, &state);
+ *      state.m_encoding = encoding;
+ *      dsAudioStateCommit(port, &state);
+ */
+
+typedef struct _dsAudioPortState_t {
+        dsAudioEncoding_t m_encoding;
+        dsAudioStereoMode_t m_stereoMode;
+        bool m_ms11Enabled;
+        float m_dBMin;                  /**< Mixer range in dB, 0 until read. */
+        float m_dBMax;
+} dsAudioPortState_t;
+
+/**
+ * @brief Consistent copy of a port's settings. Lock-free.
+ */
+void dsAudioStateGet(dsAudioPortType_t port, dsAudioPortState_t *state);
+
+/**
+ * @brief Lock the port's settings for update and return a copy to modify.
+ */
+void dsAudioStateBegin(dsAudioPortType_t port, dsAudioPortState_t *state);
+
+/**
+ * @brief Publish the modified copy, then unlock.
+ */
+void dsAudioStateCommit(dsAudioPortType_t port, const dsAudioPortState_t *state);
+
+/**
+ * @brief Encoding, stereo mode, MS11 decode and dB range of a port in one read.
+ *
+ * Unlike separate dsGetAudioEncoding() and dsGetStereoMode() calls, the
+ * values come from the same update.
+ */
+dsError_t dsGetAudioPortState(intptr_t handle, dsAudioPortState_t *state);
+
+#endif /* __DSAUDIOSTATE_H */
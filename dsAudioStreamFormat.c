@@ -0,0 +1,159 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <alsa/asoundlib.h>
+#include "dsAudioStreamFormat.h"
+
+/* The HDMI PCM the HAL plays to, hw:0,0 */
+#ifndef STREAM_FORMAT_DEVICE
+#define STREAM_FORMAT_DEVICE "/dev/snd/pcmC0D0p"
+#endif
+#ifndef STREAM_FORMAT_HW_PARAMS
+#define STREAM_FORMAT_HW_PARAMS "/proc/asound/card0/pcm0p/sub0/hw_params"
+#endif
+#define STREAM_FORMAT_STATUS_NAME "IEC958 Playback Default"
+/* High bit rate link: E-AC-3 at four times the sample rate, MAT on eight channels */
+#define STREAM_FORMAT_HBR_RATE 176400
+
+static int _watchFd = -1;
+
+dsError_t dsAudioStreamFormatInit()
+{
+        if (_watchFd >= 0) {
+                return dsERR_NONE;
+        }
+        _watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (_watchFd < 0) {
+                printf("Stream format: inotify unavailable, format follows the HAL's own streams only\n");
+                return dsERR_GENERAL;
+        }
+        if (inotify_add_watch(_watchFd, STREAM_FORMAT_DEVICE, IN_OPEN | IN_CLOSE) < 0) {
+                printf("Stream format: cannot watch %s\n", STREAM_FORMAT_DEVICE);
+                close(_watchFd);
+                _watchFd = -1;
+                return dsERR_GENERAL;
+        }
+        return dsERR_NONE;
+}
+
+void dsAudioStreamFormatTerm()
+{
+        if (_watchFd >= 0) {
+                close(_watchFd);
+                _watchFd = -1;
+        }
+}
+
+int dsAudioStreamFormatFd()
+{
+        return _watchFd;
+}
+
+bool dsAudioStreamFormatReadEvents()
+{
+        char buffer[4 * sizeof(struct inotify_event)] __attribute__((aligned(__alignof__(struct inotify_event))));
+        bool seen = false;
+
+        if (_watchFd < 0) {
+                return false;
+        }
+        /* The watch is on one file, so what the events say does not matter */
+        while (read(_watchFd, buffer, sizeof(buffer)) > 0) {
+                seen = true;
+        }
+        return seen;
+}
+
+bool dsAudioStreamFormatIsControl(const char *name)
+{
+        return strcmp(name, STREAM_FORMAT_STATUS_NAME) == 0;
+}
+
+/* Value of "key: " in the procfs text, NULL if absent */
+static const char* dsAudioStreamFormatField(const char *text, const char *key)
+{
+        const char *field = strstr(text, key);
+        return field ? field + strlen(key) : NULL;
+}
+
+/* Non-audio bit of the card's channel status, false if the card has none */
+static bool dsAudioStreamFormatNonAudio(snd_ctl_t *ctl)
+{
+        snd_ctl_elem_value_t *value;
+        snd_aes_iec958_t status;
+
+        if (ctl == NULL) {
+                return false;
+        }
+        snd_ctl_elem_value_alloca(&value);
+        /* Per-device PCM interface on the firmware driver, mixer interface on vc4-hdmi */
+        snd_ctl_elem_value_set_interface(value, SND_CTL_ELEM_IFACE_PCM);
+        snd_ctl_elem_value_set_name(value, STREAM_FORMAT_STATUS_NAME);
+        if (snd_ctl_elem_read(ctl, value) < 0) {
+                snd_ctl_elem_value_set_interface(value, SND_CTL_ELEM_IFACE_MIXER);
+                if (snd_ctl_elem_read(ctl, value) < 0) {
+                        return false;
+                }
+        }
+        snd_ctl_elem_value_get_iec958(value, &status);
+        return (status.status[0] & IEC958_AES0_NONAUDIO) != 0;
+}
+
+bool dsAudioStreamFormatProbe(snd_ctl_t *ctl, dsAudioFormat_t *format)
+{
+        char text[512];
+        ssize_t length = -1;
+        int fd = open(STREAM_FORMAT_HW_PARAMS, O_RDONLY | O_CLOEXEC);
+
+        *format = dsAUDIO_FORMAT_NONE;
+        if (fd >= 0) {
+                length = read(fd, text, sizeof(text) - 1);
+                close(fd);
+        }
+        if (length <= 0) {
+                /* No such substream: nothing is playing on it */
+                return true;
+        }
+        text[length] = '\0';
+        if (strncmp(text, "closed", 6) == 0) {
+                return true;
+        }
+        /* "no setup": opened, hw_params not yet chosen */
+        const char *channels = dsAudioStreamFormatField(text, "channels: ");
+        const char *rate = dsAudioStreamFormatField(text, "rate: ");
+        if (channels == NULL || rate == NULL) {
+                return false;
+        }
+        if (!dsAudioStreamFormatNonAudio(ctl)) {
+                *format = dsAUDIO_FORMAT_PCM;
+        }
+        else if (strtoul(rate, NULL, 10) < STREAM_FORMAT_HBR_RATE) {
+                *format = dsAUDIO_FORMAT_DOLBY_AC3;
+        }
+        else {
+                *format = strtoul(channels, NULL, 10) >= 8 ? dsAUDIO_FORMAT_DOLBY_MAT : dsAUDIO_FORMAT_DOLBY_EAC3;
+        }
+        return true;
+}
@@ -0,0 +1,66 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSAUDIOSTREAMFORMAT_H
+#define __DSAUDIOSTREAMFORMAT_H
+
+#include <alsa/asoundlib.h>
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Format of the stream playing on the HDMI PCM.
+ *
+ * Whoever plays, the kernel publishes the substream's hw_params in procfs
+ * and the card holds the IEC958 channel status the player set; together
+ * they tell PCM from a compressed (non-audio) stream and the link rate
+ * from which the codec follows. Probing reads both, so it is only done
+ * when the PCM device is opened or closed (inotify on its node) or the
+ * channel status changes (a control event), by the audio event thread.
+ */
+
+dsError_t dsAudioStreamFormatInit();
+
+void dsAudioStreamFormatTerm();
+
+/**
+ * @brief Descriptor that becomes readable when the HDMI PCM is opened or closed, -1 if not watched.
+ */
+int dsAudioStreamFormatFd();
+
+/**
+ * @brief Consume the pending open/close notifications. @return true if there were any.
+ */
+bool dsAudioStreamFormatReadEvents();
+
+/**
+ * @brief Whether a control element event may change the detected format.
+ */
+bool dsAudioStreamFormatIsControl(const char *name);
+
+/**
+ * @brief Read the format of the stream now on the HDMI PCM.
+ *
+ * @param [in] ctl      Control handle of the card, may be NULL.
+ * @param [out] format  dsAUDIO_FORMAT_NONE when the PCM is closed.
+ * @return false while the PCM is open but not yet configured, so the caller probes again later.
+ */
+bool dsAudioStreamFormatProbe(snd_ctl_t *ctl, dsAudioFormat_t *format);
+
+#endif /* __DSAUDIOSTREAMFORMAT_H */
@@ -36,6 +36,7 @@ dsVideoPortResolution_t *HdmiSupportedResolution=NULL;
 static unsigned int numSupportedResn = 0;
 
 static bool isBootup = true;
+static bool _tvserviceHeld = false;    /* holds a vchi_tv_init() reference */
 static dsError_t dsQueryHdmiResolution();
 TV_SUPPORTED_MODE_T dsVideoPortgetVideoFormatFromInfo(dsVideoResolution_t res,
                                                        unsigned frameRate, bool interlaced);
@@ -105,10 +106,13 @@ dsError_t dsDisplayInit()
 	_handles[dsVIDEOPORT_TYPE_COMPONENT][0].m_vType  = dsVIDEOPORT_TYPE_BB;
 	_handles[dsVIDEOPORT_TYPE_COMPONENT][0].m_nativeHandle = dsVIDEOPORT_TYPE_BB;
 	_handles[dsVIDEOPORT_TYPE_COMPONENT][0].m_index = 0;
-    res = vchi_tv_init();
-    if (res != 0) {
-        printf("Unable to initialise tv servic\n");
-        return dsERR_GENERAL;
+    if (!_tvserviceHeld) {
+        res = vchi_tv_init();
+        if (res != 0) {
+            printf("Unable to initialise tv servic\n");
+            return dsERR_GENERAL;
+        }
+        _tvserviceHeld = true;
     }
     // Register callback for HDMI hotplug
     vc_tv_register_callback( &tvservice_callback, &_handles[dsVIDEOPORT_TYPE_HDMI][0] );
@@ -273,7 +277,10 @@ dsError_t dsGetEDID(intptr_t handle, dsDisplayEDID_t *edid)
 dsError_t dsDisplayTerm()
 {
     dsError_t res = dsERR_NONE;
-    vchi_tv_uninit();
+    if (_tvserviceHeld) {
+        vchi_tv_uninit();
+        _tvserviceHeld = false;
+    }
     if(HdmiSupportedResolution)
     {
         free(HdmiSupportedResolution);
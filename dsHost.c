@@ -25,16 +25,18 @@
 #include "dsTypes.h"
 #include "dsError.h"
 #include "dsHost.h"
+#include "dsThermal.h"
 extern "C" {
 #include "interface/vmcs_host/vc_vchi_gencmd.h"
 }
 static uint32_t version_num = 0x10000;
-#define FILE_SIZE 50
-#define SIZE 10
 dsError_t dsHostInit()
 {
     dsError_t ret = dsERR_NONE;
 
+    if (dsThermalInit() != dsERR_NONE) {
+        printf("CPU temperature sampling unavailable\n");
+    }
     return ret;
 }
 
@@ -54,19 +56,21 @@ dsError_t dsGetHostPowerMode(int *currPower)
 
 dsError_t dsGetCPUTemperature(float *cpuTemperature)
 {
-    dsError_t ret = dsERR_NONE;
-    char Temp_File[FILE_SIZE];
-    char temp_value[SIZE];
-    FILE *fp = NULL;
-    snprintf(Temp_File, FILE_SIZE, "/sys/class/thermal/thermal_zone0/temp");
-    fp = fopen(Temp_File, "r");
-    if (fread(temp_value, 1, SIZE, fp) <= 0) {
-        printf("Error reading cpu temp\n");
-        return ret;
+    dsThermalSnapshot_t snapshot;
+
+    if (cpuTemperature == NULL) {
+        return dsERR_INVALID_PARAM;
     }
-    *cpuTemperature = atof(temp_value)/1000;
-    printf("Cpu temperature %f", *cpuTemperature);
-    return ret;
+    /* Starts the sampler if dsHostInit() has not */
+    if (!dsThermalGetSnapshot(&snapshot) &&
+        (dsThermalInit() != dsERR_NONE || !dsThermalGetSnapshot(&snapshot))) {
+        return dsERR_GENERAL;
+    }
+    if (!(snapshot.m_validMask & (1u << snapshot.m_cpuZone))) {
+        return dsERR_GENERAL;
+    }
+    *cpuTemperature = snapshot.m_milliC[snapshot.m_cpuZone] / 1000.0f;
+    return dsERR_NONE;
 }
 
 dsError_t dsGetVersion(uint32_t *versionNumber)
@@ -161,6 +165,7 @@ dsError_t dsHostTerm()
 {
     dsError_t ret = dsERR_NONE;
 
+    dsThermalTerm();
     return ret;
 }
 
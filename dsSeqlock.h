@@ -0,0 +1,73 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSSEQLOCK_H
+#define __DSSEQLOCK_H
+
+#include <stdint.h>
+
+/*
+ * Sequence lock for small state blocks that are read far more often than
+ * written. Readers never block or make syscalls; writers must already be
+ * serialised by the caller.
+ *
+ *      do {
+ *              seq = dsSeqlockReadBegin(&lock);
+ *              copy = shared;
+ *      } while (dsSeqlockReadRetry(&lock, seq));
+ */
+#if defined(__aarch64__) || defined(__arm__)
+#define DS_CPU_RELAX() __asm__ __volatile__("yield" ::: "memory")
+#elif defined(__x86_64__) || defined(__i386__)
+#define DS_CPU_RELAX() __builtin_ia32_pause()
+#else
+#define DS_CPU_RELAX() do { } while (0)
+#endif
+
+typedef struct _dsSeqlock_t {
+        uint32_t m_seq;
+} dsSeqlock_t;
+
+static inline void dsSeqlockWriteBegin(dsSeqlock_t *lock)
+{
+        __atomic_store_n(&lock->m_seq, lock->m_seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void dsSeqlockWriteEnd(dsSeqlock_t *lock)
+{
+        __atomic_store_n(&lock->m_seq, lock->m_seq + 1, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t dsSeqlockReadBegin(const dsSeqlock_t *lock)
+{
+        uint32_t seq;
+        while ((seq = __atomic_load_n(&lock->m_seq, __ATOMIC_ACQUIRE)) & 1) {
+                DS_CPU_RELAX();
+        }
+        return seq;
+}
+
+static inline bool dsSeqlockReadRetry(const dsSeqlock_t *lock, uint32_t seq)
+{
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        return __atomic_load_n(&lock->m_seq, __ATOMIC_RELAXED) != seq;
+}
+
+#endif
@@ -0,0 +1,303 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include "dsSeqlock.h"
+#include "dsThermal.h"
+#include "dsThermalMonitor.h"
+
+#ifndef THERMAL_ZONE_PATH
+#define THERMAL_ZONE_PATH "/sys/class/thermal/thermal_zone%u/%s"
+#endif
+#define THERMAL_CPU_ZONE_TYPE "cpu-thermal"
+
+static int _zoneFds[dsTHERMAL_MAX_ZONES];
+static uint32_t _zones = 0;
+static uint32_t _cpuZone = 0;
+
+static dsSeqlock_t _snapshotLock;
+static dsThermalSnapshot_t _snapshot;
+
+static pthread_mutex_t _thermalLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t _thermalThread;
+static bool _thermalRunning = false;
+static bool _thermalStop = false;
+static uint32_t _intervalMs = dsTHERMAL_DEFAULT_INTERVAL_MS;
+static int _wakeFd = -1;
+static int _timerFd = -1;
+
+static uint64_t dsThermalNowMs()
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* sysfs temp is a signed decimal in millidegrees followed by a newline */
+static bool dsThermalParse(const char *buf, ssize_t len, int32_t *milliC)
+{
+        ssize_t i = 0;
+        bool negative = false;
+        int64_t value = 0;
+
+        if (i < len && buf[i] == '-') {
+                negative = true;
+                i++;
+        }
+        if (i == len || buf[i] < '0' || buf[i] > '9') {
+                return false;
+        }
+        for (; i < len && buf[i] >= '0' && buf[i] <= '9'; i++) {
+                value = value * 10 + (buf[i] - '0');
+                if (value > INT32_MAX) {
+                        return false;
+                }
+        }
+        *milliC = (int32_t)(negative ? -value : value);
+        return true;
+}
+
+static int dsThermalOpenZone(uint32_t zone, const char *file)
+{
+        char path[64];
+        snprintf(path, sizeof(path), THERMAL_ZONE_PATH, zone, file);
+        return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+static bool dsThermalIsCpuZone(uint32_t zone)
+{
+        char type[32];
+        int fd = dsThermalOpenZone(zone, "type");
+        if (fd < 0) {
+                return false;
+        }
+        ssize_t len = pread(fd, type, sizeof(type), 0);
+        close(fd);
+        const size_t match = sizeof(THERMAL_CPU_ZONE_TYPE) - 1;
+        return len > (ssize_t)match && memcmp(type, THERMAL_CPU_ZONE_TYPE, match) == 0 && type[match] == '\n';
+}
+
+/* Called with _thermalLock held and the sampler stopped */
+static void dsThermalOpenZones()
+{
+        _zones = 0;
+        _cpuZone = 0;
+        for (uint32_t zone = 0; zone < dsTHERMAL_MAX_ZONES; zone++) {
+                int fd = dsThermalOpenZone(zone, "temp");
+                if (fd < 0) {
+                        /* Zones are numbered without gaps */
+                        break;
+                }
+                if (dsThermalIsCpuZone(zone)) {
+                        _cpuZone = zone;
+                }
+                _zoneFds[_zones++] = fd;
+        }
+}
+
+static void dsThermalCloseZones()
+{
+        for (uint32_t zone = 0; zone < _zones; zone++) {
+                close(_zoneFds[zone]);
+        }
+        _zones = 0;
+}
+
+/* Only ever run by one thread at a time: dsThermalInit() before the sampler starts, then the sampler */
+static void dsThermalSample(dsThermalSnapshot_t *sampled)
+{
+        dsThermalSnapshot_t next = _snapshot;
+        char buf[16];
+
+        next.m_zones = _zones;
+        next.m_cpuZone = _cpuZone;
+        next.m_failedMask = 0;
+        for (uint32_t zone = 0; zone < _zones; zone++) {
+                ssize_t len = pread(_zoneFds[zone], buf, sizeof(buf), 0);
+                if (len <= 0 || !dsThermalParse(buf, len, &next.m_milliC[zone])) {
+                        /* Keep the last good value, e.g. when a zone's sensor is momentarily busy */
+                        next.m_failedMask |= 1u << zone;
+                }
+                else {
+                        next.m_validMask |= 1u << zone;
+                }
+        }
+        next.m_timestampMs = dsThermalNowMs();
+
+        dsSeqlockWriteBegin(&_snapshotLock);
+        _snapshot = next;
+        dsSeqlockWriteEnd(&_snapshotLock);
+        *sampled = next;
+}
+
+static void dsThermalArmTimer(uint32_t intervalMs)
+{
+        struct itimerspec spec;
+        memset(&spec, 0, sizeof(spec));
+        spec.it_value.tv_sec = intervalMs / 1000;
+        spec.it_value.tv_nsec = (intervalMs % 1000) * 1000000L;
+        spec.it_interval = spec.it_value;
+        timerfd_settime(_timerFd, 0, &spec, NULL);
+}
+
+static void dsThermalWake()
+{
+        uint64_t one = 1;
+        if (write(_wakeFd, &one, sizeof(one)) < 0) {
+                printf("Failed to wake thermal sampler\n");
+        }
+}
+
+static void* dsThermalThread(void *arg)
+{
+        struct pollfd pfds[2];
+        dsThermalSnapshot_t snapshot;
+        uint32_t armedMs = __atomic_load_n(&_intervalMs, __ATOMIC_RELAXED);
+
+        pfds[0].fd = _wakeFd;
+        pfds[0].events = POLLIN;
+        pfds[1].fd = _timerFd;
+        pfds[1].events = POLLIN;
+        dsThermalArmTimer(armedMs);
+        if (dsThermalGetSnapshot(&snapshot)) {
+                dsThermalMonitorUpdate(&snapshot);
+        }
+
+        while (!__atomic_load_n(&_thermalStop, __ATOMIC_ACQUIRE)) {
+                if (poll(pfds, 2, -1) < 0) {
+                        continue;
+                }
+                uint64_t value;
+                if ((pfds[0].revents & POLLIN) && read(_wakeFd, &value, sizeof(value)) < 0) {
+                        printf("Failed to drain thermal sampler wake fd\n");
+                }
+                if ((pfds[1].revents & POLLIN) && read(_timerFd, &value, sizeof(value)) > 0) {
+                        dsThermalSample(&snapshot);
+                        dsThermalMonitorUpdate(&snapshot);
+                }
+                const uint32_t intervalMs = __atomic_load_n(&_intervalMs, __ATOMIC_RELAXED);
+                if (intervalMs != armedMs) {
+                        dsThermalArmTimer(intervalMs);
+                        armedMs = intervalMs;
+                }
+        }
+        return NULL;
+}
+
+dsError_t dsThermalInit()
+{
+        dsError_t ret = dsERR_NONE;
+        pthread_mutex_lock(&_thermalLock);
+        if (!_thermalRunning) {
+                dsThermalOpenZones();
+                _snapshot.m_validMask = 0;
+                if (_zones == 0) {
+                        printf("No thermal zones found\n");
+                        pthread_mutex_unlock(&_thermalLock);
+                        return dsERR_GENERAL;
+                }
+                dsThermalSnapshot_t first;
+                dsThermalSample(&first);
+
+                _thermalStop = false;
+                _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                _timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+                if (_wakeFd < 0 || _timerFd < 0 ||
+                    pthread_create(&_thermalThread, NULL, dsThermalThread, NULL) != 0) {
+                        printf("Failed to start thermal sampler thread\n");
+                        if (_wakeFd >= 0) close(_wakeFd);
+                        if (_timerFd >= 0) close(_timerFd);
+                        _wakeFd = _timerFd = -1;
+                        dsThermalCloseZones();
+                        ret = dsERR_GENERAL;
+                }
+                else {
+                        _thermalRunning = true;
+                }
+        }
+        pthread_mutex_unlock(&_thermalLock);
+        return ret;
+}
+
+dsError_t dsThermalTerm()
+{
+        pthread_mutex_lock(&_thermalLock);
+        if (!_thermalRunning) {
+                pthread_mutex_unlock(&_thermalLock);
+                return dsERR_NONE;
+        }
+        __atomic_store_n(&_thermalStop, true, __ATOMIC_RELEASE);
+        dsThermalWake();
+        pthread_join(_thermalThread, NULL);
+        dsThermalMonitorStop();
+        _thermalRunning = false;
+        close(_wakeFd);
+        close(_timerFd);
+        _wakeFd = _timerFd = -1;
+        dsThermalCloseZones();
+
+        /* Readers see "no sample" rather than a value that is no longer refreshed */
+        dsSeqlockWriteBegin(&_snapshotLock);
+        _snapshot.m_timestampMs = 0;
+        dsSeqlockWriteEnd(&_snapshotLock);
+        pthread_mutex_unlock(&_thermalLock);
+        return dsERR_NONE;
+}
+
+dsError_t dsThermalSetInterval(uint32_t intervalMs)
+{
+        if (intervalMs < dsTHERMAL_MIN_INTERVAL_MS) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_thermalLock);
+        __atomic_store_n(&_intervalMs, intervalMs, __ATOMIC_RELAXED);
+        if (_thermalRunning) {
+                dsThermalWake();
+        }
+        pthread_mutex_unlock(&_thermalLock);
+        return dsERR_NONE;
+}
+
+dsError_t dsThermalGetInterval(uint32_t *intervalMs)
+{
+        if (intervalMs == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        *intervalMs = __atomic_load_n(&_intervalMs, __ATOMIC_RELAXED);
+        return dsERR_NONE;
+}
+
+bool dsThermalGetSnapshot(dsThermalSnapshot_t *snapshot)
+{
+        uint32_t seq;
+        do {
+                seq = dsSeqlockReadBegin(&_snapshotLock);
+                *snapshot = _snapshot;
+        } while (dsSeqlockReadRetry(&_snapshotLock, seq));
+        return snapshot->m_timestampMs != 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSTHERMAL_H
+#define __DSTHERMAL_H
+
+#include <stdint.h>
+#include "dsError.h"
+
+/*
+ * Pooled thermal zone sampler.
+ *
+ * Every /sys/class/thermal zone is opened once and re-read with pread() at
+ * offset 0 from a worker thread on a timerfd tick. The readings are
+ * published as one snapshot under a seqlock, so dsGetCPUTemperature() and
+ * other readers copy memory instead of going to sysfs.
+ */
+
+#define dsTHERMAL_MAX_ZONES 8
+#define dsTHERMAL_DEFAULT_INTERVAL_MS 1000
+#define dsTHERMAL_MIN_INTERVAL_MS 10
+
+typedef struct _dsThermalSnapshot_t {
+        uint32_t m_zones;                               /**< Zones sampled, thermal_zone0 first.    */
+        uint32_t m_cpuZone;                             /**< Index of the "cpu-thermal" zone, else 0. */
+        uint32_t m_validMask;                           /**< Zones with at least one good reading.  */
+        uint32_t m_failedMask;                          /**< Zones whose last read failed.          */
+        int32_t m_milliC[dsTHERMAL_MAX_ZONES];          /**< Last good reading in 1/1000 degree C.  */
+        uint64_t m_timestampMs;                         /**< CLOCK_MONOTONIC time, 0 before the first sample. */
+} dsThermalSnapshot_t;
+
+/**
+ * @brief Open the thermal zones, take a first sample and start the sampler.
+ *
+ * Safe to call more than once.
+ * @return dsERR_GENERAL if no zone could be opened or the thread failed to start.
+ */
+dsError_t dsThermalInit();
+
+dsError_t dsThermalTerm();
+
+/**
+ * @brief Change how often the zones are read. Takes effect on the next tick.
+ *
+ * @param [in] intervalMs  At least dsTHERMAL_MIN_INTERVAL_MS.
+ */
+dsError_t dsThermalSetInterval(uint32_t intervalMs);
+
+dsError_t dsThermalGetInterval(uint32_t *intervalMs);
+
+/**
+ * @brief Consistent copy of the latest sample. Lock-free.
+ *
+ * @return false if the sampler has not produced a sample yet.
+ */
+bool dsThermalGetSnapshot(dsThermalSnapshot_t *snapshot);
+
+#endif /* __DSTHERMAL_H */
@@ -0,0 +1,202 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "dshalUtils.h"
+#include "dsThermalMonitor.h"
+
+/* Pi 4 firmware caps the ARM clock from 80 C and throttles hard at 85 C */
+#define THERMAL_DEFAULT_WARM_MILLIC 70000
+#define THERMAL_DEFAULT_HOT_MILLIC 80000
+#define THERMAL_DEFAULT_CRITICAL_MILLIC 85000
+#define THERMAL_DEFAULT_HYSTERESIS_MILLIC 3000
+#define THERMAL_DEFAULT_CALLBACK_INTERVAL_MS 5000
+
+static pthread_mutex_t _monitorLock = PTHREAD_MUTEX_INITIALIZER;
+static dsThermalThresholds_t _thresholds = {
+        THERMAL_DEFAULT_WARM_MILLIC,
+        THERMAL_DEFAULT_HOT_MILLIC,
+        THERMAL_DEFAULT_CRITICAL_MILLIC,
+        THERMAL_DEFAULT_HYSTERESIS_MILLIC,
+        THERMAL_DEFAULT_CALLBACK_INTERVAL_MS,
+};
+static dsThermalEventCB_t _eventCB = NULL;
+
+static dsThermalSample_t _history[dsTHERMAL_HISTORY_SIZE];
+static uint32_t _historyCount = 0;
+static uint32_t _historyNext = 0;
+
+/* Monitor state; only the sampler thread touches these */
+static dsThermalLevel_t _level = dsTHERMAL_LEVEL_NORMAL;
+static dsThermalLevel_t _deliveredLevel = dsTHERMAL_LEVEL_NORMAL;
+static uint32_t _deliveredThrottled = 0;
+static uint64_t _deliveredMs = 0;
+static bool _deliveredOnce = false;
+static bool _gencmdReady = false;      /* holds a vchi_tv_init() reference */
+
+static bool dsThermalReadThrottled(uint32_t *throttled)
+{
+        char buffer[64];
+
+        if (!_gencmdReady) {
+                _gencmdReady = (vchi_tv_init() == 0);
+                if (!_gencmdReady) {
+                        return false;
+                }
+        }
+        buffer[0] = '\0';
+        if (vc_gencmd(buffer, sizeof(buffer), "get_throttled") != 0) {
+                return false;
+        }
+        buffer[sizeof(buffer) - 1] = '\0';
+        /* "throttled=0x50005" */
+        const char *equal = strchr(buffer, '=');
+        if (equal == NULL || strncmp(buffer, "throttled", equal - buffer) != 0) {
+                return false;
+        }
+        char *end;
+        *throttled = strtoul(equal + 1, &end, 16);
+        return end != equal + 1;
+}
+
+static int32_t dsThermalThreshold(const dsThermalThresholds_t *thresholds, int level)
+{
+        switch (level) {
+        case dsTHERMAL_LEVEL_WARM: return thresholds->m_warmMilliC;
+        case dsTHERMAL_LEVEL_HOT: return thresholds->m_hotMilliC;
+        default: return thresholds->m_criticalMilliC;
+        }
+}
+
+/* Called with _monitorLock held */
+static dsThermalLevel_t dsThermalClassify(dsThermalLevel_t level, int32_t milliC)
+{
+        int next = level;
+        while (next < dsTHERMAL_LEVEL_CRITICAL && milliC >= dsThermalThreshold(&_thresholds, next + 1)) {
+                next++;
+        }
+        if (next == level) {
+                while (next > dsTHERMAL_LEVEL_NORMAL &&
+                       milliC < dsThermalThreshold(&_thresholds, next) - _thresholds.m_hysteresisMilliC) {
+                        next--;
+                }
+        }
+        return (dsThermalLevel_t)next;
+}
+
+void dsThermalMonitorUpdate(const dsThermalSnapshot_t *snapshot)
+{
+        dsThermalSample_t sample;
+        dsThermalLevel_t previous = _deliveredLevel;
+
+        if (!(snapshot->m_validMask & (1u << snapshot->m_cpuZone))) {
+                return;
+        }
+        sample.m_timestampMs = snapshot->m_timestampMs;
+        sample.m_cpuMilliC = snapshot->m_milliC[snapshot->m_cpuZone];
+        sample.m_throttled = 0;
+        sample.m_throttledValid = dsThermalReadThrottled(&sample.m_throttled);
+
+        pthread_mutex_lock(&_monitorLock);
+        _level = dsThermalClassify(_level, sample.m_cpuMilliC);
+        sample.m_level = _level;
+        _history[_historyNext] = sample;
+        _historyNext = (_historyNext + 1) % dsTHERMAL_HISTORY_SIZE;
+        if (_historyCount < dsTHERMAL_HISTORY_SIZE) {
+                _historyCount++;
+        }
+
+        const uint32_t throttled = sample.m_throttled & dsTHERMAL_THROTTLED_NOW_MASK;
+        bool changed = sample.m_level != _deliveredLevel || throttled != _deliveredThrottled;
+        bool due = !_deliveredOnce || sample.m_timestampMs - _deliveredMs >= _thresholds.m_callbackIntervalMs ||
+                   (sample.m_level == dsTHERMAL_LEVEL_CRITICAL && _deliveredLevel != dsTHERMAL_LEVEL_CRITICAL);
+        bool deliver = changed && due;
+        if (deliver) {
+                _deliveredLevel = sample.m_level;
+                _deliveredThrottled = throttled;
+                _deliveredMs = sample.m_timestampMs;
+                _deliveredOnce = true;
+        }
+        pthread_mutex_unlock(&_monitorLock);
+
+        dsThermalEventCB_t cb = __atomic_load_n(&_eventCB, __ATOMIC_ACQUIRE);
+        if (deliver && cb != NULL) {
+                cb(&sample, previous);
+        }
+}
+
+void dsThermalMonitorStop()
+{
+        if (_gencmdReady) {
+                vchi_tv_uninit();
+                _gencmdReady = false;
+        }
+}
+
+void dsThermalSetEventCB(dsThermalEventCB_t cb)
+{
+        __atomic_store_n(&_eventCB, cb, __ATOMIC_RELEASE);
+}
+
+dsError_t dsThermalSetThresholds(const dsThermalThresholds_t *thresholds)
+{
+        if (thresholds == NULL ||
+            thresholds->m_warmMilliC >= thresholds->m_hotMilliC ||
+            thresholds->m_hotMilliC >= thresholds->m_criticalMilliC ||
+            thresholds->m_hysteresisMilliC < 0 ||
+            thresholds->m_hysteresisMilliC >= thresholds->m_hotMilliC - thresholds->m_warmMilliC ||
+            thresholds->m_hysteresisMilliC >= thresholds->m_criticalMilliC - thresholds->m_hotMilliC) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_monitorLock);
+        _thresholds = *thresholds;
+        pthread_mutex_unlock(&_monitorLock);
+        return dsERR_NONE;
+}
+
+dsError_t dsThermalGetThresholds(dsThermalThresholds_t *thresholds)
+{
+        if (thresholds == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_monitorLock);
+        *thresholds = _thresholds;
+        pthread_mutex_unlock(&_monitorLock);
+        return dsERR_NONE;
+}
+
+dsError_t dsThermalGetHistory(dsThermalSample_t *samples, uint32_t maxSamples, uint32_t *count)
+{
+        if (samples == NULL || count == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_monitorLock);
+        uint32_t n = _historyCount < maxSamples ? _historyCount : maxSamples;
+        uint32_t first = (_historyNext + dsTHERMAL_HISTORY_SIZE - n) % dsTHERMAL_HISTORY_SIZE;
+        for (uint32_t i = 0; i < n; i++) {
+                samples[i] = _history[(first + i) % dsTHERMAL_HISTORY_SIZE];
+        }
+        pthread_mutex_unlock(&_monitorLock);
+        *count = n;
+        return dsERR_NONE;
+}
@@ -0,0 +1,115 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __DSTHERMALMONITOR_H
+#define __DSTHERMALMONITOR_H
+
+#include <stdint.h>
+#include "dsError.h"
+#include "dsThermal.h"
+
+/*
+ * Thermal threshold monitor.
+ *
+ * On each thermal sampler tick (dsThermal.h) the monitor also reads the
+ * firmware's "get_throttled" flags, classifies the CPU temperature into a
+ * level with hysteresis and records the result in a ring of recent samples.
+ * When the level or the current throttling flags change, the registered
+ * callback is called from the sampler thread, at most once per
+ * m_callbackIntervalMs; changes inside that window are coalesced into one
+ * callback with the state at its end. Reaching dsTHERMAL_LEVEL_CRITICAL is
+ * reported without waiting for the window.
+ */
+
+typedef enum _dsThermalLevel_t {
+        dsTHERMAL_LEVEL_NORMAL = 0,
+        dsTHERMAL_LEVEL_WARM,
+        dsTHERMAL_LEVEL_HOT,            /**< Firmware starts capping the ARM clock near here. */
+        dsTHERMAL_LEVEL_CRITICAL,
+        dsTHERMAL_LEVEL_MAX
+} dsThermalLevel_t;
+
+/* "get_throttled" bits: now, and sticky since boot in the upper half */
+#define dsTHERMAL_THROTTLED_UNDERVOLTAGE        0x00001
+#define dsTHERMAL_THROTTLED_FREQ_CAPPED         0x00002
+#define dsTHERMAL_THROTTLED_THROTTLED           0x00004
+#define dsTHERMAL_THROTTLED_SOFT_TEMP_LIMIT     0x00008
+#define dsTHERMAL_THROTTLED_NOW_MASK            0x0000f
+#define dsTHERMAL_THROTTLED_OCCURRED_SHIFT      16
+
+#define dsTHERMAL_HISTORY_SIZE 64
+
+typedef struct _dsThermalThresholds_t {
+        int32_t m_warmMilliC;           /**< Level entered at or above this temperature.        */
+        int32_t m_hotMilliC;
+        int32_t m_criticalMilliC;
+        int32_t m_hysteresisMilliC;     /**< A level is left this far below its threshold.      */
+        uint32_t m_callbackIntervalMs;  /**< Minimum time between callbacks.                    */
+} dsThermalThresholds_t;
+
+typedef struct _dsThermalSample_t {
+        uint64_t m_timestampMs;         /**< CLOCK_MONOTONIC time of the zone reading.          */
+        int32_t m_cpuMilliC;
+        bool m_throttledValid;          /**< false if gencmd was unavailable.                   */
+        uint32_t m_throttled;           /**< dsTHERMAL_THROTTLED_* flags.                       */
+        dsThermalLevel_t m_level;
+} dsThermalSample_t;
+
+/**
+ * @brief Called on a level or throttling change. Runs on the sampler thread;
+ *        must not block or call dsThermalTerm().
+ *
+ * @param [in] sample    The sample that caused the callback.
+ * @param [in] previous  Level reported by the previous callback.
+ */
+typedef void (*dsThermalEventCB_t)(const dsThermalSample_t *sample, dsThermalLevel_t previous);
+
+void dsThermalSetEventCB(dsThermalEventCB_t cb);
+
+/**
+ * @brief Replace the thresholds. The level is re-evaluated on the next tick.
+ *
+ * @return dsERR_INVALID_PARAM unless warm < hot < critical and the
+ *         hysteresis is non-negative and smaller than the gap between
+ *         adjacent thresholds.
+ */
+dsError_t dsThermalSetThresholds(const dsThermalThresholds_t *thresholds);
+
+dsError_t dsThermalGetThresholds(dsThermalThresholds_t *thresholds);
+
+/**
+ * @brief Copy up to maxSamples of the most recent samples, oldest first.
+ *
+ * @param [out] count  Number of samples copied.
+ */
+dsError_t dsThermalGetHistory(dsThermalSample_t *samples, uint32_t maxSamples, uint32_t *count);
+
+/**
+ * @brief Classify a snapshot, record it and deliver any due callback.
+ *        Called by the thermal sampler thread only.
+ */
+void dsThermalMonitorUpdate(const dsThermalSnapshot_t *snapshot);
+
+/**
+ * @brief Drop the monitor's tvservice reference. Called by dsThermalTerm()
+ *        once the sampler thread has stopped.
+ */
+void dsThermalMonitorStop();
+
+#endif /* __DSTHERMALMONITOR_H */
@@ -19,12 +19,280 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
 #include "dsTypes.h"
 #include "dsVideoDevice.h"
+#include "dshalUtils.h"
+
+#define MAX_HDMI_MODE_ID (127)
+#define FRF_MODE_SWITCH_TIMEOUT_MS 3000
+/* Content and sink rates are compared in mHz; 0.1% absorbs 23.976 vs 23.98. */
+#define FRF_RATE_TOLERANCE_PERMILLE 1
+#define FRF_MAX_RATE_MULTIPLE 2
+
+/*
+ * Frame rate matching.
+ *
+ * dsSetDisplayframerate() picks the CEA mode at the current resolution whose
+ * refresh is the closest integer multiple of the content rate, using the
+ * NTSC (1000/1001) pixel clock for 24/30/60 Hz modes when that matches
+ * better. A current mode that is already such a multiple is kept. The
+ * switch itself runs on _frfThread so the caller never waits for
+ * HDMI retraining; only the most recent request is kept.
+ */
+typedef struct _FRFRequest_t {
+        bool m_pending;
+        uint32_t m_group;
+        uint32_t m_code;
+        bool m_ntsc;
+        uint32_t m_rateMilliHz;
+} FRFRequest_t;
+
+static pthread_mutex_t _frfLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _frfCond = PTHREAD_COND_INITIALIZER;
+static pthread_t _frfThread;
+static bool _frfThreadRunning = false;
+static bool _frfStop = false;
+static FRFRequest_t _frfRequest;
+static int _frfMode = 0;
+static uint32_t _tvNotifications = 0;
+static dsRegisterFrameratePreChangeCB_t _framerateprechangecb = NULL;
+static dsRegisterFrameratePostChangeCB_t _frameratepostchangecb = NULL;
+
+static TV_SUPPORTED_MODE_NEW_T _supportedModes[MAX_HDMI_MODE_ID];
+static int _numSupportedModes = 0;
+static bool _supportedModesValid = false;
+
+static uint64_t dsFrfNowMs()
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint32_t dsSinkRateMilliHz(uint32_t frameRate, bool ntsc)
+{
+        if (ntsc) {
+                return (uint32_t) (((uint64_t) frameRate * 1000000 + 500) / 1001);
+        }
+        return frameRate * 1000;
+}
+
+/* Only the 24/30/60 Hz families (and their doubles) have an NTSC clock variant. */
+static bool dsHasNtscVariant(uint32_t frameRate)
+{
+        return (frameRate % 24 == 0) || (frameRate % 30 == 0);
+}
+
+static void tvservice_frf_callback(void *callback_data, uint32_t reason, uint32_t param1, uint32_t param2)
+{
+        pthread_mutex_lock(&_frfLock);
+        if (reason & (VC_HDMI_UNPLUGGED | VC_HDMI_ATTACHED)) {
+                /* New sink, new EDID */
+                _supportedModesValid = false;
+        }
+        _tvNotifications++;
+        pthread_cond_broadcast(&_frfCond);
+        pthread_mutex_unlock(&_frfLock);
+}
+
+/* Called with _frfLock held. */
+static void dsRefreshSupportedModes()
+{
+        HDMI_RES_GROUP_T group;
+        uint32_t mode;
+        int num;
+
+        if (_supportedModesValid) {
+                return;
+        }
+        num = vc_tv_hdmi_get_supported_modes_new(HDMI_RES_GROUP_CEA, _supportedModes,
+                                                 vcos_countof(_supportedModes), &group, &mode);
+        if (num < 0) {
+                printf("Failed to get supported HDMI modes\n");
+                _numSupportedModes = 0;
+                return;
+        }
+        _numSupportedModes = num;
+        _supportedModesValid = true;
+}
+
+/*
+ * Accepts "23.98", "59.94", "50" or the "3840x2160px48" form used by the
+ * DeviceSettings client and returns the rate in mHz, 0 on parse failure.
+ */
+static uint32_t dsParseFramerate(const char *framerate)
+{
+        const char *rate = strstr(framerate, "px");
+        char *end = NULL;
+        double value;
+
+        rate = rate ? rate + 2 : framerate;
+        value = strtod(rate, &end);
+        if (end == rate || value <= 0.0 || value > 240.0) {
+                return 0;
+        }
+        return (uint32_t) lrint(value * 1000.0);
+}
+
+/*
+ * True when 'sinkMilliHz' is within FRF_RATE_TOLERANCE_PERMILLE of an integer
+ * multiple (up to FRF_MAX_RATE_MULTIPLE) of 'contentMilliHz'.
+ */
+static bool dsIsRateMultiple(uint32_t sinkMilliHz, uint32_t contentMilliHz, uint32_t *multiple, uint32_t *error)
+{
+        uint32_t m = (sinkMilliHz + contentMilliHz / 2) / contentMilliHz;
+        if (m == 0 || m > FRF_MAX_RATE_MULTIPLE) {
+                return false;
+        }
+        uint32_t target = contentMilliHz * m;
+        uint32_t e = sinkMilliHz > target ? sinkMilliHz - target : target - sinkMilliHz;
+        if ((uint64_t) e * 1000 > (uint64_t) sinkMilliHz * FRF_RATE_TOLERANCE_PERMILLE) {
+                return false;
+        }
+        *multiple = m;
+        *error = e;
+        return true;
+}
+
+/*
+ * Pick the best mode for 'contentMilliHz' at the current resolution.
+ * Returns false when nothing in the sink's mode list is an integer multiple.
+ */
+static bool dsFindFrfMode(const TV_DISPLAY_STATE_T *tvstate, uint32_t contentMilliHz, FRFRequest_t *best)
+{
+        uint32_t bestMultiple = FRF_MAX_RATE_MULTIPLE + 1;
+        uint32_t bestError = UINT32_MAX;
+
+        for (int i = 0; i < _numSupportedModes; i++) {
+                const TV_SUPPORTED_MODE_NEW_T *m = &_supportedModes[i];
+                if (m->scan_mode || m->width != tvstate->display.hdmi.width || m->height != tvstate->display.hdmi.height) {
+                        continue;
+                }
+                for (int ntsc = 0; ntsc <= 1; ntsc++) {
+                        if (ntsc && !dsHasNtscVariant(m->frame_rate)) {
+                                continue;
+                        }
+                        uint32_t sink = dsSinkRateMilliHz(m->frame_rate, ntsc);
+                        uint32_t multiple, error;
+                        if (!dsIsRateMultiple(sink, contentMilliHz, &multiple, &error)) {
+                                continue;
+                        }
+                        if (multiple < bestMultiple || (multiple == bestMultiple && error < bestError)) {
+                                bestMultiple = multiple;
+                                bestError = error;
+                                best->m_group = m->group;
+                                best->m_code = m->code;
+                                best->m_ntsc = ntsc;
+                                best->m_rateMilliHz = sink;
+                        }
+                }
+        }
+        return bestMultiple <= FRF_MAX_RATE_MULTIPLE;
+}
+
+static bool dsGetPixelClockNtsc()
+{
+        HDMI_PROPERTY_PARAM_T property;
+        memset(&property, 0, sizeof(property));
+        property.property = HDMI_PROPERTY_PIXEL_CLOCK_TYPE;
+        if (vc_tv_hdmi_get_property(&property) != 0) {
+                return false;
+        }
+        return property.param1 == HDMI_PIXEL_CLOCK_TYPE_NTSC;
+}
+
+static void* dsFrfThread(void *arg)
+{
+        pthread_mutex_lock(&_frfLock);
+        while (!_frfStop) {
+                if (!_frfRequest.m_pending) {
+                        pthread_cond_wait(&_frfCond, &_frfLock);
+                        continue;
+                }
+                FRFRequest_t req = _frfRequest;
+                _frfRequest.m_pending = false;
+                dsRegisterFrameratePreChangeCB_t preCb = _framerateprechangecb;
+                dsRegisterFrameratePostChangeCB_t postCb = _frameratepostchangecb;
+                uint32_t seen = _tvNotifications;
+                pthread_mutex_unlock(&_frfLock);
+
+                uint64_t start = dsFrfNowMs();
+                if (preCb) {
+                        preCb((unsigned int) time(NULL));
+                }
+
+                HDMI_PROPERTY_PARAM_T property;
+                memset(&property, 0, sizeof(property));
+                property.property = HDMI_PROPERTY_PIXEL_CLOCK_TYPE;
+                property.param1 = req.m_ntsc ? HDMI_PIXEL_CLOCK_TYPE_NTSC : HDMI_PIXEL_CLOCK_TYPE_PAL;
+                if (vc_tv_hdmi_set_property(&property) != 0) {
+                        printf("Failed to set HDMI pixel clock type\n");
+                }
+                int res = vc_tv_hdmi_power_on_explicit_new(HDMI_MODE_HDMI, (HDMI_RES_GROUP_T) req.m_group, req.m_code);
+
+                pthread_mutex_lock(&_frfLock);
+                if (res == 0) {
+                        struct timespec deadline;
+                        clock_gettime(CLOCK_REALTIME, &deadline);
+                        deadline.tv_sec += FRF_MODE_SWITCH_TIMEOUT_MS / 1000;
+                        while (_tvNotifications == seen && !_frfStop) {
+                                if (pthread_cond_timedwait(&_frfCond, &_frfLock, &deadline) == ETIMEDOUT) {
+                                        printf("No tvservice notification after frame rate switch\n");
+                                        break;
+                                }
+                        }
+                }
+                else {
+                        printf("Failed to switch to CEA mode %u for %u.%03u Hz\n", req.m_code,
+                               req.m_rateMilliHz / 1000, req.m_rateMilliHz % 1000);
+                }
+                pthread_mutex_unlock(&_frfLock);
+
+                printf("Frame rate switch to CEA %u (%u.%03u Hz) took %llu ms\n", req.m_code,
+                       req.m_rateMilliHz / 1000, req.m_rateMilliHz % 1000,
+                       (unsigned long long) (dsFrfNowMs() - start));
+                if (postCb) {
+                        postCb((unsigned int) time(NULL));
+                }
+                pthread_mutex_lock(&_frfLock);
+        }
+        pthread_mutex_unlock(&_frfLock);
+        return NULL;
+}
 
 dsError_t  dsVideoDeviceInit()
 {
 	dsError_t ret = dsERR_NONE;
+        bool started = false;
+        if (vchi_tv_init() != 0) {
+                printf("Failed to initialise tv service\n");
+                return dsERR_GENERAL;
+        }
+        pthread_mutex_lock(&_frfLock);
+        if (!_frfThreadRunning) {
+                _frfStop = false;
+                memset(&_frfRequest, 0, sizeof(_frfRequest));
+                if (pthread_create(&_frfThread, NULL, dsFrfThread, NULL) == 0) {
+                        _frfThreadRunning = true;
+                        started = true;
+                }
+                else {
+                        ret = dsERR_RESOURCE_NOT_AVAILABLE;
+                }
+        }
+        pthread_mutex_unlock(&_frfLock);
+        if (started) {
+                /* The running thread keeps this tvservice reference until Term */
+                vc_tv_register_callback(&tvservice_frf_callback, NULL);
+        }
+        else {
+                vchi_tv_uninit();
+        }
 	return ret;
 }
 
@@ -53,6 +321,20 @@ dsError_t  dsGetDFC(intptr_t handle, dsVideoZoom_t *dfc)
 dsError_t  dsVideoDeviceTerm()
 {
 	dsError_t ret = dsERR_NONE;
+        bool running;
+
+        vc_tv_unregister_callback_full(&tvservice_frf_callback, NULL);
+        pthread_mutex_lock(&_frfLock);
+        running = _frfThreadRunning;
+        _frfStop = true;
+        _frfThreadRunning = false;
+        _supportedModesValid = false;
+        pthread_cond_broadcast(&_frfCond);
+        pthread_mutex_unlock(&_frfLock);
+        if (running) {
+                pthread_join(_frfThread, NULL);
+                vchi_tv_uninit();
+        }
 	return ret;
 }
 dsError_t dsGetHDRCapabilities(intptr_t handle, int *capabilities)
@@ -78,30 +360,120 @@ dsError_t dsForceDisableHDRSupport(intptr_t handle, bool disable)
 dsError_t dsSetFRFMode(intptr_t handle, int frfmode)
 {
         dsError_t ret = dsERR_NONE;
+        if (frfmode != 0 && frfmode != 1) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_frfLock);
+        _frfMode = frfmode;
+        if (!frfmode) {
+                _frfRequest.m_pending = false;
+        }
+        pthread_mutex_unlock(&_frfLock);
         return ret;
 }
 dsError_t dsGetFRFMode(intptr_t handle, int *frfmode)
 {
         dsError_t ret = dsERR_NONE;
+        if (frfmode == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_frfLock);
+        *frfmode = _frfMode;
+        pthread_mutex_unlock(&_frfLock);
         return ret;
 }
 dsError_t dsGetCurrentDisplayframerate(intptr_t handle, char *framerate)
 {
         dsError_t ret = dsERR_NONE;
+        TV_DISPLAY_STATE_T tvstate;
+        if (framerate == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        if (vc_tv_get_display_state(&tvstate) != 0 || !(tvstate.state & (VC_HDMI_HDMI | VC_HDMI_DVI))) {
+                return dsERR_GENERAL;
+        }
+        uint32_t rate = dsSinkRateMilliHz(tvstate.display.hdmi.frame_rate,
+                                          dsHasNtscVariant(tvstate.display.hdmi.frame_rate) && dsGetPixelClockNtsc());
+        /* Rounded to 1/100 Hz: 23976 mHz reads "23.98", the form dsParseFramerate() takes back */
+        uint32_t centiHz = (rate + 5) / 10;
+        if (centiHz % 100) {
+                sprintf(framerate, "%ux%upx%u.%02u", tvstate.display.hdmi.width, tvstate.display.hdmi.height,
+                        centiHz / 100, centiHz % 100);
+        }
+        else {
+                sprintf(framerate, "%ux%upx%u", tvstate.display.hdmi.width, tvstate.display.hdmi.height, centiHz / 100);
+        }
         return ret;
 }
+
+/**
+ * @brief Switch the HDMI output to the mode that best fits the content rate.
+ *
+ * Only acts while FRF mode is enabled. Mode selection runs on the caller's
+ * thread against the cached sink mode list; the switch is queued for the FRF
+ * thread, which fires the pre/post change callbacks around it.
+ */
 dsError_t dsSetDisplayframerate(intptr_t handle, char *framerate)
 {
         dsError_t ret = dsERR_NONE;
+        TV_DISPLAY_STATE_T tvstate;
+        FRFRequest_t req;
+        uint32_t content;
+
+        if (framerate == NULL || (content = dsParseFramerate(framerate)) == 0) {
+                return dsERR_INVALID_PARAM;
+        }
+        if (vc_tv_get_display_state(&tvstate) != 0 || !(tvstate.state & (VC_HDMI_HDMI | VC_HDMI_DVI))) {
+                return dsERR_GENERAL;
+        }
+        bool currentNtsc = dsHasNtscVariant(tvstate.display.hdmi.frame_rate) && dsGetPixelClockNtsc();
+        uint32_t multiple, error;
+        bool currentMatches = dsIsRateMultiple(dsSinkRateMilliHz(tvstate.display.hdmi.frame_rate, currentNtsc),
+                                               content, &multiple, &error);
+
+        pthread_mutex_lock(&_frfLock);
+        if (!_frfMode) {
+                pthread_mutex_unlock(&_frfLock);
+                printf("FRF mode disabled, ignoring frame rate %s\n", framerate);
+                return dsERR_NONE;
+        }
+        if (currentMatches) {
+                /* 25 fps on 50 Hz, 24 fps on 48 Hz...: no retraining needed */
+                _frfRequest.m_pending = false;
+                pthread_mutex_unlock(&_frfLock);
+                return dsERR_NONE;
+        }
+        dsRefreshSupportedModes();
+        memset(&req, 0, sizeof(req));
+        if (!dsFindFrfMode(&tvstate, content, &req)) {
+                printf("No sink mode matches frame rate %s, keeping current mode\n", framerate);
+        }
+        else if (req.m_group == tvstate.display.hdmi.group && req.m_code == tvstate.display.hdmi.mode &&
+                 req.m_ntsc == currentNtsc) {
+                /* Already there; also drop any older switch still queued */
+                _frfRequest.m_pending = false;
+        }
+        else {
+                req.m_pending = true;
+                _frfRequest = req;
+                pthread_cond_broadcast(&_frfCond);
+        }
+        pthread_mutex_unlock(&_frfLock);
         return ret;
 }
 dsError_t dsRegisterFrameratePreChangeCB(dsRegisterFrameratePreChangeCB_t CBFunc)
 {
         dsError_t ret = dsERR_NONE;
+        pthread_mutex_lock(&_frfLock);
+        _framerateprechangecb = CBFunc;
+        pthread_mutex_unlock(&_frfLock);
         return ret;
 }
 dsError_t dsRegisterFrameratePostChangeCB(dsRegisterFrameratePostChangeCB_t CBFunc)
 {
         dsError_t ret = dsERR_NONE;
+        pthread_mutex_lock(&_frfLock);
+        _frameratepostchangecb = CBFunc;
+        pthread_mutex_unlock(&_frfLock);
         return ret;
 }
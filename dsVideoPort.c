@@ -31,11 +31,14 @@
 #include "dsVideoResolutionSettings.h"
 #include "dsDisplay.h"
 #include "dshalUtils.h"
+#include "dsVideoPortTransaction.h"
+#include "dsVideoPortTrace.h"
 
 static bool isBootup = true;
 static bool isValidVopHandle(intptr_t handle);
 static const char* dsVideoGetResolution(uint32_t mode);
 static uint32_t dsGetHdmiMode(dsVideoPortResolution_t *resolution);
+static void dsReconfigureFramebuffer();
 #define MAX_HDMI_MODE_ID (127)
 
 dsHDCPStatusCallback_t _halhdcpcallback = NULL;
@@ -51,6 +54,29 @@ static VOPHandle_t _handles[dsVIDEOPORT_TYPE_MAX][2] = {
 };
 
 static dsVideoPortResolution_t _resolution;
+static bool _tvserviceHeld = false;    /* holds a vchi_tv_init() reference */
+
+typedef struct _VOPTransaction_t {
+	bool m_isOpen;
+	bool m_hasResolution;
+	bool m_hasAspectRatio;
+	bool m_hasEnable;
+	dsVideoPortResolution_t m_resolution;
+	dsVideoAspectRatio_t m_aspectRatio;
+	bool m_enabled;
+} VOPTransaction_t;
+
+static VOPTransaction_t _transactions[dsVIDEOPORT_TYPE_MAX];
+/* Guards the staged state only; never held across tvservice calls or scripts */
+static pthread_mutex_t _transactionLock = PTHREAD_MUTEX_INITIALIZER;
+/* Serialises applying commits */
+static pthread_mutex_t _commitLock = PTHREAD_MUTEX_INITIALIZER;
+
+static dsVideoPortTraceCB_t _traceCallback = NULL;
+#define DS_VOP_TRACE(point, api, arg) do { \
+                dsVideoPortTraceCB_t cb = _traceCallback; \
+                if (cb) cb((point), (api), (uint32_t)(arg)); \
+        } while (0)
 
 static void tvservice_hdcp_callback( void *callback_data,
                                 uint32_t reason,
@@ -58,6 +84,10 @@ static void tvservice_hdcp_callback( void *callback_data,
                                 uint32_t param2 )
 {
     VOPHandle_t *hdmiHandle = (VOPHandle_t*)callback_data;
+    DS_VOP_TRACE(dsVIDEOPORT_TRACE_TV_CALLBACK, "tvservice", reason);
+    if (_halhdcpcallback == NULL) {
+        return;
+    }
     switch ( reason )
     {
       case VC_HDMI_HDCP_AUTH:
@@ -99,6 +129,22 @@ dsError_t dsRegisterHdcpStatusCallback(intptr_t handle, dsHDCPStatusCallback_t c
         return ret;
 }
 
+dsError_t dsVideoPortRegisterTraceCB(dsVideoPortTraceCB_t cb)
+{
+        _traceCallback = cb;
+        return dsERR_NONE;
+}
+
+dsError_t dsVideoPortGetResolutions(const dsVideoPortResolution_t **resolutions, size_t *count)
+{
+        if (resolutions == NULL || count == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        *resolutions = kResolutions;
+        *count = dsUTL_DIM(kResolutions);
+        return dsERR_NONE;
+}
+
 dsError_t  dsVideoPortInit()
 {
 	dsError_t ret = dsERR_NONE;
@@ -125,11 +171,14 @@ dsError_t  dsVideoPortInit()
 	vc_tv_register_callback( &tvservice_hdcp_callback, &_handles[dsVIDEOPORT_TYPE_HDMI][0] );
 
 	_resolution = kResolutions[kDefaultResIndex];
-        rc = vchi_tv_init();
-        if (rc != 0)
-        {
-             printf("Failed to initialise tv service\n");
-         } 
+        if (!_tvserviceHeld) {
+                rc = vchi_tv_init();
+                if (rc != 0)
+                {
+                     printf("Failed to initialise tv service\n");
+                }
+                _tvserviceHeld = (rc == 0);
+        }
 	return ret;
 }
 
@@ -239,6 +288,7 @@ dsError_t  dsEnableVideoPort(intptr_t handle, bool enabled)
 	if (!isValidVopHandle(handle)) {
          return dsERR_INVALID_PARAM;
     }
+	DS_VOP_TRACE(dsVIDEOPORT_TRACE_CALL, __FUNCTION__, enabled);
 
 	if(vopHandle->m_vType == dsVIDEOPORT_TYPE_BB)
 	{
@@ -248,12 +298,14 @@ dsError_t  dsEnableVideoPort(intptr_t handle, bool enabled)
                      {
                          options.aspect = SDTV_ASPECT_16_9;
                          res = vc_tv_sdtv_power_on(SDTV_MODE_NTSC, &options);
+                         DS_VOP_TRACE(dsVIDEOPORT_TRACE_VCHI_RETURN, __FUNCTION__, res);
                          if (res != 0)
                              printf("Failed to enable composite video port\n");
                      }
                      else
                      {
                          res = vc_tv_power_off();
+                         DS_VOP_TRACE(dsVIDEOPORT_TRACE_VCHI_RETURN, __FUNCTION__, res);
                          if ( res != 0 )
                          {
                              printf( "Failed to disbale composite video port" );
@@ -269,6 +321,7 @@ dsError_t  dsEnableVideoPort(intptr_t handle, bool enabled)
                      if (enabled)
                      {
                          res = vc_tv_hdmi_power_on_preferred();
+                         DS_VOP_TRACE(dsVIDEOPORT_TRACE_VCHI_RETURN, __FUNCTION__, res);
                          if ( res != 0 )
                          {
                              printf( "Failed to power on HDMI with preferred settings" );
@@ -279,6 +332,7 @@ dsError_t  dsEnableVideoPort(intptr_t handle, bool enabled)
                          {
                                 printf( "Failed to run script rpiDisplayEnable.sh with enable=1 rc=%d \n", rc );
                          }
+                         DS_VOP_TRACE(dsVIDEOPORT_TRACE_FB_RECONFIG, __FUNCTION__, rc);
                      }
                      else
                      {
@@ -287,9 +341,11 @@ dsError_t  dsEnableVideoPort(intptr_t handle, bool enabled)
                          {
                                 printf( "Failed to run script rpiDisplayEnable.sh with enable=0 rc=%d \n", rc );
                          }
+                         DS_VOP_TRACE(dsVIDEOPORT_TRACE_FB_RECONFIG, __FUNCTION__, rc);
                          sleep(1);
 
                          res = vc_tv_power_off();
+                         DS_VOP_TRACE(dsVIDEOPORT_TRACE_VCHI_RETURN, __FUNCTION__, res);
                          if ( res != 0 )
                          {
                              printf( "Failed to disbale HDMI video port" );
@@ -302,6 +358,7 @@ dsError_t  dsEnableVideoPort(intptr_t handle, bool enabled)
 	{
 		ret = dsERR_OPERATION_NOT_SUPPORTED;
 	}
+	DS_VOP_TRACE(dsVIDEOPORT_TRACE_COMPLETE, __FUNCTION__, ret);
 	return ret;
 }
 
@@ -511,29 +568,29 @@ static uint32_t dsGetHdmiMode(dsVideoPortResolution_t *resolution)
  */
 dsError_t  dsSetResolution(intptr_t handle, dsVideoPortResolution_t *resolution)
 {
+        DS_VOP_TRACE(dsVIDEOPORT_TRACE_CALL, __FUNCTION__, 0);
 	/* Auto Select uses 720p. Should be converted to dsVideoPortResolution_t = 720p in DS-VOPConfig, not here */
                 printf("Inside dsSetResolution\n");
 	dsError_t ret = dsERR_NONE;
         VOPHandle_t *vopHandle = (VOPHandle_t *) handle;
         int res = 0;
         if (!isValidVopHandle(handle)) {
-            return dsERR_INVALID_PARAM;
+            ret = dsERR_INVALID_PARAM;
+            DS_VOP_TRACE(dsVIDEOPORT_TRACE_COMPLETE, __FUNCTION__, ret);
+            return ret;
         }
         if (vopHandle->m_vType == dsVIDEOPORT_TYPE_HDMI) {
-                char command[512];
                 printf("Inside set Res HDMI\n");
 	        uint32_t hdmi_mode;
                 hdmi_mode = dsGetHdmiMode(resolution);
 		res = vc_tv_hdmi_power_on_explicit_new( HDMI_MODE_HDMI, HDMI_RES_GROUP_CEA, hdmi_mode );
+                DS_VOP_TRACE(dsVIDEOPORT_TRACE_VCHI_RETURN, __FUNCTION__, res);
 		if ( res != 0 )
 		{
 			printf( "Failed to set resolution\n");
 		}
-                sleep(1);
-                snprintf(command, 512, "fbset -depth 16");
-                system(command);
-                snprintf(command, 512, "fbset -depth 32");
-                system(command);
+                dsReconfigureFramebuffer();
+                DS_VOP_TRACE(dsVIDEOPORT_TRACE_FB_RECONFIG, __FUNCTION__, hdmi_mode);
         }
         else if (vopHandle->m_vType == dsVIDEOPORT_TYPE_BB)
         {
@@ -546,15 +603,344 @@ dsError_t  dsSetResolution(intptr_t handle, dsVideoPortResolution_t *resolution)
              {
                  res = vc_tv_sdtv_power_on(SDTV_MODE_PAL, &options);
              }
+             DS_VOP_TRACE(dsVIDEOPORT_TRACE_VCHI_RETURN, __FUNCTION__, res);
         }
         else
         {
             printf("Video port typr not supported\n");
         }
+	DS_VOP_TRACE(dsVIDEOPORT_TRACE_COMPLETE, __FUNCTION__, ret);
 	return ret;
 }
 
 
+/*
+ * Toggle the framebuffer depth so the console picks up the new mode.
+ */
+static void dsReconfigureFramebuffer()
+{
+        char command[512];
+        sleep(1);
+        snprintf(command, 512, "fbset -depth 16");
+        system(command);
+        snprintf(command, 512, "fbset -depth 32");
+        system(command);
+}
+
+/*
+ * Only 480p and 576p come in both 4:3 and 16:9 flavours in the CEA table.
+ */
+static uint32_t dsHdmiModeForAspect(uint32_t hdmiMode, dsVideoAspectRatio_t aspect)
+{
+        if (aspect == dsVIDEO_ASPECT_RATIO_4x3) {
+                if (hdmiMode == HDMI_CEA_480p60H) return HDMI_CEA_480p60;
+                if (hdmiMode == HDMI_CEA_576p50H) return HDMI_CEA_576p50;
+        }
+        else if (aspect == dsVIDEO_ASPECT_RATIO_16x9) {
+                if (hdmiMode == HDMI_CEA_480p60) return HDMI_CEA_480p60H;
+                if (hdmiMode == HDMI_CEA_576p50) return HDMI_CEA_576p50H;
+        }
+        return hdmiMode;
+}
+
+static VOPTransaction_t* dsGetTransaction(intptr_t handle)
+{
+        return &_transactions[((VOPHandle_t *) handle)->m_vType];
+}
+
+dsError_t dsVideoPortBeginTransaction(intptr_t handle)
+{
+        dsError_t ret = dsERR_NONE;
+        if (!isValidVopHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_transactionLock);
+        VOPTransaction_t *txn = dsGetTransaction(handle);
+        if (txn->m_isOpen) {
+                ret = dsERR_INVALID_STATE;
+        }
+        else {
+                memset(txn, 0, sizeof(*txn));
+                txn->m_isOpen = true;
+        }
+        pthread_mutex_unlock(&_transactionLock);
+        return ret;
+}
+
+dsError_t dsVideoPortStageResolution(intptr_t handle, const dsVideoPortResolution_t *resolution)
+{
+        dsError_t ret = dsERR_NONE;
+        if (!isValidVopHandle(handle) || resolution == NULL) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_transactionLock);
+        VOPTransaction_t *txn = dsGetTransaction(handle);
+        if (!txn->m_isOpen) {
+                ret = dsERR_INVALID_STATE;
+        }
+        else {
+                txn->m_resolution = *resolution;
+                txn->m_hasResolution = true;
+        }
+        pthread_mutex_unlock(&_transactionLock);
+        return ret;
+}
+
+dsError_t dsVideoPortStageAspectRatio(intptr_t handle, dsVideoAspectRatio_t aspectRatio)
+{
+        dsError_t ret = dsERR_NONE;
+        if (!isValidVopHandle(handle) || aspectRatio >= dsVIDEO_ASPECT_RATIO_MAX) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_transactionLock);
+        VOPTransaction_t *txn = dsGetTransaction(handle);
+        if (!txn->m_isOpen) {
+                ret = dsERR_INVALID_STATE;
+        }
+        else {
+                txn->m_aspectRatio = aspectRatio;
+                txn->m_hasAspectRatio = true;
+        }
+        pthread_mutex_unlock(&_transactionLock);
+        return ret;
+}
+
+dsError_t dsVideoPortStageEnable(intptr_t handle, bool enabled)
+{
+        dsError_t ret = dsERR_NONE;
+        if (!isValidVopHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_transactionLock);
+        VOPTransaction_t *txn = dsGetTransaction(handle);
+        if (!txn->m_isOpen) {
+                ret = dsERR_INVALID_STATE;
+        }
+        else {
+                txn->m_enabled = enabled;
+                txn->m_hasEnable = true;
+        }
+        pthread_mutex_unlock(&_transactionLock);
+        return ret;
+}
+
+dsError_t dsVideoPortAbortTransaction(intptr_t handle)
+{
+        if (!isValidVopHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        pthread_mutex_lock(&_transactionLock);
+        dsGetTransaction(handle)->m_isOpen = false;
+        pthread_mutex_unlock(&_transactionLock);
+        return dsERR_NONE;
+}
+
+/*
+ * Put the display back the way vc_tv_get_display_state() reported it before
+ * the commit started.
+ */
+static void dsRestoreDisplayState(const TV_DISPLAY_STATE_T *prev, bool prevValid)
+{
+        int res = 0;
+        if (!prevValid) {
+                return;
+        }
+        if (prev->state & (VC_HDMI_HDMI | VC_HDMI_DVI)) {
+                res = vc_tv_hdmi_power_on_explicit_new((prev->state & VC_HDMI_HDMI) ? HDMI_MODE_HDMI : HDMI_MODE_DVI,
+                                                       (HDMI_RES_GROUP_T) prev->display.hdmi.group,
+                                                       prev->display.hdmi.mode);
+        }
+        else if (prev->state & (VC_SDTV_NTSC | VC_SDTV_PAL)) {
+                SDTV_OPTIONS_T options = prev->display.sdtv.display_options;
+                res = vc_tv_sdtv_power_on((SDTV_MODE_T) prev->display.sdtv.mode, &options);
+        }
+        else {
+                res = vc_tv_power_off();
+        }
+        if (res != 0) {
+                printf("Failed to restore previous display state\n");
+        }
+}
+
+static void dsRunDisplayEnable(bool enable)
+{
+        int rc = system(enable ? "/lib/rdk/rpiDisplayEnable.sh 1" : "/lib/rdk/rpiDisplayEnable.sh 0");
+        if (rc == -1) {
+                printf("Failed to run script rpiDisplayEnable.sh with enable=%d rc=%d \n", enable, rc);
+        }
+}
+
+/* Sets *displayToggled once rpiDisplayEnable.sh has been run, so a rollback knows to undo it. */
+static dsError_t dsCommitHdmi(VOPHandle_t *vopHandle, const VOPTransaction_t *txn,
+                              const TV_DISPLAY_STATE_T *prev, bool prevValid, bool *displayToggled)
+{
+        int res = 0;
+        bool enable = txn->m_hasEnable ? txn->m_enabled : vopHandle->m_isEnabled;
+        bool isOn = prevValid && (prev->state & (VC_HDMI_HDMI | VC_HDMI_DVI));
+        bool modeChanged = false;
+
+        if (!enable) {
+                if (vopHandle->m_isEnabled) {
+                        dsRunDisplayEnable(false);
+                        *displayToggled = true;
+                        sleep(1);
+                        res = vc_tv_power_off();
+                        if (res != 0) {
+                                printf("Failed to disable HDMI video port\n");
+                                return dsERR_GENERAL;
+                        }
+                }
+                return dsERR_NONE;
+        }
+
+        if (txn->m_hasResolution || txn->m_hasAspectRatio) {
+                dsVideoPortResolution_t resolution = txn->m_hasResolution ? txn->m_resolution : _resolution;
+                dsVideoAspectRatio_t aspect = txn->m_hasAspectRatio ? txn->m_aspectRatio : resolution.aspectRatio;
+                uint32_t hdmiMode = dsHdmiModeForAspect(dsGetHdmiMode(&resolution), aspect);
+
+                if (!isOn || prev->display.hdmi.group != HDMI_RES_GROUP_CEA || prev->display.hdmi.mode != hdmiMode) {
+                        res = vc_tv_hdmi_power_on_explicit_new(HDMI_MODE_HDMI, HDMI_RES_GROUP_CEA, hdmiMode);
+                        DS_VOP_TRACE(dsVIDEOPORT_TRACE_VCHI_RETURN, "dsVideoPortCommitTransaction", res);
+                        modeChanged = true;
+                }
+        }
+        else if (!isOn) {
+                res = vc_tv_hdmi_power_on_preferred();
+                DS_VOP_TRACE(dsVIDEOPORT_TRACE_VCHI_RETURN, "dsVideoPortCommitTransaction", res);
+                modeChanged = true;
+        }
+        if (res != 0) {
+                printf("Failed to power on HDMI with staged settings\n");
+                return dsERR_GENERAL;
+        }
+
+        if (!vopHandle->m_isEnabled) {
+                dsRunDisplayEnable(true);
+                *displayToggled = true;
+        }
+        if (modeChanged) {
+                dsReconfigureFramebuffer();
+                DS_VOP_TRACE(dsVIDEOPORT_TRACE_FB_RECONFIG, "dsVideoPortCommitTransaction", 0);
+        }
+        return dsERR_NONE;
+}
+
+/* Composite runs NTSC for 480i and PAL for everything else */
+static SDTV_MODE_T dsSdtvModeFor(const dsVideoPortResolution_t *resolution)
+{
+        return strncmp(resolution->name, "480i", strlen("480i")) ? SDTV_MODE_PAL : SDTV_MODE_NTSC;
+}
+
+static SDTV_ASPECT_T dsSdtvAspectFor(dsVideoAspectRatio_t aspectRatio)
+{
+        return (aspectRatio == dsVIDEO_ASPECT_RATIO_4x3) ? SDTV_ASPECT_4_3 : SDTV_ASPECT_16_9;
+}
+
+static dsError_t dsCommitComposite(VOPHandle_t *vopHandle, const VOPTransaction_t *txn,
+                                   const TV_DISPLAY_STATE_T *prev, bool prevValid)
+{
+        int res = 0;
+        bool enable = txn->m_hasEnable ? txn->m_enabled : vopHandle->m_isEnabled;
+
+        if (!enable) {
+                if (vopHandle->m_isEnabled && vc_tv_power_off() != 0) {
+                        printf("Failed to disable composite video port\n");
+                        return dsERR_GENERAL;
+                }
+                return dsERR_NONE;
+        }
+
+        /* Unstaged fields keep what the output runs now, or what was last committed */
+        SDTV_OPTIONS_T options;
+        SDTV_MODE_T mode;
+        bool isOn = prevValid && (prev->state & (VC_SDTV_NTSC | VC_SDTV_PAL));
+        if (isOn) {
+                mode = (SDTV_MODE_T) prev->display.sdtv.mode;
+                options = prev->display.sdtv.display_options;
+        }
+        else {
+                memset(&options, 0, sizeof(options));
+                mode = dsSdtvModeFor(&_resolution);
+                options.aspect = dsSdtvAspectFor(_resolution.aspectRatio);
+        }
+        if (txn->m_hasAspectRatio) {
+                options.aspect = dsSdtvAspectFor(txn->m_aspectRatio);
+        }
+        if (txn->m_hasResolution) {
+                mode = dsSdtvModeFor(&txn->m_resolution);
+        }
+        if (isOn && prev->display.sdtv.mode == (uint32_t) mode &&
+            prev->display.sdtv.display_options.aspect == options.aspect) {
+                return dsERR_NONE;
+        }
+        res = vc_tv_sdtv_power_on(mode, &options);
+        if (res != 0) {
+                printf("Failed to power on composite with staged settings\n");
+                return dsERR_GENERAL;
+        }
+        return dsERR_NONE;
+}
+
+dsError_t dsVideoPortCommitTransaction(intptr_t handle)
+{
+        dsError_t ret = dsERR_NONE;
+        VOPHandle_t *vopHandle = (VOPHandle_t *) handle;
+        VOPTransaction_t txn;
+        TV_DISPLAY_STATE_T prev;
+        bool prevValid;
+        bool displayToggled = false;
+
+        if (!isValidVopHandle(handle)) {
+                return dsERR_INVALID_PARAM;
+        }
+        /* Take the staged state and close the transaction; applying it can take seconds */
+        pthread_mutex_lock(&_transactionLock);
+        if (!dsGetTransaction(handle)->m_isOpen) {
+                pthread_mutex_unlock(&_transactionLock);
+                return dsERR_INVALID_STATE;
+        }
+        txn = *dsGetTransaction(handle);
+        dsGetTransaction(handle)->m_isOpen = false;
+        pthread_mutex_unlock(&_transactionLock);
+        DS_VOP_TRACE(dsVIDEOPORT_TRACE_CALL, __FUNCTION__, 0);
+
+        pthread_mutex_lock(&_commitLock);
+        memset(&prev, 0, sizeof(prev));
+        prevValid = (vc_tv_get_display_state(&prev) == 0);
+
+        if (vopHandle->m_vType == dsVIDEOPORT_TYPE_HDMI) {
+                ret = dsCommitHdmi(vopHandle, &txn, &prev, prevValid, &displayToggled);
+        }
+        else if (vopHandle->m_vType == dsVIDEOPORT_TYPE_BB) {
+                ret = dsCommitComposite(vopHandle, &txn, &prev, prevValid);
+        }
+        else {
+                ret = dsERR_OPERATION_NOT_SUPPORTED;
+        }
+
+        if (ret == dsERR_NONE) {
+                if (txn.m_hasEnable) {
+                        vopHandle->m_isEnabled = txn.m_enabled;
+                }
+                /* A commit that leaves the port off never applied the staged mode */
+                if (vopHandle->m_isEnabled && txn.m_hasResolution) {
+                        _resolution = txn.m_resolution;
+                }
+                if (vopHandle->m_isEnabled && txn.m_hasAspectRatio) {
+                        _resolution.aspectRatio = txn.m_aspectRatio;
+                }
+        }
+        else if (ret == dsERR_GENERAL) {
+                printf("Video port transaction failed, rolling back\n");
+                dsRestoreDisplayState(&prev, prevValid);
+                if (displayToggled) {
+                        dsRunDisplayEnable(vopHandle->m_isEnabled);
+                }
+        }
+        pthread_mutex_unlock(&_commitLock);
+        DS_VOP_TRACE(dsVIDEOPORT_TRACE_COMPLETE, __FUNCTION__, ret);
+        return ret;
+}
 
  /**
  * @brief Terminate the Video Port sub-system.
@@ -570,7 +956,10 @@ dsError_t  dsSetResolution(intptr_t handle, dsVideoPortResolution_t *resolution)
 dsError_t  dsVideoPortTerm()
 {
     dsError_t ret = dsERR_NONE;
-    vchi_tv_uninit();
+    if (_tvserviceHeld) {
+        vchi_tv_uninit();
+        _tvserviceHeld = false;
+    }
     return ret;
 }
 
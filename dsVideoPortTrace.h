@@ -0,0 +1,67 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _DS_VIDEOPORTTRACE_H_
+#define _DS_VIDEOPORTTRACE_H_
+
+#include <stddef.h>
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Mode-switch trace points. Used by tools/dsModeSwitchBench to time
+ * dsSetResolution()/dsEnableVideoPort(); costs a NULL check when unused.
+ */
+typedef enum _dsVideoPortTracePoint_t {
+    dsVIDEOPORT_TRACE_CALL = 0,       /**< API entry.                               */
+    dsVIDEOPORT_TRACE_VCHI_RETURN,    /**< tvservice request returned over VCHI.    */
+    dsVIDEOPORT_TRACE_TV_CALLBACK,    /**< tvservice notification received.         */
+    dsVIDEOPORT_TRACE_FB_RECONFIG,    /**< framebuffer reconfiguration finished.    */
+    dsVIDEOPORT_TRACE_COMPLETE,       /**< API return.                              */
+    dsVIDEOPORT_TRACE_MAX
+} dsVideoPortTracePoint_t;
+
+/**
+ * @brief Trace callback.
+ *
+ * @param [in] point  Trace point reached.
+ * @param [in] api    Name of the API being traced ("tvservice" for callbacks).
+ * @param [in] arg    Point specific value: enable flag for dsEnableVideoPort()
+ *                    CALL (0 otherwise), tvservice return code for VCHI_RETURN,
+ *                    notification reason for TV_CALLBACK, HDMI mode for the
+ *                    dsSetResolution() FB_RECONFIG.
+ *
+ * May be invoked from the tvservice notification thread.
+ */
+typedef void (*dsVideoPortTraceCB_t)(dsVideoPortTracePoint_t point, const char *api, uint32_t arg);
+
+/**
+ * @brief Register (or clear with NULL) the mode-switch trace callback.
+ */
+dsError_t dsVideoPortRegisterTraceCB(dsVideoPortTraceCB_t cb);
+
+/**
+ * @brief Get the resolution table dsSetResolution() accepts.
+ *
+ * @param [out] resolutions  Set to the first entry of the table.
+ * @param [out] count        Set to the number of entries.
+ */
+dsError_t dsVideoPortGetResolutions(const dsVideoPortResolution_t **resolutions, size_t *count);
+
+#endif /* _DS_VIDEOPORTTRACE_H_ */
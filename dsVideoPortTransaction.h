@@ -0,0 +1,76 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _DS_VIDEOPORTTRANSACTION_H_
+#define _DS_VIDEOPORTTRANSACTION_H_
+
+#include "dsError.h"
+#include "dsTypes.h"
+
+/*
+ * Batched video port configuration.
+ *
+ * Each of dsSetResolution() and dsEnableVideoPort() drives tvservice on its
+ * own, so a resolution change followed by an enable retrains the HDMI link
+ * twice. A transaction stages the settings and commit() applies them with at
+ * most one power-on, rolling back to the previous display state on failure.
+ */
+
+/**
+ * @brief Start staging settings for a video port.
+ *
+ * @param [in] handle  Handle of the video port.
+ * @return dsERR_INVALID_STATE if a transaction is already open on the port.
+ */
+dsError_t dsVideoPortBeginTransaction(intptr_t handle);
+
+/**
+ * @brief Stage a resolution. Takes effect on commit.
+ */
+dsError_t dsVideoPortStageResolution(intptr_t handle, const dsVideoPortResolution_t *resolution);
+
+/**
+ * @brief Stage an aspect ratio. On HDMI only 480p/576p have a 4:3 variant.
+ */
+dsError_t dsVideoPortStageAspectRatio(intptr_t handle, dsVideoAspectRatio_t aspectRatio);
+
+/**
+ * @brief Stage the port enable state. Takes effect on commit.
+ */
+dsError_t dsVideoPortStageEnable(intptr_t handle, bool enabled);
+
+/**
+ * @brief Apply all staged settings in a single link retrain.
+ *
+ * Nothing is sent to tvservice when the staged state matches the current one.
+ * If a step fails the previous display mode and enable state are restored.
+ * The transaction is closed as soon as the commit starts, so the next one
+ * can be staged while this one applies; commits run one at a time.
+ *
+ * @return dsERR_INVALID_STATE if no transaction is open,
+ *         dsERR_GENERAL if applying failed (after rollback).
+ */
+dsError_t dsVideoPortCommitTransaction(intptr_t handle);
+
+/**
+ * @brief Drop all staged settings without touching the output.
+ */
+dsError_t dsVideoPortAbortTransaction(intptr_t handle);
+
+#endif /* _DS_VIDEOPORTTRANSACTION_H_ */
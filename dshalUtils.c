@@ -19,21 +19,26 @@
 
 #include <stdio.h>
 #include <ctype.h>
+#include <pthread.h>
 #include "dshalUtils.h"
-static uint16_t initialised = 0;
+/* One VCHI connection shared by every module; each successful vchi_tv_init() holds a reference */
+static uint32_t references = 0;
+static pthread_mutex_t referencesLock = PTHREAD_MUTEX_INITIALIZER;
 VCHI_INSTANCE_T    vchi_instance;
 VCHI_CONNECTION_T *vchi_connection;
 
 int vchi_tv_init()
 {
     int res = 0;
-    if (!initialised)
+    pthread_mutex_lock(&referencesLock);
+    if (!references)
     {
         vcos_init();
         res = vchi_initialise( &vchi_instance );
         if ( res != 0 )
         {
           printf( "Failed to initialize VCHI (res=%d)", res );
+          pthread_mutex_unlock(&referencesLock);
           return res;
         }
 
@@ -41,6 +46,7 @@ int vchi_tv_init()
         if ( res != 0)
         {
           printf( "Failed to create VCHI connection (ret=%d)", res );
+          pthread_mutex_unlock(&referencesLock);
           return res;
         }
 
@@ -48,23 +54,26 @@ int vchi_tv_init()
         vc_vchi_tv_init( vchi_instance, &vchi_connection, 1 );
         // Initialize the gencmd
         vc_vchi_gencmd_init(vchi_instance, &vchi_connection, 1 );
-        initialised = 1;
     }
+    references++;
+    pthread_mutex_unlock(&referencesLock);
     return res;
 }
 
 int vchi_tv_uninit()
 {
     int res = 0;
-    if (initialised)
+    pthread_mutex_lock(&referencesLock);
+    /* The last holder closes the connection; callbacks of other holders stay registered until then */
+    if (references && --references == 0)
     {
         // Stop the tvservice
         vc_vchi_tv_stop();
         vc_gencmd_stop();
         // Disconnect the VCHI connection
         vchi_disconnect( vchi_instance );
-        initialised = 0;
     }
+    pthread_mutex_unlock(&referencesLock);
     return res;
 }
 
@@ -26,6 +26,11 @@ extern "C" {
 }
 #include "dsTypes.h"
 
+/*
+ * tvservice/gencmd connection. Reference counted: every successful
+ * vchi_tv_init() must be paired with one vchi_tv_uninit(), and the
+ * connection is closed when the last reference goes.
+ */
 int vchi_tv_init();
 
 int vchi_tv_uninit();
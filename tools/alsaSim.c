@@ -0,0 +1,1009 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Host-side stand-in for the parts of alsa-lib the HAL uses, so dsAudio can
+ * be linked and exercised without a Pi sound card.
+ *
+ * The simulated card answers to "hw:0" and "default". It has an "HDMI"
+ * playback element (also found as "PCM"), optionally an "IEC958" element
+ * for the SPDIF port, "HDMI Jack" and "IEC958 Playback Default" controls,
+ * and a PCM that consumes whatever is written to it at once.
+ *
+ * Like alsa-lib, the simple mixer keeps element values in user space: reads
+ * are memory only, while each write, open step and event refresh stands for
+ * one ioctl. The sim makes one cheap real syscall for each of them, so
+ * syscall counts taken around HAL calls match the hardware. A change is
+ * queued on every open mixer and control handle, as the kernel does. The
+ * kernel does that for free, but here it costs the writer one write() per
+ * handle.
+ *
+ * Configured from the environment:
+ *   DS_ALSASIM_DB_MIN    element range in 1/100 dB       (default -10239)
+ *   DS_ALSASIM_DB_MAX                                    (default 400)
+ *   DS_ALSASIM_STEPS     volume steps across the range   (default one per 1/100 dB)
+ *   DS_ALSASIM_SWITCH    0 for elements without a playback switch (default 1)
+ *   DS_ALSASIM_DB        0 for elements without a dB range  (default 1)
+ *   DS_ALSASIM_IEC958    1 to give the card an "IEC958" element   (default 0)
+ *   DS_ALSASIM_IOCTL_US  time each simulated ioctl takes (default 0)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <alsa/asoundlib.h>
+
+#define SIM_ELEMENTS 2
+#define SIM_ELEM_HDMI 0
+#define SIM_ELEM_IEC958 1
+#define SIM_CONTROLS 2
+#define SIM_CTL_JACK 0
+#define SIM_CTL_STATUS 1
+#define SIM_NAME_LEN 44
+#define SIM_MAX_CHANNELS 8
+
+typedef struct {
+    long dBMin, dBMax, steps;
+    bool hasSwitch;
+    bool hasDb;
+    bool iec958;
+    long ioctlUs;
+} SimConfig_t;
+
+/* What the kernel holds */
+typedef struct {
+    long volume[SIM_ELEMENTS];
+    int unmuted[SIM_ELEMENTS];
+    snd_aes_iec958_t status;
+} SimCard_t;
+
+struct _snd_mixer_elem {
+    snd_mixer_t *mixer;
+    int index;
+    long volume;                /* user-space copy, as alsa-lib keeps */
+    int unmuted;
+    snd_mixer_elem_callback_t callback;
+    void *callbackPrivate;
+};
+
+struct _snd_mixer {
+    int events[2];              /* pipe: one byte per changed element */
+    bool attached;
+    bool loaded;
+    struct _snd_mixer_elem elems[SIM_ELEMENTS];
+    snd_mixer_t *next;
+};
+
+struct _snd_mixer_selem_id {
+    char name[SIM_NAME_LEN];
+    unsigned int index;
+};
+
+struct _snd_ctl {
+    int events[2];              /* pipe: one byte per changed control */
+    bool subscribed;
+    snd_ctl_t *next;
+};
+
+struct _snd_ctl_elem_id {
+    snd_ctl_elem_iface_t iface;
+    unsigned int device;
+    char name[SIM_NAME_LEN];
+};
+
+struct _snd_ctl_elem_info {
+    struct _snd_ctl_elem_id id;
+    snd_ctl_elem_type_t type;
+    unsigned int count;
+};
+
+struct _snd_ctl_elem_value {
+    struct _snd_ctl_elem_id id;
+    union {
+        long integer[128];
+        unsigned char bytes[512];
+        snd_aes_iec958_t iec958;
+    } value;
+};
+
+struct _snd_ctl_event {
+    int control;
+};
+
+struct _snd_pcm_hw_params {
+    unsigned int channels;
+    unsigned int rate;
+    unsigned int frameBytes;
+    snd_pcm_uframes_t period;
+    snd_pcm_uframes_t buffer;
+};
+
+struct _snd_pcm_sw_params {
+    snd_pcm_uframes_t startThreshold;
+    snd_pcm_uframes_t availMin;
+};
+
+struct _snd_pcm_info {
+    int card;
+    unsigned int device;
+};
+
+struct _snd_pcm {
+    int fd;                     /* stands for the device node */
+    struct _snd_pcm_hw_params hw;
+    unsigned char *buffer;
+    snd_pcm_channel_area_t areas[SIM_MAX_CHANNELS];
+};
+
+static const char *kElementNames[SIM_ELEMENTS] = { "HDMI", "IEC958" };
+static const char *kControlNames[SIM_CONTROLS] = { "HDMI Jack", "IEC958 Playback Default" };
+
+static pthread_mutex_t _simLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t _simOnce = PTHREAD_ONCE_INIT;
+static SimConfig_t _config;
+static SimCard_t _card;
+static snd_mixer_t *_mixers = NULL;
+static snd_ctl_t *_ctls = NULL;
+
+static long simEnv(const char *name, long def)
+{
+    const char *v = getenv(name);
+    return v ? strtol(v, NULL, 10) : def;
+}
+
+static void simSetup()
+{
+    _config.dBMin = simEnv("DS_ALSASIM_DB_MIN", -10239);
+    _config.dBMax = simEnv("DS_ALSASIM_DB_MAX", 400);
+    if (_config.dBMax <= _config.dBMin) {
+        _config.dBMax = _config.dBMin + 1;
+    }
+    _config.steps = simEnv("DS_ALSASIM_STEPS", _config.dBMax - _config.dBMin);
+    _config.steps = _config.steps > 0 ? _config.steps : 1;
+    _config.hasSwitch = simEnv("DS_ALSASIM_SWITCH", 1) != 0;
+    _config.hasDb = simEnv("DS_ALSASIM_DB", 1) != 0;
+    _config.iec958 = simEnv("DS_ALSASIM_IEC958", 0) != 0;
+    _config.ioctlUs = simEnv("DS_ALSASIM_IOCTL_US", 0);
+    for (int i = 0; i < SIM_ELEMENTS; i++) {
+        /* 0 dB, unmuted */
+        _card.volume[i] = -_config.dBMin * _config.steps / (_config.dBMax - _config.dBMin);
+        _card.unmuted[i] = 1;
+    }
+}
+
+static const SimConfig_t* simConfig()
+{
+    pthread_once(&_simOnce, simSetup);
+    return &_config;
+}
+
+/*
+ * One ioctl: a real, cheap syscall on the handle's descriptor, then the
+ * configured latency spent spinning on the vDSO clock so it adds no
+ * syscalls of its own.
+ */
+static void simIoctl(int fd)
+{
+    int pending = 0;
+    ioctl(fd, FIONREAD, &pending);
+    if (_config.ioctlUs > 0) {
+        struct timespec start, now;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        do {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+        } while ((now.tv_sec - start.tv_sec) * 1000000L + (now.tv_nsec - start.tv_nsec) / 1000 < _config.ioctlUs);
+    }
+}
+
+static bool simCardName(const char *name)
+{
+    return name != NULL && (strncmp(name, "hw:0", 4) == 0 || strcmp(name, "default") == 0);
+}
+
+static bool simElementPresent(int index)
+{
+    return index == SIM_ELEM_HDMI || (index == SIM_ELEM_IEC958 && _config.iec958);
+}
+
+/* Queue a change on every open handle. Called with _simLock held. */
+static void simNotifyMixers(int index)
+{
+    unsigned char byte = (unsigned char) index;
+    for (snd_mixer_t *mixer = _mixers; mixer != NULL; mixer = mixer->next) {
+        if (mixer->loaded && write(mixer->events[1], &byte, 1) < 0) {
+            /* A full pipe already wakes the reader */
+        }
+    }
+}
+
+static void simNotifyCtls(int control)
+{
+    unsigned char byte = (unsigned char) control;
+    for (snd_ctl_t *ctl = _ctls; ctl != NULL; ctl = ctl->next) {
+        if (ctl->subscribed && write(ctl->events[1], &byte, 1) < 0) {
+            /* As above */
+        }
+    }
+}
+
+static long simVolumeToDb(long volume)
+{
+    return _config.dBMin + (_config.dBMax - _config.dBMin) * volume / _config.steps;
+}
+
+static long simDbToVolume(long dB, int dir)
+{
+    const long range = _config.dBMax - _config.dBMin;
+    long scaled;
+    dB = dB < _config.dBMin ? _config.dBMin : (dB > _config.dBMax ? _config.dBMax : dB);
+    scaled = (dB - _config.dBMin) * _config.steps;
+    if (dir > 0) {
+        return (scaled + range - 1) / range;
+    }
+    if (dir < 0) {
+        return scaled / range;
+    }
+    return (scaled + range / 2) / range;
+}
+
+const char *snd_strerror(int errnum)
+{
+    return strerror(errnum < 0 ? -errnum : errnum);
+}
+
+/* Mixer */
+
+int snd_mixer_open(snd_mixer_t **mixer, int mode)
+{
+    snd_mixer_t *m = (snd_mixer_t *) calloc(1, sizeof(snd_mixer_t));
+    simConfig();
+    if (m == NULL) {
+        return -ENOMEM;
+    }
+    if (pipe2(m->events, O_NONBLOCK | O_CLOEXEC) < 0) {
+        free(m);
+        return -errno;
+    }
+    for (int i = 0; i < SIM_ELEMENTS; i++) {
+        m->elems[i].mixer = m;
+        m->elems[i].index = i;
+    }
+    pthread_mutex_lock(&_simLock);
+    m->next = _mixers;
+    _mixers = m;
+    pthread_mutex_unlock(&_simLock);
+    *mixer = m;
+    return 0;
+}
+
+int snd_mixer_close(snd_mixer_t *mixer)
+{
+    pthread_mutex_lock(&_simLock);
+    for (snd_mixer_t **p = &_mixers; *p != NULL; p = &(*p)->next) {
+        if (*p == mixer) {
+            *p = mixer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_simLock);
+    close(mixer->events[0]);
+    close(mixer->events[1]);
+    free(mixer);
+    return 0;
+}
+
+int snd_mixer_attach(snd_mixer_t *mixer, const char *name)
+{
+    if (!simCardName(name)) {
+        return -ENODEV;
+    }
+    /* Card info and element list */
+    simIoctl(mixer->events[0]);
+    simIoctl(mixer->events[0]);
+    mixer->attached = true;
+    return 0;
+}
+
+int snd_mixer_selem_register(snd_mixer_t *mixer, struct snd_mixer_selem_regopt *options, snd_mixer_class_t **classp)
+{
+    return 0;
+}
+
+int snd_mixer_load(snd_mixer_t *mixer)
+{
+    if (!mixer->attached) {
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&_simLock);
+    for (int i = 0; i < SIM_ELEMENTS; i++) {
+        if (simElementPresent(i)) {
+            /* Element info and value */
+            simIoctl(mixer->events[0]);
+            simIoctl(mixer->events[0]);
+            mixer->elems[i].volume = _card.volume[i];
+            mixer->elems[i].unmuted = _card.unmuted[i];
+        }
+    }
+    mixer->loaded = true;
+    pthread_mutex_unlock(&_simLock);
+    return 0;
+}
+
+int snd_mixer_handle_events(snd_mixer_t *mixer)
+{
+    unsigned char changed[64];
+    ssize_t count;
+    int handled = 0;
+
+    while ((count = read(mixer->events[0], changed, sizeof(changed))) > 0) {
+        for (ssize_t n = 0; n < count; n++) {
+            snd_mixer_elem_t *elem = &mixer->elems[changed[n] % SIM_ELEMENTS];
+            /* Re-read the element */
+            simIoctl(mixer->events[0]);
+            pthread_mutex_lock(&_simLock);
+            elem->volume = _card.volume[elem->index];
+            elem->unmuted = _card.unmuted[elem->index];
+            pthread_mutex_unlock(&_simLock);
+            if (elem->callback) {
+                elem->callback(elem, SND_CTL_EVENT_MASK_VALUE);
+            }
+            handled++;
+        }
+    }
+    return handled;
+}
+
+int snd_mixer_poll_descriptors_count(snd_mixer_t *mixer)
+{
+    return 1;
+}
+
+int snd_mixer_poll_descriptors(snd_mixer_t *mixer, struct pollfd *pfds, unsigned int space)
+{
+    if (space < 1) {
+        return 0;
+    }
+    pfds[0].fd = mixer->events[0];
+    pfds[0].events = POLLIN | POLLERR | POLLNVAL;
+    return 1;
+}
+
+int snd_mixer_poll_descriptors_revents(snd_mixer_t *mixer, struct pollfd *pfds, unsigned int nfds, unsigned short *revents)
+{
+    *revents = nfds ? pfds[0].revents : 0;
+    return 0;
+}
+
+int snd_mixer_selem_id_malloc(snd_mixer_selem_id_t **ptr)
+{
+    *ptr = (snd_mixer_selem_id_t *) calloc(1, sizeof(snd_mixer_selem_id_t));
+    return *ptr ? 0 : -ENOMEM;
+}
+
+void snd_mixer_selem_id_free(snd_mixer_selem_id_t *obj)
+{
+    free(obj);
+}
+
+void snd_mixer_selem_id_set_index(snd_mixer_selem_id_t *obj, unsigned int val)
+{
+    obj->index = val;
+}
+
+void snd_mixer_selem_id_set_name(snd_mixer_selem_id_t *obj, const char *val)
+{
+    snprintf(obj->name, sizeof(obj->name), "%s", val);
+}
+
+const char *snd_mixer_selem_id_get_name(const snd_mixer_selem_id_t *obj)
+{
+    return obj->name;
+}
+
+unsigned int snd_mixer_selem_id_get_index(const snd_mixer_selem_id_t *obj)
+{
+    return obj->index;
+}
+
+snd_mixer_elem_t *snd_mixer_find_selem(snd_mixer_t *mixer, const snd_mixer_selem_id_t *id)
+{
+    if (!mixer->loaded || id->index != 0) {
+        return NULL;
+    }
+    if (strcmp(id->name, "PCM") == 0) {
+        return &mixer->elems[SIM_ELEM_HDMI];
+    }
+    for (int i = 0; i < SIM_ELEMENTS; i++) {
+        if (simElementPresent(i) && strcmp(id->name, kElementNames[i]) == 0) {
+            return &mixer->elems[i];
+        }
+    }
+    return NULL;
+}
+
+void snd_mixer_elem_set_callback(snd_mixer_elem_t *obj, snd_mixer_elem_callback_t val)
+{
+    obj->callback = val;
+}
+
+void snd_mixer_elem_set_callback_private(snd_mixer_elem_t *obj, void *val)
+{
+    obj->callbackPrivate = val;
+}
+
+void *snd_mixer_elem_get_callback_private(const snd_mixer_elem_t *obj)
+{
+    return obj->callbackPrivate;
+}
+
+int snd_mixer_selem_has_playback_switch(snd_mixer_elem_t *elem)
+{
+    return _config.hasSwitch;
+}
+
+int snd_mixer_selem_get_playback_switch(snd_mixer_elem_t *elem, snd_mixer_selem_channel_id_t channel, int *value)
+{
+    if (!_config.hasSwitch) {
+        return -EINVAL;
+    }
+    *value = elem->unmuted;
+    return 0;
+}
+
+/* Write the element and let every open mixer know, as the kernel does */
+static int simWriteElem(snd_mixer_elem_t *elem, long volume, int unmuted)
+{
+    simIoctl(elem->mixer->events[0]);
+    pthread_mutex_lock(&_simLock);
+    elem->volume = volume;
+    elem->unmuted = unmuted;
+    if (_card.volume[elem->index] != volume || _card.unmuted[elem->index] != unmuted) {
+        _card.volume[elem->index] = volume;
+        _card.unmuted[elem->index] = unmuted;
+        simNotifyMixers(elem->index);
+    }
+    pthread_mutex_unlock(&_simLock);
+    return 0;
+}
+
+int snd_mixer_selem_set_playback_switch_all(snd_mixer_elem_t *elem, int value)
+{
+    if (!_config.hasSwitch) {
+        return -EINVAL;
+    }
+    return simWriteElem(elem, elem->volume, value ? 1 : 0);
+}
+
+int snd_mixer_selem_get_playback_dB_range(snd_mixer_elem_t *elem, long *min, long *max)
+{
+    if (!_config.hasDb) {
+        return -EINVAL;
+    }
+    *min = _config.dBMin;
+    *max = _config.dBMax;
+    return 0;
+}
+
+int snd_mixer_selem_get_playback_dB(snd_mixer_elem_t *elem, snd_mixer_selem_channel_id_t channel, long *value)
+{
+    if (!_config.hasDb) {
+        return -EINVAL;
+    }
+    *value = simVolumeToDb(elem->volume);
+    return 0;
+}
+
+int snd_mixer_selem_set_playback_dB_all(snd_mixer_elem_t *elem, long value, int dir)
+{
+    if (!_config.hasDb) {
+        return -EINVAL;
+    }
+    return simWriteElem(elem, simDbToVolume(value, dir), elem->unmuted);
+}
+
+int snd_mixer_selem_get_playback_volume(snd_mixer_elem_t *elem, snd_mixer_selem_channel_id_t channel, long *value)
+{
+    *value = elem->volume;
+    return 0;
+}
+
+int snd_mixer_selem_get_playback_volume_range(snd_mixer_elem_t *elem, long *min, long *max)
+{
+    *min = 0;
+    *max = _config.steps;
+    return 0;
+}
+
+int snd_mixer_selem_set_playback_volume_all(snd_mixer_elem_t *elem, long value)
+{
+    value = value < 0 ? 0 : (value > _config.steps ? _config.steps : value);
+    return simWriteElem(elem, value, elem->unmuted);
+}
+
+int snd_mixer_selem_ask_playback_vol_dB(snd_mixer_elem_t *elem, long value, long *dBvalue)
+{
+    if (!_config.hasDb) {
+        return -EINVAL;
+    }
+    *dBvalue = simVolumeToDb(value);
+    return 0;
+}
+
+int snd_mixer_selem_ask_playback_dB_vol(snd_mixer_elem_t *elem, long dBvalue, int dir, long *value)
+{
+    if (!_config.hasDb) {
+        return -EINVAL;
+    }
+    *value = simDbToVolume(dBvalue, dir);
+    return 0;
+}
+
+/* Control interface */
+
+int snd_ctl_open(snd_ctl_t **ctl, const char *name, int mode)
+{
+    simConfig();
+    if (!simCardName(name)) {
+        return -ENODEV;
+    }
+    snd_ctl_t *c = (snd_ctl_t *) calloc(1, sizeof(snd_ctl_t));
+    if (c == NULL) {
+        return -ENOMEM;
+    }
+    if (pipe2(c->events, O_NONBLOCK | O_CLOEXEC) < 0) {
+        free(c);
+        return -errno;
+    }
+    pthread_mutex_lock(&_simLock);
+    c->next = _ctls;
+    _ctls = c;
+    pthread_mutex_unlock(&_simLock);
+    *ctl = c;
+    return 0;
+}
+
+int snd_ctl_close(snd_ctl_t *ctl)
+{
+    pthread_mutex_lock(&_simLock);
+    for (snd_ctl_t **p = &_ctls; *p != NULL; p = &(*p)->next) {
+        if (*p == ctl) {
+            *p = ctl->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_simLock);
+    close(ctl->events[0]);
+    close(ctl->events[1]);
+    free(ctl);
+    return 0;
+}
+
+size_t snd_ctl_elem_id_sizeof(void)
+{
+    return sizeof(snd_ctl_elem_id_t);
+}
+
+size_t snd_ctl_elem_info_sizeof(void)
+{
+    return sizeof(snd_ctl_elem_info_t);
+}
+
+size_t snd_ctl_elem_value_sizeof(void)
+{
+    return sizeof(snd_ctl_elem_value_t);
+}
+
+size_t snd_ctl_event_sizeof(void)
+{
+    return sizeof(snd_ctl_event_t);
+}
+
+int snd_ctl_elem_value_malloc(snd_ctl_elem_value_t **ptr)
+{
+    *ptr = (snd_ctl_elem_value_t *) calloc(1, sizeof(snd_ctl_elem_value_t));
+    return *ptr ? 0 : -ENOMEM;
+}
+
+void snd_ctl_elem_value_free(snd_ctl_elem_value_t *obj)
+{
+    free(obj);
+}
+
+void snd_ctl_elem_id_set_interface(snd_ctl_elem_id_t *obj, snd_ctl_elem_iface_t val)
+{
+    obj->iface = val;
+}
+
+void snd_ctl_elem_id_set_device(snd_ctl_elem_id_t *obj, unsigned int val)
+{
+    obj->device = val;
+}
+
+void snd_ctl_elem_id_set_name(snd_ctl_elem_id_t *obj, const char *val)
+{
+    snprintf(obj->name, sizeof(obj->name), "%s", val);
+}
+
+void snd_ctl_elem_info_set_id(snd_ctl_elem_info_t *obj, const snd_ctl_elem_id_t *ptr)
+{
+    obj->id = *ptr;
+}
+
+void snd_ctl_elem_value_set_id(snd_ctl_elem_value_t *obj, const snd_ctl_elem_id_t *ptr)
+{
+    obj->id = *ptr;
+}
+
+void snd_ctl_elem_value_set_interface(snd_ctl_elem_value_t *obj, snd_ctl_elem_iface_t val)
+{
+    obj->id.iface = val;
+}
+
+void snd_ctl_elem_value_set_device(snd_ctl_elem_value_t *obj, unsigned int val)
+{
+    obj->id.device = val;
+}
+
+void snd_ctl_elem_value_set_name(snd_ctl_elem_value_t *obj, const char *val)
+{
+    snprintf(obj->id.name, sizeof(obj->id.name), "%s", val);
+}
+
+/* The jack is a card control, the channel status a mixer control as on vc4-hdmi */
+static int simFindControl(const snd_ctl_elem_id_t *id)
+{
+    if (id->iface == SND_CTL_ELEM_IFACE_CARD && strcmp(id->name, kControlNames[SIM_CTL_JACK]) == 0) {
+        return SIM_CTL_JACK;
+    }
+    if (id->iface == SND_CTL_ELEM_IFACE_MIXER && strcmp(id->name, kControlNames[SIM_CTL_STATUS]) == 0) {
+        return SIM_CTL_STATUS;
+    }
+    return -1;
+}
+
+int snd_ctl_elem_info(snd_ctl_t *ctl, snd_ctl_elem_info_t *info)
+{
+    const int control = simFindControl(&info->id);
+    simIoctl(ctl->events[0]);
+    if (control < 0) {
+        return -ENOENT;
+    }
+    info->type = control == SIM_CTL_JACK ? SND_CTL_ELEM_TYPE_BOOLEAN : SND_CTL_ELEM_TYPE_IEC958;
+    info->count = 1;
+    return 0;
+}
+
+snd_ctl_elem_type_t snd_ctl_elem_info_get_type(const snd_ctl_elem_info_t *obj)
+{
+    return obj->type;
+}
+
+unsigned int snd_ctl_elem_info_get_count(const snd_ctl_elem_info_t *obj)
+{
+    return obj->count;
+}
+
+int snd_ctl_elem_read(snd_ctl_t *ctl, snd_ctl_elem_value_t *data)
+{
+    const int control = simFindControl(&data->id);
+    simIoctl(ctl->events[0]);
+    if (control < 0) {
+        return -ENOENT;
+    }
+    pthread_mutex_lock(&_simLock);
+    if (control == SIM_CTL_JACK) {
+        data->value.integer[0] = 1;
+    }
+    else {
+        data->value.iec958 = _card.status;
+    }
+    pthread_mutex_unlock(&_simLock);
+    return 0;
+}
+
+int snd_ctl_elem_write(snd_ctl_t *ctl, snd_ctl_elem_value_t *data)
+{
+    const int control = simFindControl(&data->id);
+    simIoctl(ctl->events[0]);
+    if (control != SIM_CTL_STATUS) {
+        return control < 0 ? -ENOENT : -EPERM;
+    }
+    pthread_mutex_lock(&_simLock);
+    if (memcmp(&_card.status, &data->value.iec958, sizeof(_card.status)) != 0) {
+        _card.status = data->value.iec958;
+        simNotifyCtls(control);
+    }
+    pthread_mutex_unlock(&_simLock);
+    return 0;
+}
+
+int snd_ctl_elem_value_get_boolean(const snd_ctl_elem_value_t *obj, unsigned int idx)
+{
+    return obj->value.integer[idx] != 0;
+}
+
+const void *snd_ctl_elem_value_get_bytes(const snd_ctl_elem_value_t *obj)
+{
+    return obj->value.bytes;
+}
+
+void snd_ctl_elem_value_get_iec958(const snd_ctl_elem_value_t *obj, snd_aes_iec958_t *ptr)
+{
+    *ptr = obj->value.iec958;
+}
+
+void snd_ctl_elem_value_set_iec958(snd_ctl_elem_value_t *obj, const snd_aes_iec958_t *ptr)
+{
+    obj->value.iec958 = *ptr;
+}
+
+int snd_ctl_subscribe_events(snd_ctl_t *ctl, int subscribe)
+{
+    simIoctl(ctl->events[0]);
+    pthread_mutex_lock(&_simLock);
+    ctl->subscribed = subscribe != 0;
+    pthread_mutex_unlock(&_simLock);
+    return 0;
+}
+
+int snd_ctl_read(snd_ctl_t *ctl, snd_ctl_event_t *event)
+{
+    unsigned char control;
+    if (read(ctl->events[0], &control, 1) != 1) {
+        return -EAGAIN;
+    }
+    event->control = control % SIM_CONTROLS;
+    return 1;
+}
+
+snd_ctl_event_type_t snd_ctl_event_get_type(const snd_ctl_event_t *obj)
+{
+    return SND_CTL_EVENT_ELEM;
+}
+
+const char *snd_ctl_event_elem_get_name(const snd_ctl_event_t *obj)
+{
+    return kControlNames[obj->control];
+}
+
+int snd_ctl_poll_descriptors(snd_ctl_t *ctl, struct pollfd *pfds, unsigned int space)
+{
+    if (space < 1) {
+        return 0;
+    }
+    pfds[0].fd = ctl->events[0];
+    pfds[0].events = POLLIN | POLLERR | POLLNVAL;
+    return 1;
+}
+
+int snd_ctl_poll_descriptors_revents(snd_ctl_t *ctl, struct pollfd *pfds, unsigned int nfds, unsigned short *revents)
+{
+    *revents = nfds ? pfds[0].revents : 0;
+    return 0;
+}
+
+/* PCM: any name opens a sink that is always ready for a full buffer */
+
+int snd_pcm_open(snd_pcm_t **pcm, const char *name, snd_pcm_stream_t stream, int mode)
+{
+    simConfig();
+    if (stream != SND_PCM_STREAM_PLAYBACK) {
+        return -ENOENT;
+    }
+    snd_pcm_t *p = (snd_pcm_t *) calloc(1, sizeof(snd_pcm_t));
+    if (p == NULL) {
+        return -ENOMEM;
+    }
+    p->fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (p->fd < 0) {
+        free(p);
+        return -errno;
+    }
+    *pcm = p;
+    return 0;
+}
+
+int snd_pcm_close(snd_pcm_t *pcm)
+{
+    close(pcm->fd);
+    free(pcm->buffer);
+    free(pcm);
+    return 0;
+}
+
+size_t snd_pcm_hw_params_sizeof(void)
+{
+    return sizeof(snd_pcm_hw_params_t);
+}
+
+size_t snd_pcm_sw_params_sizeof(void)
+{
+    return sizeof(snd_pcm_sw_params_t);
+}
+
+size_t snd_pcm_info_sizeof(void)
+{
+    return sizeof(snd_pcm_info_t);
+}
+
+int snd_pcm_hw_params_any(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
+{
+    memset(params, 0, sizeof(*params));
+    params->channels = 2;
+    params->rate = 48000;
+    params->frameBytes = 4;
+    params->period = 1024;
+    params->buffer = 4096;
+    return 0;
+}
+
+int snd_pcm_hw_params_set_access(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, snd_pcm_access_t access)
+{
+    return 0;
+}
+
+int snd_pcm_hw_params_set_format(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, snd_pcm_format_t val)
+{
+    params->frameBytes = (val == SND_PCM_FORMAT_S16_LE ? 2 : 4) * params->channels;
+    return 0;
+}
+
+int snd_pcm_hw_params_set_channels(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, unsigned int val)
+{
+    if (val == 0 || val > SIM_MAX_CHANNELS) {
+        return -EINVAL;
+    }
+    params->frameBytes = params->frameBytes / params->channels * val;
+    params->channels = val;
+    return 0;
+}
+
+int snd_pcm_hw_params_set_rate_resample(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, unsigned int val)
+{
+    return 0;
+}
+
+int snd_pcm_hw_params_set_rate(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, unsigned int val, int dir)
+{
+    params->rate = val;
+    return 0;
+}
+
+int snd_pcm_hw_params_set_period_size_near(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, snd_pcm_uframes_t *val, int *dir)
+{
+    params->period = *val;
+    return 0;
+}
+
+int snd_pcm_hw_params_set_buffer_size_near(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, snd_pcm_uframes_t *val)
+{
+    params->buffer = *val;
+    return 0;
+}
+
+int snd_pcm_hw_params(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
+{
+    const unsigned int sampleBytes = params->frameBytes / params->channels;
+    unsigned char *buffer = (unsigned char *) calloc(params->buffer, params->frameBytes);
+    simIoctl(pcm->fd);
+    if (buffer == NULL) {
+        return -ENOMEM;
+    }
+    free(pcm->buffer);
+    pcm->buffer = buffer;
+    pcm->hw = *params;
+    for (unsigned int c = 0; c < params->channels; c++) {
+        pcm->areas[c].addr = buffer;
+        pcm->areas[c].first = c * sampleBytes * 8;
+        pcm->areas[c].step = params->frameBytes * 8;
+    }
+    return 0;
+}
+
+int snd_pcm_sw_params_current(snd_pcm_t *pcm, snd_pcm_sw_params_t *params)
+{
+    memset(params, 0, sizeof(*params));
+    return 0;
+}
+
+int snd_pcm_sw_params_set_start_threshold(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, snd_pcm_uframes_t val)
+{
+    params->startThreshold = val;
+    return 0;
+}
+
+int snd_pcm_sw_params_set_avail_min(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, snd_pcm_uframes_t val)
+{
+    params->availMin = val;
+    return 0;
+}
+
+int snd_pcm_sw_params(snd_pcm_t *pcm, snd_pcm_sw_params_t *params)
+{
+    simIoctl(pcm->fd);
+    return 0;
+}
+
+int snd_pcm_info(snd_pcm_t *pcm, snd_pcm_info_t *info)
+{
+    info->card = 0;
+    info->device = 0;
+    return 0;
+}
+
+int snd_pcm_info_get_card(const snd_pcm_info_t *obj)
+{
+    return obj->card;
+}
+
+unsigned int snd_pcm_info_get_device(const snd_pcm_info_t *obj)
+{
+    return obj->device;
+}
+
+int snd_pcm_prepare(snd_pcm_t *pcm)
+{
+    simIoctl(pcm->fd);
+    return 0;
+}
+
+int snd_pcm_drop(snd_pcm_t *pcm)
+{
+    simIoctl(pcm->fd);
+    return 0;
+}
+
+int snd_pcm_recover(snd_pcm_t *pcm, int err, int silent)
+{
+    return snd_pcm_prepare(pcm);
+}
+
+int snd_pcm_wait(snd_pcm_t *pcm, int timeout)
+{
+    return 1;
+}
+
+snd_pcm_sframes_t snd_pcm_avail_update(snd_pcm_t *pcm)
+{
+    /* The hardware pointer sync */
+    simIoctl(pcm->fd);
+    return (snd_pcm_sframes_t) pcm->hw.buffer;
+}
+
+int snd_pcm_mmap_begin(snd_pcm_t *pcm, const snd_pcm_channel_area_t **areas, snd_pcm_uframes_t *offset, snd_pcm_uframes_t *frames)
+{
+    if (pcm->buffer == NULL) {
+        return -EBADFD;
+    }
+    *areas = pcm->areas;
+    *offset = 0;
+    *frames = *frames < pcm->hw.buffer ? *frames : pcm->hw.buffer;
+    return 0;
+}
+
+snd_pcm_sframes_t snd_pcm_mmap_commit(snd_pcm_t *pcm, snd_pcm_uframes_t offset, snd_pcm_uframes_t frames)
+{
+    return (snd_pcm_sframes_t) frames;
+}
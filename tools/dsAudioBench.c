@@ -0,0 +1,419 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * dsAudio API benchmark.
+ *
+ * Calls each entry point in kCases repeatedly on the HDMI port and prints
+ * the p50/p99/max latency of one call and the system calls it costs. The
+ * syscalls are counted first, in a child process run under ptrace(2) with
+ * every HAL thread included, so setters are charged for the work their
+ * command worker does. Latency is then measured in an untraced pass. With
+ * -f each timed setter also waits for its command to be applied
+ * (dsAudioFlushCommands). Gain and mute ramps are set to steps so that a
+ * flushed setter measures the mixer path and one ramp tick rather than the
+ * fade length.
+ *
+ * Build with "make tools" for hardware or "make tools-sim" to link against
+ * tools/alsaSim.c and tools/tvserviceSim.c on any Linux host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+
+#include "dsError.h"
+#include "dsTypes.h"
+#include "dsAudio.h"
+#include "dsAudioCmdQueue.h"
+#include "dsAudioDsp.h"
+#include "dsAudioRamp.h"
+#include "dsAudioState.h"
+
+#define MAX_TRACED_THREADS 64
+
+/* Untimed flush interval, keeps unflushed setters below the command queue capacity */
+#define FLUSH_INTERVAL 32
+
+typedef struct {
+    const char *name;
+    dsError_t (*call)(intptr_t handle, uint32_t i);
+} BenchCase_t;
+
+/* Getters: one output of the given type */
+#define BENCH_GETTER(api, type) \
+    static dsError_t bench_##api(intptr_t handle, uint32_t i) { type value; return api(handle, &value); }
+
+BENCH_GETTER(dsGetAudioLevel, float)
+BENCH_GETTER(dsGetAudioGain, float)
+BENCH_GETTER(dsGetAudioDB, float)
+BENCH_GETTER(dsGetAudioMaxDB, float)
+BENCH_GETTER(dsGetAudioMinDB, float)
+BENCH_GETTER(dsIsAudioMute, bool)
+BENCH_GETTER(dsGetAudioEncoding, dsAudioEncoding_t)
+BENCH_GETTER(dsGetStereoMode, dsAudioStereoMode_t)
+BENCH_GETTER(dsIsAudioMSDecode, bool)
+BENCH_GETTER(dsGetAudioPortState, dsAudioPortState_t)
+BENCH_GETTER(dsGetAudioFormat, dsAudioFormat_t)
+BENCH_GETTER(dsGetAudioCapabilities, int)
+BENCH_GETTER(dsGetSinkDeviceAtmosCapability, dsATMOSCapability_t)
+BENCH_GETTER(dsAudioOutIsConnected, bool)
+BENCH_GETTER(dsIsAudioPortEnabled, bool)
+BENCH_GETTER(dsGetAudioDelay, uint32_t)
+BENCH_GETTER(dsGetDialogEnhancement, int)
+BENCH_GETTER(dsGetGraphicEqualizerMode, int)
+BENCH_GETTER(dsGetVolumeLeveller, dsVolumeLeveller_t)
+BENCH_GETTER(dsGetBassEnhancer, int)
+BENCH_GETTER(dsGetSurroundVirtualizer, dsSurroundVirtualizer_t)
+BENCH_GETTER(dsGetDRCMode, int)
+BENCH_GETTER(dsGetAssociatedAudioMixing, bool)
+BENCH_GETTER(dsGetFaderControl, int)
+BENCH_GETTER(dsGetAudioLoudness, dsDspLoudness_t)
+BENCH_GETTER(dsGetAudioOptimalLevel, float)
+
+/* Setters alternate between two values so that no call is a no-op */
+static dsError_t bench_dsSetAudioLevel(intptr_t handle, uint32_t i) { return dsSetAudioLevel(handle, (i & 1) ? 40.0f : 60.0f); }
+static dsError_t bench_dsSetAudioGain(intptr_t handle, uint32_t i) { return dsSetAudioGain(handle, (i & 1) ? 40.0f : 60.0f); }
+static dsError_t bench_dsSetAudioDB(intptr_t handle, uint32_t i) { return dsSetAudioDB(handle, (i & 1) ? -10.0f : -20.0f); }
+static dsError_t bench_dsSetAudioMute(intptr_t handle, uint32_t i) { return dsSetAudioMute(handle, (i & 1) != 0); }
+static dsError_t bench_dsSetAudioDucking(intptr_t handle, uint32_t i)
+{
+    return dsSetAudioDucking(handle, (i & 1) ? dsAUDIO_DUCKINGACTION_START : dsAUDIO_DUCKINGACTION_STOP,
+                             dsAUDIO_DUCKINGTYPE_RELATIVE, 50);
+}
+static dsError_t bench_dsSetAudioEncoding(intptr_t handle, uint32_t i)
+{
+    return dsSetAudioEncoding(handle, (i & 1) ? dsAUDIO_ENC_AC3 : dsAUDIO_ENC_PCM);
+}
+static dsError_t bench_dsSetStereoMode(intptr_t handle, uint32_t i)
+{
+    return dsSetStereoMode(handle, (i & 1) ? dsAUDIO_STEREO_SURROUND : dsAUDIO_STEREO_STEREO);
+}
+static dsError_t bench_dsEnableAudioPort(intptr_t handle, uint32_t i) { return dsEnableAudioPort(handle, true); }
+static dsError_t bench_dsSetAudioDelay(intptr_t handle, uint32_t i) { return dsSetAudioDelay(handle, (i & 1) ? 20 : 40); }
+static dsError_t bench_dsSetDialogEnhancement(intptr_t handle, uint32_t i) { return dsSetDialogEnhancement(handle, (i & 1) ? 4 : 8); }
+static dsError_t bench_dsSetGraphicEqualizerMode(intptr_t handle, uint32_t i) { return dsSetGraphicEqualizerMode(handle, (i & 1) ? 1 : 2); }
+static dsError_t bench_dsSetVolumeLeveller(intptr_t handle, uint32_t i)
+{
+    dsVolumeLeveller_t leveller;
+    leveller.mode = 1;
+    leveller.level = (i & 1) ? 5 : 10;
+    return dsSetVolumeLeveller(handle, leveller);
+}
+static dsError_t bench_dsSetBassEnhancer(intptr_t handle, uint32_t i) { return dsSetBassEnhancer(handle, (i & 1) ? 30 : 60); }
+static dsError_t bench_dsSetSurroundVirtualizer(intptr_t handle, uint32_t i)
+{
+    dsSurroundVirtualizer_t virtualizer;
+    virtualizer.mode = 1;
+    virtualizer.boost = (i & 1) ? 32 : 64;
+    return dsSetSurroundVirtualizer(handle, virtualizer);
+}
+static dsError_t bench_dsSetDRCMode(intptr_t handle, uint32_t i) { return dsSetDRCMode(handle, (i & 1) ? 1 : 0); }
+static dsError_t bench_dsSetAssociatedAudioMixing(intptr_t handle, uint32_t i) { return dsSetAssociatedAudioMixing(handle, (i & 1) != 0); }
+static dsError_t bench_dsSetFaderControl(intptr_t handle, uint32_t i) { return dsSetFaderControl(handle, (i & 1) ? -16 : 16); }
+static dsError_t bench_dsSetAudioMixerLevels(intptr_t handle, uint32_t i)
+{
+    return dsSetAudioMixerLevels(handle, dsAUDIO_INPUT_SYSTEM, (i & 1) ? 50 : 80);
+}
+
+#define BENCH_CASE(api) { #api, bench_##api }
+
+static const BenchCase_t kCases[] = {
+    BENCH_CASE(dsGetAudioLevel),
+    BENCH_CASE(dsGetAudioGain),
+    BENCH_CASE(dsGetAudioDB),
+    BENCH_CASE(dsGetAudioMaxDB),
+    BENCH_CASE(dsGetAudioMinDB),
+    BENCH_CASE(dsIsAudioMute),
+    BENCH_CASE(dsGetAudioEncoding),
+    BENCH_CASE(dsGetStereoMode),
+    BENCH_CASE(dsIsAudioMSDecode),
+    BENCH_CASE(dsGetAudioPortState),
+    BENCH_CASE(dsGetAudioFormat),
+    BENCH_CASE(dsGetAudioCapabilities),
+    BENCH_CASE(dsGetSinkDeviceAtmosCapability),
+    BENCH_CASE(dsAudioOutIsConnected),
+    BENCH_CASE(dsIsAudioPortEnabled),
+    BENCH_CASE(dsGetAudioDelay),
+    BENCH_CASE(dsGetDialogEnhancement),
+    BENCH_CASE(dsGetGraphicEqualizerMode),
+    BENCH_CASE(dsGetVolumeLeveller),
+    BENCH_CASE(dsGetBassEnhancer),
+    BENCH_CASE(dsGetSurroundVirtualizer),
+    BENCH_CASE(dsGetDRCMode),
+    BENCH_CASE(dsGetAssociatedAudioMixing),
+    BENCH_CASE(dsGetFaderControl),
+    BENCH_CASE(dsGetAudioLoudness),
+    BENCH_CASE(dsGetAudioOptimalLevel),
+    BENCH_CASE(dsSetAudioLevel),
+    BENCH_CASE(dsSetAudioGain),
+    BENCH_CASE(dsSetAudioDB),
+    BENCH_CASE(dsSetAudioMute),
+    BENCH_CASE(dsSetAudioDucking),
+    BENCH_CASE(dsSetAudioEncoding),
+    BENCH_CASE(dsSetStereoMode),
+    BENCH_CASE(dsEnableAudioPort),
+    BENCH_CASE(dsSetAudioDelay),
+    BENCH_CASE(dsSetDialogEnhancement),
+    BENCH_CASE(dsSetGraphicEqualizerMode),
+    BENCH_CASE(dsSetVolumeLeveller),
+    BENCH_CASE(dsSetBassEnhancer),
+    BENCH_CASE(dsSetSurroundVirtualizer),
+    BENCH_CASE(dsSetDRCMode),
+    BENCH_CASE(dsSetAssociatedAudioMixing),
+    BENCH_CASE(dsSetFaderControl),
+    BENCH_CASE(dsSetAudioMixerLevels),
+};
+
+#define NUM_CASES (sizeof(kCases) / sizeof(kCases[0]))
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static bool selected(const char *filter, size_t n)
+{
+    return filter == NULL || strstr(kCases[n].name, filter) != NULL;
+}
+
+static intptr_t benchInit()
+{
+    dsAudioRampConfig_t config;
+    intptr_t handle = 0;
+
+    if (dsAudioPortInit() != dsERR_NONE || dsGetAudioPort(dsAUDIOPORT_TYPE_HDMI, 0, &handle) != dsERR_NONE) {
+        return 0;
+    }
+    dsAudioRampGetConfig(&config);
+    config.m_gainMs = 0;
+    config.m_muteMs = 0;
+    dsAudioRampSetConfig(&config);
+    return handle;
+}
+
+/*
+ * Traced child: a SIGUSR1 before and after each case marks the span whose
+ * syscalls the parent counts. The first, empty span measures the markers.
+ */
+static void countChild(const char *filter, uint32_t iterations)
+{
+    if (ptrace(PTRACE_TRACEME, 0, NULL, NULL) < 0) {
+        _exit(2);
+    }
+    raise(SIGSTOP);
+    intptr_t handle = benchInit();
+    if (handle == 0) {
+        _exit(1);
+    }
+    raise(SIGUSR1);
+    raise(SIGUSR1);
+    for (size_t n = 0; n < NUM_CASES; n++) {
+        if (!selected(filter, n)) {
+            continue;
+        }
+        raise(SIGUSR1);
+        for (uint32_t i = 0; i < iterations; i++) {
+            kCases[n].call(handle, i);
+            if ((i + 1) % FLUSH_INTERVAL == 0) {
+                dsAudioFlushCommands();
+            }
+        }
+        /* Charge the queued work to this case, not the next */
+        dsAudioFlushCommands();
+        raise(SIGUSR1);
+    }
+    dsAudioPortTerm();
+    _exit(0);
+}
+
+/* Syscall-entry state of a traced thread */
+static bool *tracedThread(pid_t *tids, bool *inSyscall, pid_t tid)
+{
+    for (int t = 0; t < MAX_TRACED_THREADS; t++) {
+        if (tids[t] == tid || tids[t] == 0) {
+            tids[t] = tid;
+            return &inSyscall[t];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * @return false if the process cannot be traced; syscalls[] then stays unset.
+ */
+static bool countSyscalls(const char *filter, uint32_t iterations, double *syscalls)
+{
+    pid_t tids[MAX_TRACED_THREADS] = { 0 };
+    bool inSyscall[MAX_TRACED_THREADS] = { false };
+    uint64_t entries = 0, spanStart = 0, baseline = 0;
+    unsigned markers = 0;
+    size_t next = 0;
+    int status;
+
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) {
+        return false;
+    }
+    if (child == 0) {
+        countChild(filter, iterations);
+    }
+    if (waitpid(child, &status, 0) != child || !WIFSTOPPED(status)) {
+        return false;
+    }
+    ptrace(PTRACE_SETOPTIONS, child, NULL, (void *) (PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL));
+    ptrace(PTRACE_SYSCALL, child, NULL, NULL);
+
+    for (;;) {
+        pid_t tid = waitpid(-1, &status, __WALL);
+        if (tid < 0) {
+            break;
+        }
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            if (tid == child) {
+                break;
+            }
+            continue;
+        }
+        int deliver = 0;
+        const int sig = WSTOPSIG(status);
+        if (sig == (SIGTRAP | 0x80)) {
+            bool *state = tracedThread(tids, inSyscall, tid);
+            if (state != NULL) {
+                *state = !*state;
+                entries += *state;
+            }
+        }
+        else if (sig == SIGUSR1 && tid == child) {
+            if (markers++ & 1) {
+                const uint64_t span = entries - spanStart;
+                if (markers == 2) {
+                    baseline = span;
+                }
+                else {
+                    while (next < NUM_CASES && !selected(filter, next)) {
+                        next++;
+                    }
+                    if (next < NUM_CASES) {
+                        syscalls[next++] = span > baseline ? (double) (span - baseline) / iterations : 0.0;
+                    }
+                }
+            }
+            else {
+                spanStart = entries;
+            }
+        }
+        else if (sig != SIGSTOP && sig != SIGTRAP) {
+            /* New threads start with SIGSTOP, clone events stop with SIGTRAP */
+            deliver = sig;
+        }
+        ptrace(PTRACE_SYSCALL, tid, NULL, (void *) (intptr_t) deliver);
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static int compareNs(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-n calls] [-f] [-S] [-C name]\n", prog);
+    printf("  -n calls    calls per API (default 1000)\n");
+    printf("  -f          wait for queued setters to be applied inside each timed call\n");
+    printf("  -S          skip the syscall count (no ptrace)\n");
+    printf("  -C name     only APIs whose name contains this\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t iterations = 1000;
+    bool flush = false, count = true;
+    const char *filter = NULL;
+    double syscalls[NUM_CASES];
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:fSC:h")) != -1) {
+        switch (opt) {
+        case 'n': iterations = strtoul(optarg, NULL, 10); break;
+        case 'f': flush = true; break;
+        case 'S': count = false; break;
+        case 'C': filter = optarg; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (iterations == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    for (size_t n = 0; n < NUM_CASES; n++) {
+        syscalls[n] = -1.0;
+    }
+    if (count && !countSyscalls(filter, iterations, syscalls)) {
+        printf("Syscalls not counted: the traced run failed or ptrace is not permitted\n");
+    }
+
+    intptr_t handle = benchInit();
+    uint64_t *samples = (uint64_t *) malloc(iterations * sizeof(uint64_t));
+    if (handle == 0 || samples == NULL) {
+        printf("Audio port init failed\n");
+        return 1;
+    }
+
+    printf("\n%-32s %10s %10s %10s %10s\n", "api", "p50(us)", "p99(us)", "max(us)", "syscalls");
+    for (size_t n = 0; n < NUM_CASES; n++) {
+        if (!selected(filter, n)) {
+            continue;
+        }
+        for (uint32_t i = 0; i < 16; i++) {
+            kCases[n].call(handle, i);
+        }
+        dsAudioFlushCommands();
+        for (uint32_t i = 0; i < iterations; i++) {
+            const uint64_t start = nowNs();
+            kCases[n].call(handle, i);
+            if (flush) {
+                dsAudioFlushCommands();
+            }
+            samples[i] = nowNs() - start;
+            if (!flush && (i + 1) % FLUSH_INTERVAL == 0) {
+                dsAudioFlushCommands();
+            }
+        }
+        dsAudioFlushCommands();
+        qsort(samples, iterations, sizeof(uint64_t), compareNs);
+        printf("%-32s %10.2f %10.2f %10.2f", kCases[n].name, samples[iterations / 2] / 1000.0,
+               samples[(size_t) iterations * 99 / 100] / 1000.0, samples[iterations - 1] / 1000.0);
+        if (syscalls[n] < 0) printf(" %10s\n", "-");
+        else printf(" %10.2f\n", syscalls[n]);
+    }
+    dsAudioPortTerm();
+    free(samples);
+    return 0;
+}
@@ -0,0 +1,463 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Output processing benchmark.
+ *
+ * Runs the pcm_dshal pipeline (audiodsp/dsDspPipeline.c) one period at a
+ * time the way the plugin does, for each entry of kConfigs, and prints the
+ * cost per sample. CPU cycles come from perf_event_open(); where that is not
+ * permitted (containers, perf_event_paranoid) the benchmark falls back to
+ * nanoseconds.
+ *
+ * The input is a 16-bit PCM WAV file (-i) or, by default, noise whose level
+ * jumps by 18 dB every 5 s like a programme/advert transition. Alongside the
+ * cost, the spread (standard deviation) of the 1 s RMS levels and the peak
+ * of the output are printed, so level-changing stages can be judged on real
+ * content, and the configurations that include the loudness meter print
+ * its integrated reading. -o writes the processed audio of the last
+ * configuration run. The "mix" configurations also feed secondary inputs
+ * (dsDspInput.h) from a control block in memory, one period ahead of the
+ * stream as a producer would, and print how many input periods are mixed
+ * per millisecond of CPU time.
+ *
+ * Build with "make tools"; it does not need ALSA or the HAL.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "dsDspPipeline.h"
+#include "dsDspInput.h"
+#include "dsDspMeter.h"
+#include "dsDspSimd.h"
+
+typedef struct {
+    const char *name;
+    dsDspParams_t params;       /* delay, offset, eq, leveller mode/level, drc, virtualizer mode/boost, bass, dialog,
+                                   primary cut, system cut, associated mixing, fader */
+    bool meter;                 /* also run the loudness meter, as the plugin's meter thread does */
+    uint32_t inputs;            /* secondary inputs fed, from DS_DSP_INPUT_SYSTEM up */
+} BenchConfig_t;
+
+static const BenchConfig_t kConfigs[] = {
+    { "bypass",            { 0, 0, 0, 0, 0, 0 } },
+    { "eq open",           { 0, 0, 1, 0, 0, 0 } },
+    { "eq rich",           { 0, 0, 2, 0, 0, 0 } },
+    { "eq focused",        { 0, 0, 3, 0, 0, 0 } },
+    { "delay 40ms",        { 40, 0, 0, 0, 0, 0 } },
+    { "leveller 5",        { 0, 0, 0, 1, 5, 0 } },
+    { "leveller 10",       { 0, 0, 0, 1, 10, 0 } },
+    { "drc rf",            { 0, 0, 0, 0, 0, 1 } },
+    { "leveller auto+rf",  { 0, 0, 0, 2, 0, 1 } },
+    { "virtualizer 96",    { 0, 0, 0, 0, 0, 0, 1, 96, 0 } },
+    { "bass 60",           { 0, 0, 0, 0, 0, 0, 0, 0, 60 } },
+    { "virtualizer+bass",  { 0, 0, 0, 0, 0, 0, 1, 64, 60 } },
+    { "dialog 4",          { 0, 0, 0, 0, 0, 0, 0, 0, 0, 4 } },
+    { "dialog 8",          { 0, 0, 0, 0, 0, 0, 0, 0, 0, 8 } },
+    { "dialog 16",         { 0, 0, 0, 0, 0, 0, 0, 0, 0, 16 } },
+    { "eq rich+delay",     { 40, 0, 2, 0, 0, 0 } },
+    { "all",               { 40, 0, 2, 2, 0, 1, 1, 64, 60, 8 } },
+    { "meter",             { 0, 0, 0, 0, 0, 0 }, true },
+    { "all+meter",         { 40, 0, 2, 2, 0, 1, 1, 64, 60, 8 }, true },
+    { "mix system",        { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 50 }, false, 1 },
+    { "mix system+ad",     { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 50, 1, 0 }, false, 2 },
+    { "mix ad fader 16",   { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 20, 50, 1, 16 }, false, 2 },
+    { "all+mix",           { 40, 0, 2, 2, 0, 1, 1, 64, 60, 8, 0, 50, 1, 0 }, false, 2 },
+};
+
+typedef struct {
+    uint32_t rate;
+    uint32_t channels;
+    uint32_t frames;
+    int16_t *samples;           /* interleaved */
+} BenchAudio_t;
+
+/* Queue one period of the programme's front pair on each input */
+static void inputsFeed(dsDspControl_t *control, uint32_t inputs, const BenchAudio_t *audio, uint32_t start,
+                       uint32_t frames, int16_t *feed)
+{
+    const uint32_t channels = audio->channels;
+    for (uint32_t i = 0; i < frames; i++) {
+        const int16_t *frame = audio->samples + (size_t)(start + i) * channels;
+        feed[i * 2] = frame[0];
+        feed[i * 2 + 1] = frame[channels > 1 ? 1 : 0];
+    }
+    for (uint32_t n = 0; n < inputs; n++) {
+        dsDspInputWrite(control, DS_DSP_INPUT_SYSTEM + n, audio->rate, feed, frames);
+    }
+}
+
+static int _perfFd = -1;
+
+static void counterOpen()
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    _perfFd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void counterStart()
+{
+    if (_perfFd >= 0) {
+        ioctl(_perfFd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(_perfFd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+/* Cycles, or nanoseconds since start when there is no counter */
+static uint64_t counterStop(uint64_t startNs)
+{
+    uint64_t value = 0;
+    if (_perfFd >= 0) {
+        ioctl(_perfFd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(_perfFd, &value, sizeof(value)) != sizeof(value)) {
+            value = 0;
+        }
+        return value;
+    }
+    return nowNs() - startNs;
+}
+
+static uint32_t readLe(const uint8_t *p, int bytes)
+{
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static void writeLe(uint8_t *p, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++, value >>= 8) {
+        p[i] = (uint8_t) value;
+    }
+}
+
+static bool wavRead(const char *path, BenchAudio_t *audio)
+{
+    FILE *file = fopen(path, "rb");
+    uint8_t header[12], chunk[8], fmt[16];
+    bool haveFmt = false;
+
+    if (file == NULL) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    if (fread(header, 1, 12, file) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        printf("%s is not a WAV file\n", path);
+        fclose(file);
+        return false;
+    }
+    while (fread(chunk, 1, 8, file) == 8) {
+        uint32_t size = readLe(chunk + 4, 4);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            if (fread(fmt, 1, 16, file) != 16) {
+                break;
+            }
+            fseek(file, size - 16 + (size & 1), SEEK_CUR);
+            haveFmt = true;
+            if (readLe(fmt, 2) != 1 || readLe(fmt + 14, 2) != 16) {
+                printf("%s: only 16-bit PCM is supported\n", path);
+                break;
+            }
+            audio->channels = readLe(fmt + 2, 2);
+            audio->rate = readLe(fmt + 4, 4);
+        }
+        else if (memcmp(chunk, "data", 4) == 0 && haveFmt && audio->channels) {
+            audio->frames = size / (2 * audio->channels);
+            audio->samples = (int16_t*) malloc((size_t) audio->frames * audio->channels * sizeof(int16_t));
+            uint8_t *raw = (uint8_t*) audio->samples;
+            if (audio->samples == NULL ||
+                fread(raw, 2 * audio->channels, audio->frames, file) != audio->frames) {
+                printf("%s: short data chunk\n", path);
+                break;
+            }
+            /* Samples are little endian on disk */
+            for (size_t i = 0; i < (size_t) audio->frames * audio->channels; i++) {
+                audio->samples[i] = (int16_t) readLe(raw + 2 * i, 2);
+            }
+            fclose(file);
+            return true;
+        }
+        else {
+            fseek(file, size + (size & 1), SEEK_CUR);
+        }
+    }
+    free(audio->samples);
+    audio->samples = NULL;
+    if (!haveFmt) {
+        printf("%s: no fmt chunk\n", path);
+    }
+    fclose(file);
+    return false;
+}
+
+static bool wavWrite(const char *path, const BenchAudio_t *audio, const int16_t *samples)
+{
+    FILE *file = fopen(path, "wb");
+    uint8_t header[44];
+    uint32_t dataSize = audio->frames * audio->channels * 2;
+
+    if (file == NULL) {
+        printf("Cannot create %s\n", path);
+        return false;
+    }
+    memcpy(header, "RIFF", 4);
+    writeLe(header + 4, 36 + dataSize, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    writeLe(header + 16, 16, 4);
+    writeLe(header + 20, 1, 2);
+    writeLe(header + 22, audio->channels, 2);
+    writeLe(header + 24, audio->rate, 4);
+    writeLe(header + 28, audio->rate * audio->channels * 2, 4);
+    writeLe(header + 32, audio->channels * 2, 2);
+    writeLe(header + 34, 16, 2);
+    memcpy(header + 36, "data", 4);
+    writeLe(header + 40, dataSize, 4);
+    bool ok = fwrite(header, 1, 44, file) == 44;
+    for (size_t i = 0; ok && i < (size_t) audio->frames * audio->channels; i++) {
+        uint8_t sample[2];
+        writeLe(sample, (uint16_t) samples[i], 2);
+        ok = fwrite(sample, 1, 2, file) == 2;
+    }
+    fclose(file);
+    return ok;
+}
+
+static void noiseGenerate(BenchAudio_t *audio, uint32_t seconds)
+{
+    audio->frames = audio->rate * seconds;
+    audio->samples = (int16_t*) malloc((size_t) audio->frames * audio->channels * sizeof(int16_t));
+    if (audio->samples == NULL) {
+        return;
+    }
+    srand(1);
+    for (uint32_t i = 0; i < audio->frames; i++) {
+        /* -30 dBFS and -12 dBFS RMS, alternating every 5 s */
+        float rms = (i / (audio->rate * 5)) & 1 ? 0.251f : 0.0316f;
+        for (uint32_t c = 0; c < audio->channels; c++) {
+            float uniform = (float) rand() / RAND_MAX * 2.0f - 1.0f;
+            audio->samples[(size_t) i * audio->channels + c] = (int16_t) lrintf(uniform * rms * 1.732f * 32767.0f);
+        }
+    }
+}
+
+/* Standard deviation of the 1 s RMS levels above -60 dBFS, and the peak, in dB */
+static void levelStats(const BenchAudio_t *audio, const int16_t *samples, float *spreadDb, float *peakDb)
+{
+    double sum = 0.0, sumSquares = 0.0;
+    uint32_t windows = 0;
+    int peak = 0;
+
+    for (uint32_t start = 0; start + audio->rate <= audio->frames; start += audio->rate) {
+        double energy = 0.0;
+        for (size_t i = (size_t) start * audio->channels; i < (size_t)(start + audio->rate) * audio->channels; i++) {
+            energy += (double) samples[i] * samples[i];
+            peak = abs(samples[i]) > peak ? abs(samples[i]) : peak;
+        }
+        double db = 10.0 * log10(energy / ((double) audio->rate * audio->channels) / (32768.0 * 32768.0) + 1e-20);
+        if (db > -60.0) {
+            sum += db;
+            sumSquares += db * db;
+            windows++;
+        }
+    }
+    *spreadDb = windows ? (float) sqrt(fmax(sumSquares / windows - (sum / windows) * (sum / windows), 0.0)) : 0.0f;
+    *peakDb = peak ? 20.0f * log10f(peak / 32768.0f) : -96.0f;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-i in.wav] [-o out.wav] [-C config] [-r rate] [-c channels] [-p period frames] [-s seconds of noise]\n", prog);
+    printf("Configs:");
+    for (size_t n = 0; n < sizeof(kConfigs) / sizeof(kConfigs[0]); n++) {
+        printf(" \"%s\"", kConfigs[n].name);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    BenchAudio_t audio = { 48000, 2, 0, NULL };
+    uint32_t period = 1024, seconds = 60;
+    const char *input = NULL, *output = NULL, *only = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:o:C:r:c:p:s:h")) != -1) {
+        switch (opt) {
+        case 'i': input = optarg; break;
+        case 'o': output = optarg; break;
+        case 'C': only = optarg; break;
+        case 'r': audio.rate = strtoul(optarg, NULL, 10); break;
+        case 'c': audio.channels = strtoul(optarg, NULL, 10); break;
+        case 'p': period = strtoul(optarg, NULL, 10); break;
+        case 's': seconds = strtoul(optarg, NULL, 10); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (input) {
+        if (!wavRead(input, &audio)) {
+            return 1;
+        }
+    }
+    else if (audio.rate && audio.channels && audio.channels <= DS_DSP_MAX_CHANNELS) {
+        noiseGenerate(&audio, seconds ? seconds : 1);
+    }
+    if (audio.channels == 0 || audio.channels > DS_DSP_MAX_CHANNELS || audio.rate == 0 || period == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const uint32_t channels = audio.channels;
+    int16_t *out = (int16_t*) malloc((size_t) audio.frames * channels * sizeof(int16_t));
+    int16_t *feed = (int16_t*) malloc((size_t) period * 2 * sizeof(int16_t));
+    dsDspControl_t *control = NULL;
+    if (posix_memalign((void**) &control, 64, sizeof(dsDspControl_t)) != 0) {
+        control = NULL;
+    }
+    if (audio.samples == NULL || out == NULL || feed == NULL || control == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    float spreadDb, peakDb;
+    levelStats(&audio, audio.samples, &spreadDb, &peakDb);
+    counterOpen();
+    printf("%s: %u Hz, %u channels, %.1f s, %u frame periods, %s kernels, %s\n", input ? input : "noise",
+           audio.rate, channels, (double) audio.frames / audio.rate, period, DS_DSP_SIMD,
+           _perfFd >= 0 ? "CPU cycles" : "no cycle counter, nanoseconds");
+    printf("input: level spread %.1f dB, peak %.1f dBFS\n", spreadDb, peakDb);
+    printf("%-18s %12s %12s %10s %8s %8s\n", "config", "per sample", "per period", "realtime", "spread", "peak");
+
+    bool found = false;
+    for (size_t n = 0; n < sizeof(kConfigs) / sizeof(kConfigs[0]); n++) {
+        if (only && strcmp(only, kConfigs[n].name) != 0) {
+            continue;
+        }
+        found = true;
+
+        dsDspPipeline_t pipeline;
+        if (!dsDspPipelineInit(&pipeline, audio.rate, channels, period)) {
+            printf("%-18s pipeline init failed\n", kConfigs[n].name);
+            continue;
+        }
+        const uint32_t inputs = kConfigs[n].inputs;
+        if (inputs) {
+            /* Parameters then come through the control block, as in the plugin */
+            memset(control, 0, sizeof(dsDspControl_t));
+            control->m_params = kConfigs[n].params;
+            dsDspPipelineAttach(&pipeline, control);
+            dsDspPipelineUpdate(&pipeline);
+            inputsFeed(control, inputs, &audio, 0, audio.frames < period ? audio.frames : period, feed);
+        }
+        else {
+            dsDspPipelineSetParams(&pipeline, &kConfigs[n].params);
+        }
+        dsDspMeter_t meter;
+        bool metering = kConfigs[n].meter && dsDspMeterInit(&meter, audio.rate, channels, pipeline.m_stride);
+
+        uint32_t periods = 0;
+        uint64_t startNs = nowNs();
+        counterStart();
+        for (uint32_t start = 0; start < audio.frames; start += period, periods++) {
+            uint32_t frames = audio.frames - start < period ? audio.frames - start : period;
+            const int16_t *inPlanes[DS_DSP_MAX_CHANNELS];
+            int16_t *outPlanes[DS_DSP_MAX_CHANNELS];
+            for (uint32_t c = 0; c < channels; c++) {
+                inPlanes[c] = audio.samples + (size_t) start * channels + c;
+                outPlanes[c] = out + (size_t) start * channels + c;
+            }
+            if (inputs && start + period < audio.frames) {
+                const uint32_t next = start + period;
+                inputsFeed(control, inputs, &audio, next, audio.frames - next < period ? audio.frames - next : period, feed);
+            }
+            bool bypassed = dsDspPipelineBypassed(&pipeline);
+            if (bypassed && !metering) {
+                memcpy(outPlanes[0], inPlanes[0], (size_t) frames * channels * sizeof(int16_t));
+                continue;
+            }
+            dsDspPipelineImportS16(&pipeline, inPlanes, channels, frames);
+            if (bypassed) {
+                memcpy(outPlanes[0], inPlanes[0], (size_t) frames * channels * sizeof(int16_t));
+            }
+            else {
+                dsDspPipelineProcess(&pipeline, frames);
+                dsDspPipelineExportS16(&pipeline, outPlanes, channels, frames);
+            }
+            if (metering) {
+                /* The plugin meters a copy on another thread; the cost is the same */
+                dsDspMeterProcess(&meter, pipeline.m_block, frames);
+            }
+        }
+        uint64_t total = counterStop(startNs);
+        uint64_t elapsedNs = nowNs() - startNs;
+
+        levelStats(&audio, out, &spreadDb, &peakDb);
+        printf("%-18s %12.2f %12.0f %9.0fx %5.1f dB %5.1f dB\n", kConfigs[n].name,
+               (double) total / ((double) audio.frames * channels), (double) total / periods,
+               elapsedNs ? (double) audio.frames / audio.rate * 1e9 / elapsedNs : 0.0, spreadDb, peakDb);
+        if (metering) {
+            printf("%-18s integrated %.1f LUFS, short-term %.1f LUFS at the end\n", "",
+                   meter.m_integrated, meter.m_shortTerm);
+            dsDspMeterFree(&meter);
+        }
+        if (inputs && elapsedNs) {
+            printf("%-18s %.1f input periods of %u frames mixed per ms of CPU\n", "",
+                   (double) periods * inputs * 1e6 / elapsedNs, period);
+        }
+        dsDspPipelineFree(&pipeline);
+    }
+    if (!found) {
+        usage(argv[0]);
+    }
+    else if (output && !wavWrite(output, &audio, out)) {
+        return 1;
+    }
+
+    if (_perfFd >= 0) {
+        close(_perfFd);
+    }
+    free(audio.samples);
+    free(out);
+    free(feed);
+    free(control);
+    return found ? 0 : 1;
+}
@@ -0,0 +1,290 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Mode-switch latency benchmark.
+ *
+ * Walks every dsVideoPortGetResolutions() entry through dsSetResolution() (and optionally
+ * a dsEnableVideoPort() off/on cycle), timestamps each trace point exposed by
+ * dsVideoPortTrace.h and prints a per-mode latency table. With -o a Chrome
+ * trace (chrome://tracing, Perfetto) of the whole run is written as well.
+ *
+ * Build with "make tools" for hardware or "make tools-sim" to link against
+ * tools/tvserviceSim.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "dsError.h"
+#include "dsTypes.h"
+#include "dsVideoPort.h"
+#include "dsVideoPortTrace.h"
+
+#define MAX_EVENTS 4096
+#define CALLBACK_TIMEOUT_MS 5000
+
+typedef struct {
+    dsVideoPortTracePoint_t point;
+    const char *api;
+    uint32_t arg;
+    uint64_t tsUs;
+} BenchEvent_t;
+
+static BenchEvent_t _events[MAX_EVENTS];
+static size_t _numEvents = 0;
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _cond = PTHREAD_COND_INITIALIZER;
+static unsigned _callbacks = 0;
+
+static const char *kPointNames[dsVIDEOPORT_TRACE_MAX] = {
+    "call", "vchi_return", "tv_callback", "fb_reconfig", "complete"
+};
+
+static uint64_t nowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void traceCallback(dsVideoPortTracePoint_t point, const char *api, uint32_t arg)
+{
+    uint64_t ts = nowUs();
+    pthread_mutex_lock(&_lock);
+    if (_numEvents < MAX_EVENTS) {
+        _events[_numEvents].point = point;
+        _events[_numEvents].api = api;
+        _events[_numEvents].arg = arg;
+        _events[_numEvents].tsUs = ts;
+        _numEvents++;
+    }
+    if (point == dsVIDEOPORT_TRACE_TV_CALLBACK) {
+        _callbacks++;
+        pthread_cond_broadcast(&_cond);
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+/*
+ * Wait until a tvservice notification newer than 'seen' arrives.
+ */
+static bool waitForCallback(unsigned seen)
+{
+    struct timespec deadline;
+    bool ok = true;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += CALLBACK_TIMEOUT_MS / 1000;
+    pthread_mutex_lock(&_lock);
+    while (_callbacks == seen && ok) {
+        ok = (pthread_cond_timedwait(&_cond, &_lock, &deadline) != ETIMEDOUT);
+    }
+    pthread_mutex_unlock(&_lock);
+    return ok;
+}
+
+/* "set " + up to LABEL_NAME_MAX characters of the resolution name */
+#define LABEL_NAME_MAX 40
+
+typedef struct {
+    char label[LABEL_NAME_MAX + 8];
+    size_t first;
+    size_t last;
+    uint64_t stamp[dsVIDEOPORT_TRACE_MAX];
+} BenchSwitch_t;
+
+static void collectSwitch(BenchSwitch_t *sw)
+{
+    memset(sw->stamp, 0, sizeof(sw->stamp));
+    pthread_mutex_lock(&_lock);
+    sw->last = _numEvents;
+    for (size_t i = sw->first; i < sw->last; i++) {
+        /* Keep the first occurrence of each point; a switch that powers off and on reports the first VCHI return. */
+        if (sw->stamp[_events[i].point] == 0) {
+            sw->stamp[_events[i].point] = _events[i].tsUs;
+        }
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+static size_t eventMark()
+{
+    size_t n;
+    pthread_mutex_lock(&_lock);
+    n = _numEvents;
+    pthread_mutex_unlock(&_lock);
+    return n;
+}
+
+static double msBetween(uint64_t from, uint64_t to)
+{
+    if (from == 0 || to == 0 || to < from) {
+        return -1.0;
+    }
+    return (to - from) / 1000.0;
+}
+
+static void printCell(double ms)
+{
+    if (ms < 0) printf(" %10s", "-");
+    else printf(" %10.2f", ms);
+}
+
+static void printTable(const BenchSwitch_t *sw, size_t count)
+{
+    printf("\n%-22s %10s %10s %10s %10s %10s\n", "switch", "vchi(ms)", "cb(ms)", "fb(ms)", "api(ms)", "stable(ms)");
+    for (size_t i = 0; i < count; i++) {
+        const uint64_t *t = sw[i].stamp;
+        uint64_t stable = t[dsVIDEOPORT_TRACE_COMPLETE];
+        if (t[dsVIDEOPORT_TRACE_TV_CALLBACK] > stable) {
+            stable = t[dsVIDEOPORT_TRACE_TV_CALLBACK];
+        }
+        printf("%-22s", sw[i].label);
+        printCell(msBetween(t[dsVIDEOPORT_TRACE_CALL], t[dsVIDEOPORT_TRACE_VCHI_RETURN]));
+        printCell(msBetween(t[dsVIDEOPORT_TRACE_CALL], t[dsVIDEOPORT_TRACE_TV_CALLBACK]));
+        printCell(msBetween(t[dsVIDEOPORT_TRACE_CALL], t[dsVIDEOPORT_TRACE_FB_RECONFIG]));
+        printCell(msBetween(t[dsVIDEOPORT_TRACE_CALL], t[dsVIDEOPORT_TRACE_COMPLETE]));
+        printCell(msBetween(t[dsVIDEOPORT_TRACE_CALL], stable));
+        printf("\n");
+    }
+}
+
+/*
+ * Chrome trace: one complete ("X") slice per switch plus instant ("i")
+ * events for every trace point, tvservice callbacks on their own track.
+ */
+static int writeChromeTrace(const char *path, const BenchSwitch_t *sw, size_t count, uint64_t origin)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        printf("Cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fprintf(fp, "{\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"caller\"}},\n");
+    fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"tvservice\"}}");
+    for (size_t i = 0; i < count; i++) {
+        const uint64_t *t = sw[i].stamp;
+        if (t[dsVIDEOPORT_TRACE_CALL] && t[dsVIDEOPORT_TRACE_COMPLETE]) {
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%llu,\"dur\":%llu}",
+                    sw[i].label,
+                    (unsigned long long) (t[dsVIDEOPORT_TRACE_CALL] - origin),
+                    (unsigned long long) (t[dsVIDEOPORT_TRACE_COMPLETE] - t[dsVIDEOPORT_TRACE_CALL]));
+        }
+        for (size_t e = sw[i].first; e < sw[i].last; e++) {
+            const BenchEvent_t *ev = &_events[e];
+            fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"args\":{\"arg\":%u}}",
+                    kPointNames[ev->point], ev->api,
+                    ev->point == dsVIDEOPORT_TRACE_TV_CALLBACK ? 2 : 1,
+                    (unsigned long long) (ev->tsUs - origin), ev->arg);
+        }
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-n rounds] [-e] [-o trace.json]\n", prog);
+    printf("  -n rounds   walk the resolution table this many times (default 1)\n");
+    printf("  -e          add a dsEnableVideoPort off/on cycle per round\n");
+    printf("  -o file     write a Chrome trace JSON timeline\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int rounds = 1;
+    bool cycleEnable = false;
+    const char *tracePath = NULL;
+    intptr_t handle = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:eo:h")) != -1) {
+        switch (opt) {
+        case 'n': rounds = atoi(optarg); break;
+        case 'e': cycleEnable = true; break;
+        case 'o': tracePath = optarg; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    const dsVideoPortResolution_t *resolutions = NULL;
+    size_t numRes = 0;
+    dsVideoPortGetResolutions(&resolutions, &numRes);
+    size_t maxSwitches = (size_t) rounds * (numRes + (cycleEnable ? 2 : 0));
+    BenchSwitch_t *switches = (BenchSwitch_t *) calloc(maxSwitches, sizeof(BenchSwitch_t));
+    size_t numSwitches = 0;
+    if (!switches || rounds <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (dsVideoPortInit() != dsERR_NONE || dsGetVideoPort(dsVIDEOPORT_TYPE_HDMI, 0, &handle) != dsERR_NONE) {
+        printf("Video port init failed\n");
+        return 1;
+    }
+    dsVideoPortRegisterTraceCB(traceCallback);
+    uint64_t origin = nowUs();
+
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < numRes; i++) {
+            BenchSwitch_t *sw = &switches[numSwitches++];
+            unsigned seen;
+            snprintf(sw->label, sizeof(sw->label), "set %.*s", LABEL_NAME_MAX, resolutions[i].name);
+            pthread_mutex_lock(&_lock);
+            seen = _callbacks;
+            pthread_mutex_unlock(&_lock);
+            sw->first = eventMark();
+            dsSetResolution(handle, (dsVideoPortResolution_t *) &resolutions[i]);
+            if (!waitForCallback(seen)) {
+                printf("%s: no tvservice callback within %d ms\n", sw->label, CALLBACK_TIMEOUT_MS);
+            }
+            collectSwitch(sw);
+        }
+        if (cycleEnable) {
+            for (int on = 0; on <= 1; on++) {
+                BenchSwitch_t *sw = &switches[numSwitches++];
+                unsigned seen;
+                snprintf(sw->label, sizeof(sw->label), "enable %d", on);
+                pthread_mutex_lock(&_lock);
+                seen = _callbacks;
+                pthread_mutex_unlock(&_lock);
+                sw->first = eventMark();
+                dsEnableVideoPort(handle, on != 0);
+                waitForCallback(seen);
+                collectSwitch(sw);
+            }
+        }
+    }
+    dsVideoPortRegisterTraceCB(NULL);
+
+    printTable(switches, numSwitches);
+    if (tracePath && writeChromeTrace(tracePath, switches, numSwitches, origin) == 0) {
+        printf("\nTrace written to %s\n", tracePath);
+    }
+    dsVideoPortTerm();
+    free(switches);
+    return 0;
+}
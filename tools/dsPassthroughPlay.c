@@ -0,0 +1,154 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Plays a raw AC-3 or E-AC-3 elementary stream through the HAL's IEC 61937
+ * passthrough: sets the encoding with dsSetAudioEncoding(), opens the
+ * stream and writes it frame by frame (E-AC-3 as access units), then
+ * reports whether the sink took it and the achieved rate.
+ *
+ * Pointing the "dshal_iec958" PCM at a file (see audiodsp/asound.conf.example)
+ * captures the bursts, e.g. for "ffprobe -f spdif".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dsError.h"
+#include "dsTypes.h"
+#include "dsAudio.h"
+#include "dshalUtils.h"
+#include "dsAudioCmdQueue.h"
+#include "dsAudioIec61937.h"
+
+static const uint32_t kRates[3] = { 48000, 44100, 32000 };
+static const uint16_t kAc3Kbps[19] = { 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 576, 640 };
+
+typedef struct {
+    bool eac3;
+    bool dependent;             /* E-AC-3 dependent substream, belongs to the preceding frame */
+    uint32_t rate;
+    size_t bytes;
+} PlayFrame_t;
+
+static bool parseFrame(const uint8_t *p, size_t left, PlayFrame_t *frame)
+{
+    if (left < 6 || p[0] != 0x0B || p[1] != 0x77) {
+        return false;
+    }
+    uint32_t bsid = p[5] >> 3, fscod = p[4] >> 6;
+    if (bsid <= 8) {
+        uint32_t code = p[4] & 0x3F;
+        if (fscod == 3 || code >= 38) {
+            return false;
+        }
+        uint32_t kbps = kAc3Kbps[code >> 1];
+        frame->eac3 = false;
+        frame->dependent = false;
+        frame->rate = kRates[fscod];
+        frame->bytes = 2 * (fscod == 0 ? 2 * kbps : (fscod == 2 ? 3 * kbps : kbps * 320 / 147 + (code & 1)));
+    } else if (bsid >= 11 && bsid <= 16) {
+        frame->eac3 = true;
+        frame->dependent = (p[2] >> 6) == 1;
+        frame->rate = fscod == 3 ? 0 : kRates[fscod];
+        frame->bytes = 2 * ((((size_t) p[2] & 0x07) << 8 | p[3]) + 1);
+    } else {
+        return false;
+    }
+    return frame->bytes <= left;
+}
+
+static double nowS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    intptr_t handle = 0;
+    PlayFrame_t frame;
+    bool passthrough = false;
+    struct stat st;
+
+    if (argc != 2 || strcmp(argv[1], "-h") == 0) {
+        printf("Usage: %s stream.ac3|stream.eac3\n", argv[0]);
+        return argc == 2 ? 0 : 1;
+    }
+    int fd = open(argv[1], O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        printf("Cannot read %s\n", argv[1]);
+        return 1;
+    }
+    const uint8_t *data = (const uint8_t *) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED || !parseFrame(data, st.st_size, &frame) || frame.rate == 0) {
+        printf("%s does not start with an AC-3/E-AC-3 syncframe at 32, 44.1 or 48 kHz\n", argv[1]);
+        return 1;
+    }
+    const dsAudioEncoding_t encoding = frame.eac3 ? dsAUDIO_ENC_EAC3 : dsAUDIO_ENC_AC3;
+    const char *name = frame.eac3 ? "E-AC-3" : "AC-3";
+
+    vchi_tv_init();
+    if (dsAudioPortInit() != dsERR_NONE || dsGetAudioPort(dsAUDIOPORT_TYPE_HDMI, 0, &handle) != dsERR_NONE ||
+        dsSetAudioEncoding(handle, encoding) != dsERR_NONE || dsAudioFlushCommands() != dsERR_NONE) {
+        printf("Audio port init failed\n");
+        return 1;
+    }
+    dsError_t ret = dsAudioPassthroughOpen(handle, frame.rate, &passthrough);
+    if (ret != dsERR_NONE) {
+        printf("Opening %s passthrough failed (%d)\n", name, ret);
+        return 1;
+    }
+    if (!passthrough) {
+        printf("Sink does not take %s at %u Hz; a player would decode to PCM\n", name, frame.rate);
+        dsAudioPortTerm();
+        return 0;
+    }
+
+    size_t pos = 0, units = 0;
+    double start = nowS();
+    while (pos < (size_t) st.st_size && parseFrame(data + pos, st.st_size - pos, &frame)) {
+        /* An access unit runs up to the next independent frame */
+        size_t unit = frame.bytes;
+        PlayFrame_t next;
+        while (frame.eac3 && pos + unit < (size_t) st.st_size &&
+               parseFrame(data + pos + unit, st.st_size - pos - unit, &next) && next.dependent) {
+            unit += next.bytes;
+        }
+        if ((ret = dsAudioPassthroughWrite(handle, data + pos, unit)) != dsERR_NONE) {
+            printf("Write of unit %zu failed (%d)\n", units, ret);
+            break;
+        }
+        pos += unit;
+        units++;
+    }
+    double elapsed = nowS() - start;
+    printf("%s: %zu units, %zu of %lld bytes in %.2f s\n", name, units, pos, (long long) st.st_size, elapsed);
+    dsAudioPassthroughClose(handle);
+    dsAudioPortTerm();
+    return pos == (size_t) st.st_size ? 0 : 1;
+}
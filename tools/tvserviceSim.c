@@ -0,0 +1,416 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2017 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Host-side stand-in for libvchostif's tvservice/gencmd entry points so the
+ * HAL can be linked and exercised without VideoCore firmware.
+ *
+ * Latencies are taken from the environment:
+ *   DS_TVSIM_VCHI_US     round trip of a tvservice request   (default 2000)
+ *   DS_TVSIM_RETRAIN_US  power-on to VC_HDMI_HDMI callback    (default 250000)
+ *
+ * DS_TVSIM_THROTTLED sets the "get_throttled" answer (hex, default 0x0); it
+ * is read on every call so a test can change it while running.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+extern "C" {
+#include "interface/vmcs_host/vc_tvservice.h"
+#include "interface/vmcs_host/vc_vchi_gencmd.h"
+}
+
+#define SIM_MAX_CALLBACKS 8
+
+typedef struct {
+    TVSERVICE_CALLBACK_T fn;
+    void *data;
+} SimCallback_t;
+
+static pthread_mutex_t _simLock = PTHREAD_MUTEX_INITIALIZER;
+static SimCallback_t _callbacks[SIM_MAX_CALLBACKS];
+static TV_DISPLAY_STATE_T _state;
+static bool _vchiOpen = false;
+static bool _gencmdOpen = false;
+static HDMI_PROPERTY_PARAM_T _clockProperty = { HDMI_PROPERTY_PIXEL_CLOCK_TYPE, HDMI_PIXEL_CLOCK_TYPE_PAL, 0 };
+
+static const struct {
+    uint32_t code;
+    uint16_t width, height, rate;
+    uint32_t interlaced;
+} kSimModes[] = {
+    { HDMI_CEA_480p60H,  720,  480, 60, 0 },
+    { HDMI_CEA_576p50H,  720,  576, 50, 0 },
+    { HDMI_CEA_720p60,  1280,  720, 60, 0 },
+    { HDMI_CEA_720p50,  1280,  720, 50, 0 },
+    { HDMI_CEA_1080i60, 1920, 1080, 60, 1 },
+    { HDMI_CEA_1080i50, 1920, 1080, 50, 1 },
+    { HDMI_CEA_1080p24, 1920, 1080, 24, 0 },
+    { HDMI_CEA_1080p25, 1920, 1080, 25, 0 },
+    { HDMI_CEA_1080p30, 1920, 1080, 30, 0 },
+    { HDMI_CEA_1080p50, 1920, 1080, 50, 0 },
+    { HDMI_CEA_1080p60, 1920, 1080, 60, 0 },
+};
+
+/*
+ * EDID of the simulated sink: a base block and one CTA-861 extension whose
+ * audio descriptors match vc_tv_hdmi_audio_supported() below (LPCM 2ch,
+ * AC-3 5.1 at 48 kHz).
+ */
+static uint8_t _simEdid[256];
+static pthread_once_t _simEdidOnce = PTHREAD_ONCE_INIT;
+
+static void simEdidBuild()
+{
+    static const uint8_t header[8] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+    static const uint8_t cta[] = {
+        0x02, 0x03, 0x0F, 0x40,
+        0x26, 0x09, 0x07, 0x07, 0x15, 0x04, 0x50,   /* audio: LPCM 2ch 32-48k 16-24 bit, AC-3 6ch 48k 640 kbps */
+        0x83, 0x0F, 0x00, 0x00,                     /* speakers: FL/FR, LFE, FC, RL/RR */
+    };
+    uint8_t sum;
+
+    memcpy(_simEdid, header, sizeof(header));
+    _simEdid[0x7E] = 1;
+    memcpy(_simEdid + 128, cta, sizeof(cta));
+    for (int block = 0; block < 2; block++) {
+        sum = 0;
+        for (int i = 0; i < 127; i++) {
+            sum += _simEdid[block * 128 + i];
+        }
+        _simEdid[block * 128 + 127] = (uint8_t) -sum;
+    }
+}
+
+static long simEnvUs(const char *name, long def)
+{
+    const char *v = getenv(name);
+    return v ? atol(v) : def;
+}
+
+static void simVchiDelay()
+{
+    usleep(simEnvUs("DS_TVSIM_VCHI_US", 2000));
+}
+
+typedef struct {
+    uint32_t reason;
+    uint32_t param1;
+    uint32_t param2;
+    long delayUs;
+} SimNotify_t;
+
+static void* simNotifyThread(void *arg)
+{
+    SimNotify_t *n = (SimNotify_t *) arg;
+    SimCallback_t cbs[SIM_MAX_CALLBACKS];
+
+    usleep(n->delayUs);
+    pthread_mutex_lock(&_simLock);
+    memcpy(cbs, _callbacks, sizeof(cbs));
+    pthread_mutex_unlock(&_simLock);
+    for (int i = 0; i < SIM_MAX_CALLBACKS; i++) {
+        if (cbs[i].fn) {
+            cbs[i].fn(cbs[i].data, n->reason, n->param1, n->param2);
+        }
+    }
+    free(n);
+    return NULL;
+}
+
+static void simNotify(uint32_t reason, uint32_t param1, uint32_t param2, long delayUs)
+{
+    pthread_t tid;
+    SimNotify_t *n = (SimNotify_t *) malloc(sizeof(SimNotify_t));
+    if (!n) {
+        return;
+    }
+    n->reason = reason;
+    n->param1 = param1;
+    n->param2 = param2;
+    n->delayUs = delayUs;
+    if (pthread_create(&tid, NULL, simNotifyThread, n) == 0) {
+        pthread_detach(tid);
+    }
+    else {
+        free(n);
+    }
+}
+
+static int simHdmiOn(HDMI_MODE_T mode, HDMI_RES_GROUP_T group, uint32_t code)
+{
+    size_t i;
+    for (i = 0; i < vcos_countof(kSimModes); i++) {
+        if (kSimModes[i].code == code) break;
+    }
+    if (group != HDMI_RES_GROUP_CEA || i == vcos_countof(kSimModes)) {
+        return -1;
+    }
+    pthread_mutex_lock(&_simLock);
+    _state.state = VC_HDMI_ATTACHED | (mode == HDMI_MODE_DVI ? VC_HDMI_DVI : VC_HDMI_HDMI);
+    _state.display.hdmi.state = _state.state;
+    _state.display.hdmi.group = group;
+    _state.display.hdmi.mode = code;
+    _state.display.hdmi.width = kSimModes[i].width;
+    _state.display.hdmi.height = kSimModes[i].height;
+    _state.display.hdmi.frame_rate = kSimModes[i].rate;
+    _state.display.hdmi.scan_mode = kSimModes[i].interlaced;
+    _state.display.hdmi.aspect_ratio = HDMI_ASPECT_16_9;
+    pthread_mutex_unlock(&_simLock);
+    simNotify(mode == HDMI_MODE_DVI ? VC_HDMI_DVI : VC_HDMI_HDMI, group, code,
+              simEnvUs("DS_TVSIM_RETRAIN_US", 250000));
+    return 0;
+}
+
+extern "C" {
+
+void vcos_init(void) {}
+
+int vchi_initialise(VCHI_INSTANCE_T *instance)
+{
+    pthread_mutex_lock(&_simLock);
+    if (_vchiOpen) {
+        printf("tvserviceSim: vchi_initialise() on an open connection\n");
+    }
+    _vchiOpen = true;
+    pthread_mutex_unlock(&_simLock);
+    *instance = NULL;
+    return 0;
+}
+int vchi_connect(void *connections, int num, VCHI_INSTANCE_T instance) { return 0; }
+int vchi_disconnect(VCHI_INSTANCE_T instance)
+{
+    pthread_mutex_lock(&_simLock);
+    _vchiOpen = false;
+    pthread_mutex_unlock(&_simLock);
+    return 0;
+}
+
+void vc_vchi_tv_init(VCHI_INSTANCE_T instance, VCHI_CONNECTION_T **connections, int num)
+{
+    pthread_mutex_lock(&_simLock);
+    if (_state.state == 0) {
+        _state.state = VC_HDMI_ATTACHED | VC_HDMI_HDMI;
+        _state.display.hdmi.state = _state.state;
+        _state.display.hdmi.group = HDMI_RES_GROUP_CEA;
+        _state.display.hdmi.mode = HDMI_CEA_720p60;
+        _state.display.hdmi.width = 1280;
+        _state.display.hdmi.height = 720;
+        _state.display.hdmi.frame_rate = 60;
+        _state.display.hdmi.aspect_ratio = HDMI_ASPECT_16_9;
+    }
+    pthread_mutex_unlock(&_simLock);
+}
+/* Like the real service, stopping it forgets every registered callback */
+void vc_vchi_tv_stop(void)
+{
+    pthread_mutex_lock(&_simLock);
+    memset(_callbacks, 0, sizeof(_callbacks));
+    pthread_mutex_unlock(&_simLock);
+}
+void vc_vchi_gencmd_init(VCHI_INSTANCE_T instance, VCHI_CONNECTION_T **connections, int num)
+{
+    __atomic_store_n(&_gencmdOpen, true, __ATOMIC_RELEASE);
+}
+void vc_gencmd_stop(void)
+{
+    __atomic_store_n(&_gencmdOpen, false, __ATOMIC_RELEASE);
+}
+
+int vc_gencmd(char *response, int maxlen, const char *format, ...)
+{
+    if (!__atomic_load_n(&_gencmdOpen, __ATOMIC_ACQUIRE)) {
+        printf("tvserviceSim: vc_gencmd() after vc_gencmd_stop()\n");
+        return -1;
+    }
+    simVchiDelay();
+    if (!strncmp(format, "get_mem reloc_total", strlen("get_mem reloc_total"))) {
+        snprintf(response, maxlen, "reloc_total=256M");
+    }
+    else if (!strncmp(format, "get_mem reloc", strlen("get_mem reloc"))) {
+        snprintf(response, maxlen, "reloc=200M");
+    }
+    else if (!strncmp(format, "get_throttled", strlen("get_throttled"))) {
+        const char *throttled = getenv("DS_TVSIM_THROTTLED");
+        snprintf(response, maxlen, "throttled=0x%lx", throttled ? strtoul(throttled, NULL, 16) : 0UL);
+    }
+    else {
+        snprintf(response, maxlen, "error=1 error_msg=\"Command not registered\"");
+    }
+    return 0;
+}
+
+void vc_tv_register_callback(TVSERVICE_CALLBACK_T callback, void *callback_data)
+{
+    pthread_mutex_lock(&_simLock);
+    for (int i = 0; i < SIM_MAX_CALLBACKS; i++) {
+        if (_callbacks[i].fn == NULL) {
+            _callbacks[i].fn = callback;
+            _callbacks[i].data = callback_data;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_simLock);
+}
+
+void vc_tv_unregister_callback_full(TVSERVICE_CALLBACK_T callback, void *callback_data)
+{
+    pthread_mutex_lock(&_simLock);
+    for (int i = 0; i < SIM_MAX_CALLBACKS; i++) {
+        if (_callbacks[i].fn == callback && _callbacks[i].data == callback_data) {
+            _callbacks[i].fn = NULL;
+            _callbacks[i].data = NULL;
+        }
+    }
+    pthread_mutex_unlock(&_simLock);
+}
+
+void vc_tv_unregister_callback(TVSERVICE_CALLBACK_T callback)
+{
+    pthread_mutex_lock(&_simLock);
+    for (int i = 0; i < SIM_MAX_CALLBACKS; i++) {
+        if (_callbacks[i].fn == callback) {
+            _callbacks[i].fn = NULL;
+            _callbacks[i].data = NULL;
+        }
+    }
+    pthread_mutex_unlock(&_simLock);
+}
+
+int vc_tv_get_display_state(TV_DISPLAY_STATE_T *tvstate)
+{
+    simVchiDelay();
+    pthread_mutex_lock(&_simLock);
+    *tvstate = _state;
+    pthread_mutex_unlock(&_simLock);
+    return 0;
+}
+
+int vc_tv_hdmi_power_on_preferred(void)
+{
+    simVchiDelay();
+    return simHdmiOn(HDMI_MODE_HDMI, HDMI_RES_GROUP_CEA, HDMI_CEA_1080p60);
+}
+
+int vc_tv_hdmi_power_on_explicit_new(HDMI_MODE_T mode, HDMI_RES_GROUP_T group, uint32_t code)
+{
+    simVchiDelay();
+    return simHdmiOn(mode, group, code);
+}
+
+int vc_tv_sdtv_power_on(SDTV_MODE_T mode, SDTV_OPTIONS_T *options)
+{
+    simVchiDelay();
+    pthread_mutex_lock(&_simLock);
+    _state.state = VC_SDTV_ATTACHED | (mode == SDTV_MODE_PAL ? VC_SDTV_PAL : VC_SDTV_NTSC);
+    _state.display.sdtv.state = _state.state;
+    _state.display.sdtv.mode = mode;
+    if (options) {
+        _state.display.sdtv.display_options = *options;
+    }
+    pthread_mutex_unlock(&_simLock);
+    simNotify(mode == SDTV_MODE_PAL ? VC_SDTV_PAL : VC_SDTV_NTSC, 0, 0,
+              simEnvUs("DS_TVSIM_RETRAIN_US", 250000));
+    return 0;
+}
+
+int vc_tv_power_off(void)
+{
+    simVchiDelay();
+    pthread_mutex_lock(&_simLock);
+    _state.state = VC_HDMI_ATTACHED;
+    _state.display.hdmi.state = _state.state;
+    pthread_mutex_unlock(&_simLock);
+    simNotify(VC_HDMI_ATTACHED, 0, 0, simEnvUs("DS_TVSIM_VCHI_US", 2000));
+    return 0;
+}
+
+int vc_tv_hdmi_get_supported_modes_new(HDMI_RES_GROUP_T group, TV_SUPPORTED_MODE_NEW_T *supported_modes,
+                                       uint32_t max_supported_modes, HDMI_RES_GROUP_T *preferred_group,
+                                       uint32_t *preferred_mode)
+{
+    uint32_t n = 0;
+    simVchiDelay();
+    if (group != HDMI_RES_GROUP_CEA) {
+        return 0;
+    }
+    for (size_t i = 0; i < vcos_countof(kSimModes) && n < max_supported_modes; i++, n++) {
+        memset(&supported_modes[n], 0, sizeof(supported_modes[n]));
+        supported_modes[n].group = HDMI_RES_GROUP_CEA;
+        supported_modes[n].code = kSimModes[i].code;
+        supported_modes[n].width = kSimModes[i].width;
+        supported_modes[n].height = kSimModes[i].height;
+        supported_modes[n].frame_rate = kSimModes[i].rate;
+        supported_modes[n].scan_mode = kSimModes[i].interlaced;
+        supported_modes[n].native = (kSimModes[i].code == HDMI_CEA_1080p60);
+    }
+    if (preferred_group) *preferred_group = HDMI_RES_GROUP_CEA;
+    if (preferred_mode) *preferred_mode = HDMI_CEA_1080p60;
+    return n;
+}
+
+int vc_tv_hdmi_audio_supported(uint32_t audio_format, uint32_t num_channels, EDID_AudioSampleRate fs, uint32_t bitrate)
+{
+    simVchiDelay();
+    if (audio_format == EDID_AudioFormat_ePCM) {
+        return num_channels <= 2 ? 0 : -1;
+    }
+    return (audio_format == EDID_AudioFormat_eAC3 && num_channels <= 6) ? 0 : -1;
+}
+
+int vc_tv_hdmi_set_property(const HDMI_PROPERTY_PARAM_T *property)
+{
+    simVchiDelay();
+    if (property->property == HDMI_PROPERTY_PIXEL_CLOCK_TYPE) {
+        pthread_mutex_lock(&_simLock);
+        _clockProperty = *property;
+        pthread_mutex_unlock(&_simLock);
+    }
+    return 0;
+}
+
+int vc_tv_hdmi_get_property(HDMI_PROPERTY_PARAM_T *property)
+{
+    simVchiDelay();
+    if (property->property != HDMI_PROPERTY_PIXEL_CLOCK_TYPE) {
+        return -1;
+    }
+    pthread_mutex_lock(&_simLock);
+    *property = _clockProperty;
+    pthread_mutex_unlock(&_simLock);
+    return 0;
+}
+
+int vc_tv_hdmi_ddc_read(uint32_t offset, uint32_t length, uint8_t *buffer)
+{
+    simVchiDelay();
+    if (offset + length > sizeof(_simEdid)) {
+        memset(buffer, 0, length);
+        return -1;
+    }
+    pthread_once(&_simEdidOnce, simEdidBuild);
+    memcpy(buffer, _simEdid + offset, length);
+    return (int) length;
+}
+
+}